@@ -4,6 +4,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "hashmap.h"
 
@@ -36,6 +37,541 @@ static PyObject* HashmapIterator_iter(PyObject *self) {
     return self;
 }
 
+/******************************************************************************
+ * Hashmap layout - common                                                    *
+ ******************************************************************************/
+
+/* Names of the HashmapLayout_e values, index is the value */
+static const char *layout_names[] = {
+    "items", "swiss", "compact", "soa", "cuckoo", "concurrent", NULL
+};
+
+static int layout_from_name(const char * const name,
+        HashmapLayout_e * const layout) {
+    for (int i=0; NULL != layout_names[i]; ++i) {
+        if (0 == strcmp(name, layout_names[i])) {
+            *layout = (HashmapLayout_e) i;
+            return 0;
+        }
+    }
+    PyErr_Format(PyExc_ValueError, "Unknown layout '%s'", name);
+    return -1;
+}
+
+static PyObject* layout_to_name(const unsigned char layout) {
+    return PyUnicode_FromString(layout_names[layout]);
+}
+
+/******************************************************************************
+ * Buffers - common                                                           *
+ ******************************************************************************/
+
+/* Struct module formats of the C types, item size is checked separately */
+#define UINT64_FORMATS "QL"
+#define SIZE_T_FORMATS "NQLI"
+/* Signed deltas are ptrdiff_t, negative delta is subtracted */
+#define SIGNED_DELTA_FORMATS "nqli"
+#define DELTA_FORMATS SIZE_T_FORMATS SIGNED_DELTA_FORMATS
+#define DOUBLE_FORMATS "d"
+#define BOOL_FORMATS "?Bb"
+
+/* Array typecode of size_t values */
+#define SIZE_T_TYPECODE \
+        ((sizeof(size_t) == sizeof(unsigned long long)) ? "Q" : "L")
+
+/* Get C-contiguous buffer of obj, its items must be itemsize bytes long
+   and have one of the formats in native byte order */
+static int get_typed_buffer(PyObject *obj, Py_buffer *view, const int flags,
+        const char * const formats, const Py_ssize_t itemsize,
+        const char * const name, const char * const type_name) {
+    const char *format;
+
+    if (PyObject_GetBuffer(obj, view,
+            flags | PyBUF_FORMAT | PyBUF_C_CONTIGUOUS)) {
+        return -1;
+    }
+    format = (NULL != view->format) ? view->format : "B";
+    if (('@' == format[0]) || ('=' == format[0])
+            || ((PY_LITTLE_ENDIAN) && ('<' == format[0]))
+            || ((!PY_LITTLE_ENDIAN) && ('>' == format[0]))) {
+        format += 1;
+    }
+    if ((view->itemsize != itemsize) || ('\0' == format[0])
+            || ('\0' != format[1]) || (NULL == strchr(formats, format[0]))) {
+        PyErr_Format(PyExc_TypeError, "'%s' must be a buffer of %s",
+                name, type_name);
+        PyBuffer_Release(view);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Get writable buffer for n items of the result, length_of names what
+   determines n */
+static int get_result_buffer(PyObject *obj, Py_buffer *view,
+        const Py_ssize_t n, const char * const length_of,
+        const char * const formats, const Py_ssize_t itemsize,
+        const char * const name, const char * const type_name) {
+    if (get_typed_buffer(obj, view, PyBUF_WRITABLE, formats, itemsize,
+            name, type_name)) {
+        return -1;
+    }
+    if (view->len / itemsize != n) {
+        PyErr_Format(PyExc_ValueError,
+                "'%s' must have the same length as %s", name, length_of);
+        PyBuffer_Release(view);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Return new array.array of n zero items */
+static PyObject* new_array(const char * const typecode, const Py_ssize_t n) {
+    PyObject *array_module;
+    PyObject *item;
+    PyObject *res = NULL;
+
+    if (NULL == (array_module = PyImport_ImportModule("array"))) {
+        return NULL;
+    }
+    item = PyObject_CallMethod(array_module, "array", "s(i)", typecode, 0);
+    if (NULL != item) {
+        res = PySequence_Repeat(item, n);
+        Py_DECREF(item);
+    }
+    Py_DECREF(array_module);
+
+    return res;
+}
+
+/* Read-only view of the whole memory block of the table, __reduce_ex__
+   exports it as PickleBuffer. Owner can't be changed while the memory is
+   exported. View can't be exported again once all its exports were
+   released, the owner may have reallocated the table since then. */
+typedef struct {
+    PyObject_HEAD
+    PyObject *owner;
+    Py_ssize_t *owner_exports;
+    void *buf;
+    Py_ssize_t len;
+    Py_ssize_t exports;
+    bool released;
+} HashmapBlock_t;
+
+static PyTypeObject HashmapBlock_type;
+
+static PyObject* HashmapBlock_new(PyObject * const owner,
+        Py_ssize_t * const owner_exports, void * const buf,
+        const size_t len) {
+    HashmapBlock_t *self;
+
+    if (NULL == (self = PyObject_New(HashmapBlock_t, &HashmapBlock_type))) {
+        return NULL;
+    }
+    self->owner = owner;
+    Py_INCREF(self->owner);
+    self->owner_exports = owner_exports;
+    self->buf = buf;
+    self->len = (Py_ssize_t) len;
+    self->exports = 0;
+    self->released = false;
+
+    return (PyObject*) self;
+}
+
+static void HashmapBlock_dealloc(HashmapBlock_t *self) {
+    Py_DECREF(self->owner);
+    PyObject_Del(self);
+}
+
+static int HashmapBlock_getbuffer(HashmapBlock_t *self, Py_buffer *view,
+        int flags) {
+    if (self->released) {
+        PyErr_SetString(PyExc_BufferError, "Memory block was released");
+        return -1;
+    }
+    if (PyBuffer_FillInfo(view, (PyObject*) self, self->buf, self->len, 1,
+            flags)) {
+        return -1;
+    }
+    self->exports += 1;
+    *self->owner_exports += 1;
+
+    return 0;
+}
+
+static void HashmapBlock_releasebuffer(HashmapBlock_t *self,
+        Py_buffer *view) {
+    *self->owner_exports -= 1;
+    self->exports -= 1;
+    if (0 == self->exports) {
+        self->released = true;
+    }
+}
+
+static PyBufferProcs HashmapBlock_buffer_procs = {
+    (getbufferproc) HashmapBlock_getbuffer,
+    (releasebufferproc) HashmapBlock_releasebuffer,
+};
+
+static PyTypeObject HashmapBlock_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "cdatastructs.hashmap._HashmapBlock",
+    .tp_doc = "Memory block of the hashmap",
+    .tp_basicsize = sizeof(HashmapBlock_t),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_as_buffer = &HashmapBlock_buffer_procs,
+    .tp_dealloc = (destructor) HashmapBlock_dealloc
+};
+
+/******************************************************************************
+ * Files - common                                                             *
+ ******************************************************************************/
+
+/* Number of bytes passed to one call of write() or readinto() of the file
+   object by dump() and load() */
+#define STREAM_CHUNK_SIZE ((size_t) 1 << 20)
+
+/* Write len bytes of buf into the file object by chunks, memoryview of each
+   chunk is released after the call, so the file can't keep it */
+static int stream_write(PyObject * const file, const void * const buf,
+        const size_t len) {
+    const char *data = (const char*) buf;
+    size_t done = 0;
+    size_t n;
+    Py_ssize_t written;
+    PyObject *view;
+    PyObject *res;
+    PyObject *released;
+    PyObject *exc_type, *exc_value, *exc_traceback;
+
+    while (done < len) {
+        n = ((len - done) < STREAM_CHUNK_SIZE)
+                ? (len - done) : STREAM_CHUNK_SIZE;
+        if (NULL == (view = PyMemoryView_FromMemory(
+                (char*) data + done, (Py_ssize_t) n, PyBUF_READ))) {
+            return -1;
+        }
+        if (NULL == (res = PyObject_CallMethod(file, "write", "O", view))) {
+            PyErr_Fetch(&exc_type, &exc_value, &exc_traceback);
+            Py_XDECREF(PyObject_CallMethod(view, "release", NULL));
+            PyErr_Restore(exc_type, exc_value, exc_traceback);
+            Py_DECREF(view);
+            return -1;
+        }
+        released = PyObject_CallMethod(view, "release", NULL);
+        Py_DECREF(view);
+        if (NULL == released) {
+            Py_DECREF(res);
+            return -1;
+        }
+        Py_DECREF(released);
+        /* Buffered files write everything, raw files may write less */
+        written = (Py_None == res) ? (Py_ssize_t) n : PyLong_AsSsize_t(res);
+        Py_DECREF(res);
+        if ((written == -1) && PyErr_Occurred()) {
+            return -1;
+        }
+        if ((written <= 0) || ((size_t) written > n)) {
+            PyErr_SetString(PyExc_OSError, "write() returned invalid size");
+            return -1;
+        }
+        done += (size_t) written;
+    }
+
+    return 0;
+}
+
+/* Read exactly len bytes from the file object by readinto() into buf, if
+   checksum is not NULL, it is updated by the read data while they are
+   still in the cache */
+static int stream_readinto(PyObject * const file, void * const buf,
+        const size_t len, unsigned long long * const checksum) {
+    char *data = (char*) buf;
+    size_t done = 0;
+    size_t hashed = 0;
+    size_t n;
+    Py_ssize_t read;
+    PyObject *view;
+    PyObject *res;
+    PyObject *released;
+    PyObject *exc_type, *exc_value, *exc_traceback;
+
+    while (done < len) {
+        n = ((len - done) < STREAM_CHUNK_SIZE)
+                ? (len - done) : STREAM_CHUNK_SIZE;
+        if (NULL == (view = PyMemoryView_FromMemory(
+                data + done, (Py_ssize_t) n, PyBUF_WRITE))) {
+            return -1;
+        }
+        if (NULL == (res = PyObject_CallMethod(file, "readinto", "O", view))) {
+            PyErr_Fetch(&exc_type, &exc_value, &exc_traceback);
+            Py_XDECREF(PyObject_CallMethod(view, "release", NULL));
+            PyErr_Restore(exc_type, exc_value, exc_traceback);
+            Py_DECREF(view);
+            return -1;
+        }
+        released = PyObject_CallMethod(view, "release", NULL);
+        Py_DECREF(view);
+        if (NULL == released) {
+            Py_DECREF(res);
+            return -1;
+        }
+        Py_DECREF(released);
+        if (Py_None == res) {
+            Py_DECREF(res);
+            PyErr_SetString(PyExc_OSError, "readinto() returned no data");
+            return -1;
+        }
+        read = PyLong_AsSsize_t(res);
+        Py_DECREF(res);
+        if ((read == -1) && PyErr_Occurred()) {
+            return -1;
+        }
+        if (0 == read) {
+            PyErr_SetString(PyExc_ValueError, "Unexpected end of the stream");
+            return -1;
+        }
+        if ((read < 0) || ((size_t) read > n)) {
+            PyErr_SetString(PyExc_OSError, "readinto() returned invalid size");
+            return -1;
+        }
+        done += (size_t) read;
+        if ((NULL != checksum) && ((done == len) || (done - hashed >= 8))) {
+            /* Parts except the last one must be divisible by 8 */
+            n = (done == len) ? (done - hashed)
+                    : ((done - hashed) & ~((size_t) 7));
+            *checksum = hashmap_checksum_update(*checksum, data + hashed, n);
+            hashed += n;
+        }
+    }
+
+    return 0;
+}
+
+/* Read header of the stream written by dump() */
+static int stream_read_header(PyObject * const file,
+        HashmapFileHeader_t * const header, const HashmapFileType_e type) {
+    if (stream_readinto(file, header, sizeof(HashmapFileHeader_t), NULL)) {
+        return -1;
+    }
+    if (hashmap_file_check(header, SIZE_MAX, type)
+            || (sizeof(HashmapFileHeader_t) != header->table_offset)) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the stream");
+        return -1;
+    }
+    return 0;
+}
+
+/* Fill header of the stream of key/value pairs */
+static void stream_pairs_header(HashmapFileHeader_t * const header,
+        const HashmapFileType_e type, const unsigned char layout,
+        const size_t size, const size_t current_size, const size_t table_size,
+        const size_t table_bytes, const unsigned long long checksum) {
+    memset(header, 0, sizeof(HashmapFileHeader_t));
+    memcpy(header->magic, HASHMAP_FILE_MAGIC, sizeof(header->magic));
+    header->version = HASHMAP_FILE_VERSION;
+    header->type = (unsigned short) type;
+    header->layout = layout;
+    header->flags = HASHMAP_FILE_FLAG_PAIRS;
+    header->size = size;
+    header->current_size = current_size;
+    header->table_size = table_size;
+    header->table_offset = sizeof(HashmapFileHeader_t);
+    header->table_bytes = table_bytes;
+    header->checksum = checksum;
+}
+
+/* Write header and memory block of the table into the file at path. Data
+   are written into path.tmp which then replaces path, so processes which
+   mapped the previous file keep using its content. */
+static int save_table(PyObject * const path,
+        const HashmapFileHeader_t * const header, const void * const table) {
+    PyObject *io_module = NULL;
+    PyObject *os_module = NULL;
+    PyObject *tmp_path = NULL;
+    PyObject *file = NULL;
+    PyObject *view;
+    PyObject *res;
+    PyObject *exc_type, *exc_value, *exc_traceback;
+
+    if (NULL == (io_module = PyImport_ImportModule("io"))) {
+        goto error;
+    }
+    if (NULL == (os_module = PyImport_ImportModule("os"))) {
+        goto error;
+    }
+    if (NULL == (tmp_path = PyUnicode_FromFormat("%U.tmp", path))) {
+        goto error;
+    }
+    if (NULL == (file = PyObject_CallMethod(
+            io_module, "open", "Os", tmp_path, "wb"))) {
+        goto error;
+    }
+    if (NULL == (res = PyObject_CallMethod(file, "write", "y#",
+            (const char*) header, (Py_ssize_t) sizeof(HashmapFileHeader_t)))) {
+        goto error;
+    }
+    Py_DECREF(res);
+    /* Memory block is written without a copy */
+    if (NULL == (view = PyMemoryView_FromMemory((char*) table,
+            (Py_ssize_t) header->table_bytes, PyBUF_READ))) {
+        goto error;
+    }
+    res = PyObject_CallMethod(file, "write", "O", view);
+    Py_DECREF(view);
+    if (NULL == res) {
+        goto error;
+    }
+    Py_DECREF(res);
+    res = PyObject_CallMethod(file, "close", NULL);
+    Py_CLEAR(file);
+    if (NULL == res) {
+        goto error;
+    }
+    Py_DECREF(res);
+    if (NULL == (res = PyObject_CallMethod(
+            os_module, "replace", "OO", tmp_path, path))) {
+        goto error;
+    }
+    Py_DECREF(res);
+
+    Py_DECREF(tmp_path);
+    Py_DECREF(os_module);
+    Py_DECREF(io_module);
+
+    return 0;
+
+error:
+    if (NULL != file) {
+        /* Partially written file is removed, original error is raised */
+        PyErr_Fetch(&exc_type, &exc_value, &exc_traceback);
+        Py_XDECREF(PyObject_CallMethod(file, "close", NULL));
+        Py_XDECREF(PyObject_CallMethod(os_module, "remove", "O", tmp_path));
+        PyErr_Restore(exc_type, exc_value, exc_traceback);
+        Py_DECREF(file);
+    }
+    Py_XDECREF(tmp_path);
+    Py_XDECREF(os_module);
+    Py_XDECREF(io_module);
+    return -1;
+}
+
+/* Map the file at path into the memory and get its buffer into view,
+   return pointer to the table or NULL if the file is not valid. Mode 'r'
+   maps private copy-on-write pages, so the header of the table can be
+   marked read-only while all other pages stay shared with other processes
+   in the page cache. Mode 'r+' maps shared writable pages. */
+static void* open_table(PyObject * const path, const char * const mode,
+        const HashmapFileType_e type, const bool verify,
+        Py_buffer * const view) {
+    const bool writable = (0 == strcmp(mode, "r+"));
+    PyObject *io_module = NULL;
+    PyObject *mmap_module = NULL;
+    PyObject *file = NULL;
+    PyObject *fileno = NULL;
+    PyObject *mmap_type = NULL;
+    PyObject *mmap_args = NULL;
+    PyObject *mmap_kwargs = NULL;
+    PyObject *memory;
+    PyObject *res;
+    PyObject *exc_type, *exc_value, *exc_traceback;
+    HashmapFileHeader_t *header;
+
+    if (!writable && (0 != strcmp(mode, "r"))) {
+        PyErr_SetString(PyExc_ValueError, "'mode' must be 'r' or 'r+'");
+        return NULL;
+    }
+    if (NULL == (io_module = PyImport_ImportModule("io"))) {
+        goto error;
+    }
+    if (NULL == (mmap_module = PyImport_ImportModule("mmap"))) {
+        goto error;
+    }
+    if (NULL == (file = PyObject_CallMethod(
+            io_module, "open", "Os", path, writable ? "r+b" : "rb"))) {
+        goto error;
+    }
+    if (NULL == (fileno = PyObject_CallMethod(file, "fileno", NULL))) {
+        goto error;
+    }
+    /* Mapping holds its own descriptor of the file */
+    if (NULL == (mmap_args = Py_BuildValue("(Oi)", fileno, 0))) {
+        goto error;
+    }
+    if (NULL == (mmap_kwargs = Py_BuildValue("{sN}", "access",
+            PyObject_GetAttrString(mmap_module,
+                    writable ? "ACCESS_WRITE" : "ACCESS_COPY")))) {
+        goto error;
+    }
+    if (NULL == (mmap_type = PyObject_GetAttrString(mmap_module, "mmap"))) {
+        goto error;
+    }
+    if (NULL == (memory = PyObject_Call(mmap_type, mmap_args, mmap_kwargs))) {
+        goto error;
+    }
+    if (PyObject_GetBuffer(memory, view, PyBUF_WRITABLE)) {
+        Py_DECREF(memory);
+        goto error;
+    }
+    Py_DECREF(memory);
+    res = PyObject_CallMethod(file, "close", NULL);
+    Py_CLEAR(file);
+    if (NULL == res) {
+        goto error;
+    }
+    Py_DECREF(res);
+
+    header = (HashmapFileHeader_t*) view->buf;
+    if (hashmap_file_check(header, (size_t) view->len, type)) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the file");
+        goto error;
+    }
+    if (header->flags & HASHMAP_FILE_FLAG_PAIRS) {
+        PyErr_SetString(PyExc_ValueError,
+                "File holds only key/value pairs, it must be read by load()");
+        goto error;
+    }
+    if (verify && (0 == header->checksum)) {
+        PyErr_SetString(PyExc_ValueError,
+                "Checksum of the file is unknown, it was opened as 'r+'");
+        goto error;
+    }
+    if (verify && (header->checksum != hashmap_checksum(
+            (char*) view->buf + header->table_offset,
+            (size_t) header->table_bytes))) {
+        PyErr_SetString(PyExc_ValueError, "Checksum of the file is wrong");
+        goto error;
+    }
+
+    Py_DECREF(mmap_kwargs);
+    Py_DECREF(mmap_args);
+    Py_DECREF(mmap_type);
+    Py_DECREF(fileno);
+    Py_DECREF(mmap_module);
+    Py_DECREF(io_module);
+
+    return (char*) view->buf + header->table_offset;
+
+error:
+    if (NULL != file) {
+        PyErr_Fetch(&exc_type, &exc_value, &exc_traceback);
+        Py_XDECREF(PyObject_CallMethod(file, "close", NULL));
+        PyErr_Restore(exc_type, exc_value, exc_traceback);
+        Py_DECREF(file);
+    }
+    Py_XDECREF(mmap_kwargs);
+    Py_XDECREF(mmap_args);
+    Py_XDECREF(mmap_type);
+    Py_XDECREF(fileno);
+    Py_XDECREF(mmap_module);
+    Py_XDECREF(io_module);
+    return NULL;
+}
+
 /******************************************************************************
  * Int2Int class                                                              *
  ******************************************************************************/
@@ -43,9 +579,15 @@ static PyObject* HashmapIterator_iter(PyObject *self) {
 typedef struct {
     PyObject_HEAD
     Int2IntHashTable_t *hashmap;
-    Int2IntItem_t *table;
     PyObject *default_value;
     bool release_memory;
+    /* Number of operations which use the table without the GIL */
+    Py_ssize_t exports;
+    /* Shape and stride of the exported buffer */
+    Py_ssize_t export_shape;
+    Py_ssize_t export_stride;
+    /* Buffer of the caller which holds the table (create_in/from_buffer) */
+    Py_buffer memory;
 } Int2Int_t;
 
 static PyTypeObject Int2Int_type;
@@ -55,25 +597,21 @@ static PyTypeObject Int2Int_type;
 static PyObject* Int2IntIterator_next(HashmapIterator_t *self) {
     Int2Int_t *obj = (Int2Int_t*) self->obj;
     PyObject *res = NULL;
-
-    while (self->current_position < obj->hashmap->table_size) {
-        Int2IntItem_t item = obj->table[self->current_position];
-        if (item.status == USED) {
-            switch (self->iterator_type) {
-            case KEYS:
-                res = PyLong_FromUnsignedLongLong(item.key);
-                break;
-            case VALUES:
-                res = PyLong_FromSize_t(item.value);
-                break;
-            case ITEMS:
-                res = PyTuple_Pack(2, PyLong_FromUnsignedLongLong(item.key),
-                        PyLong_FromSize_t(item.value));
-                break;
-            }
-        }
-        ++self->current_position;
-        if (res != NULL) {
+    unsigned long long key;
+    size_t *value;
+
+    if (0 == int2int_next(obj->hashmap, &self->current_position,
+            &key, &value)) {
+        switch (self->iterator_type) {
+        case KEYS:
+            res = PyLong_FromUnsignedLongLong(key);
+            break;
+        case VALUES:
+            res = PyLong_FromSize_t(*value);
+            break;
+        case ITEMS:
+            res = PyTuple_Pack(2, PyLong_FromUnsignedLongLong(key),
+                    PyLong_FromSize_t(*value));
             break;
         }
     }
@@ -98,18 +636,54 @@ static PyTypeObject Int2IntIterator_type = {
 static int Int2Int_update_from_initializer(Int2Int_t *self,
         PyObject *initializer);
 
-static PyObject* Int2Int_new(PyTypeObject *cls,
-        PyObject *args, PyObject *kwds) {
+static PyObject* Int2Int_new_layout(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds, const HashmapLayout_e default_layout) {
 
-    char *kwnames[] = {"initializer", "default", "prealloc_size", NULL};
+    char *kwnames[] = {"initializer", "default", "prealloc_size", "layout",
+            "incremental_resize", "max_load", "growth", "shrink_load", NULL};
     PyObject *initializer = NULL;
     PyObject *default_value = Py_None;
     unsigned int prealloc_size = INT2INT_INITIAL_SIZE;
+    const char *layout_name = NULL;
+    HashmapLayout_e layout = default_layout;
+    int incremental_resize = false;
+    double max_load = HASHMAP_DEFAULT_MAX_LOAD;
+    double growth = HASHMAP_DEFAULT_GROWTH;
+    double shrink_load = 0.0;
     Int2Int_t *self = NULL;
 
     /* Parse arguments */
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O$OI", kwnames,
-            &initializer, &default_value, &prealloc_size)) {
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O$OIspddd", kwnames,
+            &initializer, &default_value, &prealloc_size, &layout_name,
+            &incremental_resize, &max_load, &growth, &shrink_load)) {
+        goto error;
+    }
+    if ((NULL != layout_name) && layout_from_name(layout_name, &layout)) {
+        goto error;
+    }
+    if (0 == int2int_layout_table_size(prealloc_size, layout,
+            HASHMAP_DEFAULT_MAX_LOAD)) {
+        PyErr_Format(PyExc_ValueError,
+                "Layout '%s' is not supported", layout_name);
+        goto error;
+    }
+    if (HASHMAP_LAYOUT_CUCKOO == layout) {
+        PyErr_SetString(PyExc_ValueError,
+                "Layout 'cuckoo' is created only by freeze()");
+        goto error;
+    }
+    if (!((max_load > 0.0) && (max_load <= 1.0))) {
+        PyErr_SetString(PyExc_ValueError,
+                "'max_load' must be greater than 0 and at most 1");
+        goto error;
+    }
+    if (!(growth > 1.0)) {
+        PyErr_SetString(PyExc_ValueError, "'growth' must be greater than 1");
+        goto error;
+    }
+    if (!((shrink_load >= 0.0) && (shrink_load < 1.0))) {
+        PyErr_SetString(PyExc_ValueError,
+                "'shrink_load' must be at least 0 and less than 1");
         goto error;
     }
     /* Validate arguments */
@@ -129,15 +703,18 @@ static PyObject* Int2Int_new(PyTypeObject *cls,
     /* Allocate memory for Int2IntHashTable_t structure and hashtable. At
        the beginning of block of the memory Int2IntHashTable_t structure
        is placed, followed by hashtable (array of Int2IntItem_t). */
-    if (int2int_new(prealloc_size, &self->hashmap)) {
+    if (int2int_new_ex(prealloc_size, layout, max_load, growth,
+            &self->hashmap)) {
         PyErr_NoMemory();
         goto error;
     }
+    if (incremental_resize) {
+        self->hashmap->flags |= HASHMAP_FLAG_INCREMENTAL_RESIZE;
+    }
+    self->hashmap->shrink_load = shrink_load;
     /* Initialize object attributes */
     self->release_memory = true;
     self->default_value = default_value;
-    self->table = (Int2IntItem_t*) (
-            (char*) self->hashmap + sizeof(Int2IntHashTable_t));
 
     if ((NULL != initializer) &&
             (Int2Int_update_from_initializer(self, initializer) != 0)) {
@@ -155,11 +732,22 @@ error:
     return NULL;
 }
 
+static PyObject* Int2Int_new(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    return Int2Int_new_layout(cls, args, kwds, HASHMAP_LAYOUT_ITEMS);
+}
+
+static PyObject* Int2IntSwiss_new(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    return Int2Int_new_layout(cls, args, kwds, HASHMAP_LAYOUT_SWISS);
+}
+
 static void Int2Int_dealloc(Int2Int_t *self) {
     Py_DECREF(self->default_value);
     if (self->release_memory && (NULL != self->hashmap)) {
         free(self->hashmap);
     }
+    PyBuffer_Release(&self->memory);
     Py_TYPE(self)->tp_free((PyObject*) self);
 }
 
@@ -214,60 +802,61 @@ static PyObject* Int2Int_richcompare(Int2Int_t *self, PyObject *other, int op) {
     }
 
     if (res != NULL) {
-        if (PyDict_Check(other) || (Py_TYPE(other) == &Int2Int_type)) {
+        if (PyDict_Check(other) || PyObject_TypeCheck(other, &Int2Int_type)) {
             Py_ssize_t other_length = PyMapping_Size(other);
 
             if (other_length == (Py_ssize_t) self->hashmap->current_size) {
+                size_t position = 0;
+                unsigned long long item_key;
+                size_t *item_value;
+
                 res = Py_True;
-                for (size_t i = 0; i < self->hashmap->table_size; ++i) {
-                    Int2IntItem_t item = self->table[i];
-
-                    if (item.status == USED) {
-                        PyObject *key = NULL;
-                        PyObject *value = NULL;
-                        size_t c_value;
-
-                        key = PyLong_FromLongLong(item.key);
-                        if (key != NULL) {
-                            value = PyObject_GetItem(other, key);
-                            if (value != NULL) {
-                                c_value = PyLong_AsSize_t(value);
-                                if ((c_value != (size_t) -1) &&
-                                        PyErr_Occurred() != NULL) {
-                                    /* PyLong to size_t conversion error */
-                                    res = NULL;
-                                }
-                                else {
-                                    /* Values for key are different */
-                                    if (item.value != c_value) {
-                                        res = Py_False;
-                                    }
-                                }
+                while (0 == int2int_next(self->hashmap, &position,
+                        &item_key, &item_value)) {
+                    PyObject *key = NULL;
+                    PyObject *value = NULL;
+                    size_t c_value;
+
+                    key = PyLong_FromLongLong(item_key);
+                    if (key != NULL) {
+                        value = PyObject_GetItem(other, key);
+                        if (value != NULL) {
+                            c_value = PyLong_AsSize_t(value);
+                            if ((c_value != (size_t) -1) &&
+                                    PyErr_Occurred() != NULL) {
+                                /* PyLong to size_t conversion error */
+                                res = NULL;
                             }
                             else {
-                                /* other[key] error, if KeyError, objects are
-                                   different, otherwise return with error. */
-                                if (PyErr_GivenExceptionMatches(
-                                        PyErr_Occurred(), PyExc_KeyError)) {
-                                    PyErr_Clear();
+                                /* Values for key are different */
+                                if (*item_value != c_value) {
                                     res = Py_False;
                                 }
-                                else {
-                                    res = NULL;
-                                }
                             }
                         }
                         else {
-                            /* long long to PyLong conversion error */
-                            res = NULL;
+                            /* other[key] error, if KeyError, objects are
+                               different, otherwise return with error. */
+                            if (PyErr_GivenExceptionMatches(
+                                    PyErr_Occurred(), PyExc_KeyError)) {
+                                PyErr_Clear();
+                                res = Py_False;
+                            }
+                            else {
+                                res = NULL;
+                            }
                         }
+                    }
+                    else {
+                        /* long long to PyLong conversion error */
+                        res = NULL;
+                    }
 
-                        Py_XDECREF(key);
-                        Py_XDECREF(value);
+                    Py_XDECREF(key);
+                    Py_XDECREF(value);
 
-                        if (res != Py_True) {
-                            break;
-                        }
+                    if (res != Py_True) {
+                        break;
                     }
                 }
             }
@@ -290,8 +879,23 @@ static PyObject* Int2Int_richcompare(Int2Int_t *self, PyObject *other, int op) {
     return res;
 }
 
+/* Look up the key, table with seqlock may be modified meanwhile by the
+   writer in other process. Return -1 if the key does not exist and -2 with
+   exception set if the writer did not let the lookup finish. */
+static int Int2Int_lookup(Int2Int_t *self, const unsigned long long key,
+        size_t * const value) {
+    int res = int2int_get_consistent(self->hashmap, key, value);
+
+    if (-2 == res) {
+        PyErr_SetString(PyExc_RuntimeError,
+                "Table is being modified by the writer");
+    }
+    return res;
+}
+
 static int Int2Int_contains(Int2Int_t *self, PyObject *key) {
     unsigned long long c_key;
+    size_t c_value;
 
     if (!PyLong_Check(key)) {
         PyErr_SetString(PyExc_TypeError, "'key' must be an integer");
@@ -302,18 +906,72 @@ static int Int2Int_contains(Int2Int_t *self, PyObject *key) {
         return -1;
     }
 
-    return int2int_has(self->hashmap, c_key) == -1 ? 0 : 1;
+    switch (Int2Int_lookup(self, c_key, &c_value)) {
+    case -2:
+        return -1;
+    case -1:
+        return 0;
+    default:
+        return 1;
+    }
+}
+
+/* Set of the key failed, table of fixed size is full or memory can't be
+   allocated */
+static void Int2Int_set_error(Int2Int_t *self, const int res) {
+    if (-2 == res) {
+        PyErr_SetString(PyExc_RuntimeError,
+                "Instance has no free slots, deleted keys keep their slots "
+                "until clear()");
+    }
+    else if (-3 == res) {
+        PyErr_SetString(PyExc_RuntimeError,
+                "Key is locked by a writer which crashed");
+    }
+    else if (-4 == res) {
+        PyErr_SetString(PyExc_OverflowError,
+                "Value of the key would be out of range of size_t");
+    }
+    else if (INT2INT_IS_FIXED_SIZE(self->hashmap)) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is full");
+    }
+    else {
+        PyErr_NoMemory();
+    }
+}
+
+/* Table must not be changed or moved while it is used without the GIL */
+static int Int2Int_check_exports(Int2Int_t *self) {
+    if (self->exports > 0) {
+        PyErr_SetString(PyExc_BufferError,
+                "Existing exports of data: object cannot be changed");
+        return -1;
+    }
+    return 0;
+}
+
+/* Deletion may drop load of the table under its shrink_load */
+static void Int2Int_shrink(Int2Int_t *self) {
+    Int2IntHashTable_t *new_hashmap;
+
+    /* Failure is not an error, the table only keeps its memory */
+    int2int_shrink(self->hashmap, &new_hashmap);
+    self->hashmap = new_hashmap;
 }
 
 static int Int2Int_setitem(Int2Int_t *self, PyObject *key, PyObject *value) {
     unsigned long long c_key;
     size_t c_value;
     Int2IntHashTable_t * new_hashmap;
+    int res;
 
     if (self->hashmap->readonly) {
         PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
         return -1;
     }
+    if (Int2Int_check_exports(self)) {
+        return -1;
+    }
     if (!PyLong_Check(key)) {
         PyErr_SetString(PyExc_TypeError, "'key' must be an integer");
         return -1;
@@ -330,6 +988,7 @@ static int Int2Int_setitem(Int2Int_t *self, PyObject *key, PyObject *value) {
             PyErr_SetObject(PyExc_KeyError, key);
             return -1;
         }
+        Int2Int_shrink(self);
     }
     else {
         /* Set new or update existing item */
@@ -342,14 +1001,13 @@ static int Int2Int_setitem(Int2Int_t *self, PyObject *key, PyObject *value) {
             return -1;
         }
 
-        if (int2int_set(self->hashmap, c_key, c_value, &new_hashmap)) {
-            PyErr_NoMemory();
+        if ((res = int2int_set(self->hashmap, c_key, c_value,
+                &new_hashmap))) {
+            Int2Int_set_error(self, res);
             return -1;
         }
         if (new_hashmap != self->hashmap) {
             self->hashmap = new_hashmap;
-            self->table = (Int2IntItem_t*) (
-                    (char*) new_hashmap + sizeof(Int2IntHashTable_t));
         }
     }
 
@@ -360,6 +1018,7 @@ static PyObject* Int2Int_getitem(Int2Int_t *self, PyObject *key) {
     unsigned long long c_key;
     size_t c_value;
     Int2IntHashTable_t * new_hashmap;
+    int res;
 
     if (!PyLong_Check(key)) {
         PyErr_SetString(PyExc_TypeError, "'key' must be an integer");
@@ -370,20 +1029,25 @@ static PyObject* Int2Int_getitem(Int2Int_t *self, PyObject *key) {
         return NULL;
     }
 
-    if (int2int_get(self->hashmap, c_key, &c_value) == -1) {
+    if ((res = Int2Int_lookup(self, c_key, &c_value)) == -2) {
+        return NULL;
+    }
+    if (res == -1) {
         if (self->default_value != Py_None) {
+            if (Int2Int_check_exports(self)) {
+                return NULL;
+            }
             c_value = PyLong_AsSize_t(self->default_value);
             if ((c_value == (size_t) -1) && (NULL != PyErr_Occurred())) {
                 return NULL;
             }
-            if (int2int_set(self->hashmap, c_key, c_value, &new_hashmap)) {
-                PyErr_NoMemory();
+            if ((res = int2int_set(self->hashmap, c_key, c_value,
+                    &new_hashmap))) {
+                Int2Int_set_error(self, res);
                 return NULL;
             }
             if (new_hashmap != self->hashmap) {
                 self->hashmap = new_hashmap;
-                self->table = (Int2IntItem_t*) (
-                        (char*) new_hashmap + sizeof(Int2IntHashTable_t));
             }
             Py_INCREF(self->default_value);
             return self->default_value;
@@ -411,6 +1075,7 @@ static PyObject* Int2Int_get(Int2Int_t *self, PyObject *args, PyObject *kwds) {
     PyObject * default_value = Py_None;
     unsigned long long c_key;
     size_t value;
+    int res;
 
     if (!PyArg_ParseTuple(args, "O|O", &key, &default_value)) {
         return NULL;
@@ -425,7 +1090,10 @@ static PyObject* Int2Int_get(Int2Int_t *self, PyObject *args, PyObject *kwds) {
         return NULL;
     }
 
-    if (int2int_get(self->hashmap, c_key, &value) == -1) {
+    if ((res = Int2Int_lookup(self, c_key, &value)) == -2) {
+        return NULL;
+    }
+    if (res == -1) {
         if (default_value != Py_None) {
             if (!PyLong_Check(default_value)) {
                 PyErr_SetString(PyExc_TypeError,
@@ -445,11 +1113,120 @@ static PyObject* Int2Int_get(Int2Int_t *self, PyObject *args, PyObject *kwds) {
     return PyLong_FromSize_t(value);
 }
 
-static PyObject* Int2Int_keys(Int2Int_t *self) {
-    HashmapIterator_t *iterator = PyObject_New(
-            HashmapIterator_t, &Int2IntIterator_type);
-    if (iterator != NULL) {
-        Py_INCREF(self);
+static PyObject* Int2Int_get_many(Int2Int_t *self,
+        PyObject *args, PyObject *kwds) {
+
+    char *kwnames[] = {"keys", "out", "found", "default", NULL};
+    PyObject *keys_obj;
+    PyObject *out_obj = Py_None;
+    PyObject *found_obj = Py_None;
+    PyObject *default_value = NULL;
+    Py_buffer keys = {NULL};
+    Py_buffer out = {NULL};
+    Py_buffer found = {NULL};
+    const unsigned long long *c_keys;
+    size_t *c_values;
+    size_t c_default = 0;
+    Py_ssize_t n;
+    size_t count;
+    PyObject *res = NULL;
+
+    /* Parse arguments */
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O$OO", kwnames,
+            &keys_obj, &out_obj, &found_obj, &default_value)) {
+        return NULL;
+    }
+    if (get_typed_buffer(keys_obj, &keys, PyBUF_SIMPLE, UINT64_FORMATS,
+            sizeof(unsigned long long), "keys", "uint64")) {
+        return NULL;
+    }
+    n = keys.len / keys.itemsize;
+
+    /* default argument */
+    if (Py_None == default_value) {
+        default_value = NULL;
+    }
+    if (NULL != default_value) {
+        if (!PyLong_Check(default_value)) {
+            PyErr_SetString(PyExc_TypeError,
+                    "'default' must be positive int");
+            goto error;
+        }
+        c_default = PyLong_AsSize_t(default_value);
+        if ((c_default == (size_t) -1) && (PyErr_Occurred() != NULL)) {
+            goto error;
+        }
+    }
+
+    /* Result buffers */
+    if (Py_None == out_obj) {
+        if (NULL == (out_obj = new_array(SIZE_T_TYPECODE, n))) {
+            goto error;
+        }
+    }
+    else {
+        Py_INCREF(out_obj);
+    }
+    if (get_result_buffer(out_obj, &out, n, "'keys'", SIZE_T_FORMATS,
+            sizeof(size_t), "out", "size_t")) {
+        goto error;
+    }
+    if ((Py_None != found_obj) && get_result_buffer(found_obj, &found, n,
+            "'keys'", BOOL_FORMATS, sizeof(bool), "found", "bool")) {
+        goto error;
+    }
+
+    /* Look up keys without the GIL */
+    c_keys = (const unsigned long long*) keys.buf;
+    c_values = (size_t*) out.buf;
+    self->exports += 1;
+    Py_BEGIN_ALLOW_THREADS
+    if (NULL != default_value) {
+        for (Py_ssize_t i=0; i<n; ++i) {
+            c_values[i] = c_default;
+        }
+    }
+    count = int2int_get_many_consistent(self->hashmap, c_keys, (size_t) n,
+            c_values, (bool*) found.buf);
+    Py_END_ALLOW_THREADS
+    self->exports -= 1;
+    if (SIZE_MAX == count) {
+        PyErr_SetString(PyExc_RuntimeError,
+                "Table is being modified by the writer");
+        goto error;
+    }
+
+    /* Missing key is an error if caller can't recognize it */
+    if ((count < (size_t) n) && (NULL == default_value)
+            && (Py_None == found_obj)) {
+        for (Py_ssize_t i=0; i<n; ++i) {
+            switch (Int2Int_lookup(self, c_keys[i], &c_default)) {
+            case -2:
+                goto error;
+            case -1:
+                PyErr_Format(PyExc_KeyError, "%llu", c_keys[i]);
+                goto error;
+            }
+        }
+    }
+
+    res = out_obj;
+    out_obj = NULL;
+
+error:
+    PyBuffer_Release(&found);
+    PyBuffer_Release(&out);
+    PyBuffer_Release(&keys);
+    Py_XDECREF(out_obj);
+
+    return res;
+}
+
+static PyObject* Int2Int_keys(Int2Int_t *self) {
+    HashmapIterator_t *iterator = PyObject_New(
+            HashmapIterator_t, &Int2IntIterator_type);
+    if (iterator != NULL) {
+        Py_INCREF(self);
         iterator->iterator_type = KEYS;
         iterator->current_position = 0;
         iterator->obj = (PyObject*) self;
@@ -481,12 +1258,144 @@ static PyObject* Int2Int_items(Int2Int_t *self) {
     return (PyObject*) iterator;
 }
 
+/* Copy items into buffers of keys and values. Buffer which is None is
+   created as new array, NULL buffer is not wanted. Results are new
+   references. */
+static int Int2Int_export(Int2Int_t *self,
+        PyObject *keys_obj, const char * const keys_name,
+        PyObject *values_obj, const char * const values_name,
+        PyObject **keys_res, PyObject **values_res) {
+
+    Py_buffer keys = {NULL};
+    Py_buffer values = {NULL};
+    Py_ssize_t n = (Py_ssize_t) self->hashmap->current_size;
+
+    *keys_res = NULL;
+    *values_res = NULL;
+    if (NULL != keys_obj) {
+        if (Py_None == keys_obj) {
+            keys_obj = new_array("Q", n);
+        }
+        else {
+            Py_INCREF(keys_obj);
+        }
+        if (NULL == (*keys_res = keys_obj)) {
+            goto error;
+        }
+        if (get_result_buffer(keys_obj, &keys, n, "the mapping",
+                UINT64_FORMATS, sizeof(unsigned long long), keys_name,
+                "uint64")) {
+            goto error;
+        }
+    }
+    if (NULL != values_obj) {
+        if (Py_None == values_obj) {
+            values_obj = new_array(SIZE_T_TYPECODE, n);
+        }
+        else {
+            Py_INCREF(values_obj);
+        }
+        if (NULL == (*values_res = values_obj)) {
+            goto error;
+        }
+        if (get_result_buffer(values_obj, &values, n, "the mapping",
+                SIZE_T_FORMATS, sizeof(size_t), values_name, "size_t")) {
+            goto error;
+        }
+    }
+
+    /* Copy items without the GIL */
+    self->exports += 1;
+    Py_BEGIN_ALLOW_THREADS
+    int2int_export(self->hashmap, (unsigned long long*) keys.buf,
+            (size_t*) values.buf);
+    Py_END_ALLOW_THREADS
+    self->exports -= 1;
+
+    PyBuffer_Release(&values);
+    PyBuffer_Release(&keys);
+
+    return 0;
+
+error:
+    PyBuffer_Release(&values);
+    PyBuffer_Release(&keys);
+    Py_CLEAR(*keys_res);
+    Py_CLEAR(*values_res);
+
+    return -1;
+}
+
+static PyObject* Int2Int_keys_array(Int2Int_t *self,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"out", NULL};
+    PyObject *out = Py_None;
+    PyObject *keys;
+    PyObject *values;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kwnames, &out)) {
+        return NULL;
+    }
+    if (Int2Int_export(self, out, "out", NULL, NULL, &keys, &values)) {
+        return NULL;
+    }
+    return keys;
+}
+
+static PyObject* Int2Int_values_array(Int2Int_t *self,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"out", NULL};
+    PyObject *out = Py_None;
+    PyObject *keys;
+    PyObject *values;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kwnames, &out)) {
+        return NULL;
+    }
+    if (Int2Int_export(self, NULL, NULL, out, "out", &keys, &values)) {
+        return NULL;
+    }
+    return values;
+}
+
+static PyObject* Int2Int_items_arrays(Int2Int_t *self,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"keys_out", "values_out", NULL};
+    PyObject *keys_out = Py_None;
+    PyObject *values_out = Py_None;
+    PyObject *keys;
+    PyObject *values;
+    PyObject *res;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|OO", kwnames,
+            &keys_out, &values_out)) {
+        return NULL;
+    }
+    if (Int2Int_export(self, keys_out, "keys_out", values_out, "values_out",
+            &keys, &values)) {
+        return NULL;
+    }
+    res = PyTuple_Pack(2, keys, values);
+    Py_DECREF(keys);
+    Py_DECREF(values);
+
+    return res;
+}
+
 static PyObject* Int2Int_pop(Int2Int_t *self, PyObject *args) {
     PyObject * key;
     PyObject * default_value = NULL;
     unsigned long long c_key;
     size_t value;
 
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Int_check_exports(self)) {
+        return NULL;
+    }
+
     if (!PyArg_ParseTuple(args, "O|O", &key, &default_value)) {
         return NULL;
     }
@@ -520,35 +1429,42 @@ static PyObject* Int2Int_pop(Int2Int_t *self, PyObject *args) {
     }
 
     int2int_del(self->hashmap, c_key);
+    Int2Int_shrink(self);
     return PyLong_FromSize_t(value);
 }
 
 static PyObject* Int2Int_popitem(Int2Int_t *self) {
-    Int2IntItem_t * item;
+    size_t position = 0;
+    unsigned long long item_key;
+    size_t *item_value;
     PyObject * res = NULL;
     PyObject * key = NULL;
     PyObject * value = NULL;
 
-    for (size_t i=0; i<self->hashmap->table_size; ++i) {
-        item = &(self->table[i]);
-        if (USED == item->status) {
-            if (NULL == (key = PyLong_FromUnsignedLongLong(item->key))) {
-                goto error;
-            }
-            if (NULL == (value = PyLong_FromSize_t(item->value))) {
-                goto error;
-            }
-            if (NULL == (res = PyTuple_New(2))) {
-                goto error;
-            }
-            PyTuple_SET_ITEM(res, 0, key);
-            PyTuple_SET_ITEM(res, 1, value);
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Int_check_exports(self)) {
+        return NULL;
+    }
+    if (0 == int2int_next(self->hashmap, &position, &item_key, &item_value)) {
+        if (NULL == (key = PyLong_FromUnsignedLongLong(item_key))) {
+            goto error;
+        }
+        if (NULL == (value = PyLong_FromSize_t(*item_value))) {
+            goto error;
+        }
+        if (NULL == (res = PyTuple_New(2))) {
+            goto error;
+        }
+        PyTuple_SET_ITEM(res, 0, key);
+        PyTuple_SET_ITEM(res, 1, value);
 
-            item->status = DELETED;
-            self->hashmap->current_size -= 1;
+        int2int_del(self->hashmap, item_key);
+        Int2Int_shrink(self);
 
-            return res;
-        }
+        return res;
     }
     PyErr_SetString(PyExc_KeyError, "popitem(): mapping is empty");
 
@@ -561,10 +1477,38 @@ error:
 }
 
 static PyObject* Int2Int_clear(Int2Int_t *self) {
-    for (size_t i=0; i<self->hashmap->table_size; ++i) {
-        self->table[i].status = EMPTY;
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Int_check_exports(self)) {
+        return NULL;
+    }
+
+    int2int_clear(self->hashmap);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject* Int2Int_shrink_to_fit(Int2Int_t *self) {
+    Int2IntHashTable_t *new_hashmap;
+
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Int_check_exports(self)) {
+        return NULL;
+    }
+    if (INT2INT_IS_FIXED_SIZE(self->hashmap)) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance has fixed size");
+        return NULL;
     }
-    self->hashmap->current_size = 0;
+    if (int2int_compact(self->hashmap, &new_hashmap)) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    self->hashmap = new_hashmap;
 
     Py_RETURN_NONE;
 }
@@ -654,6 +1598,218 @@ static PyObject* Int2Int_update(Int2Int_t *self, PyObject *args) {
     Py_RETURN_NONE;
 }
 
+static PyObject* Int2Int_update_from_buffers(Int2Int_t *self, PyObject *args) {
+    PyObject *keys_obj;
+    PyObject *values_obj = Py_None;
+    Py_buffer keys = {NULL};
+    Py_buffer values = {NULL};
+    Int2IntHashTable_t *new_hashmap;
+    Py_ssize_t n;
+    int res;
+
+    if (!PyArg_ParseTuple(args, "O|O", &keys_obj, &values_obj)) {
+        return NULL;
+    }
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Int_check_exports(self)) {
+        return NULL;
+    }
+    if (get_typed_buffer(keys_obj, &keys, PyBUF_SIMPLE, UINT64_FORMATS,
+            sizeof(unsigned long long), "keys", "uint64")) {
+        return NULL;
+    }
+    n = keys.len / keys.itemsize;
+    /* Key gets its position in keys if values are not specified */
+    if (Py_None != values_obj) {
+        if (get_typed_buffer(values_obj, &values, PyBUF_SIMPLE,
+                SIZE_T_FORMATS, sizeof(size_t), "values", "size_t")) {
+            PyBuffer_Release(&keys);
+            return NULL;
+        }
+        if (values.len / values.itemsize != n) {
+            PyErr_SetString(PyExc_ValueError,
+                    "'values' must have the same length as 'keys'");
+            PyBuffer_Release(&values);
+            PyBuffer_Release(&keys);
+            return NULL;
+        }
+    }
+
+    res = int2int_set_many(self->hashmap, (const unsigned long long*) keys.buf,
+            (const size_t*) values.buf, (size_t) n, &new_hashmap, NULL);
+    self->hashmap = new_hashmap;
+    PyBuffer_Release(&values);
+    PyBuffer_Release(&keys);
+    if (res) {
+        Int2Int_set_error(self, res);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject* Int2Int_add(Int2Int_t *self, PyObject *args) {
+    PyObject *key;
+    PyObject *delta;
+    unsigned long long c_key;
+    long long c_signed_delta;
+    size_t c_delta;
+    size_t c_value;
+    Int2IntHashTable_t *new_hashmap;
+    bool subtract = false;
+    int overflow;
+    int res;
+
+    if (!PyArg_ParseTuple(args, "OO", &key, &delta)) {
+        return NULL;
+    }
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Int_check_exports(self)) {
+        return NULL;
+    }
+    if (!PyLong_Check(key)) {
+        PyErr_SetString(PyExc_TypeError, "'key' must be an integer");
+        return NULL;
+    }
+    c_key = PyLong_AsUnsignedLongLong(key);
+    if ((c_key == (unsigned long long) -1) && (PyErr_Occurred() != NULL)) {
+        return NULL;
+    }
+    if (!PyLong_Check(delta)) {
+        PyErr_SetString(PyExc_TypeError, "'delta' must be an integer");
+        return NULL;
+    }
+    /* Negative delta is subtracted, result below 0 is an error */
+    c_signed_delta = PyLong_AsLongLongAndOverflow(delta, &overflow);
+    if (overflow > 0) {
+        c_delta = PyLong_AsSize_t(delta);
+        if ((c_delta == (size_t) -1) && (PyErr_Occurred() != NULL)) {
+            return NULL;
+        }
+    }
+    else if (overflow < 0) {
+        PyErr_SetString(PyExc_OverflowError, "'delta' is too small");
+        return NULL;
+    }
+    else if ((c_signed_delta == -1) && (PyErr_Occurred() != NULL)) {
+        return NULL;
+    }
+    else if (c_signed_delta < 0) {
+        c_delta = (size_t) 0 - (size_t) c_signed_delta;
+        subtract = true;
+    }
+    else {
+        c_delta = (size_t) c_signed_delta;
+    }
+
+    if (subtract) {
+        res = int2int_sub(self->hashmap, c_key, c_delta, &c_value,
+                &new_hashmap);
+    }
+    else {
+        res = int2int_add(self->hashmap, c_key, c_delta, &c_value,
+                &new_hashmap);
+    }
+    self->hashmap = new_hashmap;
+    if (res) {
+        Int2Int_set_error(self, res);
+        return NULL;
+    }
+
+    return PyLong_FromSize_t(c_value);
+}
+
+static PyObject* Int2Int_add_many(Int2Int_t *self, PyObject *args) {
+    PyObject *keys_obj;
+    PyObject *deltas_obj;
+    Py_buffer keys = {NULL};
+    Py_buffer deltas = {NULL};
+    Int2IntHashTable_t *new_hashmap;
+    const char *format;
+    Py_ssize_t n;
+    int res;
+
+    if (!PyArg_ParseTuple(args, "OO", &keys_obj, &deltas_obj)) {
+        return NULL;
+    }
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Int_check_exports(self)) {
+        return NULL;
+    }
+    if (get_typed_buffer(keys_obj, &keys, PyBUF_SIMPLE, UINT64_FORMATS,
+            sizeof(unsigned long long), "keys", "uint64")) {
+        return NULL;
+    }
+    n = keys.len / keys.itemsize;
+    if (get_typed_buffer(deltas_obj, &deltas, PyBUF_SIMPLE,
+            DELTA_FORMATS, sizeof(size_t), "deltas", "size_t or ssize_t")) {
+        PyBuffer_Release(&keys);
+        return NULL;
+    }
+    if (deltas.len / deltas.itemsize != n) {
+        PyErr_SetString(PyExc_ValueError,
+                "'deltas' must have the same length as 'keys'");
+        PyBuffer_Release(&deltas);
+        PyBuffer_Release(&keys);
+        return NULL;
+    }
+
+    /* Format was checked, its type character is the last one */
+    format = deltas.format;
+    if (NULL != strchr(SIGNED_DELTA_FORMATS, format[strlen(format) - 1])) {
+        res = int2int_add_many_signed(self->hashmap,
+                (const unsigned long long*) keys.buf,
+                (const ptrdiff_t*) deltas.buf, (size_t) n, &new_hashmap);
+    }
+    else {
+        res = int2int_add_many(self->hashmap,
+                (const unsigned long long*) keys.buf,
+                (const size_t*) deltas.buf, (size_t) n, &new_hashmap);
+    }
+    self->hashmap = new_hashmap;
+    PyBuffer_Release(&deltas);
+    PyBuffer_Release(&keys);
+    if (res) {
+        Int2Int_set_error(self, res);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject* Int2Int_from_arrays(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    PyObject *empty_args;
+    PyObject *self;
+    PyObject *res;
+
+    if (NULL == (empty_args = PyTuple_New(0))) {
+        return NULL;
+    }
+    self = PyObject_Call((PyObject*) cls, empty_args, kwds);
+    Py_DECREF(empty_args);
+    if (NULL == self) {
+        return NULL;
+    }
+    res = Int2Int_update_from_buffers((Int2Int_t*) self, args);
+    if (NULL == res) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    Py_DECREF(res);
+
+    return self;
+}
+
 static PyObject* Int2Int_setdefault(Int2Int_t *self, PyObject *args) {
     PyObject * key;
     PyObject * default_value = NULL;
@@ -684,17 +1840,70 @@ static PyObject* Int2Int_setdefault(Int2Int_t *self, PyObject *args) {
     return PyLong_FromSize_t(c_value);
 }
 
-static PyObject* Int2Int_reduce(Int2Int_t *self) {
+/* Validate header of the table in memory of len bytes and bounds of the
+   table, sets exception if the table can't be used */
+static int Int2Int_check_table(const Int2IntHashTable_t * const hashmap,
+        const size_t len) {
+    size_t expected_table_size;
+
+    if (0 != ((uintptr_t) hashmap % sizeof(double))) {
+        PyErr_SetString(PyExc_ValueError, "Buffer is not aligned");
+        return -1;
+    }
+    if ((len < HASHMAP_LEGACY_HEADER_SIZE)
+            || ((HASHMAP_VERSION == hashmap->version)
+                    && (len < sizeof(Int2IntHashTable_t)))) {
+        PyErr_SetString(PyExc_ValueError, "Buffer is too small");
+        return -1;
+    }
+    if (((HASHMAP_LEGACY_VERSION != hashmap->version)
+                    && (HASHMAP_VERSION != hashmap->version))
+            || (hashmap->layout > HASHMAP_LAYOUT_CONCURRENT)
+            || ((HASHMAP_LEGACY_VERSION == hashmap->version)
+                    && !hashmap->readonly)
+            || (hashmap->flags & HASHMAP_FLAG_MIGRATING)
+            || !((int2int_max_load(hashmap) > 0.0)
+                    && (int2int_max_load(hashmap) <= 1.0))
+            || (hashmap->current_size > hashmap->size)
+            || (hashmap->size > hashmap->table_size)) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the table");
+        return -1;
+    }
+    if (HASHMAP_VERSION == hashmap->version) {
+        expected_table_size = int2int_layout_table_size(hashmap->size,
+                hashmap->layout, int2int_max_load(hashmap));
+        if ((HASHMAP_LAYOUT_CUCKOO == hashmap->layout)
+                ? (!hashmap->readonly
+                        || (hashmap->table_size < expected_table_size)
+                        || (0 != (hashmap->table_size
+                                & (hashmap->table_size - 1))))
+                : (hashmap->table_size != expected_table_size)) {
+            PyErr_SetString(PyExc_ValueError,
+                    "Unsupported format of the table");
+            return -1;
+        }
+    }
+    if (len < int2int_buffer_size(hashmap)) {
+        PyErr_SetString(PyExc_ValueError, "Table exceeds the buffer");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Return reduced value with data of the table (stolen reference), block
+   tells whether data hold the whole memory block including the header */
+static PyObject* Int2Int_reduce_data(Int2Int_t *self, PyObject *data,
+        const bool block) {
     PyObject *res = NULL;
     PyObject *args = NULL;
     PyObject *callable = NULL;
     PyObject *readonly;
-    PyObject *data;
 
     if (NULL == (res = PyTuple_New(2))) {
         goto error;
     }
-    if (NULL == (args = PyTuple_New(6))) {
+    if (NULL == (args = PyTuple_New(block ? 14 : 13))) {
         goto error;
     }
     if (NULL == (callable = PyObject_GetAttrString(
@@ -703,11 +1912,6 @@ static PyObject* Int2Int_reduce(Int2Int_t *self) {
     }
 
     readonly = self->hashmap->readonly ? Py_True : Py_False;
-    if (NULL == (data = PyBytes_FromStringAndSize(
-            (const char *) self->table,
-            self->hashmap->table_size * sizeof(Int2IntItem_t)))) {
-        goto error;
-    }
 
     Py_INCREF(self->default_value);
     Py_INCREF(readonly);
@@ -718,6 +1922,20 @@ static PyObject* Int2Int_reduce(Int2Int_t *self) {
     PyTuple_SET_ITEM(args, 3, PyLong_FromSize_t(self->hashmap->table_size));
     PyTuple_SET_ITEM(args, 4, readonly);
     PyTuple_SET_ITEM(args, 5, data);
+    PyTuple_SET_ITEM(args, 6, PyLong_FromLong(self->hashmap->version));
+    PyTuple_SET_ITEM(args, 7, PyLong_FromLong(self->hashmap->layout));
+    PyTuple_SET_ITEM(args, 8, PyBool_FromLong(self->hashmap->zero_key_used));
+    PyTuple_SET_ITEM(args, 9, PyLong_FromLong(
+            self->hashmap->flags & HASHMAP_FLAG_INCREMENTAL_RESIZE));
+    PyTuple_SET_ITEM(args, 10, PyFloat_FromDouble(
+            int2int_max_load(self->hashmap)));
+    PyTuple_SET_ITEM(args, 11, PyFloat_FromDouble(
+            int2int_growth(self->hashmap)));
+    PyTuple_SET_ITEM(args, 12, PyFloat_FromDouble(
+            int2int_shrink_load(self->hashmap)));
+    if (block) {
+        PyTuple_SET_ITEM(args, 13, PyBool_FromLong(block));
+    }
 
     PyTuple_SET_ITEM(res, 0, callable);
     PyTuple_SET_ITEM(res, 1, args);
@@ -725,6 +1943,7 @@ static PyObject* Int2Int_reduce(Int2Int_t *self) {
     return res;
 
 error:
+    Py_DECREF(data);
     Py_XDECREF(res);
     Py_XDECREF(args);
     Py_XDECREF(callable);
@@ -732,6 +1951,63 @@ error:
     return NULL;
 }
 
+static PyObject* Int2Int_reduce(Int2Int_t *self) {
+    PyObject *data;
+
+    if (self->hashmap->flags & HASHMAP_FLAG_MIGRATING) {
+        /* Memory block must not refer to the previous table */
+        if (Int2Int_check_exports(self)) {
+            return NULL;
+        }
+        int2int_finish_resize(self->hashmap);
+    }
+
+    if (NULL == (data = PyBytes_FromStringAndSize(
+            INT2INT_TABLE(self->hashmap), int2int_buffer_size(self->hashmap)
+                    - INT2INT_HEADER_SIZE(self->hashmap)))) {
+        return NULL;
+    }
+
+    return Int2Int_reduce_data(self, data, false);
+}
+
+static PyObject* Int2Int_reduce_ex(Int2Int_t *self, PyObject *args) {
+    int protocol;
+#if PY_VERSION_HEX >= 0x03080000
+    PyObject *block;
+    PyObject *data;
+#endif
+
+    if (!PyArg_ParseTuple(args, "i", &protocol)) {
+        return NULL;
+    }
+#if PY_VERSION_HEX >= 0x03080000
+    /* Protocol 5 pickles the whole memory block without a copy, pickler
+       with buffer_callback passes it out-of-band */
+    if ((protocol >= 5) && (HASHMAP_VERSION == self->hashmap->version)) {
+        if (self->hashmap->flags & HASHMAP_FLAG_MIGRATING) {
+            if (Int2Int_check_exports(self)) {
+                return NULL;
+            }
+            int2int_finish_resize(self->hashmap);
+        }
+        if (NULL == (block = HashmapBlock_new((PyObject*) self,
+                &self->exports, self->hashmap,
+                int2int_buffer_size(self->hashmap)))) {
+            return NULL;
+        }
+        data = PyPickleBuffer_FromObject(block);
+        Py_DECREF(block);
+        if (NULL == data) {
+            return NULL;
+        }
+        return Int2Int_reduce_data(self, data, true);
+    }
+#endif
+
+    return Int2Int_reduce(self);
+}
+
 static PyObject* Int2Int_from_raw_data(PyTypeObject *cls, PyObject *args) {
     PyObject *default_value = Py_None;
     size_t size;
@@ -739,13 +2015,25 @@ static PyObject* Int2Int_from_raw_data(PyTypeObject *cls, PyObject *args) {
     size_t table_size;
     int readonly;
     Py_buffer buffer = { .obj = NULL };
+    unsigned char version = HASHMAP_LEGACY_VERSION;
+    unsigned char layout = HASHMAP_LAYOUT_ITEMS;
+    int zero_key_used = false;
+    unsigned char flags = 0;
+    double max_load = HASHMAP_DEFAULT_MAX_LOAD;
+    double growth = HASHMAP_DEFAULT_GROWTH;
+    double shrink_load = 0.0;
+    int block = false;
+    size_t table_memory_size;
     size_t int2int_memory_size;
+    Int2IntHashTable_t *hashmap;
     Int2Int_t *self = NULL;
     PyObject *res = NULL;
 
     /* Parse arguments */
-    if (!PyArg_ParseTuple(args, "Onnnpy*", &default_value, &size,
-            &current_size, &table_size, &readonly, &buffer)) {
+    if (!PyArg_ParseTuple(args, "Onnnpy*|bbpbdddp", &default_value, &size,
+            &current_size, &table_size, &readonly, &buffer, &version,
+            &layout, &zero_key_used, &flags, &max_load, &growth,
+            &shrink_load, &block)) {
         goto error;
     }
     /* Validate arguments */
@@ -756,36 +2044,126 @@ static PyObject* Int2Int_from_raw_data(PyTypeObject *cls, PyObject *args) {
         PyErr_SetString(PyExc_TypeError, "'default' must be positive int");
         goto error;
     }
+    if (((HASHMAP_LEGACY_VERSION != version) && (HASHMAP_VERSION != version))
+            || !((max_load > 0.0) && (max_load <= 1.0)) || !(growth > 1.0)
+            || !((shrink_load >= 0.0) && (shrink_load < 1.0))
+            || (0 == int2int_layout_table_size(size, layout, max_load))
+            || ((HASHMAP_LEGACY_VERSION == version)
+                    && ((HASHMAP_LAYOUT_ITEMS != layout) || block))) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of raw data");
+        goto error;
+    }
+    int2int_memory_size = int2int_layout_memory_size(table_size, layout);
+    table_memory_size = int2int_memory_size - sizeof(Int2IntHashTable_t);
     if ((size < current_size) || (table_size < size)
-            || ((size_t) buffer.len != (table_size * sizeof(Int2IntItem_t)))) {
+            || ((size_t) buffer.len != (block
+                    ? int2int_memory_size : table_memory_size))) {
         PyErr_SetString(PyExc_ValueError, "Inconsistent argument's values");
         goto error;
     }
+    if ((HASHMAP_VERSION == version) && (HASHMAP_LAYOUT_CUCKOO != layout)
+            && (table_size != int2int_layout_table_size(size, layout,
+                    max_load))) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of raw data");
+        goto error;
+    }
+    /* Cuckoo table may be bigger when the build was repeated, it can not
+       be modified */
+    if ((HASHMAP_LAYOUT_CUCKOO == layout)
+            && (!readonly || (0 != (table_size & (table_size - 1)))
+                    || (table_size < int2int_layout_table_size(size, layout,
+                            max_load)))) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of raw data");
+        goto error;
+    }
 
     /* Create instance */
     if (NULL == (self = (Int2Int_t*) cls->tp_alloc(cls, 0))) {
         goto error;
     }
 
+    /* Read-only table in the received memory block is used in place, the
+       instance holds the buffer */
+    if (block && readonly
+            && (0 == ((uintptr_t) buffer.buf % sizeof(double)))) {
+        hashmap = (Int2IntHashTable_t*) buffer.buf;
+        if (Int2Int_check_table(hashmap, (size_t) buffer.len)) {
+            goto error;
+        }
+        if (!hashmap->readonly || (hashmap->size != size)
+                || (hashmap->current_size != current_size)
+                || (hashmap->table_size != table_size)
+                || (hashmap->layout != layout)) {
+            PyErr_SetString(PyExc_ValueError,
+                    "Inconsistent argument's values");
+            goto error;
+        }
+        self->hashmap = hashmap;
+        self->memory = buffer;
+        buffer.obj = NULL;
+        self->default_value = default_value;
+        Py_INCREF(self->default_value);
+        res = (PyObject*) self;
+        goto cleanup;
+    }
+
     /* Allocate memory for Int2IntHashTable_t structure and hashtable. At
        the beginning of block of the memory Int2IntHashTable_t structure
        is placed, followed by hashtable (array of Int2IntItem_t). */
-    int2int_memory_size = INT2INT_MEMORY_SIZE(table_size);
-    if (NULL == (self->hashmap = malloc(int2int_memory_size))) {
-        PyErr_NoMemory();
-        goto error;
+    if (HASHMAP_LEGACY_VERSION == version) {
+        /* Legacy table has different hash, so items are inserted again */
+        Int2IntItem_t *items = (Int2IntItem_t*) buffer.buf;
+
+        if (int2int_new_ex(size, HASHMAP_LAYOUT_ITEMS, max_load, growth,
+                &self->hashmap)) {
+            PyErr_NoMemory();
+            goto error;
+        }
+        for (size_t i=0; i<table_size; ++i) {
+            if (USED == items[i].status) {
+                if (int2int_set(self->hashmap, items[i].key,
+                        items[i].value, NULL)) {
+                    free(self->hashmap);
+                    PyErr_NoMemory();
+                    goto error;
+                }
+            }
+        }
+    }
+    else {
+        if (NULL == (self->hashmap = malloc(int2int_memory_size))) {
+            PyErr_NoMemory();
+            goto error;
+        }
+        memset(self->hashmap, 0, int2int_memory_size);
+        self->hashmap->size = size;
+        self->hashmap->current_size = current_size;
+        self->hashmap->table_size = table_size;
+        self->hashmap->version = version;
+        self->hashmap->layout = layout;
+        self->hashmap->zero_key_used = zero_key_used;
+        self->hashmap->max_load = max_load;
+        self->hashmap->growth = growth;
+        memcpy((char *) self->hashmap + sizeof(Int2IntHashTable_t),
+                (char *) buffer.buf
+                        + (block ? sizeof(Int2IntHashTable_t) : 0),
+                table_memory_size);
+        if (HASHMAP_LAYOUT_CONCURRENT == layout) {
+            /* Raw data has no header, claimed items keep their keys */
+            Int2IntItem_t *items =
+                    (Int2IntItem_t*) INT2INT_TABLE(self->hashmap);
+
+            for (size_t i=0; i<table_size; ++i) {
+                self->hashmap->claimed += (0 != items[i].key);
+            }
+        }
     }
-    memset(self->hashmap, 0, int2int_memory_size);
 
+    self->hashmap->flags = flags & HASHMAP_FLAG_INCREMENTAL_RESIZE;
+    self->hashmap->shrink_load = shrink_load;
     self->release_memory = true;
     self->default_value = default_value;
-    self->hashmap->size = size;
-    self->hashmap->current_size = current_size;
-    self->hashmap->table_size = table_size;
     self->hashmap->readonly = readonly;
-    self->table = (Int2IntItem_t*) (
-            (char*) self->hashmap + sizeof(Int2IntHashTable_t));
-    memcpy((void *) self->table, buffer.buf, buffer.len);
 
     Py_INCREF(self->default_value);
     res = (PyObject*) self;
@@ -820,61 +2198,697 @@ static PyObject* Int2Int_from_ptr(PyTypeObject *cls, PyObject *args) {
     self->default_value = Py_None;
     self->release_memory = false;
     self->hashmap = (Int2IntHashTable_t*) addr;
-    self->table = (Int2IntItem_t*) (
-            (char*) self->hashmap + sizeof(Int2IntHashTable_t));
 
     Py_INCREF(self->default_value);
     return (PyObject*) self;
 }
 
-static PyObject* Int2Int_make_readonly(Int2Int_t *self) {
-    self->hashmap->readonly = true;
+/* Size of the memory block of the table for capacity items, sets
+   exception if arguments are not valid */
+static int Int2Int_fixed_memory_size(const Py_ssize_t capacity,
+        const char * const layout_name, const double max_load,
+        HashmapLayout_e * const layout, size_t * const memory_size) {
+    *layout = HASHMAP_LAYOUT_ITEMS;
+    if ((NULL != layout_name) && layout_from_name(layout_name, layout)) {
+        return -1;
+    }
+    if (HASHMAP_LAYOUT_CUCKOO == *layout) {
+        PyErr_SetString(PyExc_ValueError,
+                "Layout 'cuckoo' is created only by freeze()");
+        return -1;
+    }
+    if (!((max_load > 0.0) && (max_load <= 1.0))) {
+        PyErr_SetString(PyExc_ValueError,
+                "'max_load' must be greater than 0 and at most 1");
+        return -1;
+    }
+    if (capacity < 0) {
+        PyErr_SetString(PyExc_ValueError, "'capacity' must not be negative");
+        return -1;
+    }
+    *memory_size = int2int_layout_memory_size(int2int_layout_table_size(
+            (size_t) capacity, *layout, max_load), *layout);
+    if (0 == *memory_size) {
+        PyErr_SetString(PyExc_ValueError, "'capacity' is too big");
+        return -1;
+    }
+
+    return 0;
+}
+
+static PyObject* Int2Int_buffer_size_for(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"capacity", "layout", "max_load", NULL};
+    Py_ssize_t capacity;
+    const char *layout_name = NULL;
+    HashmapLayout_e layout;
+    double max_load = HASHMAP_DEFAULT_MAX_LOAD;
+    size_t memory_size;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "n|$sd", kwnames,
+            &capacity, &layout_name, &max_load)) {
+        return NULL;
+    }
+    if (Int2Int_fixed_memory_size(capacity, layout_name, max_load,
+            &layout, &memory_size)) {
+        return NULL;
+    }
+
+    return PyLong_FromSize_t(memory_size);
+}
+
+static PyObject* Int2Int_create_in(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"buffer", "capacity", "default", "layout",
+            "max_load", "seqlock", NULL};
+    PyObject *buffer;
+    Py_ssize_t capacity;
+    PyObject *default_value = Py_None;
+    const char *layout_name = NULL;
+    HashmapLayout_e layout;
+    double max_load = HASHMAP_DEFAULT_MAX_LOAD;
+    int seqlock = 0;
+    size_t memory_size;
+    Int2Int_t *self;
+
+    /* Parse arguments */
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "On|$Osdp", kwnames,
+            &buffer, &capacity, &default_value, &layout_name, &max_load,
+            &seqlock)) {
+        return NULL;
+    }
+    if (Int2Int_fixed_memory_size(capacity, layout_name, max_load,
+            &layout, &memory_size)) {
+        return NULL;
+    }
+    if (seqlock && (HASHMAP_LAYOUT_CONCURRENT == layout)) {
+        PyErr_SetString(PyExc_ValueError,
+                "Layout 'concurrent' can't be used with seqlock");
+        return NULL;
+    }
+    if ((default_value != Py_None)
+            && (!PyLong_Check(default_value) ||
+                    ((PyLong_AsSize_t(default_value) == (size_t) -1)
+                            && PyErr_Occurred()))) {
+        PyErr_SetString(PyExc_TypeError, "'default' must be positive int");
+        return NULL;
+    }
+
+    /* Create instance, it holds the buffer while it exists */
+    if (NULL == (self = (Int2Int_t*) cls->tp_alloc(cls, 0))) {
+        return NULL;
+    }
+    self->default_value = default_value;
+    Py_INCREF(self->default_value);
+    if (PyObject_GetBuffer(buffer, &self->memory, PyBUF_WRITABLE)) {
+        goto error;
+    }
+    if ((size_t) self->memory.len < memory_size) {
+        PyErr_Format(PyExc_ValueError,
+                "Buffer of %zd bytes is too small, %zu bytes are needed",
+                self->memory.len, memory_size);
+        goto error;
+    }
+    if (int2int_new_in(self->memory.buf, (size_t) self->memory.len,
+            (size_t) capacity, layout, max_load, &self->hashmap)) {
+        PyErr_SetString(PyExc_ValueError, "Buffer is not aligned");
+        goto error;
+    }
+    if (seqlock) {
+        int2int_seqlock(self->hashmap);
+    }
+
+    return (PyObject*) self;
+
+error:
+    Py_DECREF(self);
+    return NULL;
+}
+
+static PyObject* Int2Int_from_buffer(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"buffer", "default", NULL};
+    PyObject *buffer;
+    PyObject *default_value = Py_None;
+    Int2IntHashTable_t *hashmap;
+    Int2Int_t *self;
+
+    /* Parse arguments */
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|$O", kwnames,
+            &buffer, &default_value)) {
+        return NULL;
+    }
+    if ((default_value != Py_None)
+            && (!PyLong_Check(default_value) ||
+                    ((PyLong_AsSize_t(default_value) == (size_t) -1)
+                            && PyErr_Occurred()))) {
+        PyErr_SetString(PyExc_TypeError, "'default' must be positive int");
+        return NULL;
+    }
+
+    /* Create instance, it holds the buffer while it exists */
+    if (NULL == (self = (Int2Int_t*) cls->tp_alloc(cls, 0))) {
+        return NULL;
+    }
+    self->default_value = default_value;
+    Py_INCREF(self->default_value);
+    if (PyObject_GetBuffer(buffer, &self->memory, PyBUF_WRITABLE)) {
+        /* Read-only buffer can hold only read-only table */
+        PyErr_Clear();
+        if (PyObject_GetBuffer(buffer, &self->memory, PyBUF_SIMPLE)) {
+            goto error;
+        }
+    }
+    hashmap = (Int2IntHashTable_t*) self->memory.buf;
+
+    if (Int2Int_check_table(hashmap, (size_t) self->memory.len)) {
+        goto error;
+    }
+    if (self->memory.readonly && !hashmap->readonly) {
+        PyErr_SetString(PyExc_ValueError,
+                "Table in read-only buffer must be read-only");
+        goto error;
+    }
+    if (!hashmap->readonly) {
+        /* Memory of the caller must not be reallocated */
+        hashmap->flags |= HASHMAP_FLAG_FIXED_SIZE;
+    }
+    self->hashmap = hashmap;
+
+    return (PyObject*) self;
+
+error:
+    Py_DECREF(self);
+    return NULL;
+}
+
+static PyObject* Int2Int_save(Int2Int_t *self,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"path", NULL};
+    PyObject *path;
+    HashmapFileHeader_t header;
+    int res;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&", kwnames,
+            PyUnicode_FSDecoder, &path)) {
+        return NULL;
+    }
+    if (self->hashmap->flags & HASHMAP_FLAG_MIGRATING) {
+        /* Items from the previous table are moved into saved one */
+        if (Int2Int_check_exports(self)) {
+            Py_DECREF(path);
+            return NULL;
+        }
+        int2int_finish_resize(self->hashmap);
+    }
+    int2int_file_header(self->hashmap, &header);
+    res = save_table(path, &header, self->hashmap);
+    Py_DECREF(path);
+    if (res) {
+        return NULL;
+    }
+
     Py_RETURN_NONE;
 }
 
-static PyObject* Int2Int_get_readonly(Int2Int_t *self) {
-    if (self->hashmap->readonly) {
-        Py_RETURN_TRUE;
+static PyObject* Int2Int_open(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"path", "mode", "default", "verify", NULL};
+    PyObject *path;
+    const char *mode = "r";
+    PyObject *default_value = Py_None;
+    int verify = false;
+    HashmapFileHeader_t *header;
+    Int2IntHashTable_t *hashmap;
+    Int2Int_t *self = NULL;
+
+    /* Parse arguments */
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|s$Op", kwnames,
+            PyUnicode_FSDecoder, &path, &mode, &default_value, &verify)) {
+        return NULL;
     }
-    else {
-        Py_RETURN_FALSE;
+    if ((default_value != Py_None)
+            && (!PyLong_Check(default_value) ||
+                    ((PyLong_AsSize_t(default_value) == (size_t) -1)
+                            && PyErr_Occurred()))) {
+        PyErr_SetString(PyExc_TypeError, "'default' must be positive int");
+        goto error;
+    }
+
+    /* Create instance, it holds the mapped file while it exists */
+    if (NULL == (self = (Int2Int_t*) cls->tp_alloc(cls, 0))) {
+        goto error;
+    }
+    self->default_value = default_value;
+    Py_INCREF(self->default_value);
+    if (NULL == (hashmap = (Int2IntHashTable_t*) open_table(path, mode,
+            HASHMAP_FILE_INT2INT, verify, &self->memory))) {
+        goto error;
+    }
+    header = (HashmapFileHeader_t*) self->memory.buf;
+    if (Int2Int_check_table(hashmap, (size_t) header->table_bytes)) {
+        goto error;
+    }
+    if ((header->layout != ((HASHMAP_LEGACY_VERSION == hashmap->version)
+                    ? HASHMAP_LAYOUT_ITEMS : hashmap->layout))
+            || (header->size != hashmap->size)
+            || (header->table_size != hashmap->table_size)) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the file");
+        goto error;
+    }
+    if (0 == strcmp(mode, "r")) {
+        /* Only private copy of the first page is modified */
+        hashmap->readonly = true;
+    } else {
+        /* Table is modified in place, saved checksum is no longer valid */
+        header->checksum = 0;
+        if (!hashmap->readonly) {
+            hashmap->flags |= HASHMAP_FLAG_FIXED_SIZE;
+        }
     }
+    self->hashmap = hashmap;
+    Py_DECREF(path);
+
+    return (PyObject*) self;
+
+error:
+    Py_XDECREF(self);
+    Py_DECREF(path);
+    return NULL;
 }
 
-static PyObject* Int2Int_get_buffer_ptr(Int2Int_t *self) {
-    return PyLong_FromVoidPtr(self->hashmap);
+/* Copy up to n used items from position into slots, return their count */
+static size_t Int2Int_next_slots(const Int2IntHashTable_t * const ctx,
+        size_t * const position, Int2IntSlot_t * const slots,
+        const size_t n) {
+    unsigned long long key;
+    size_t *value;
+    size_t count = 0;
+
+    while ((count < n) && (0 == int2int_next(ctx, position, &key, &value))) {
+        slots[count].key = key;
+        slots[count].value = *value;
+        ++count;
+    }
+
+    return count;
 }
 
-static PyObject* Int2Int_get_buffer_size(Int2Int_t *self) {
-    return PyLong_FromSize_t(INT2INT_MEMORY_SIZE(self->hashmap->table_size));
+/* Write header of the stream and of the table followed by key/value slots
+   of used items. Checksum must be written first, so the items are walked
+   through twice. */
+static int Int2Int_dump_pairs(const Int2IntHashTable_t * const ctx,
+        PyObject * const file) {
+    HashmapFileHeader_t header;
+    Int2IntHashTable_t table;
+    Int2IntSlot_t *slots;
+    const size_t chunk = STREAM_CHUNK_SIZE / sizeof(Int2IntSlot_t);
+    unsigned long long checksum;
+    size_t position;
+    size_t count;
+
+    /* Header of the table without pointers, legacy table gets defaults */
+    memset(&table, 0, sizeof(Int2IntHashTable_t));
+    table.size = ctx->size;
+    table.current_size = ctx->current_size;
+    table.table_size = ctx->table_size;
+    table.readonly = ctx->readonly;
+    table.version = HASHMAP_VERSION;
+    if (HASHMAP_LEGACY_VERSION != ctx->version) {
+        table.layout = ctx->layout;
+        table.flags = ctx->flags & HASHMAP_FLAG_INCREMENTAL_RESIZE;
+    }
+    table.max_load = int2int_max_load(ctx);
+    table.growth = int2int_growth(ctx);
+    table.shrink_load = int2int_shrink_load(ctx);
+
+    if (NULL == (slots = malloc(chunk * sizeof(Int2IntSlot_t)))) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    checksum = hashmap_checksum_update(HASHMAP_CHECKSUM_INIT,
+            &table, sizeof(Int2IntHashTable_t));
+    position = 0;
+    while (0 != (count = Int2Int_next_slots(ctx, &position, slots, chunk))) {
+        checksum = hashmap_checksum_update(checksum, slots,
+                count * sizeof(Int2IntSlot_t));
+    }
+    stream_pairs_header(&header, HASHMAP_FILE_INT2INT, table.layout,
+            table.size, table.current_size, table.table_size,
+            sizeof(Int2IntHashTable_t)
+                    + table.current_size * sizeof(Int2IntSlot_t),
+            checksum);
+
+    if (stream_write(file, &header, sizeof(HashmapFileHeader_t))
+            || stream_write(file, &table, sizeof(Int2IntHashTable_t))) {
+        goto error;
+    }
+    position = 0;
+    while (0 != (count = Int2Int_next_slots(ctx, &position, slots, chunk))) {
+        if (stream_write(file, slots, count * sizeof(Int2IntSlot_t))) {
+            goto error;
+        }
+    }
+    free(slots);
+
+    return 0;
+
+error:
+    free(slots);
+    return -1;
 }
 
-static PySequenceMethods Int2Int_sequence_methods = {
-    0,                                                  /* sq_length */
-    0,                                                  /* sq_concat */
-    0,                                                  /* sq_repeat */
-    0,                                                  /* sq_item */
-    0,                                                  /* sq_slice */
-    0,                                                  /* sq_ass_item */
-    0,                                                  /* sq_ass_slice */
-    (objobjproc) Int2Int_contains,                      /* sq_contains */
-    0,                                                  /* sq_inplace_concat */
-    0,                                                  /* sq_inplace_repeat */
-};
+static PyObject* Int2Int_dump(Int2Int_t *self,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"file", "pairs", NULL};
+    PyObject *file;
+    int pairs = false;
+    HashmapFileHeader_t header;
+    int res;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|$p", kwnames,
+            &file, &pairs)) {
+        return NULL;
+    }
+    if (self->hashmap->flags & HASHMAP_FLAG_MIGRATING) {
+        /* Items from the previous table are moved into dumped one */
+        if (Int2Int_check_exports(self)) {
+            return NULL;
+        }
+        int2int_finish_resize(self->hashmap);
+    }
 
-static PyMappingMethods Int2Int_mapping_methods = {
-    (lenfunc) Int2Int_len,                              /* mp_length */
-    (binaryfunc) Int2Int_getitem,                       /* mp_subscript */
-    (objobjargproc) Int2Int_setitem,                    /* mp_ass_subscript */
-};
+    /* Table can't be changed by the file object while it is written */
+    self->exports += 1;
+    if (pairs || (HASHMAP_LEGACY_VERSION == self->hashmap->version)) {
+        /* Legacy block can be attached only read-only, so it is stored
+           as pairs too */
+        res = Int2Int_dump_pairs(self->hashmap, file);
+    } else {
+        int2int_file_header(self->hashmap, &header);
+        res = stream_write(file, &header, sizeof(HashmapFileHeader_t))
+                || stream_write(file, self->hashmap, header.table_bytes);
+    }
+    self->exports -= 1;
+    if (res) {
+        return NULL;
+    }
 
-static PyMethodDef Int2Int_methods[] = {
-    {"get", (PyCFunction) Int2Int_get, METH_VARARGS,
-            "get(self, key, default=None, /)\n"
-            "--\n"
-            "\n"
-            "Return value for key. If key does not exist, return default\n"
-            "value, otherwise return None. default must be int or None."},
+    Py_RETURN_NONE;
+}
+
+/* Read the memory block of the table from the stream, the block is read
+   directly into the new table */
+static Int2IntHashTable_t* Int2Int_load_block(PyObject * const file,
+        const HashmapFileHeader_t * const header) {
+    Int2IntHashTable_t table;
+    Int2IntHashTable_t *hashmap;
+    const size_t head_size = (header->table_bytes
+            < sizeof(Int2IntHashTable_t))
+                    ? header->table_bytes : sizeof(Int2IntHashTable_t);
+    unsigned long long checksum = HASHMAP_CHECKSUM_INIT;
+
+    memset(&table, 0, sizeof(Int2IntHashTable_t));
+    if (stream_readinto(file, &table, head_size, &checksum)) {
+        return NULL;
+    }
+    if (Int2Int_check_table(&table, header->table_bytes)) {
+        return NULL;
+    }
+    if (header->table_bytes != int2int_buffer_size(&table)) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the stream");
+        return NULL;
+    }
+    if (NULL == (hashmap = malloc(header->table_bytes))) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    memcpy(hashmap, &table, head_size);
+    if (stream_readinto(file, (char*) hashmap + head_size,
+            header->table_bytes - head_size, &checksum)) {
+        free(hashmap);
+        return NULL;
+    }
+    if ((0 != header->checksum) && (header->checksum != checksum)) {
+        free(hashmap);
+        PyErr_SetString(PyExc_ValueError, "Checksum of the stream is wrong");
+        return NULL;
+    }
+    if (HASHMAP_LEGACY_VERSION != hashmap->version) {
+        /* Table is owned by the instance now */
+        hashmap->flags &= HASHMAP_FLAG_INCREMENTAL_RESIZE;
+    }
+
+    return hashmap;
+}
+
+/* Rebuild the table from the stream of key/value pairs */
+static Int2IntHashTable_t* Int2Int_load_pairs(PyObject * const file,
+        const HashmapFileHeader_t * const header) {
+    Int2IntHashTable_t table;
+    Int2IntHashTable_t *hashmap = NULL;
+    Int2IntSlot_t *slots = NULL;
+    const size_t chunk = STREAM_CHUNK_SIZE / sizeof(Int2IntSlot_t);
+    unsigned long long checksum = HASHMAP_CHECKSUM_INIT;
+    size_t remaining;
+    size_t count;
+
+    if (header->table_bytes < sizeof(Int2IntHashTable_t)) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the stream");
+        return NULL;
+    }
+    if (stream_readinto(file, &table, sizeof(Int2IntHashTable_t),
+            &checksum)) {
+        return NULL;
+    }
+    if ((HASHMAP_VERSION != table.version)
+            || (table.layout > HASHMAP_LAYOUT_CONCURRENT)
+            || (table.current_size > table.size)
+            || ((header->table_bytes - sizeof(Int2IntHashTable_t))
+                    / sizeof(Int2IntSlot_t) != table.current_size)
+            || ((header->table_bytes - sizeof(Int2IntHashTable_t))
+                    % sizeof(Int2IntSlot_t) != 0)
+            || !((table.max_load > 0.0) && (table.max_load <= 1.0))
+            || !(table.growth > 1.0)
+            || !((table.shrink_load >= 0.0) && (table.shrink_load < 1.0))) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the stream");
+        return NULL;
+    }
+
+    /* Cuckoo table is built by freeze when all items are inserted */
+    if (int2int_new_ex(table.size, (HASHMAP_LAYOUT_CUCKOO == table.layout)
+            ? HASHMAP_LAYOUT_ITEMS : table.layout,
+            table.max_load, table.growth, &hashmap)) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    if (NULL == (slots = malloc(chunk * sizeof(Int2IntSlot_t)))) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    remaining = table.current_size;
+    while (remaining > 0) {
+        count = (remaining < chunk) ? remaining : chunk;
+        if (stream_readinto(file, slots, count * sizeof(Int2IntSlot_t),
+                &checksum)) {
+            goto error;
+        }
+        for (size_t i=0; i<count; ++i) {
+            if (int2int_set(hashmap, slots[i].key, slots[i].value,
+                    &hashmap)) {
+                PyErr_NoMemory();
+                goto error;
+            }
+        }
+        remaining -= count;
+    }
+    free(slots);
+    slots = NULL;
+    if ((0 != header->checksum) && (header->checksum != checksum)) {
+        PyErr_SetString(PyExc_ValueError, "Checksum of the stream is wrong");
+        goto error;
+    }
+    if (hashmap->current_size != table.current_size) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the stream");
+        goto error;
+    }
+    if ((HASHMAP_LAYOUT_CUCKOO == table.layout)
+            && int2int_freeze(hashmap, &hashmap)) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    hashmap->readonly = table.readonly;
+    hashmap->flags |= table.flags & HASHMAP_FLAG_INCREMENTAL_RESIZE;
+    hashmap->shrink_load = table.shrink_load;
+
+    return hashmap;
+
+error:
+    free(slots);
+    free(hashmap);
+    return NULL;
+}
+
+static PyObject* Int2Int_load(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"file", "default", NULL};
+    PyObject *file;
+    PyObject *default_value = Py_None;
+    HashmapFileHeader_t header;
+    Int2IntHashTable_t *hashmap;
+    Int2Int_t *self;
+
+    /* Parse arguments */
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|$O", kwnames,
+            &file, &default_value)) {
+        return NULL;
+    }
+    if ((default_value != Py_None)
+            && (!PyLong_Check(default_value) ||
+                    ((PyLong_AsSize_t(default_value) == (size_t) -1)
+                            && PyErr_Occurred()))) {
+        PyErr_SetString(PyExc_TypeError, "'default' must be positive int");
+        return NULL;
+    }
+
+    /* Read the table */
+    if (stream_read_header(file, &header, HASHMAP_FILE_INT2INT)) {
+        return NULL;
+    }
+    hashmap = (header.flags & HASHMAP_FILE_FLAG_PAIRS)
+            ? Int2Int_load_pairs(file, &header)
+            : Int2Int_load_block(file, &header);
+    if (NULL == hashmap) {
+        return NULL;
+    }
+
+    /* Create instance */
+    if (NULL == (self = (Int2Int_t*) cls->tp_alloc(cls, 0))) {
+        free(hashmap);
+        return NULL;
+    }
+    self->hashmap = hashmap;
+    self->release_memory = true;
+    self->default_value = default_value;
+    Py_INCREF(self->default_value);
+
+    return (PyObject*) self;
+}
+
+static PyObject* Int2Int_make_readonly(Int2Int_t *self) {
+    if (Int2Int_check_exports(self)) {
+        return NULL;
+    }
+    int2int_finish_resize(self->hashmap);
+    self->hashmap->readonly = true;
+    Py_RETURN_NONE;
+}
+
+static PyObject* Int2Int_freeze(Int2Int_t *self) {
+    Int2IntHashTable_t *new_hashmap;
+
+    if (Int2Int_check_exports(self)) {
+        return NULL;
+    }
+    /* Memory which is not owned by the instance can't be replaced */
+    if ((HASHMAP_LAYOUT_CUCKOO != self->hashmap->layout)
+            && (INT2INT_IS_FIXED_SIZE(self->hashmap)
+                    || !self->release_memory)) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance has fixed size");
+        return NULL;
+    }
+    if (int2int_freeze(self->hashmap, &new_hashmap)) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    self->hashmap = new_hashmap;
+
+    Py_RETURN_NONE;
+}
+
+static PyObject* Int2Int_get_readonly(Int2Int_t *self) {
+    if (self->hashmap->readonly) {
+        Py_RETURN_TRUE;
+    }
+    else {
+        Py_RETURN_FALSE;
+    }
+}
+
+static PyObject* Int2Int_get_layout(Int2Int_t *self) {
+    return layout_to_name(self->hashmap->layout);
+}
+
+static PyObject* Int2Int_get_max_load(Int2Int_t *self) {
+    return PyFloat_FromDouble(int2int_max_load(self->hashmap));
+}
+
+static PyObject* Int2Int_get_growth(Int2Int_t *self) {
+    return PyFloat_FromDouble(int2int_growth(self->hashmap));
+}
+
+static PyObject* Int2Int_get_shrink_load(Int2Int_t *self) {
+    return PyFloat_FromDouble(int2int_shrink_load(self->hashmap));
+}
+
+static PyObject* Int2Int_get_buffer_ptr(Int2Int_t *self) {
+    if (self->hashmap->flags & HASHMAP_FLAG_MIGRATING) {
+        /* Pending incremental resize is finished, so the block can be
+           shared */
+        if (Int2Int_check_exports(self)) {
+            return NULL;
+        }
+        int2int_finish_resize(self->hashmap);
+    }
+    return PyLong_FromVoidPtr(self->hashmap);
+}
+
+static PyObject* Int2Int_get_buffer_size(Int2Int_t *self) {
+    return PyLong_FromSize_t(int2int_buffer_size(self->hashmap));
+}
+
+static PySequenceMethods Int2Int_sequence_methods = {
+    0,                                                  /* sq_length */
+    0,                                                  /* sq_concat */
+    0,                                                  /* sq_repeat */
+    0,                                                  /* sq_item */
+    0,                                                  /* sq_slice */
+    0,                                                  /* sq_ass_item */
+    0,                                                  /* sq_ass_slice */
+    (objobjproc) Int2Int_contains,                      /* sq_contains */
+    0,                                                  /* sq_inplace_concat */
+    0,                                                  /* sq_inplace_repeat */
+};
+
+static PyMappingMethods Int2Int_mapping_methods = {
+    (lenfunc) Int2Int_len,                              /* mp_length */
+    (binaryfunc) Int2Int_getitem,                       /* mp_subscript */
+    (objobjargproc) Int2Int_setitem,                    /* mp_ass_subscript */
+};
+
+static PyMethodDef Int2Int_methods[] = {
+    {"get", (PyCFunction) Int2Int_get, METH_VARARGS,
+            "get(self, key, default=None, /)\n"
+            "--\n"
+            "\n"
+            "Return value for key. If key does not exist, return default\n"
+            "value, otherwise return None. default must be int or None."},
+    {"get_many", (PyCFunction) Int2Int_get_many,
+            METH_VARARGS | METH_KEYWORDS,
+            "get_many(self, keys, out=None, *, found=None, default=None)\n"
+            "--\n"
+            "\n"
+            "Look up all keys from buffer of uint64 (e.g. array('Q')) and\n"
+            "return buffer of their values. Values are stored into out,\n"
+            "writable buffer of size_t of the same length, new array('Q') is\n"
+            "created if it is None. found is optional writable buffer of\n"
+            "bool which is set to True for found keys. Missing key gets\n"
+            "default value, its out item is unchanged if default is not\n"
+            "specified, or KeyError is raised if neither default nor found\n"
+            "is specified. Lookup runs without the GIL, the instance can't\n"
+            "be changed by other threads meanwhile. Table with seqlock (see\n"
+            "create_in()) is read by chunks of 64 keys, each chunk is\n"
+            "consistent."},
     {"keys", (PyCFunction) Int2Int_keys, METH_VARARGS,
             "keys(self, /)\n"
             "--\n"
@@ -894,6 +2908,30 @@ static PyMethodDef Int2Int_methods[] = {
             "Return an iterator over the hashmaps’s (key, value) tuple\n"
             "pairs. Don't change hashmap during iteration, behavior is\n"
             "undefined!"},
+    {"keys_array", (PyCFunction) Int2Int_keys_array,
+            METH_VARARGS | METH_KEYWORDS,
+            "keys_array(self, out=None)\n"
+            "--\n"
+            "\n"
+            "Return buffer of all keys. Keys are copied into out, writable\n"
+            "buffer of uint64 of the same length as the mapping, new\n"
+            "array('Q') is created if it is None."},
+    {"values_array", (PyCFunction) Int2Int_values_array,
+            METH_VARARGS | METH_KEYWORDS,
+            "values_array(self, out=None)\n"
+            "--\n"
+            "\n"
+            "Return buffer of all values in the order of keys_array().\n"
+            "Values are copied into out, writable buffer of size_t of the\n"
+            "same length as the mapping, new array('Q') is created if it\n"
+            "is None."},
+    {"items_arrays", (PyCFunction) Int2Int_items_arrays,
+            METH_VARARGS | METH_KEYWORDS,
+            "items_arrays(self, keys_out=None, values_out=None)\n"
+            "--\n"
+            "\n"
+            "Return tuple (keys, values) of buffers as keys_array() and\n"
+            "values_array() do, in one pass over the table."},
     {"pop", (PyCFunction) Int2Int_pop, METH_VARARGS,
             "pop(self, key, default, /)\n"
             "--\n"
@@ -912,6 +2950,12 @@ static PyMethodDef Int2Int_methods[] = {
             "--\n"
             "\n"
             "Remove all items from structure."},
+    {"shrink_to_fit", (PyCFunction) Int2Int_shrink_to_fit, METH_NOARGS,
+            "shrink_to_fit(self, /)\n"
+            "--\n"
+            "\n"
+            "Rebuild the table into memory block sized for current items\n"
+            "and release the old one. Use it after mass deletion."},
     {"update", (PyCFunction) Int2Int_update, METH_VARARGS,
             "update(self, initializer, /)\n"
             "--\n"
@@ -919,6 +2963,40 @@ static PyMethodDef Int2Int_methods[] = {
             "Update mapping with keys and values from initializer,\n"
             "overwrite existing values. initializer can be either\n"
             "iterable with (key, value) pairs or mapping."},
+    {"update_from_buffers", (PyCFunction) Int2Int_update_from_buffers,
+            METH_VARARGS,
+            "update_from_buffers(self, keys, values=None, /)\n"
+            "--\n"
+            "\n"
+            "Set keys from buffer of uint64 (e.g. array('Q')) to values\n"
+            "from buffer of size_t of the same length. If values is None,\n"
+            "key is set to its position in keys. The table is resized at\n"
+            "most once, no Python objects are created."},
+    {"add", (PyCFunction) Int2Int_add, METH_VARARGS,
+            "add(self, key, delta, /)\n"
+            "--\n"
+            "\n"
+            "Add delta to the value of key and return the new value, key\n"
+            "which is not in the instance is set to delta. Key is looked up\n"
+            "only once. Table in 'concurrent' layout is updated atomically.\n"
+            "Negative delta (at least -2**63) is subtracted. Raise\n"
+            "OverflowError and keep the value when the result would be\n"
+            "below 0 or above 2**64 - 1."},
+    {"add_many", (PyCFunction) Int2Int_add_many, METH_VARARGS,
+            "add_many(self, keys, deltas, /)\n"
+            "--\n"
+            "\n"
+            "add() every key from buffer of uint64 (e.g. array('Q')) with\n"
+            "delta from buffer of size_t or ssize_t (e.g. array('q')) of\n"
+            "the same length, keys may repeat. No Python objects are\n"
+            "created. Keys before the one which failed stay added."},
+    {"from_arrays", (PyCFunction) Int2Int_from_arrays,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "from_arrays(cls, keys, values=None, /, **kwargs)\n"
+            "--\n"
+            "\n"
+            "Return new instance created by kwargs and filled by\n"
+            "update_from_buffers(keys, values)."},
     {"setdefault", (PyCFunction) Int2Int_setdefault, METH_VARARGS,
             "setdefault(self, key, default, /)\n"
             "--\n"
@@ -932,16 +3010,118 @@ static PyMethodDef Int2Int_methods[] = {
             "\n"
             "Return instance created from address pointed to existing\n"
             "Int2Int memory block."},
+    {"buffer_size_for", (PyCFunction) Int2Int_buffer_size_for,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "buffer_size_for(cls, capacity, *, layout='items', "
+            "max_load=0.83)\n"
+            "--\n"
+            "\n"
+            "Return number of bytes create_in() needs for the table of\n"
+            "capacity items."},
+    {"create_in", (PyCFunction) Int2Int_create_in,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "create_in(cls, buffer, capacity, *, default=None, "
+            "layout='items', max_load=0.83, seqlock=False)\n"
+            "--\n"
+            "\n"
+            "Return new empty instance whose table is formatted directly in\n"
+            "writable buffer (e.g. mmap, shared_memory) and modified in\n"
+            "place. The table never grows, it holds at most capacity items,\n"
+            "set of a new key into the full instance raises RuntimeError.\n"
+            "The buffer is held while the instance exists.\n"
+            "\n"
+            "If seqlock is true, every modification bumps a sequence counter\n"
+            "in the header, so instances attached to the table in other\n"
+            "processes (from_buffer(), from_ptr()) look up keys by get(),\n"
+            "get_many(), [] and in without any lock while this instance\n"
+            "modifies the table. Lookup is repeated when it raced with the\n"
+            "modification. Only one instance may modify the table, iteration\n"
+            "and other reads are not protected.\n"
+            "\n"
+            "Table in 'concurrent' layout may be modified by set, del and\n"
+            "update_from_buffers() of instances in many processes at once\n"
+            "without any lock. Keys are never removed from it, del only\n"
+            "marks them deleted, so it accepts only size distinct keys\n"
+            "until clear(), then insert of a new key raises RuntimeError.\n"
+            "Writer waits while other writer inserts the same key. Writer\n"
+            "which crashed in the middle of an insert leaves its key\n"
+            "locked, later inserts of that key raise RuntimeError. Writers\n"
+            "must run in the same PID namespace."},
+    {"from_buffer", (PyCFunction) Int2Int_from_buffer,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "from_buffer(cls, buffer, *, default=None)\n"
+            "--\n"
+            "\n"
+            "Return instance which uses table at the beginning of buffer,\n"
+            "e.g. created by create_in() in other process. Header and size\n"
+            "of the table are validated against the buffer. Table in\n"
+            "read-only buffer must be read-only, table in writable buffer\n"
+            "gets fixed size as by create_in()."},
+    {"save", (PyCFunction) Int2Int_save, METH_VARARGS | METH_KEYWORDS,
+            "save(self, path)\n"
+            "--\n"
+            "\n"
+            "Write the table into file at path, it can be mapped back by\n"
+            "open(). File is written under temporary name and then renamed,\n"
+            "so processes which opened the previous file are not affected."},
+    {"open", (PyCFunction) Int2Int_open,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "open(cls, path, mode='r', *, default=None, verify=False)\n"
+            "--\n"
+            "\n"
+            "Return instance which uses table in file written by save(). The\n"
+            "file is mapped into the memory, so the table is not loaded and\n"
+            "processes which open the same file share one copy in the page\n"
+            "cache. Mode 'r' returns read-only instance, mode 'r+' modifies\n"
+            "the file in place and the table has fixed size as by\n"
+            "create_in(). If verify is true, checksum of the table is\n"
+            "checked, it reads the whole file."},
+    {"dump", (PyCFunction) Int2Int_dump, METH_VARARGS | METH_KEYWORDS,
+            "dump(self, file, *, pairs=False)\n"
+            "--\n"
+            "\n"
+            "Write the table into binary file object by chunks, the table\n"
+            "is not copied into memory. Stream has the format of save(). If\n"
+            "pairs is true, only key/value pairs of used items are written,\n"
+            "so size of the stream depends on number of items, not on size\n"
+            "of the table. Instance can't be modified by write() of the\n"
+            "file object."},
+    {"load", (PyCFunction) Int2Int_load,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "load(cls, file, *, default=None)\n"
+            "--\n"
+            "\n"
+            "Return instance read from binary file object written by dump()\n"
+            "or save(). The memory block is read by readinto() directly into\n"
+            "the new table, pairs are inserted chunk by chunk. Checksum is\n"
+            "always checked."},
     {"make_readonly", (PyCFunction) Int2Int_make_readonly, METH_NOARGS,
             "make_readonly(self, /)\n"
             "--\n"
             "\n"
             "Make Int2Int structure as a read-only."},
+    {"freeze", (PyCFunction) Int2Int_freeze, METH_NOARGS,
+            "freeze(self, /)\n"
+            "--\n"
+            "\n"
+            "Rebuild the table into read-only 'cuckoo' layout. Each key is\n"
+            "stored in one of its two buckets of 4 slots, so lookup reads\n"
+            "at most two buckets. Table stays a single memory block usable\n"
+            "through buffer_ptr, from_ptr and int2int_get."},
     {"__reduce__", (PyCFunction) Int2Int_reduce, METH_NOARGS,
             "__reduce__(self, /)\n"
             "--\n"
             "\n"
             "Return reduced value of the instance."},
+    {"__reduce_ex__", (PyCFunction) Int2Int_reduce_ex, METH_VARARGS,
+            "__reduce_ex__(self, protocol, /)\n"
+            "--\n"
+            "\n"
+            "Return reduced value of the instance. Protocol 5 passes the\n"
+            "memory block as PickleBuffer, so out-of-band pickling does not\n"
+            "copy it. Instance can't be modified while the buffer is\n"
+            "exported. Read-only table is unpickled in place of the\n"
+            "received buffer."},
     {"_from_raw_data", (PyCFunction) Int2Int_from_raw_data,
             METH_VARARGS | METH_CLASS,
             "_from_raw_data(self, ..., /)\n"
@@ -957,6 +3137,16 @@ static PyMethodDef Int2Int_methods[] = {
 static PyGetSetDef Int2Int_getset[] = {
     {"readonly", (getter) Int2Int_get_readonly, NULL,
             "Flag that indicates that instance is read-only.", NULL},
+    {"layout", (getter) Int2Int_get_layout, NULL,
+            "Layout of the table in the internal buffer.", NULL},
+    {"max_load", (getter) Int2Int_get_max_load, NULL,
+            "Maximum load factor of the table.", NULL},
+    {"growth", (getter) Int2Int_get_growth, NULL,
+            "Factor by which the capacity grows when the table is full.",
+            NULL},
+    {"shrink_load", (getter) Int2Int_get_shrink_load, NULL,
+            "Load under which deletion shrinks the table, 0 if disabled.",
+            NULL},
     {"buffer_ptr", (getter) Int2Int_get_buffer_ptr, NULL,
             "Address of the internal buffer.", NULL},
     {"buffer_size", (getter) Int2Int_get_buffer_size, NULL,
@@ -964,6 +3154,79 @@ static PyGetSetDef Int2Int_getset[] = {
     {NULL}
 };
 
+/* Slot table is exported as read-only array of records, layouts which
+   keep keys, values or control bytes in separate arrays can't be
+   exported. Table is not changed or moved while a view is held. */
+static int Int2Int_getbuffer(Int2Int_t *self, Py_buffer *view, int flags) {
+    Int2IntHashTable_t *hashmap = self->hashmap;
+    const char *format;
+    Py_ssize_t itemsize;
+    Py_ssize_t header_size;
+
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "Slot table is read-only");
+        return -1;
+    }
+    switch (hashmap->layout) {
+    case HASHMAP_LAYOUT_ITEMS:
+        format = (sizeof(size_t) == sizeof(unsigned long long))
+                ? "T{Q:key:Q:value:I:status:I:distance:}"
+                : "T{Q:key:I:value:I:status:I:distance:}";
+        itemsize = sizeof(Int2IntItem_t);
+        break;
+    case HASHMAP_LAYOUT_COMPACT:
+    case HASHMAP_LAYOUT_CUCKOO:
+        format = (sizeof(size_t) == sizeof(unsigned long long))
+                ? "T{Q:key:Q:value:}" : "T{Q:key:I:value:}";
+        itemsize = sizeof(Int2IntSlot_t);
+        break;
+    default:
+        PyErr_Format(PyExc_BufferError,
+                "Layout '%s' can't be exported as array of slots",
+                layout_names[hashmap->layout]);
+        return -1;
+    }
+    if (hashmap->flags & HASHMAP_FLAG_MIGRATING) {
+        /* Items from the previous table are moved into exported one */
+        if (Int2Int_check_exports(self)) {
+            return -1;
+        }
+        int2int_finish_resize(hashmap);
+    }
+
+    header_size = INT2INT_HEADER_SIZE(hashmap);
+    self->export_shape = ((Py_ssize_t) int2int_buffer_size(hashmap)
+            - header_size) / itemsize;
+    self->export_stride = itemsize;
+
+    view->obj = (PyObject*) self;
+    view->buf = (char*) hashmap + header_size;
+    view->len = self->export_shape * itemsize;
+    view->readonly = 1;
+    view->itemsize = itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? (char*) format : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &self->export_shape : NULL;
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES)
+            ? &self->export_stride : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+
+    Py_INCREF(self);
+    self->exports += 1;
+
+    return 0;
+}
+
+static void Int2Int_releasebuffer(Int2Int_t *self, Py_buffer *view) {
+    self->exports -= 1;
+}
+
+static PyBufferProcs Int2Int_buffer_procs = {
+    (getbufferproc) Int2Int_getbuffer,
+    (releasebufferproc) Int2Int_releasebuffer,
+};
+
 static PyTypeObject Int2Int_type = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "cdatastructs.hashmap.Int2Int",                     /* tp_name */
@@ -983,10 +3246,11 @@ static PyTypeObject Int2Int_type = {
     0,                                                  /* tp_str */
     0,                                                  /* tp_getattro */
     0,                                                  /* tp_setattro */
-    0,                                                  /* tp_as_buffer */
+    &Int2Int_buffer_procs,                              /* tp_as_buffer */
     Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,           /* tp_flags */
     "Int2Int(self, initializer, default=None, "         /* tp_doc */
-    "prealloc_size=None, /)\n"
+    "prealloc_size=None, layout='items', incremental_resize=False, "
+    "max_load=0.83, growth=2.0, shrink_load=0.0, /)\n"
     "--\n"
     "\n"
     "Simple fixed-size hashmap which maps int key to int value. Provides\n"
@@ -999,7 +3263,26 @@ static PyTypeObject Int2Int_type = {
     "mapping. If default is specified, value of the default will be\n"
     "returned when key does not exist and will be stored into mapping.\n"
     "If prealloc_size is specified, memory for hashmap table will be\n"
-    "allocated for this amount of items.",
+    "allocated for this amount of items. layout selects how the table is\n"
+    "stored in the memory block: 'items' (key, value and status per\n"
+    "slot), 'compact' (16 bytes per slot, key 0 marks an empty slot) or\n"
+    "'soa' (as compact, but array of keys is followed by array of values).\n"
+    "'concurrent' (as items, but set/del are atomic and the table never\n"
+    "grows, see create_in()).\n"
+    "freeze() rebuilds the table into read-only 'cuckoo' layout.\n"
+    "If incremental_resize is true, items layout is resized step by step:\n"
+    "new table is allocated and each following set/del moves a few items\n"
+    "from the old one, so no single insert copies the whole table.\n"
+    "max_load is the maximum ratio of items to table slots, lower value\n"
+    "makes lookups faster at the cost of memory. When the table is full,\n"
+    "its capacity is multiplied by growth. If shrink_load is set, the\n"
+    "table is rebuilt smaller when deletion drops number of items under\n"
+    "shrink_load of its capacity.\n"
+    "\n"
+    "Slot table of 'items', 'compact' and 'cuckoo' layouts is exported\n"
+    "by the buffer protocol as read-only array of records, e.g. for\n"
+    "memoryview or numpy. The instance can't be changed while a view\n"
+    "is held.",
     0,                                                  /* tp_traverse */
     0,                                                  /* tp_clear */
     (richcmpfunc) Int2Int_richcompare,                  /* tp_richcompare */
@@ -1019,6 +3302,28 @@ static PyTypeObject Int2Int_type = {
     (newfunc) Int2Int_new,                              /* tp_new */
 };
 
+/* Int2IntSwiss */
+
+static PyTypeObject Int2IntSwiss_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "cdatastructs.hashmap.Int2IntSwiss",
+    .tp_doc = "Int2IntSwiss(self, initializer, default=None, "
+    "prealloc_size=None, layout='swiss', /)\n"
+    "--\n"
+    "\n"
+    "Int2Int hashmap with the Swiss table layout. Table is split into\n"
+    "groups of 16 slots, each slot has one control byte with 7 bits of\n"
+    "the key's hash. Lookup compares the whole group of control bytes at\n"
+    "once (SSE2/AVX2 when CPU supports it), so keys are compared only\n"
+    "when hash bits match. Interface and C functions are the same as for\n"
+    "Int2Int.",
+    .tp_basicsize = sizeof(Int2Int_t),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_base = &Int2Int_type,
+    .tp_new = (newfunc) Int2IntSwiss_new,
+};
+
 /******************************************************************************
  * Int2Float class                                                            *
  ******************************************************************************/
@@ -1026,9 +3331,17 @@ static PyTypeObject Int2Int_type = {
 typedef struct {
     PyObject_HEAD
     Int2FloatHashTable_t *hashmap;
-    Int2FloatItem_t *table;
     PyObject *default_value;
     bool release_memory;
+    /* Number of operations which use the table without the GIL */
+    Py_ssize_t exports;
+    /* Shape and stride of the exported buffer */
+    Py_ssize_t export_shape;
+    Py_ssize_t export_stride;
+    /* Buffer of the caller which holds the table (create_in/from_buffer) */
+    Py_buffer memory;
+    /* Header of int2float has no shrink_load, instance keeps it */
+    double shrink_load;
 } Int2Float_t;
 
 static PyTypeObject Int2Float_type;
@@ -1038,25 +3351,21 @@ static PyTypeObject Int2Float_type;
 static PyObject* Int2FloatIterator_next(HashmapIterator_t *self) {
     Int2Float_t *obj = (Int2Float_t*) self->obj;
     PyObject *res = NULL;
-
-    while (self->current_position < obj->hashmap->table_size) {
-        Int2FloatItem_t item = obj->table[self->current_position];
-        if (item.status == USED) {
-            switch (self->iterator_type) {
-            case KEYS:
-                res = PyLong_FromUnsignedLongLong(item.key);
-                break;
-            case VALUES:
-                res = PyFloat_FromDouble(item.value);
-                break;
-            case ITEMS:
-                res = PyTuple_Pack(2, PyLong_FromUnsignedLongLong(item.key),
-                        PyFloat_FromDouble(item.value));
-                break;
-            }
-        }
-        ++self->current_position;
-        if (res != NULL) {
+    unsigned long long key;
+    double *value;
+
+    if (0 == int2float_next(obj->hashmap, &self->current_position,
+            &key, &value)) {
+        switch (self->iterator_type) {
+        case KEYS:
+            res = PyLong_FromUnsignedLongLong(key);
+            break;
+        case VALUES:
+            res = PyFloat_FromDouble(*value);
+            break;
+        case ITEMS:
+            res = PyTuple_Pack(2, PyLong_FromUnsignedLongLong(key),
+                    PyFloat_FromDouble(*value));
             break;
         }
     }
@@ -1084,17 +3393,35 @@ static int Int2Float_update_from_initializer(Int2Float_t *self,
 static PyObject* Int2Float_new(PyTypeObject *cls,
         PyObject *args, PyObject *kwds) {
 
-    char *kwnames[] = {"initializer", "default", "prealloc_size", NULL};
+    char *kwnames[] = {"initializer", "default", "prealloc_size", "layout",
+            "shrink_load", NULL};
     PyObject *initializer = NULL;
     PyObject *default_value = NULL;
     unsigned int prealloc_size = INT2FLOAT_INITIAL_SIZE;
+    const char *layout_name = NULL;
+    HashmapLayout_e layout = HASHMAP_LAYOUT_ITEMS;
+    double shrink_load = 0.0;
     Int2Float_t *self = NULL;
 
     /* Parse arguments */
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O$OI", kwnames,
-            &initializer, &default_value, &prealloc_size)) {
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O$OIsd", kwnames,
+            &initializer, &default_value, &prealloc_size, &layout_name,
+            &shrink_load)) {
         goto error;
     }
+    if ((NULL != layout_name) && layout_from_name(layout_name, &layout)) {
+        return NULL;
+    }
+    if (0 == int2float_layout_table_size(prealloc_size, layout)) {
+        PyErr_Format(PyExc_ValueError,
+                "Layout '%s' is not supported", layout_name);
+        return NULL;
+    }
+    if (!((shrink_load >= 0.0) && (shrink_load < 1.0))) {
+        PyErr_SetString(PyExc_ValueError,
+                "'shrink_load' must be at least 0 and less than 1");
+        return NULL;
+    }
     /* Validate arguments */
     if ((NULL != default_value) && (Py_None != default_value)) {
         if (PyLong_Check(default_value)) {
@@ -1123,7 +3450,7 @@ static PyObject* Int2Float_new(PyTypeObject *cls,
     /* Allocate memory for Int2FloatHashTable_t structure and hashtable. At
        the beginning of block of the memory Int2FloatHashTable_t structure
        is placed, followed by hashtable (array of Int2FloatItem_t). */
-    if (int2float_new(prealloc_size, &self->hashmap)) {
+    if (int2float_new_layout(prealloc_size, layout, &self->hashmap)) {
         PyErr_NoMemory();
         goto error;
     }
@@ -1131,8 +3458,7 @@ static PyObject* Int2Float_new(PyTypeObject *cls,
     /* Initialize object attributes */
     self->release_memory = true;
     self->default_value = default_value;
-    self->table = (Int2FloatItem_t*) (
-            (char*) self->hashmap + sizeof(Int2FloatHashTable_t));
+    self->shrink_load = shrink_load;
 
     if ((NULL != initializer) &&
             (Int2Float_update_from_initializer(self, initializer) != 0)) {
@@ -1155,6 +3481,7 @@ static void Int2Float_dealloc(Int2Float_t *self) {
     if (self->release_memory && (NULL != self->hashmap)) {
         free(self->hashmap);
     }
+    PyBuffer_Release(&self->memory);
     Py_TYPE(self)->tp_free((PyObject*) self);
 }
 
@@ -1210,60 +3537,62 @@ static PyObject* Int2Float_richcompare(Int2Float_t *self,
     }
 
     if (res != NULL) {
-        if (PyDict_Check(other) || (Py_TYPE(other) == &Int2Float_type)) {
+        if (PyDict_Check(other)
+                || PyObject_TypeCheck(other, &Int2Float_type)) {
             Py_ssize_t other_length = PyMapping_Size(other);
 
             if (other_length == (Py_ssize_t) self->hashmap->current_size) {
+                size_t position = 0;
+                unsigned long long item_key;
+                double *item_value;
+
                 res = Py_True;
-                for (size_t i = 0; i < self->hashmap->table_size; ++i) {
-                    Int2FloatItem_t item = self->table[i];
-
-                    if (item.status == USED) {
-                        PyObject *key = NULL;
-                        PyObject *value = NULL;
-                        double c_value;
-
-                        key = PyLong_FromLongLong(item.key);
-                        if (key != NULL) {
-                            value = PyObject_GetItem(other, key);
-                            if (value != NULL) {
-                                c_value = PyFloat_AsDouble(value);
-                                if ((c_value == -1.0) &&
-                                        PyErr_Occurred() != NULL) {
-                                    /* PyLong to size_t conversion error */
-                                    res = NULL;
-                                }
-                                else {
-                                    /* Values for key are different */
-                                    if (item.value != c_value) {
-                                        res = Py_False;
-                                    }
-                                }
+                while (0 == int2float_next(self->hashmap, &position,
+                        &item_key, &item_value)) {
+                    PyObject *key = NULL;
+                    PyObject *value = NULL;
+                    double c_value;
+
+                    key = PyLong_FromLongLong(item_key);
+                    if (key != NULL) {
+                        value = PyObject_GetItem(other, key);
+                        if (value != NULL) {
+                            c_value = PyFloat_AsDouble(value);
+                            if ((c_value == -1.0) &&
+                                    PyErr_Occurred() != NULL) {
+                                /* PyLong to size_t conversion error */
+                                res = NULL;
                             }
                             else {
-                                /* other[key] error, if KeyError, objects are
-                                   different, otherwise return with error. */
-                                if (PyErr_GivenExceptionMatches(
-                                        PyErr_Occurred(), PyExc_KeyError)) {
-                                    PyErr_Clear();
+                                /* Values for key are different */
+                                if (*item_value != c_value) {
                                     res = Py_False;
                                 }
-                                else {
-                                    res = NULL;
-                                }
                             }
                         }
                         else {
-                            /* long long to PyLong conversion error */
-                            res = NULL;
+                            /* other[key] error, if KeyError, objects are
+                               different, otherwise return with error. */
+                            if (PyErr_GivenExceptionMatches(
+                                    PyErr_Occurred(), PyExc_KeyError)) {
+                                PyErr_Clear();
+                                res = Py_False;
+                            }
+                            else {
+                                res = NULL;
+                            }
                         }
+                    }
+                    else {
+                        /* long long to PyLong conversion error */
+                        res = NULL;
+                    }
 
-                        Py_XDECREF(key);
-                        Py_XDECREF(value);
+                    Py_XDECREF(key);
+                    Py_XDECREF(value);
 
-                        if (res != Py_True) {
-                            break;
-                        }
+                    if (res != Py_True) {
+                        break;
                     }
                 }
             }
@@ -1301,17 +3630,50 @@ static int Int2Float_contains(Int2Float_t *self, PyObject *key) {
     return int2float_has(self->hashmap, c_key) == -1 ? 0 : 1;
 }
 
-static int Int2Float_setitem(Int2Float_t *self,
-        PyObject *key, PyObject *value) {
-    unsigned long long c_key;
-    double c_value;
-    Int2FloatHashTable_t * new_hashmap;
+/* Set of the key failed, table of fixed size is full or memory can't be
+   allocated */
+static void Int2Float_set_error(Int2Float_t *self) {
+    if (self->hashmap->flags & HASHMAP_FLAG_FIXED_SIZE) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is full");
+    }
+    else {
+        PyErr_NoMemory();
+    }
+}
 
-    if (self->hashmap->readonly) {
-        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+/* Table must not be changed or moved while it is used without the GIL */
+static int Int2Float_check_exports(Int2Float_t *self) {
+    if (self->exports > 0) {
+        PyErr_SetString(PyExc_BufferError,
+                "Existing exports of data: object cannot be changed");
         return -1;
     }
-    if (!PyLong_Check(key)) {
+    return 0;
+}
+
+/* Deletion may drop load of the table under shrink_load of the instance */
+static void Int2Float_shrink(Int2Float_t *self) {
+    Int2FloatHashTable_t *new_hashmap;
+
+    /* Failure is not an error, the table only keeps its memory */
+    int2float_shrink(self->hashmap, self->shrink_load, &new_hashmap);
+    self->hashmap = new_hashmap;
+}
+
+static int Int2Float_setitem(Int2Float_t *self,
+        PyObject *key, PyObject *value) {
+    unsigned long long c_key;
+    double c_value;
+    Int2FloatHashTable_t * new_hashmap;
+
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return -1;
+    }
+    if (Int2Float_check_exports(self)) {
+        return -1;
+    }
+    if (!PyLong_Check(key)) {
         PyErr_SetString(PyExc_TypeError, "'key' must be an integer");
         return -1;
     }
@@ -1327,6 +3689,7 @@ static int Int2Float_setitem(Int2Float_t *self,
             PyErr_SetObject(PyExc_KeyError, key);
             return -1;
         }
+        Int2Float_shrink(self);
     }
     else {
         /* Set new or update existing item */
@@ -1346,13 +3709,11 @@ static int Int2Float_setitem(Int2Float_t *self,
             }
         }
         if (int2float_set(self->hashmap, c_key, c_value, &new_hashmap)) {
-            PyErr_NoMemory();
+            Int2Float_set_error(self);
             return -1;
         }
         if (new_hashmap != self->hashmap) {
             self->hashmap = new_hashmap;
-            self->table = (Int2FloatItem_t*) (
-                    (char*) new_hashmap + sizeof(Int2FloatHashTable_t));
         }
     }
 
@@ -1375,18 +3736,19 @@ static PyObject* Int2Float_getitem(Int2Float_t *self, PyObject *key) {
 
     if (int2float_get(self->hashmap, c_key, &c_value) == -1) {
         if (self->default_value != Py_None) {
+            if (Int2Float_check_exports(self)) {
+                return NULL;
+            }
             c_value = PyFloat_AsDouble(self->default_value);
             if ((c_value == -1.0) && (NULL != PyErr_Occurred())) {
                 return NULL;
             }
             if (int2float_set(self->hashmap, c_key, c_value, &new_hashmap)) {
-                PyErr_NoMemory();
+                Int2Float_set_error(self);
                 return NULL;
             }
             if (new_hashmap != self->hashmap) {
                 self->hashmap = new_hashmap;
-                self->table = (Int2FloatItem_t*) (
-                        (char*) new_hashmap + sizeof(Int2FloatHashTable_t));
             }
             Py_INCREF(self->default_value);
             return self->default_value;
@@ -1454,6 +3816,106 @@ static PyObject* Int2Float_get(Int2Float_t *self,
     return PyFloat_FromDouble(value);
 }
 
+static PyObject* Int2Float_get_many(Int2Float_t *self,
+        PyObject *args, PyObject *kwds) {
+
+    char *kwnames[] = {"keys", "out", "found", "default", NULL};
+    PyObject *keys_obj;
+    PyObject *out_obj = Py_None;
+    PyObject *found_obj = Py_None;
+    PyObject *default_value = NULL;
+    Py_buffer keys = {NULL};
+    Py_buffer out = {NULL};
+    Py_buffer found = {NULL};
+    const unsigned long long *c_keys;
+    double *c_values;
+    double c_default = 0;
+    Py_ssize_t n;
+    size_t count;
+    PyObject *res = NULL;
+
+    /* Parse arguments */
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O$OO", kwnames,
+            &keys_obj, &out_obj, &found_obj, &default_value)) {
+        return NULL;
+    }
+    if (get_typed_buffer(keys_obj, &keys, PyBUF_SIMPLE, UINT64_FORMATS,
+            sizeof(unsigned long long), "keys", "uint64")) {
+        return NULL;
+    }
+    n = keys.len / keys.itemsize;
+
+    /* default argument */
+    if (Py_None == default_value) {
+        default_value = NULL;
+    }
+    if (NULL != default_value) {
+        if (!PyLong_Check(default_value) && !PyFloat_Check(default_value)) {
+            PyErr_SetString(PyExc_TypeError, "'default' must be a float");
+            goto error;
+        }
+        c_default = PyFloat_AsDouble(default_value);
+        if ((c_default == -1.0) && (PyErr_Occurred() != NULL)) {
+            goto error;
+        }
+    }
+
+    /* Result buffers */
+    if (Py_None == out_obj) {
+        if (NULL == (out_obj = new_array("d", n))) {
+            goto error;
+        }
+    }
+    else {
+        Py_INCREF(out_obj);
+    }
+    if (get_result_buffer(out_obj, &out, n, "'keys'", DOUBLE_FORMATS,
+            sizeof(double), "out", "double")) {
+        goto error;
+    }
+    if ((Py_None != found_obj) && get_result_buffer(found_obj, &found, n,
+            "'keys'", BOOL_FORMATS, sizeof(bool), "found", "bool")) {
+        goto error;
+    }
+
+    /* Look up keys without the GIL */
+    c_keys = (const unsigned long long*) keys.buf;
+    c_values = (double*) out.buf;
+    self->exports += 1;
+    Py_BEGIN_ALLOW_THREADS
+    if (NULL != default_value) {
+        for (Py_ssize_t i=0; i<n; ++i) {
+            c_values[i] = c_default;
+        }
+    }
+    count = int2float_get_many(self->hashmap, c_keys, (size_t) n, c_values,
+            (bool*) found.buf);
+    Py_END_ALLOW_THREADS
+    self->exports -= 1;
+
+    /* Missing key is an error if caller can't recognize it */
+    if ((count < (size_t) n) && (NULL == default_value)
+            && (Py_None == found_obj)) {
+        for (Py_ssize_t i=0; i<n; ++i) {
+            if (-1 == int2float_has(self->hashmap, c_keys[i])) {
+                PyErr_Format(PyExc_KeyError, "%llu", c_keys[i]);
+                goto error;
+            }
+        }
+    }
+
+    res = out_obj;
+    out_obj = NULL;
+
+error:
+    PyBuffer_Release(&found);
+    PyBuffer_Release(&out);
+    PyBuffer_Release(&keys);
+    Py_XDECREF(out_obj);
+
+    return res;
+}
+
 static PyObject* Int2Float_keys(Int2Float_t *self) {
     HashmapIterator_t *iterator = PyObject_New(
             HashmapIterator_t, &Int2FloatIterator_type);
@@ -1490,12 +3952,144 @@ static PyObject* Int2Float_items(Int2Float_t *self) {
     return (PyObject*) iterator;
 }
 
+/* Copy items into buffers of keys and values. Buffer which is None is
+   created as new array, NULL buffer is not wanted. Results are new
+   references. */
+static int Int2Float_export(Int2Float_t *self,
+        PyObject *keys_obj, const char * const keys_name,
+        PyObject *values_obj, const char * const values_name,
+        PyObject **keys_res, PyObject **values_res) {
+
+    Py_buffer keys = {NULL};
+    Py_buffer values = {NULL};
+    Py_ssize_t n = (Py_ssize_t) self->hashmap->current_size;
+
+    *keys_res = NULL;
+    *values_res = NULL;
+    if (NULL != keys_obj) {
+        if (Py_None == keys_obj) {
+            keys_obj = new_array("Q", n);
+        }
+        else {
+            Py_INCREF(keys_obj);
+        }
+        if (NULL == (*keys_res = keys_obj)) {
+            goto error;
+        }
+        if (get_result_buffer(keys_obj, &keys, n, "the mapping",
+                UINT64_FORMATS, sizeof(unsigned long long), keys_name,
+                "uint64")) {
+            goto error;
+        }
+    }
+    if (NULL != values_obj) {
+        if (Py_None == values_obj) {
+            values_obj = new_array("d", n);
+        }
+        else {
+            Py_INCREF(values_obj);
+        }
+        if (NULL == (*values_res = values_obj)) {
+            goto error;
+        }
+        if (get_result_buffer(values_obj, &values, n, "the mapping",
+                DOUBLE_FORMATS, sizeof(double), values_name, "double")) {
+            goto error;
+        }
+    }
+
+    /* Copy items without the GIL */
+    self->exports += 1;
+    Py_BEGIN_ALLOW_THREADS
+    int2float_export(self->hashmap, (unsigned long long*) keys.buf,
+            (double*) values.buf);
+    Py_END_ALLOW_THREADS
+    self->exports -= 1;
+
+    PyBuffer_Release(&values);
+    PyBuffer_Release(&keys);
+
+    return 0;
+
+error:
+    PyBuffer_Release(&values);
+    PyBuffer_Release(&keys);
+    Py_CLEAR(*keys_res);
+    Py_CLEAR(*values_res);
+
+    return -1;
+}
+
+static PyObject* Int2Float_keys_array(Int2Float_t *self,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"out", NULL};
+    PyObject *out = Py_None;
+    PyObject *keys;
+    PyObject *values;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kwnames, &out)) {
+        return NULL;
+    }
+    if (Int2Float_export(self, out, "out", NULL, NULL, &keys, &values)) {
+        return NULL;
+    }
+    return keys;
+}
+
+static PyObject* Int2Float_values_array(Int2Float_t *self,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"out", NULL};
+    PyObject *out = Py_None;
+    PyObject *keys;
+    PyObject *values;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kwnames, &out)) {
+        return NULL;
+    }
+    if (Int2Float_export(self, NULL, NULL, out, "out", &keys, &values)) {
+        return NULL;
+    }
+    return values;
+}
+
+static PyObject* Int2Float_items_arrays(Int2Float_t *self,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"keys_out", "values_out", NULL};
+    PyObject *keys_out = Py_None;
+    PyObject *values_out = Py_None;
+    PyObject *keys;
+    PyObject *values;
+    PyObject *res;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|OO", kwnames,
+            &keys_out, &values_out)) {
+        return NULL;
+    }
+    if (Int2Float_export(self, keys_out, "keys_out", values_out, "values_out",
+            &keys, &values)) {
+        return NULL;
+    }
+    res = PyTuple_Pack(2, keys, values);
+    Py_DECREF(keys);
+    Py_DECREF(values);
+
+    return res;
+}
+
 static PyObject* Int2Float_pop(Int2Float_t *self, PyObject *args) {
     PyObject * key;
     PyObject * default_value = NULL;
     unsigned long long c_key;
     double value;
 
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Float_check_exports(self)) {
+        return NULL;
+    }
+
     if (!PyArg_ParseTuple(args, "O|O", &key, &default_value)) {
         return NULL;
     }
@@ -1535,35 +4129,43 @@ static PyObject* Int2Float_pop(Int2Float_t *self, PyObject *args) {
     }
 
     int2float_del(self->hashmap, c_key);
+    Int2Float_shrink(self);
     return PyFloat_FromDouble(value);
 }
 
 static PyObject* Int2Float_popitem(Int2Float_t *self) {
-    Int2FloatItem_t * item;
+    size_t position = 0;
+    unsigned long long item_key;
+    double *item_value;
     PyObject * res = NULL;
     PyObject * key = NULL;
     PyObject * value = NULL;
 
-    for (size_t i=0; i<self->hashmap->table_size; ++i) {
-        item = &(self->table[i]);
-        if (USED == item->status) {
-            if (NULL == (key = PyLong_FromUnsignedLongLong(item->key))) {
-                goto error;
-            }
-            if (NULL == (value = PyFloat_FromDouble(item->value))) {
-                goto error;
-            }
-            if (NULL == (res = PyTuple_New(2))) {
-                goto error;
-            }
-            PyTuple_SET_ITEM(res, 0, key);
-            PyTuple_SET_ITEM(res, 1, value);
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Float_check_exports(self)) {
+        return NULL;
+    }
+    if (0 == int2float_next(self->hashmap, &position, &item_key,
+            &item_value)) {
+        if (NULL == (key = PyLong_FromUnsignedLongLong(item_key))) {
+            goto error;
+        }
+        if (NULL == (value = PyFloat_FromDouble(*item_value))) {
+            goto error;
+        }
+        if (NULL == (res = PyTuple_New(2))) {
+            goto error;
+        }
+        PyTuple_SET_ITEM(res, 0, key);
+        PyTuple_SET_ITEM(res, 1, value);
 
-            item->status = DELETED;
-            self->hashmap->current_size -= 1;
+        int2float_del(self->hashmap, item_key);
+        Int2Float_shrink(self);
 
-            return res;
-        }
+        return res;
     }
     PyErr_SetString(PyExc_KeyError, "popitem(): mapping is empty");
 
@@ -1576,10 +4178,38 @@ error:
 }
 
 static PyObject* Int2Float_clear(Int2Float_t *self) {
-    for (size_t i=0; i<self->hashmap->table_size; ++i) {
-        self->table[i].status = EMPTY;
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Float_check_exports(self)) {
+        return NULL;
+    }
+
+    int2float_clear(self->hashmap);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject* Int2Float_shrink_to_fit(Int2Float_t *self) {
+    Int2FloatHashTable_t *new_hashmap;
+
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Float_check_exports(self)) {
+        return NULL;
+    }
+    if (self->hashmap->flags & HASHMAP_FLAG_FIXED_SIZE) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance has fixed size");
+        return NULL;
+    }
+    if (int2float_compact(self->hashmap, &new_hashmap)) {
+        PyErr_NoMemory();
+        return NULL;
     }
-    self->hashmap->current_size = 0;
+    self->hashmap = new_hashmap;
 
     Py_RETURN_NONE;
 }
@@ -1669,6 +4299,180 @@ static PyObject* Int2Float_update(Int2Float_t *self, PyObject *args) {
     Py_RETURN_NONE;
 }
 
+static PyObject* Int2Float_update_from_buffers(Int2Float_t *self,
+        PyObject *args) {
+    PyObject *keys_obj;
+    PyObject *values_obj = NULL;
+    Py_buffer keys = {NULL};
+    Py_buffer values = {NULL};
+    Int2FloatHashTable_t *new_hashmap;
+    Py_ssize_t n;
+    int res;
+
+    if (!PyArg_ParseTuple(args, "OO", &keys_obj, &values_obj)) {
+        return NULL;
+    }
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Float_check_exports(self)) {
+        return NULL;
+    }
+    if (get_typed_buffer(keys_obj, &keys, PyBUF_SIMPLE, UINT64_FORMATS,
+            sizeof(unsigned long long), "keys", "uint64")) {
+        return NULL;
+    }
+    n = keys.len / keys.itemsize;
+    if (get_typed_buffer(values_obj, &values, PyBUF_SIMPLE,
+            DOUBLE_FORMATS, sizeof(double), "values", "double")) {
+        PyBuffer_Release(&keys);
+        return NULL;
+    }
+    if (values.len / values.itemsize != n) {
+        PyErr_SetString(PyExc_ValueError,
+                "'values' must have the same length as 'keys'");
+        PyBuffer_Release(&values);
+        PyBuffer_Release(&keys);
+        return NULL;
+    }
+
+    res = int2float_set_many(self->hashmap,
+            (const unsigned long long*) keys.buf, (const double*) values.buf,
+            (size_t) n, &new_hashmap, NULL);
+    self->hashmap = new_hashmap;
+    PyBuffer_Release(&values);
+    PyBuffer_Release(&keys);
+    if (res) {
+        Int2Float_set_error(self);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject* Int2Float_add(Int2Float_t *self, PyObject *args) {
+    PyObject *key;
+    PyObject *delta;
+    unsigned long long c_key;
+    double c_delta;
+    double c_value;
+    Int2FloatHashTable_t *new_hashmap;
+    int res;
+
+    if (!PyArg_ParseTuple(args, "OO", &key, &delta)) {
+        return NULL;
+    }
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Float_check_exports(self)) {
+        return NULL;
+    }
+    if (!PyLong_Check(key)) {
+        PyErr_SetString(PyExc_TypeError, "'key' must be an integer");
+        return NULL;
+    }
+    c_key = PyLong_AsUnsignedLongLong(key);
+    if ((c_key == (unsigned long long) -1) && (PyErr_Occurred() != NULL)) {
+        return NULL;
+    }
+    if (!PyLong_Check(delta) && !PyFloat_Check(delta)) {
+        PyErr_SetString(PyExc_TypeError, "'delta' must be a float");
+        return NULL;
+    }
+    c_delta = PyFloat_AsDouble(delta);
+    if ((c_delta == -1.0) && (PyErr_Occurred() != NULL)) {
+        return NULL;
+    }
+
+    res = int2float_add(self->hashmap, c_key, c_delta, &c_value,
+            &new_hashmap);
+    self->hashmap = new_hashmap;
+    if (res) {
+        Int2Float_set_error(self);
+        return NULL;
+    }
+
+    return PyFloat_FromDouble(c_value);
+}
+
+static PyObject* Int2Float_add_many(Int2Float_t *self, PyObject *args) {
+    PyObject *keys_obj;
+    PyObject *deltas_obj;
+    Py_buffer keys = {NULL};
+    Py_buffer deltas = {NULL};
+    Int2FloatHashTable_t *new_hashmap;
+    Py_ssize_t n;
+    int res;
+
+    if (!PyArg_ParseTuple(args, "OO", &keys_obj, &deltas_obj)) {
+        return NULL;
+    }
+    if (self->hashmap->readonly) {
+        PyErr_SetString(PyExc_RuntimeError, "Instance is read-only");
+        return NULL;
+    }
+    if (Int2Float_check_exports(self)) {
+        return NULL;
+    }
+    if (get_typed_buffer(keys_obj, &keys, PyBUF_SIMPLE, UINT64_FORMATS,
+            sizeof(unsigned long long), "keys", "uint64")) {
+        return NULL;
+    }
+    n = keys.len / keys.itemsize;
+    if (get_typed_buffer(deltas_obj, &deltas, PyBUF_SIMPLE,
+            DOUBLE_FORMATS, sizeof(double), "deltas", "double")) {
+        PyBuffer_Release(&keys);
+        return NULL;
+    }
+    if (deltas.len / deltas.itemsize != n) {
+        PyErr_SetString(PyExc_ValueError,
+                "'deltas' must have the same length as 'keys'");
+        PyBuffer_Release(&deltas);
+        PyBuffer_Release(&keys);
+        return NULL;
+    }
+
+    res = int2float_add_many(self->hashmap,
+            (const unsigned long long*) keys.buf,
+            (const double*) deltas.buf, (size_t) n, &new_hashmap);
+    self->hashmap = new_hashmap;
+    PyBuffer_Release(&deltas);
+    PyBuffer_Release(&keys);
+    if (res) {
+        Int2Float_set_error(self);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject* Int2Float_from_arrays(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    PyObject *empty_args;
+    PyObject *self;
+    PyObject *res;
+
+    if (NULL == (empty_args = PyTuple_New(0))) {
+        return NULL;
+    }
+    self = PyObject_Call((PyObject*) cls, empty_args, kwds);
+    Py_DECREF(empty_args);
+    if (NULL == self) {
+        return NULL;
+    }
+    res = Int2Float_update_from_buffers((Int2Float_t*) self, args);
+    if (NULL == res) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    Py_DECREF(res);
+
+    return self;
+}
+
 static PyObject* Int2Float_setdefault(Int2Float_t *self, PyObject *args) {
     PyObject * key;
     PyObject * default_value = NULL;
@@ -1699,17 +4503,60 @@ static PyObject* Int2Float_setdefault(Int2Float_t *self, PyObject *args) {
     return PyFloat_FromDouble(c_value);
 }
 
-static PyObject* Int2Float_reduce(Int2Float_t *self) {
+/* Validate header of the table in memory of len bytes and bounds of the
+   table, sets exception if the table can't be used */
+static int Int2Float_check_table(const Int2FloatHashTable_t * const hashmap,
+        const size_t len) {
+    size_t expected_table_size;
+
+    if (0 != ((uintptr_t) hashmap % sizeof(double))) {
+        PyErr_SetString(PyExc_ValueError, "Buffer is not aligned");
+        return -1;
+    }
+    if (len < sizeof(Int2FloatHashTable_t)) {
+        PyErr_SetString(PyExc_ValueError, "Buffer is too small");
+        return -1;
+    }
+    if (((HASHMAP_LEGACY_VERSION != hashmap->version)
+                    && (HASHMAP_VERSION != hashmap->version))
+            || ((HASHMAP_LEGACY_VERSION == hashmap->version)
+                    && !hashmap->readonly)
+            || (0 == int2float_layout_table_size(0, hashmap->layout))
+            || (hashmap->current_size > hashmap->size)
+            || (hashmap->size > hashmap->table_size)) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the table");
+        return -1;
+    }
+    if (HASHMAP_VERSION == hashmap->version) {
+        expected_table_size = int2float_layout_table_size(hashmap->size,
+                hashmap->layout);
+        if (hashmap->table_size != expected_table_size) {
+            PyErr_SetString(PyExc_ValueError,
+                    "Unsupported format of the table");
+            return -1;
+        }
+    }
+    if (len < int2float_buffer_size(hashmap)) {
+        PyErr_SetString(PyExc_ValueError, "Table exceeds the buffer");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Return reduced value with data of the table (stolen reference), block
+   tells whether data hold the whole memory block including the header */
+static PyObject* Int2Float_reduce_data(Int2Float_t *self, PyObject *data,
+        const bool block) {
     PyObject *res = NULL;
     PyObject *args = NULL;
     PyObject *callable = NULL;
     PyObject *readonly;
-    PyObject *data;
 
     if (NULL == (res = PyTuple_New(2))) {
         goto error;
     }
-    if (NULL == (args = PyTuple_New(6))) {
+    if (NULL == (args = PyTuple_New(11))) {
         goto error;
     }
     if (NULL == (callable = PyObject_GetAttrString(
@@ -1718,11 +4565,6 @@ static PyObject* Int2Float_reduce(Int2Float_t *self) {
     }
 
     readonly = self->hashmap->readonly ? Py_True : Py_False;
-    if (NULL == (data = PyBytes_FromStringAndSize(
-            (const char *) self->table,
-            self->hashmap->table_size * sizeof(Int2FloatItem_t)))) {
-        goto error;
-    }
 
     Py_INCREF(self->default_value);
     Py_INCREF(readonly);
@@ -1733,6 +4575,12 @@ static PyObject* Int2Float_reduce(Int2Float_t *self) {
     PyTuple_SET_ITEM(args, 3, PyLong_FromSize_t(self->hashmap->table_size));
     PyTuple_SET_ITEM(args, 4, readonly);
     PyTuple_SET_ITEM(args, 5, data);
+    PyTuple_SET_ITEM(args, 6, PyLong_FromLong(self->hashmap->version));
+    PyTuple_SET_ITEM(args, 7, PyLong_FromLong(self->hashmap->layout));
+    PyTuple_SET_ITEM(args, 8, PyBool_FromLong(self->hashmap->zero_key_used));
+    PyTuple_SET_ITEM(args, 9, PyBool_FromLong(block));
+    /* Header of int2float has no shrink_load, it is passed beside it */
+    PyTuple_SET_ITEM(args, 10, PyFloat_FromDouble(self->shrink_load));
 
     PyTuple_SET_ITEM(res, 0, callable);
     PyTuple_SET_ITEM(res, 1, args);
@@ -1740,6 +4588,7 @@ static PyObject* Int2Float_reduce(Int2Float_t *self) {
     return res;
 
 error:
+    Py_DECREF(data);
     Py_XDECREF(res);
     Py_XDECREF(args);
     Py_XDECREF(callable);
@@ -1747,6 +4596,50 @@ error:
     return NULL;
 }
 
+static PyObject* Int2Float_reduce(Int2Float_t *self) {
+    PyObject *data;
+
+    if (NULL == (data = PyBytes_FromStringAndSize(
+            (const char *) self->hashmap + sizeof(Int2FloatHashTable_t),
+            int2float_buffer_size(self->hashmap)
+                    - sizeof(Int2FloatHashTable_t)))) {
+        return NULL;
+    }
+
+    return Int2Float_reduce_data(self, data, false);
+}
+
+static PyObject* Int2Float_reduce_ex(Int2Float_t *self, PyObject *args) {
+    int protocol;
+#if PY_VERSION_HEX >= 0x03080000
+    PyObject *block;
+    PyObject *data;
+#endif
+
+    if (!PyArg_ParseTuple(args, "i", &protocol)) {
+        return NULL;
+    }
+#if PY_VERSION_HEX >= 0x03080000
+    /* Protocol 5 pickles the whole memory block without a copy, pickler
+       with buffer_callback passes it out-of-band */
+    if ((protocol >= 5) && (HASHMAP_VERSION == self->hashmap->version)) {
+        if (NULL == (block = HashmapBlock_new((PyObject*) self,
+                &self->exports, self->hashmap,
+                int2float_buffer_size(self->hashmap)))) {
+            return NULL;
+        }
+        data = PyPickleBuffer_FromObject(block);
+        Py_DECREF(block);
+        if (NULL == data) {
+            return NULL;
+        }
+        return Int2Float_reduce_data(self, data, true);
+    }
+#endif
+
+    return Int2Float_reduce(self);
+}
+
 static PyObject* Int2Float_from_raw_data(PyTypeObject *cls, PyObject *args) {
     PyObject *default_value = Py_None;
     size_t size;
@@ -1754,13 +4647,21 @@ static PyObject* Int2Float_from_raw_data(PyTypeObject *cls, PyObject *args) {
     size_t table_size;
     int readonly;
     Py_buffer buffer = { .obj = NULL };
+    unsigned char version = HASHMAP_LEGACY_VERSION;
+    unsigned char layout = HASHMAP_LAYOUT_ITEMS;
+    int zero_key_used = false;
+    int block = false;
+    double shrink_load = 0.0;
+    size_t table_memory_size;
     size_t int2float_memory_size;
+    Int2FloatHashTable_t *hashmap;
     Int2Float_t *self = NULL;
     PyObject *res = NULL;
 
     /* Parse arguments */
-    if (!PyArg_ParseTuple(args, "Onnnpy*", &default_value, &size,
-            &current_size, &table_size, &readonly, &buffer)) {
+    if (!PyArg_ParseTuple(args, "Onnnpy*|bbppd", &default_value, &size,
+            &current_size, &table_size, &readonly, &buffer, &version,
+            &layout, &zero_key_used, &block, &shrink_load)) {
         goto error;
     }
     /* Validate arguments */
@@ -1771,37 +4672,102 @@ static PyObject* Int2Float_from_raw_data(PyTypeObject *cls, PyObject *args) {
         PyErr_SetString(PyExc_TypeError, "'default' must be float");
         goto error;
     }
+    if (((HASHMAP_LEGACY_VERSION != version) && (HASHMAP_VERSION != version))
+            || !((shrink_load >= 0.0) && (shrink_load < 1.0))
+            || (0 == int2float_layout_table_size(size, layout))
+            || ((HASHMAP_LEGACY_VERSION == version)
+                    && ((HASHMAP_LAYOUT_ITEMS != layout) || block))) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of raw data");
+        goto error;
+    }
+    int2float_memory_size = int2float_layout_memory_size(table_size, layout);
+    table_memory_size = int2float_memory_size - sizeof(Int2FloatHashTable_t);
     if ((size < current_size) || (table_size < size)
-            || ((size_t) buffer.len !=
-                    (table_size * sizeof(Int2FloatItem_t)))) {
+            || ((size_t) buffer.len != (block
+                    ? int2float_memory_size : table_memory_size))) {
         PyErr_SetString(PyExc_ValueError, "Inconsistent argument's values");
         goto error;
     }
+    if ((HASHMAP_VERSION == version)
+            && (table_size != int2float_layout_table_size(size, layout))) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of raw data");
+        goto error;
+    }
 
     /* Create instance */
     if (NULL == (self = (Int2Float_t*) cls->tp_alloc(cls, 0))) {
         goto error;
     }
+    self->shrink_load = shrink_load;
+
+    /* Read-only table in the received memory block is used in place, the
+       instance holds the buffer */
+    if (block && readonly
+            && (0 == ((uintptr_t) buffer.buf % sizeof(double)))) {
+        hashmap = (Int2FloatHashTable_t*) buffer.buf;
+        if (Int2Float_check_table(hashmap, (size_t) buffer.len)) {
+            goto error;
+        }
+        if (!hashmap->readonly || (hashmap->size != size)
+                || (hashmap->current_size != current_size)
+                || (hashmap->table_size != table_size)
+                || (hashmap->layout != layout)) {
+            PyErr_SetString(PyExc_ValueError,
+                    "Inconsistent argument's values");
+            goto error;
+        }
+        self->hashmap = hashmap;
+        self->memory = buffer;
+        buffer.obj = NULL;
+        self->default_value = default_value;
+        Py_INCREF(self->default_value);
+        res = (PyObject*) self;
+        goto cleanup;
+    }
 
     /* Allocate memory for Int2FloatHashTable_t structure and hashtable. At
        the beginning of block of the memory Int2FloatHashTable_t structure
        is placed, followed by hashtable (array of Int2FloatItem_t). */
-    int2float_memory_size = INT2FLOAT_MEMORY_SIZE(table_size);
-    if (NULL == (self->hashmap = malloc(int2float_memory_size))) {
-        PyErr_NoMemory();
-        goto error;
+    if (HASHMAP_LEGACY_VERSION == version) {
+        /* Legacy table has different hash, so items are inserted again */
+        Int2FloatItem_t *items = (Int2FloatItem_t*) buffer.buf;
+
+        if (int2float_new(size, &self->hashmap)) {
+            PyErr_NoMemory();
+            goto error;
+        }
+        for (size_t i=0; i<table_size; ++i) {
+            if (USED == items[i].status) {
+                if (int2float_set(self->hashmap, items[i].key,
+                        items[i].value, NULL)) {
+                    free(self->hashmap);
+                    PyErr_NoMemory();
+                    goto error;
+                }
+            }
+        }
+    }
+    else {
+        if (NULL == (self->hashmap = malloc(int2float_memory_size))) {
+            PyErr_NoMemory();
+            goto error;
+        }
+        memset(self->hashmap, 0, int2float_memory_size);
+        self->hashmap->size = size;
+        self->hashmap->current_size = current_size;
+        self->hashmap->table_size = table_size;
+        self->hashmap->version = version;
+        self->hashmap->layout = layout;
+        self->hashmap->zero_key_used = zero_key_used;
+        memcpy((char *) self->hashmap + sizeof(Int2FloatHashTable_t),
+                (char *) buffer.buf
+                        + (block ? sizeof(Int2FloatHashTable_t) : 0),
+                table_memory_size);
     }
-    memset(self->hashmap, 0, int2float_memory_size);
 
     self->release_memory = true;
     self->default_value = default_value;
-    self->hashmap->size = size;
-    self->hashmap->current_size = current_size;
-    self->hashmap->table_size = table_size;
     self->hashmap->readonly = readonly;
-    self->table = (Int2FloatItem_t*) (
-            (char*) self->hashmap + sizeof(Int2FloatHashTable_t));
-    memcpy((void *) self->table, buffer.buf, buffer.len);
 
     Py_INCREF(self->default_value);
     res = (PyObject*) self;
@@ -1811,35 +4777,570 @@ error:
     if (NULL != self) {
         cls->tp_free((PyObject*) self);
     }
-cleanup:
-    if (NULL != buffer.obj) {
-        PyBuffer_Release(&buffer);
+cleanup:
+    if (NULL != buffer.obj) {
+        PyBuffer_Release(&buffer);
+    }
+
+    return res;
+}
+
+static PyObject* Int2Float_from_ptr(PyTypeObject *cls, PyObject *args) {
+    const Py_ssize_t addr;
+    Int2Float_t *self;
+
+    /* Parse addr */
+    if (!PyArg_ParseTuple(args, "n", &addr)) {
+        return NULL;
+    }
+
+    /* Create instance */
+    self = (Int2Float_t*) cls->tp_alloc(cls, 0);
+    if (!self) {
+        return NULL;
+    }
+    self->default_value = Py_None;
+    self->release_memory = false;
+    self->hashmap = (Int2FloatHashTable_t*) addr;
+
+    Py_INCREF(self->default_value);
+    return (PyObject*) self;
+}
+
+/* Size of the memory block of the table for capacity items, sets
+   exception if arguments are not valid */
+static int Int2Float_fixed_memory_size(const Py_ssize_t capacity,
+        const char * const layout_name, HashmapLayout_e * const layout,
+        size_t * const memory_size) {
+    *layout = HASHMAP_LAYOUT_ITEMS;
+    if ((NULL != layout_name) && layout_from_name(layout_name, layout)) {
+        return -1;
+    }
+    if (capacity < 0) {
+        PyErr_SetString(PyExc_ValueError, "'capacity' must not be negative");
+        return -1;
+    }
+    if (0 == int2float_layout_table_size(0, *layout)) {
+        PyErr_Format(PyExc_ValueError,
+                "Layout '%s' is not supported", layout_name);
+        return -1;
+    }
+    *memory_size = int2float_layout_memory_size(int2float_layout_table_size(
+            (size_t) capacity, *layout), *layout);
+    if (0 == *memory_size) {
+        PyErr_SetString(PyExc_ValueError, "'capacity' is too big");
+        return -1;
+    }
+
+    return 0;
+}
+
+static PyObject* Int2Float_buffer_size_for(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"capacity", "layout", NULL};
+    Py_ssize_t capacity;
+    const char *layout_name = NULL;
+    HashmapLayout_e layout;
+    size_t memory_size;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "n|$s", kwnames,
+            &capacity, &layout_name)) {
+        return NULL;
+    }
+    if (Int2Float_fixed_memory_size(capacity, layout_name,
+            &layout, &memory_size)) {
+        return NULL;
+    }
+
+    return PyLong_FromSize_t(memory_size);
+}
+
+static PyObject* Int2Float_create_in(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"buffer", "capacity", "default", "layout", NULL};
+    PyObject *buffer;
+    Py_ssize_t capacity;
+    PyObject *default_value = Py_None;
+    const char *layout_name = NULL;
+    HashmapLayout_e layout;
+    size_t memory_size;
+    Int2Float_t *self;
+
+    /* Parse arguments */
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "On|$Os", kwnames,
+            &buffer, &capacity, &default_value, &layout_name)) {
+        return NULL;
+    }
+    if (Int2Float_fixed_memory_size(capacity, layout_name,
+            &layout, &memory_size)) {
+        return NULL;
+    }
+    if ((default_value != Py_None) && !PyLong_Check(default_value)
+            && !PyFloat_Check(default_value)) {
+        PyErr_SetString(PyExc_TypeError, "'default' must be a float");
+        return NULL;
+    }
+    if (PyLong_Check(default_value)) {
+        if (NULL == (default_value = PyNumber_Float(default_value))) {
+            return NULL;
+        }
+    } else {
+        Py_INCREF(default_value);
+    }
+
+    /* Create instance, it holds the buffer while it exists */
+    if (NULL == (self = (Int2Float_t*) cls->tp_alloc(cls, 0))) {
+        Py_DECREF(default_value);
+        return NULL;
+    }
+    self->default_value = default_value;
+    if (PyObject_GetBuffer(buffer, &self->memory, PyBUF_WRITABLE)) {
+        goto error;
+    }
+    if ((size_t) self->memory.len < memory_size) {
+        PyErr_Format(PyExc_ValueError,
+                "Buffer of %zd bytes is too small, %zu bytes are needed",
+                self->memory.len, memory_size);
+        goto error;
+    }
+    if (int2float_new_in(self->memory.buf, (size_t) self->memory.len,
+            (size_t) capacity, layout, &self->hashmap)) {
+        PyErr_SetString(PyExc_ValueError, "Buffer is not aligned");
+        goto error;
+    }
+
+    return (PyObject*) self;
+
+error:
+    Py_DECREF(self);
+    return NULL;
+}
+
+static PyObject* Int2Float_from_buffer(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"buffer", "default", NULL};
+    PyObject *buffer;
+    PyObject *default_value = Py_None;
+    Int2FloatHashTable_t *hashmap;
+    Int2Float_t *self;
+
+    /* Parse arguments */
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|$O", kwnames,
+            &buffer, &default_value)) {
+        return NULL;
+    }
+    if ((default_value != Py_None) && !PyLong_Check(default_value)
+            && !PyFloat_Check(default_value)) {
+        PyErr_SetString(PyExc_TypeError, "'default' must be a float");
+        return NULL;
+    }
+    if (PyLong_Check(default_value)) {
+        if (NULL == (default_value = PyNumber_Float(default_value))) {
+            return NULL;
+        }
+    } else {
+        Py_INCREF(default_value);
+    }
+
+    /* Create instance, it holds the buffer while it exists */
+    if (NULL == (self = (Int2Float_t*) cls->tp_alloc(cls, 0))) {
+        Py_DECREF(default_value);
+        return NULL;
+    }
+    self->default_value = default_value;
+    if (PyObject_GetBuffer(buffer, &self->memory, PyBUF_WRITABLE)) {
+        /* Read-only buffer can hold only read-only table */
+        PyErr_Clear();
+        if (PyObject_GetBuffer(buffer, &self->memory, PyBUF_SIMPLE)) {
+            goto error;
+        }
+    }
+    hashmap = (Int2FloatHashTable_t*) self->memory.buf;
+
+    if (Int2Float_check_table(hashmap, (size_t) self->memory.len)) {
+        goto error;
+    }
+    if (self->memory.readonly && !hashmap->readonly) {
+        PyErr_SetString(PyExc_ValueError,
+                "Table in read-only buffer must be read-only");
+        goto error;
+    }
+    if (!hashmap->readonly) {
+        /* Memory of the caller must not be reallocated */
+        hashmap->flags |= HASHMAP_FLAG_FIXED_SIZE;
+    }
+    self->hashmap = hashmap;
+
+    return (PyObject*) self;
+
+error:
+    Py_DECREF(self);
+    return NULL;
+}
+
+static PyObject* Int2Float_save(Int2Float_t *self,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"path", NULL};
+    PyObject *path;
+    HashmapFileHeader_t header;
+    int res;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&", kwnames,
+            PyUnicode_FSDecoder, &path)) {
+        return NULL;
+    }
+    int2float_file_header(self->hashmap, &header);
+    res = save_table(path, &header, self->hashmap);
+    Py_DECREF(path);
+    if (res) {
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject* Int2Float_open(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"path", "mode", "default", "verify", NULL};
+    PyObject *path;
+    const char *mode = "r";
+    PyObject *default_value = Py_None;
+    int verify = false;
+    HashmapFileHeader_t *header;
+    Int2FloatHashTable_t *hashmap;
+    Int2Float_t *self = NULL;
+
+    /* Parse arguments */
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|s$Op", kwnames,
+            PyUnicode_FSDecoder, &path, &mode, &default_value, &verify)) {
+        return NULL;
+    }
+    if ((default_value != Py_None) && !PyLong_Check(default_value)
+            && !PyFloat_Check(default_value)) {
+        PyErr_SetString(PyExc_TypeError, "'default' must be a float");
+        goto error;
+    }
+    if (PyLong_Check(default_value)) {
+        if (NULL == (default_value = PyNumber_Float(default_value))) {
+            goto error;
+        }
+    } else {
+        Py_INCREF(default_value);
+    }
+
+    /* Create instance, it holds the mapped file while it exists */
+    if (NULL == (self = (Int2Float_t*) cls->tp_alloc(cls, 0))) {
+        Py_DECREF(default_value);
+        goto error;
+    }
+    self->default_value = default_value;
+    if (NULL == (hashmap = (Int2FloatHashTable_t*) open_table(path, mode,
+            HASHMAP_FILE_INT2FLOAT, verify, &self->memory))) {
+        goto error;
+    }
+    header = (HashmapFileHeader_t*) self->memory.buf;
+    if (Int2Float_check_table(hashmap, (size_t) header->table_bytes)) {
+        goto error;
+    }
+    if ((header->layout != hashmap->layout)
+            || (header->size != hashmap->size)
+            || (header->table_size != hashmap->table_size)) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the file");
+        goto error;
+    }
+    if (0 == strcmp(mode, "r")) {
+        /* Only private copy of the first page is modified */
+        hashmap->readonly = true;
+    } else {
+        /* Table is modified in place, saved checksum is no longer valid */
+        header->checksum = 0;
+        if (!hashmap->readonly) {
+            hashmap->flags |= HASHMAP_FLAG_FIXED_SIZE;
+        }
+    }
+    self->hashmap = hashmap;
+    Py_DECREF(path);
+
+    return (PyObject*) self;
+
+error:
+    Py_XDECREF(self);
+    Py_DECREF(path);
+    return NULL;
+}
+
+/* Copy up to n used items from position into slots, return their count */
+static size_t Int2Float_next_slots(const Int2FloatHashTable_t * const ctx,
+        size_t * const position, Int2FloatSlot_t * const slots,
+        const size_t n) {
+    unsigned long long key;
+    double *value;
+    size_t count = 0;
+
+    while ((count < n) && (0 == int2float_next(ctx, position, &key, &value))) {
+        slots[count].key = key;
+        slots[count].value = *value;
+        ++count;
+    }
+
+    return count;
+}
+
+/* Write header of the stream and of the table followed by key/value slots
+   of used items. Checksum must be written first, so the items are walked
+   through twice. */
+static int Int2Float_dump_pairs(const Int2FloatHashTable_t * const ctx,
+        PyObject * const file) {
+    HashmapFileHeader_t header;
+    Int2FloatHashTable_t table;
+    Int2FloatSlot_t *slots;
+    const size_t chunk = STREAM_CHUNK_SIZE / sizeof(Int2FloatSlot_t);
+    unsigned long long checksum;
+    size_t position;
+    size_t count;
+
+    /* Header of the table without internal flags */
+    memset(&table, 0, sizeof(Int2FloatHashTable_t));
+    table.size = ctx->size;
+    table.current_size = ctx->current_size;
+    table.table_size = ctx->table_size;
+    table.readonly = ctx->readonly;
+    table.version = HASHMAP_VERSION;
+    table.layout = ctx->layout;
+
+    if (NULL == (slots = malloc(chunk * sizeof(Int2FloatSlot_t)))) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    checksum = hashmap_checksum_update(HASHMAP_CHECKSUM_INIT,
+            &table, sizeof(Int2FloatHashTable_t));
+    position = 0;
+    while (0 != (count = Int2Float_next_slots(ctx, &position, slots, chunk))) {
+        checksum = hashmap_checksum_update(checksum, slots,
+                count * sizeof(Int2FloatSlot_t));
+    }
+    stream_pairs_header(&header, HASHMAP_FILE_INT2FLOAT, table.layout,
+            table.size, table.current_size, table.table_size,
+            sizeof(Int2FloatHashTable_t)
+                    + table.current_size * sizeof(Int2FloatSlot_t),
+            checksum);
+
+    if (stream_write(file, &header, sizeof(HashmapFileHeader_t))
+            || stream_write(file, &table, sizeof(Int2FloatHashTable_t))) {
+        goto error;
+    }
+    position = 0;
+    while (0 != (count = Int2Float_next_slots(ctx, &position, slots, chunk))) {
+        if (stream_write(file, slots, count * sizeof(Int2FloatSlot_t))) {
+            goto error;
+        }
+    }
+    free(slots);
+
+    return 0;
+
+error:
+    free(slots);
+    return -1;
+}
+
+static PyObject* Int2Float_dump(Int2Float_t *self,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"file", "pairs", NULL};
+    PyObject *file;
+    int pairs = false;
+    HashmapFileHeader_t header;
+    int res;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|$p", kwnames,
+            &file, &pairs)) {
+        return NULL;
+    }
+
+    /* Table can't be changed by the file object while it is written */
+    self->exports += 1;
+    if (pairs || (HASHMAP_LEGACY_VERSION == self->hashmap->version)) {
+        /* Legacy block can be attached only read-only, so it is stored
+           as pairs too */
+        res = Int2Float_dump_pairs(self->hashmap, file);
+    } else {
+        int2float_file_header(self->hashmap, &header);
+        res = stream_write(file, &header, sizeof(HashmapFileHeader_t))
+                || stream_write(file, self->hashmap, header.table_bytes);
+    }
+    self->exports -= 1;
+    if (res) {
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+/* Read the memory block of the table from the stream, the block is read
+   directly into the new table */
+static Int2FloatHashTable_t* Int2Float_load_block(PyObject * const file,
+        const HashmapFileHeader_t * const header) {
+    Int2FloatHashTable_t table;
+    Int2FloatHashTable_t *hashmap;
+    const size_t head_size = (header->table_bytes
+            < sizeof(Int2FloatHashTable_t))
+                    ? header->table_bytes : sizeof(Int2FloatHashTable_t);
+    unsigned long long checksum = HASHMAP_CHECKSUM_INIT;
+
+    memset(&table, 0, sizeof(Int2FloatHashTable_t));
+    if (stream_readinto(file, &table, head_size, &checksum)) {
+        return NULL;
+    }
+    if (Int2Float_check_table(&table, header->table_bytes)) {
+        return NULL;
+    }
+    if (header->table_bytes != int2float_buffer_size(&table)) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the stream");
+        return NULL;
+    }
+    if (NULL == (hashmap = malloc(header->table_bytes))) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    memcpy(hashmap, &table, head_size);
+    if (stream_readinto(file, (char*) hashmap + head_size,
+            header->table_bytes - head_size, &checksum)) {
+        free(hashmap);
+        return NULL;
+    }
+    if ((0 != header->checksum) && (header->checksum != checksum)) {
+        free(hashmap);
+        PyErr_SetString(PyExc_ValueError, "Checksum of the stream is wrong");
+        return NULL;
+    }
+    /* Table is owned by the instance now */
+    hashmap->flags = 0;
+
+    return hashmap;
+}
+
+/* Rebuild the table from the stream of key/value pairs */
+static Int2FloatHashTable_t* Int2Float_load_pairs(PyObject * const file,
+        const HashmapFileHeader_t * const header) {
+    Int2FloatHashTable_t table;
+    Int2FloatHashTable_t *hashmap = NULL;
+    Int2FloatSlot_t *slots = NULL;
+    const size_t chunk = STREAM_CHUNK_SIZE / sizeof(Int2FloatSlot_t);
+    unsigned long long checksum = HASHMAP_CHECKSUM_INIT;
+    size_t remaining;
+    size_t count;
+
+    if (header->table_bytes < sizeof(Int2FloatHashTable_t)) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the stream");
+        return NULL;
+    }
+    if (stream_readinto(file, &table, sizeof(Int2FloatHashTable_t),
+            &checksum)) {
+        return NULL;
+    }
+    if ((HASHMAP_VERSION != table.version)
+            || (0 == int2float_layout_table_size(0, table.layout))
+            || (table.current_size > table.size)
+            || ((header->table_bytes - sizeof(Int2FloatHashTable_t))
+                    / sizeof(Int2FloatSlot_t) != table.current_size)
+            || ((header->table_bytes - sizeof(Int2FloatHashTable_t))
+                    % sizeof(Int2FloatSlot_t) != 0)) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the stream");
+        return NULL;
+    }
+
+    if (int2float_new_layout(table.size, table.layout, &hashmap)) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    if (NULL == (slots = malloc(chunk * sizeof(Int2FloatSlot_t)))) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    remaining = table.current_size;
+    while (remaining > 0) {
+        count = (remaining < chunk) ? remaining : chunk;
+        if (stream_readinto(file, slots, count * sizeof(Int2FloatSlot_t),
+                &checksum)) {
+            goto error;
+        }
+        for (size_t i=0; i<count; ++i) {
+            if (int2float_set(hashmap, slots[i].key, slots[i].value,
+                    &hashmap)) {
+                PyErr_NoMemory();
+                goto error;
+            }
+        }
+        remaining -= count;
+    }
+    free(slots);
+    slots = NULL;
+    if ((0 != header->checksum) && (header->checksum != checksum)) {
+        PyErr_SetString(PyExc_ValueError, "Checksum of the stream is wrong");
+        goto error;
+    }
+    if (hashmap->current_size != table.current_size) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the stream");
+        goto error;
     }
+    hashmap->readonly = table.readonly;
 
-    return res;
+    return hashmap;
+
+error:
+    free(slots);
+    free(hashmap);
+    return NULL;
 }
 
-static PyObject* Int2Float_from_ptr(PyTypeObject *cls, PyObject *args) {
-    const Py_ssize_t addr;
+static PyObject* Int2Float_load(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"file", "default", NULL};
+    PyObject *file;
+    PyObject *default_value = Py_None;
+    HashmapFileHeader_t header;
+    Int2FloatHashTable_t *hashmap;
     Int2Float_t *self;
 
-    /* Parse addr */
-    if (!PyArg_ParseTuple(args, "n", &addr)) {
+    /* Parse arguments */
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|$O", kwnames,
+            &file, &default_value)) {
+        return NULL;
+    }
+    if ((default_value != Py_None) && !PyLong_Check(default_value)
+            && !PyFloat_Check(default_value)) {
+        PyErr_SetString(PyExc_TypeError, "'default' must be a float");
+        return NULL;
+    }
+
+    /* Read the table */
+    if (stream_read_header(file, &header, HASHMAP_FILE_INT2FLOAT)) {
+        return NULL;
+    }
+    hashmap = (header.flags & HASHMAP_FILE_FLAG_PAIRS)
+            ? Int2Float_load_pairs(file, &header)
+            : Int2Float_load_block(file, &header);
+    if (NULL == hashmap) {
         return NULL;
     }
 
     /* Create instance */
-    self = (Int2Float_t*) cls->tp_alloc(cls, 0);
-    if (!self) {
+    if (NULL == (self = (Int2Float_t*) cls->tp_alloc(cls, 0))) {
+        free(hashmap);
         return NULL;
     }
-    self->default_value = Py_None;
-    self->release_memory = false;
-    self->hashmap = (Int2FloatHashTable_t*) addr;
-    self->table = (Int2FloatItem_t*) (
-            (char*) self->hashmap + sizeof(Int2FloatHashTable_t));
+    self->hashmap = hashmap;
+    self->release_memory = true;
+    if (PyLong_Check(default_value)) {
+        if (NULL == (self->default_value = PyNumber_Float(default_value))) {
+            Py_DECREF(self);
+            return NULL;
+        }
+    } else {
+        self->default_value = default_value;
+        Py_INCREF(self->default_value);
+    }
 
-    Py_INCREF(self->default_value);
     return (PyObject*) self;
 }
 
@@ -1857,12 +5358,16 @@ static PyObject* Int2Float_get_readonly(Int2Float_t *self) {
     }
 }
 
+static PyObject* Int2Float_get_layout(Int2Float_t *self) {
+    return layout_to_name(self->hashmap->layout);
+}
+
 static PyObject* Int2Float_get_buffer_ptr(Int2Float_t *self) {
     return PyLong_FromVoidPtr(self->hashmap);
 }
 
 static PyObject* Int2Float_get_buffer_size(Int2Float_t *self) {
-    return PyLong_FromSize_t(INT2FLOAT_MEMORY_SIZE(self->hashmap->table_size));
+    return PyLong_FromSize_t(int2float_buffer_size(self->hashmap));
 }
 
 static PySequenceMethods Int2Float_sequence_methods = {
@@ -1891,6 +5396,20 @@ static PyMethodDef Int2Float_methods[] = {
             "\n"
             "Return value for key. If key does not exist, return default\n"
             "value, otherwise return None. default must be float or None."},
+    {"get_many", (PyCFunction) Int2Float_get_many,
+            METH_VARARGS | METH_KEYWORDS,
+            "get_many(self, keys, out=None, *, found=None, default=None)\n"
+            "--\n"
+            "\n"
+            "Look up all keys from buffer of uint64 (e.g. array('Q')) and\n"
+            "return buffer of their values. Values are stored into out,\n"
+            "writable buffer of double of the same length, new array('d') is\n"
+            "created if it is None. found is optional writable buffer of\n"
+            "bool which is set to True for found keys. Missing key gets\n"
+            "default value, its out item is unchanged if default is not\n"
+            "specified, or KeyError is raised if neither default nor found\n"
+            "is specified. Lookup runs without the GIL, the instance can't\n"
+            "be changed by other threads meanwhile."},
     {"keys", (PyCFunction) Int2Float_keys, METH_VARARGS,
             "keys(self, /)\n"
             "--\n"
@@ -1910,6 +5429,30 @@ static PyMethodDef Int2Float_methods[] = {
             "Return an iterator over the hashmaps’s (key, value) tuple\n"
             "pairs. Don't change hashmap during iteration, behavior is\n"
             "undefined!"},
+    {"keys_array", (PyCFunction) Int2Float_keys_array,
+            METH_VARARGS | METH_KEYWORDS,
+            "keys_array(self, out=None)\n"
+            "--\n"
+            "\n"
+            "Return buffer of all keys. Keys are copied into out, writable\n"
+            "buffer of uint64 of the same length as the mapping, new\n"
+            "array('Q') is created if it is None."},
+    {"values_array", (PyCFunction) Int2Float_values_array,
+            METH_VARARGS | METH_KEYWORDS,
+            "values_array(self, out=None)\n"
+            "--\n"
+            "\n"
+            "Return buffer of all values in the order of keys_array().\n"
+            "Values are copied into out, writable buffer of double of the\n"
+            "same length as the mapping, new array('d') is created if it\n"
+            "is None."},
+    {"items_arrays", (PyCFunction) Int2Float_items_arrays,
+            METH_VARARGS | METH_KEYWORDS,
+            "items_arrays(self, keys_out=None, values_out=None)\n"
+            "--\n"
+            "\n"
+            "Return tuple (keys, values) of buffers as keys_array() and\n"
+            "values_array() do, in one pass over the table."},
     {"pop", (PyCFunction) Int2Float_pop, METH_VARARGS,
             "pop(self, key, default, /)\n"
              "--\n"
@@ -1928,6 +5471,12 @@ static PyMethodDef Int2Float_methods[] = {
             "--\n"
             "\n"
             "Remove all items from structure."},
+    {"shrink_to_fit", (PyCFunction) Int2Float_shrink_to_fit, METH_NOARGS,
+            "shrink_to_fit(self, /)\n"
+            "--\n"
+            "\n"
+            "Rebuild the table into memory block sized for current items\n"
+            "and release the old one. Use it after mass deletion."},
     {"update", (PyCFunction) Int2Float_update, METH_VARARGS,
             "update(self, initializer, /)\n"
             "--\n"
@@ -1935,6 +5484,35 @@ static PyMethodDef Int2Float_methods[] = {
             "Update mapping with keys and values from initializer,\n"
             "overwrite existing values. initializer can be either\n"
             "iterable with (key, value) pairs or mapping."},
+    {"update_from_buffers", (PyCFunction) Int2Float_update_from_buffers,
+            METH_VARARGS,
+            "update_from_buffers(self, keys, values, /)\n"
+            "--\n"
+            "\n"
+            "Set keys from buffer of uint64 (e.g. array('Q')) to values\n"
+            "from buffer of double of the same length. The table is resized\n"
+            "at most once, no Python objects are created."},
+    {"add", (PyCFunction) Int2Float_add, METH_VARARGS,
+            "add(self, key, delta, /)\n"
+            "--\n"
+            "\n"
+            "Add delta to the value of key and return the new value, key\n"
+            "which is not in the instance is set to delta. Key is looked up\n"
+            "only once."},
+    {"add_many", (PyCFunction) Int2Float_add_many, METH_VARARGS,
+            "add_many(self, keys, deltas, /)\n"
+            "--\n"
+            "\n"
+            "add() every key from buffer of uint64 (e.g. array('Q')) with\n"
+            "delta from buffer of double of the same length, keys may\n"
+            "repeat. No Python objects are created."},
+    {"from_arrays", (PyCFunction) Int2Float_from_arrays,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "from_arrays(cls, keys, values, /, **kwargs)\n"
+            "--\n"
+            "\n"
+            "Return new instance created by kwargs and filled by\n"
+            "update_from_buffers(keys, values)."},
     {"setdefault", (PyCFunction) Int2Float_setdefault, METH_VARARGS,
             "setdefault(self, key, default, /)\n"
             "--\n"
@@ -1948,16 +5526,91 @@ static PyMethodDef Int2Float_methods[] = {
             "\n"
             "Return instance created from address pointed to existing\n"
             "Int2Float memory block."},
+    {"buffer_size_for", (PyCFunction) Int2Float_buffer_size_for,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "buffer_size_for(cls, capacity, *, layout='items')\n"
+            "--\n"
+            "\n"
+            "Return number of bytes create_in() needs for the table of\n"
+            "capacity items."},
+    {"create_in", (PyCFunction) Int2Float_create_in,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "create_in(cls, buffer, capacity, *, default=None, "
+            "layout='items')\n"
+            "--\n"
+            "\n"
+            "Return new empty instance whose table is formatted directly in\n"
+            "writable buffer (e.g. mmap, shared_memory) and modified in\n"
+            "place. The table never grows, it holds at most capacity items,\n"
+            "set of a new key into the full instance raises RuntimeError.\n"
+            "The buffer is held while the instance exists."},
+    {"from_buffer", (PyCFunction) Int2Float_from_buffer,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "from_buffer(cls, buffer, *, default=None)\n"
+            "--\n"
+            "\n"
+            "Return instance which uses table at the beginning of buffer,\n"
+            "e.g. created by create_in() in other process. Header and size\n"
+            "of the table are validated against the buffer. Table in\n"
+            "read-only buffer must be read-only, table in writable buffer\n"
+            "gets fixed size as by create_in()."},
+    {"save", (PyCFunction) Int2Float_save, METH_VARARGS | METH_KEYWORDS,
+            "save(self, path)\n"
+            "--\n"
+            "\n"
+            "Write the table into file at path, it can be mapped back by\n"
+            "open(). File is written under temporary name and then renamed,\n"
+            "so processes which opened the previous file are not affected."},
+    {"open", (PyCFunction) Int2Float_open,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "open(cls, path, mode='r', *, default=None, verify=False)\n"
+            "--\n"
+            "\n"
+            "Return instance which uses table in file written by save(). The\n"
+            "file is mapped into the memory, so the table is not loaded and\n"
+            "processes which open the same file share one copy in the page\n"
+            "cache. Mode 'r' returns read-only instance, mode 'r+' modifies\n"
+            "the file in place and the table has fixed size as by\n"
+            "create_in(). If verify is true, checksum of the table is\n"
+            "checked, it reads the whole file."},
+    {"dump", (PyCFunction) Int2Float_dump, METH_VARARGS | METH_KEYWORDS,
+            "dump(self, file, *, pairs=False)\n"
+            "--\n"
+            "\n"
+            "Write the table into binary file object by chunks, the table\n"
+            "is not copied into memory. Stream has the format of save(). If\n"
+            "pairs is true, only key/value pairs of used items are written,\n"
+            "so size of the stream depends on number of items, not on size\n"
+            "of the table. Instance can't be modified by write() of the\n"
+            "file object."},
+    {"load", (PyCFunction) Int2Float_load,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "load(cls, file, *, default=None)\n"
+            "--\n"
+            "\n"
+            "Return instance read from binary file object written by dump()\n"
+            "or save(). The memory block is read by readinto() directly into\n"
+            "the new table, pairs are inserted chunk by chunk. Checksum is\n"
+            "always checked."},
     {"make_readonly", (PyCFunction) Int2Float_make_readonly, METH_NOARGS,
             "make_readonly(self, /)\n"
             "--\n"
             "\n"
             "Make Int2Float structure as a read-only."},
     {"__reduce__", (PyCFunction) Int2Float_reduce, METH_NOARGS,
-            "__setstate__(self, /)\n"
+            "__reduce__(self, /)\n"
             "--\n"
             "\n"
             "Return reduced value of the instance."},
+    {"__reduce_ex__", (PyCFunction) Int2Float_reduce_ex, METH_VARARGS,
+            "__reduce_ex__(self, protocol, /)\n"
+            "--\n"
+            "\n"
+            "Return reduced value of the instance. Protocol 5 passes the\n"
+            "memory block as PickleBuffer, so out-of-band pickling does not\n"
+            "copy it. Instance can't be modified while the buffer is\n"
+            "exported. Read-only table is unpickled in place of the\n"
+            "received buffer."},
     {"_from_raw_data", (PyCFunction) Int2Float_from_raw_data,
             METH_VARARGS | METH_CLASS,
             "_from_raw_data(self, ..., /)\n"
@@ -1970,16 +5623,86 @@ static PyMethodDef Int2Float_methods[] = {
     {NULL}
 };
 
+static PyObject* Int2Float_get_shrink_load(Int2Float_t *self) {
+    return PyFloat_FromDouble(self->shrink_load);
+}
+
 static PyGetSetDef Int2Float_getset[] = {
     {"readonly", (getter) Int2Float_get_readonly, NULL,
             "Flag that indicates that instance is read-only.", NULL},
+    {"layout", (getter) Int2Float_get_layout, NULL,
+            "Layout of the table in the internal buffer.", NULL},
     {"buffer_ptr", (getter) Int2Float_get_buffer_ptr, NULL,
             "Address of the internal buffer.", NULL},
     {"buffer_size", (getter) Int2Float_get_buffer_size, NULL,
             "Size of the internal buffer in bytes.", NULL},
+    {"shrink_load", (getter) Int2Float_get_shrink_load, NULL,
+            "Load under which deletion shrinks the table, 0 if disabled.",
+            NULL},
     {NULL}
 };
 
+/* Slot table is exported as read-only array of records, layouts which
+   keep keys, values or control bytes in separate arrays can't be
+   exported. Table is not changed or moved while a view is held. */
+static int Int2Float_getbuffer(Int2Float_t *self, Py_buffer *view, int flags) {
+    Int2FloatHashTable_t *hashmap = self->hashmap;
+    const char *format;
+    Py_ssize_t itemsize;
+    Py_ssize_t header_size;
+
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "Slot table is read-only");
+        return -1;
+    }
+    switch (hashmap->layout) {
+    case HASHMAP_LAYOUT_ITEMS:
+        format = "T{Q:key:d:value:I:status:I:distance:}";
+        itemsize = sizeof(Int2FloatItem_t);
+        break;
+    case HASHMAP_LAYOUT_COMPACT:
+        format = "T{Q:key:d:value:}";
+        itemsize = sizeof(Int2FloatSlot_t);
+        break;
+    default:
+        PyErr_Format(PyExc_BufferError,
+                "Layout '%s' can't be exported as array of slots",
+                layout_names[hashmap->layout]);
+        return -1;
+    }
+    header_size = sizeof(Int2FloatHashTable_t);
+    self->export_shape = ((Py_ssize_t) int2float_buffer_size(hashmap)
+            - header_size) / itemsize;
+    self->export_stride = itemsize;
+
+    view->obj = (PyObject*) self;
+    view->buf = (char*) hashmap + header_size;
+    view->len = self->export_shape * itemsize;
+    view->readonly = 1;
+    view->itemsize = itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? (char*) format : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &self->export_shape : NULL;
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES)
+            ? &self->export_stride : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+
+    Py_INCREF(self);
+    self->exports += 1;
+
+    return 0;
+}
+
+static void Int2Float_releasebuffer(Int2Float_t *self, Py_buffer *view) {
+    self->exports -= 1;
+}
+
+static PyBufferProcs Int2Float_buffer_procs = {
+    (getbufferproc) Int2Float_getbuffer,
+    (releasebufferproc) Int2Float_releasebuffer,
+};
+
 static PyTypeObject Int2Float_type = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "cdatastructs.hashmap.Int2Float",                   /* tp_name */
@@ -1999,10 +5722,10 @@ static PyTypeObject Int2Float_type = {
     0,                                                  /* tp_str */
     0,                                                  /* tp_getattro */
     0,                                                  /* tp_setattro */
-    0,                                                  /* tp_as_buffer */
+    &Int2Float_buffer_procs,                            /* tp_as_buffer */
     Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,           /* tp_flags */
     "Int2Float(self, initializer, default=None, "       /* tp_doc */
-    "prealloc_size=None, /)\n"
+    "prealloc_size=None, layout='items', shrink_load=0.0, /)\n"
     "--\n"
     "\n"
     "Simple fixed-size hashmap which maps int key to float value. Provides\n"
@@ -2015,7 +5738,18 @@ static PyTypeObject Int2Float_type = {
     "mapping. If default is specified, value of the default will be\n"
     "returned when key does not exist and will be stored into mapping.\n"
     "If prealloc_size is specified, memory for hashmap table will be\n"
-    "allocated for this amount of items.",
+    "allocated for this amount of items. layout selects how the table is\n"
+    "stored in the memory block: 'items' (key, value and status per\n"
+    "slot), 'compact' (16 bytes per slot, key 0 marks an empty slot) or\n"
+    "'soa' (as compact, but array of keys is followed by array of values).\n"
+    "If shrink_load is set, the table is rebuilt smaller when deletion\n"
+    "drops number of items under shrink_load of its capacity. It belongs\n"
+    "to the instance, pickled copies keep it, but dump() and from_ptr()\n"
+    "don't.\n"
+    "\n"
+    "Slot table of 'items' and 'compact' layouts is exported by the\n"
+    "buffer protocol as read-only array of records, e.g. for memoryview\n"
+    "or numpy. The instance can't be changed while a view is held.",
     0,                                                  /* tp_traverse */
     0,                                                  /* tp_clear */
     (richcmpfunc) Int2Float_richcompare,                /* tp_richcompare */
@@ -2035,10 +5769,383 @@ static PyTypeObject Int2Float_type = {
     (newfunc) Int2Float_new,                            /* tp_new */
 };
 
+/******************************************************************************
+ * Publisher                                                                  *
+ ******************************************************************************/
+
+typedef struct {
+    PyObject_HEAD
+    HashmapPublisher_t *publisher;
+    /* Buffer of the caller which holds the publisher */
+    Py_buffer memory;
+} Publisher_t;
+
+/* Slot of the generation held by the reader, the table of the slot is
+   exported as read-only buffer to Int2Int/Int2Float.from_buffer. Slot is
+   released when the last table attached to it is deallocated. */
+typedef struct {
+    PyObject_HEAD
+    PyObject *publisher;
+    HashmapPublisherSlot_t *slot;
+} PublisherSlot_t;
+
+static PyTypeObject PublisherSlot_type;
+
+static void PublisherSlot_dealloc(PublisherSlot_t *self) {
+    hashmap_publisher_release(self->slot);
+    Py_DECREF(self->publisher);
+    PyObject_Del(self);
+}
+
+static int PublisherSlot_getbuffer(PublisherSlot_t *self, Py_buffer *view,
+        int flags) {
+    return PyBuffer_FillInfo(view, (PyObject*) self,
+            HASHMAP_PUBLISHER_TABLE(self->slot),
+            (Py_ssize_t) self->slot->size, 1, flags);
+}
+
+static PyBufferProcs PublisherSlot_buffer_procs = {
+    (getbufferproc) PublisherSlot_getbuffer,
+    NULL,
+};
+
+static PyTypeObject PublisherSlot_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "cdatastructs.hashmap._PublisherSlot",
+    .tp_doc = "Slot of the published table held by the reader",
+    .tp_basicsize = sizeof(PublisherSlot_t),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_as_buffer = &PublisherSlot_buffer_procs,
+    .tp_dealloc = (destructor) PublisherSlot_dealloc
+};
+
+static void Publisher_dealloc(Publisher_t *self) {
+    PyBuffer_Release(&self->memory);
+    Py_TYPE(self)->tp_free((PyObject*) self);
+}
+
+/* Size of the memory of the publisher, sets exception if arguments are not
+   valid */
+static int Publisher_memory_size(const Py_ssize_t slot_size,
+        const int slots, size_t * const memory_size) {
+    if (slot_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "'slot_size' must not be negative");
+        return -1;
+    }
+    if (slots < 2) {
+        PyErr_SetString(PyExc_ValueError, "'slots' must be at least 2");
+        return -1;
+    }
+    *memory_size = hashmap_publisher_memory_size(
+            (unsigned int) slots, (size_t) slot_size);
+    if (0 == *memory_size) {
+        PyErr_SetString(PyExc_ValueError, "'slot_size' is too big");
+        return -1;
+    }
+
+    return 0;
+}
+
+static PyObject* Publisher_buffer_size_for(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"slot_size", "slots", NULL};
+    Py_ssize_t slot_size;
+    int slots = 2;
+    size_t memory_size;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "n|$i", kwnames,
+            &slot_size, &slots)) {
+        return NULL;
+    }
+    if (Publisher_memory_size(slot_size, slots, &memory_size)) {
+        return NULL;
+    }
+
+    return PyLong_FromSize_t(memory_size);
+}
+
+static PyObject* Publisher_create_in(PyTypeObject *cls,
+        PyObject *args, PyObject *kwds) {
+    char *kwnames[] = {"buffer", "slot_size", "slots", NULL};
+    PyObject *buffer;
+    Py_ssize_t slot_size;
+    int slots = 2;
+    size_t memory_size;
+    Publisher_t *self;
+
+    /* Parse arguments */
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "On|$i", kwnames,
+            &buffer, &slot_size, &slots)) {
+        return NULL;
+    }
+    if (Publisher_memory_size(slot_size, slots, &memory_size)) {
+        return NULL;
+    }
+
+    /* Create instance, it holds the buffer while it exists */
+    if (NULL == (self = (Publisher_t*) cls->tp_alloc(cls, 0))) {
+        return NULL;
+    }
+    if (PyObject_GetBuffer(buffer, &self->memory, PyBUF_WRITABLE)) {
+        goto error;
+    }
+    if ((size_t) self->memory.len < memory_size) {
+        PyErr_Format(PyExc_ValueError,
+                "Buffer of %zd bytes is too small, %zu bytes are needed",
+                self->memory.len, memory_size);
+        goto error;
+    }
+    if (hashmap_publisher_new_in(self->memory.buf,
+            (size_t) self->memory.len, (unsigned int) slots,
+            (size_t) slot_size, &self->publisher)) {
+        PyErr_SetString(PyExc_ValueError, "Buffer is not aligned");
+        goto error;
+    }
+
+    return (PyObject*) self;
+
+error:
+    Py_DECREF(self);
+    return NULL;
+}
+
+static PyObject* Publisher_from_buffer(PyTypeObject *cls, PyObject *buffer) {
+    Publisher_t *self;
+
+    /* Create instance, it holds the buffer while it exists */
+    if (NULL == (self = (Publisher_t*) cls->tp_alloc(cls, 0))) {
+        return NULL;
+    }
+    /* Readers count themselves in the memory, so it must be writable */
+    if (PyObject_GetBuffer(buffer, &self->memory, PyBUF_WRITABLE)) {
+        goto error;
+    }
+    if (hashmap_publisher_check(self->memory.buf,
+            (size_t) self->memory.len)) {
+        PyErr_SetString(PyExc_ValueError,
+                "Unsupported format of the publisher");
+        goto error;
+    }
+    self->publisher = (HashmapPublisher_t*) self->memory.buf;
+
+    return (PyObject*) self;
+
+error:
+    Py_DECREF(self);
+    return NULL;
+}
+
+static PyObject* Publisher_publish(Publisher_t *self, PyObject *table) {
+    const void *memory;
+    size_t size;
+    HashmapFileType_e type;
+    bool readonly;
+
+    if (PyObject_TypeCheck(table, &Int2Int_type)) {
+        memory = ((Int2Int_t*) table)->hashmap;
+        size = int2int_buffer_size(((Int2Int_t*) table)->hashmap);
+        type = HASHMAP_FILE_INT2INT;
+        readonly = ((Int2Int_t*) table)->hashmap->readonly;
+    }
+    else if (PyObject_TypeCheck(table, &Int2Float_type)) {
+        memory = ((Int2Float_t*) table)->hashmap;
+        size = int2float_buffer_size(((Int2Float_t*) table)->hashmap);
+        type = HASHMAP_FILE_INT2FLOAT;
+        readonly = ((Int2Float_t*) table)->hashmap->readonly;
+    }
+    else {
+        PyErr_SetString(PyExc_TypeError,
+                "'table' must be an Int2Int or an Int2Float");
+        return NULL;
+    }
+    /* Readers attach the table without a copy */
+    if (!readonly) {
+        PyErr_SetString(PyExc_ValueError, "Table must be read-only");
+        return NULL;
+    }
+
+    switch (hashmap_publisher_publish(self->publisher, memory, size, type)) {
+    case -1:
+        return PyErr_Format(PyExc_ValueError,
+                "Table of %zu bytes exceeds slot of %llu bytes",
+                size, self->publisher->slot_size);
+    case -2:
+        PyErr_SetString(PyExc_RuntimeError,
+                "Slot of the next generation is still used by readers");
+        return NULL;
+    }
+
+    return PyLong_FromUnsignedLongLong(self->publisher->generation);
+}
+
+static PyObject* Publisher_acquire(Publisher_t *self) {
+    PublisherSlot_t *slot;
+    PyTypeObject *type;
+    PyObject *res;
+
+    if (NULL == (slot = PyObject_New(PublisherSlot_t, &PublisherSlot_type))) {
+        return NULL;
+    }
+    if (NULL == (slot->slot = hashmap_publisher_acquire(self->publisher))) {
+        /* Nothing was published yet */
+        PyObject_Del(slot);
+        Py_RETURN_NONE;
+    }
+    slot->publisher = (PyObject*) self;
+    Py_INCREF(slot->publisher);
+
+    switch (slot->slot->type) {
+    case HASHMAP_FILE_INT2INT:
+        type = &Int2Int_type;
+        break;
+    case HASHMAP_FILE_INT2FLOAT:
+        type = &Int2Float_type;
+        break;
+    default:
+        Py_DECREF(slot);
+        PyErr_SetString(PyExc_ValueError, "Unsupported format of the table");
+        return NULL;
+    }
+    /* Table holds the slot while it exists */
+    res = PyObject_CallMethod((PyObject*) type, "from_buffer", "O", slot);
+    Py_DECREF(slot);
+
+    return res;
+}
+
+static PyObject* Publisher_get_generation(Publisher_t *self) {
+    return PyLong_FromUnsignedLongLong(self->publisher->generation);
+}
+
+static PyObject* Publisher_get_slots(Publisher_t *self) {
+    return PyLong_FromUnsignedLong(self->publisher->slot_count);
+}
+
+static PyObject* Publisher_get_slot_size(Publisher_t *self) {
+    return PyLong_FromUnsignedLongLong(self->publisher->slot_size);
+}
+
+static PyMethodDef Publisher_methods[] = {
+    {"buffer_size_for", (PyCFunction) Publisher_buffer_size_for,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "buffer_size_for(cls, slot_size, *, slots=2)\n"
+            "--\n"
+            "\n"
+            "Return size of the buffer in bytes needed by create_in() for\n"
+            "slots tables of at most slot_size bytes (buffer_size)."},
+    {"create_in", (PyCFunction) Publisher_create_in,
+            METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+            "create_in(cls, buffer, slot_size, *, slots=2)\n"
+            "--\n"
+            "\n"
+            "Return new publisher formatted in writable buffer shared by\n"
+            "processes (e.g. mmap, shared_memory), nothing is published\n"
+            "yet. The buffer is held while the instance exists."},
+    {"from_buffer", (PyCFunction) Publisher_from_buffer, METH_O | METH_CLASS,
+            "from_buffer(cls, buffer, /)\n"
+            "--\n"
+            "\n"
+            "Return instance which uses publisher at the beginning of\n"
+            "writable buffer, e.g. created by create_in() in other process."},
+    {"publish", (PyCFunction) Publisher_publish, METH_O,
+            "publish(self, table, /)\n"
+            "--\n"
+            "\n"
+            "Copy read-only Int2Int or Int2Float into the slot of the next\n"
+            "generation and make it current, return the new generation.\n"
+            "Readers are not blocked, they keep tables of older generations\n"
+            "until they drop them. RuntimeError is raised if the slot of the\n"
+            "next generation is still used by a reader, more slots allow\n"
+            "readers to hold older tables longer. Only one process may\n"
+            "publish."},
+    {"acquire", (PyCFunction) Publisher_acquire, METH_NOARGS,
+            "acquire(self, /)\n"
+            "--\n"
+            "\n"
+            "Return read-only table of the current generation, None if\n"
+            "nothing was published yet. The table is used in place, its\n"
+            "slot is not reused by publish() until the table is\n"
+            "deallocated. Cost does not depend on the size of the table."},
+    {NULL}
+};
+
+static PyGetSetDef Publisher_getset[] = {
+    {"generation", (getter) Publisher_get_generation, NULL,
+            "Generation of the current table, 0 if nothing was published.",
+            NULL},
+    {"slots", (getter) Publisher_get_slots, NULL,
+            "Number of slots for tables.", NULL},
+    {"slot_size", (getter) Publisher_get_slot_size, NULL,
+            "Maximum size of the table in bytes.", NULL},
+    {NULL}
+};
+
+static PyTypeObject Publisher_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "cdatastructs.hashmap.Publisher",
+    .tp_doc = "Publisher of read-only tables in memory shared by processes.\n"
+        "\n"
+        "Writer publishes new versions of a table by publish(), readers in\n"
+        "other processes get the current version by acquire() without any\n"
+        "lock. Instance is created by create_in() or from_buffer().",
+    .tp_basicsize = sizeof(Publisher_t),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_methods = Publisher_methods,
+    .tp_getset = Publisher_getset,
+    .tp_dealloc = (destructor) Publisher_dealloc
+};
+
 /******************************************************************************
  * hashmap module                                                             *
  ******************************************************************************/
 
+static const char *swiss_kernel_names[] = {
+    "auto", "generic", "sse2", "avx2", NULL
+};
+
+static PyObject* hashmap_get_swiss_kernel(PyObject *module) {
+    return PyUnicode_FromString(swiss_kernel_names[hashmap_swiss_kernel()]);
+}
+
+static PyObject* hashmap_set_swiss_kernel(PyObject *module, PyObject *args) {
+    const char *name;
+
+    if (!PyArg_ParseTuple(args, "s", &name)) {
+        return NULL;
+    }
+    for (int i=0; NULL != swiss_kernel_names[i]; ++i) {
+        if (0 == strcmp(name, swiss_kernel_names[i])) {
+            if (hashmap_swiss_set_kernel((HashmapSwissKernel_e) i)) {
+                return PyErr_Format(PyExc_ValueError,
+                        "Kernel '%s' is not supported by CPU", name);
+            }
+            Py_RETURN_NONE;
+        }
+    }
+
+    return PyErr_Format(PyExc_ValueError, "Unknown kernel '%s'", name);
+}
+
+static PyMethodDef hashmap_methods[] = {
+    {"_get_swiss_kernel", (PyCFunction) hashmap_get_swiss_kernel,
+            METH_NOARGS,
+            "_get_swiss_kernel()\n"
+            "--\n"
+            "\n"
+            "Return name of the kernel used for Swiss table lookup."},
+    {"_set_swiss_kernel", (PyCFunction) hashmap_set_swiss_kernel,
+            METH_VARARGS,
+            "_set_swiss_kernel(name, /)\n"
+            "--\n"
+            "\n"
+            "Select kernel used for Swiss table lookup, one of 'auto',\n"
+            "'generic', 'sse2' or 'avx2'. It is intended for tests and\n"
+            "benchmarks."},
+    {NULL}
+};
+
 static PyModuleDef hashmapmodule = {
     PyModuleDef_HEAD_INIT,                              /* m_base */
     "hashmap",                                          /* m_name */
@@ -2046,7 +6153,7 @@ static PyModuleDef hashmapmodule = {
     "key -> value mapping. Goal is \n"
     "make mapping accesible from both Python and C.",
     -1,                                                 /* m_size */
-    0,                                                  /* m_methods */
+    hashmap_methods,                                    /* m_methods */
     0,                                                  /* m_slots */
     0,                                                  /* m_traverse */
     0,                                                  /* m_clear */
@@ -2069,10 +6176,14 @@ PyMODINIT_FUNC PyInit_hashmap(void) {
     }
 
     /* Initialize types */
-    if (PyType_Ready(&Int2IntIterator_type)
+    if (PyType_Ready(&HashmapBlock_type)
+            || PyType_Ready(&Int2IntIterator_type)
             || PyType_Ready(&Int2Int_type)
+            || PyType_Ready(&Int2IntSwiss_type)
             || PyType_Ready(&Int2FloatIterator_type)
-            || PyType_Ready(&Int2Float_type)) {
+            || PyType_Ready(&Int2Float_type)
+            || PyType_Ready(&PublisherSlot_type)
+            || PyType_Ready(&Publisher_type)) {
         goto error;
     }
 
@@ -2081,22 +6192,35 @@ PyMODINIT_FUNC PyInit_hashmap(void) {
         goto error;
     }
     /* Create __all__ attribute */
-    if (NULL == (all = PyList_New(2))) {
+    if (NULL == (all = PyList_New(4))) {
         goto error;
     }
     PyList_SET_ITEM(all, 0, PyUnicode_FromString("Int2Int"));
-    PyList_SET_ITEM(all, 1, PyUnicode_FromString("Int2Float"));
+    PyList_SET_ITEM(all, 1, PyUnicode_FromString("Int2IntSwiss"));
+    PyList_SET_ITEM(all, 2, PyUnicode_FromString("Int2Float"));
+    PyList_SET_ITEM(all, 3, PyUnicode_FromString("Publisher"));
     /* Add objects onto module */
     Py_INCREF(&Int2Int_type);
     if (PyModule_AddObject(module, "Int2Int", (PyObject*) &Int2Int_type)) {
         Py_DECREF(&Int2Int_type);
         goto error;
     }
+    Py_INCREF(&Int2IntSwiss_type);
+    if (PyModule_AddObject(
+            module, "Int2IntSwiss", (PyObject*) &Int2IntSwiss_type)) {
+        Py_DECREF(&Int2IntSwiss_type);
+        goto error;
+    }
     Py_INCREF(&Int2Float_type);
     if (PyModule_AddObject(module, "Int2Float", (PyObject*) &Int2Float_type)) {
         Py_DECREF(&Int2Float_type);
         goto error;
     }
+    Py_INCREF(&Publisher_type);
+    if (PyModule_AddObject(module, "Publisher", (PyObject*) &Publisher_type)) {
+        Py_DECREF(&Publisher_type);
+        goto error;
+    }
     if (PyModule_AddObject(module, "__all__", all)) {
         goto error;
     }
@@ -1,221 +1,676 @@
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+/* kill, getpid and sched_yield */
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <limits.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define HASHMAP_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(HASHMAP_HAVE_SSE2) && (defined(__x86_64__) \
+        || defined(_M_X64) || defined(_M_AMD64))
+#define HASHMAP_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif !defined(__GNUC__)
+/* Seqlock and the concurrent layout need atomics, other compilers must
+   provide them by C11 */
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) \
+        && !defined(__STDC_NO_ATOMICS__)
+#define HASHMAP_HAVE_C11_ATOMICS
+#include <stdatomic.h>
+#else
+#error "Atomic operations of GCC, MSVC or C11 are required"
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define HASHMAP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define HASHMAP_TARGET_AVX2
+#endif
+
+/* Prefetch of the memory for read, no-op if compiler does not support it */
+#if defined(__GNUC__)
+#define HASHMAP_PREFETCH(addr) __builtin_prefetch((addr), 0, 1)
+#elif defined(HASHMAP_HAVE_SSE2)
+#define HASHMAP_PREFETCH(addr) \
+        _mm_prefetch((const char*) (addr), _MM_HINT_T1)
+#else
+#define HASHMAP_PREFETCH(addr) ((void) (addr))
+#endif
+
+/* Memory ordering of the seqlock. Sequence is read and written by relaxed
+   atomic accesses, data of the table by plain accesses which are ordered
+   by fences. Plain reads of the reader race with writes of the writer,
+   which the C standard leaves undefined. This is a known limitation, as
+   in every seqlock in C: torn values are discarded by the sequence check,
+   and the supported compilers neither invent nor tear aligned 64-bit
+   accesses. Aligned 64-bit accesses are atomic on targets of MSVC. */
+#if defined(__GNUC__)
+#define HASHMAP_SEQ_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define HASHMAP_SEQ_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define HASHMAP_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define HASHMAP_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#elif defined(_MSC_VER)
+#define HASHMAP_SEQ_LOAD(p) (*(volatile unsigned long long*) (p))
+#define HASHMAP_SEQ_STORE(p, v) (*(volatile unsigned long long*) (p) = (v))
+#if defined(_M_ARM64)
+#define HASHMAP_ACQUIRE() __dmb(_ARM64_BARRIER_ISH)
+#define HASHMAP_RELEASE() __dmb(_ARM64_BARRIER_ISH)
+#else
+/* x86 keeps order of loads and of stores, only the compiler must not
+   reorder them */
+#define HASHMAP_ACQUIRE() _ReadWriteBarrier()
+#define HASHMAP_RELEASE() _ReadWriteBarrier()
+#endif
+#else
+#define HASHMAP_SEQ_LOAD(p) atomic_load_explicit( \
+        (_Atomic unsigned long long*) (p), memory_order_relaxed)
+#define HASHMAP_SEQ_STORE(p, v) atomic_store_explicit( \
+        (_Atomic unsigned long long*) (p), (v), memory_order_relaxed)
+#define HASHMAP_ACQUIRE() atomic_thread_fence(memory_order_acquire)
+#define HASHMAP_RELEASE() atomic_thread_fence(memory_order_release)
+#endif
+
+/* Sequentially consistent accesses of counters of the publisher and of
+   items of the concurrent table. CAS returns the previous value, 32 bit
+   variants access status of the item. There is no fallback without
+   atomics, see the check of C11 atomics above. */
+#if defined(__GNUC__)
+#define HASHMAP_ATOMIC_LOAD(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define HASHMAP_ATOMIC_STORE(p, v) \
+        __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define HASHMAP_ATOMIC_INC(p) __atomic_fetch_add((p), 1, __ATOMIC_SEQ_CST)
+#define HASHMAP_ATOMIC_DEC(p) __atomic_fetch_sub((p), 1, __ATOMIC_SEQ_CST)
+#define HASHMAP_ATOMIC_CAS(p, expected, desired) \
+        __sync_val_compare_and_swap((p), (expected), (desired))
+#define HASHMAP_ATOMIC_LOAD32(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define HASHMAP_ATOMIC_XCHG32(p, v) \
+        __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define HASHMAP_ATOMIC_CAS32(p, expected, desired) \
+        __sync_val_compare_and_swap((p), (expected), (desired))
+#elif defined(_MSC_VER)
+#define HASHMAP_ATOMIC_LOAD(p) \
+        ((unsigned long long) _InterlockedOr64((volatile __int64*) (p), 0))
+#define HASHMAP_ATOMIC_STORE(p, v) \
+        ((void) _InterlockedExchange64((volatile __int64*) (p), (__int64) (v)))
+#define HASHMAP_ATOMIC_INC(p) _InterlockedIncrement64((volatile __int64*) (p))
+#define HASHMAP_ATOMIC_DEC(p) _InterlockedDecrement64((volatile __int64*) (p))
+#define HASHMAP_ATOMIC_CAS(p, expected, desired) \
+        ((unsigned long long) _InterlockedCompareExchange64( \
+                (volatile __int64*) (p), (__int64) (desired), \
+                (__int64) (expected)))
+#define HASHMAP_ATOMIC_LOAD32(p) _InterlockedOr((volatile long*) (p), 0)
+#define HASHMAP_ATOMIC_XCHG32(p, v) \
+        _InterlockedExchange((volatile long*) (p), (long) (v))
+#define HASHMAP_ATOMIC_CAS32(p, expected, desired) \
+        _InterlockedCompareExchange((volatile long*) (p), (long) (desired), \
+                (long) (expected))
+#else
+/* C11 atomics of 64-bit type access counters and values like MSVC */
+#if SIZE_MAX != ULLONG_MAX
+#error "Atomic accesses of size_t require 64-bit size_t"
+#endif
+#define HASHMAP_ATOMIC_LOAD(p) atomic_load((_Atomic unsigned long long*) (p))
+#define HASHMAP_ATOMIC_STORE(p, v) \
+        atomic_store((_Atomic unsigned long long*) (p), (v))
+#define HASHMAP_ATOMIC_INC(p) \
+        atomic_fetch_add((_Atomic unsigned long long*) (p), 1)
+#define HASHMAP_ATOMIC_DEC(p) \
+        atomic_fetch_sub((_Atomic unsigned long long*) (p), 1)
+#define HASHMAP_ATOMIC_CAS(p, expected, desired) \
+        hashmap_cas((_Atomic unsigned long long*) (p), (expected), (desired))
+#define HASHMAP_ATOMIC_LOAD32(p) atomic_load((_Atomic int*) (p))
+#define HASHMAP_ATOMIC_XCHG32(p, v) atomic_exchange((_Atomic int*) (p), (v))
+#define HASHMAP_ATOMIC_CAS32(p, expected, desired) \
+        hashmap_cas32((_Atomic int*) (p), (expected), (desired))
+
+/* Failed compare-and-swap stores the current value into expected */
+static inline unsigned long long hashmap_cas(_Atomic unsigned long long *p,
+        unsigned long long expected, const unsigned long long desired) {
+    atomic_compare_exchange_strong(p, &expected, desired);
+    return expected;
+}
+
+static inline int hashmap_cas32(_Atomic int *p, int expected,
+        const int desired) {
+    atomic_compare_exchange_strong(p, &expected, desired);
+    return expected;
+}
+#endif
+
+/* Hint for the CPU that the reader spins on the sequence */
+#if defined(HASHMAP_HAVE_SSE2)
+#define HASHMAP_SPIN() _mm_pause()
+#else
+#define HASHMAP_SPIN() ((void) 0)
+#endif
+
+/* Writer of the concurrent table spins this many times on the item of
+   other writer, then it yields the CPU, as the other writer may have been
+   preempted */
+#define HASHMAP_CONCURRENT_SPINS 1024
+
 #include "hashmap.h"
 
+/* Identifier of this process, it is never 0 */
+static unsigned int hashmap_process_id(void) {
+#if defined(_WIN32)
+    return (unsigned int) GetCurrentProcessId();
+#else
+    return (unsigned int) getpid();
+#endif
+}
+
+/* Return false only when the process surely does not exist */
+static bool hashmap_process_alive(const unsigned int id) {
+#if defined(_WIN32)
+    HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, (DWORD) id);
+    DWORD res;
+
+    if (NULL == process) {
+        return ERROR_INVALID_PARAMETER != GetLastError();
+    }
+    res = WaitForSingleObject(process, 0);
+    CloseHandle(process);
+    return WAIT_OBJECT_0 != res;
+#else
+    return (0 == kill((pid_t) id, 0)) || (ESRCH != errno);
+#endif
+}
+
+static void hashmap_yield(void) {
+#if defined(_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+size_t hashmap_table_size(const size_t size) {
+    return hashmap_load_table_size(size, HASHMAP_DEFAULT_MAX_LOAD);
+}
+
+/* Return 0 if the table would not fit into size_t */
+size_t hashmap_load_table_size(const size_t size, const double max_load) {
+    double min_size = size / max_load;
+    size_t min_table_size;
+    size_t table_size = 1;
+
+    if (!(min_size < (double) (SIZE_MAX / 2))) {
+        return 0;
+    }
+    min_table_size = (size_t) min_size + 1;
+
+    while (table_size < min_table_size) {
+        table_size <<= 1;
+    }
+    return table_size;
+}
+
+/* Finalizer of the MurmurHash3, it spreads sequential and strided keys
+   over the whole 64 bits, so low bits can be used as an index. */
+static inline unsigned long long u_long_long_mix(
+        const unsigned long long key) {
+    unsigned long long h = key;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
 static inline size_t u_long_long_hash(const unsigned long long key,
         const size_t table_size) {
+    return (size_t) u_long_long_mix(key) & (table_size - 1);
+}
+
+static inline size_t u_long_long_legacy_hash(const unsigned long long key,
+        const size_t table_size) {
     return (97 * key) % table_size;
 }
 
 /*
- * int2int
+ * Swiss layout - control bytes
+ *
+ * Low bits of the hash select the first group, groups are aligned to
+ * SWISS_GROUP_WIDTH and probed linearly. High 7 bits of the hash are
+ * stored in the control byte of the used slot. Lookup compares the whole
+ * group of control bytes at once and stops at the first group which
+ * contains an empty slot. Slot is marked as empty on delete when its
+ * group contains an empty slot (probe never continued behind such group),
+ * otherwise it is marked as deleted. First group of control bytes is
+ * cloned behind the last one, so kernel can load two groups at once.
  */
 
-int int2int_new(const size_t size, Int2IntHashTable_t ** new_ctx) {
-    size_t table_size = NEW_TABLE_SIZE(size);
-    size_t memory_size = INT2INT_MEMORY_SIZE(table_size);
-    Int2IntHashTable_t *hashmap = malloc(memory_size);
+#define SWISS_H1(hash) ((size_t) (hash))
+#define SWISS_H2(hash) ((unsigned char) ((hash) >> 57))
+
+static HashmapSwissKernel_e swiss_kernel = HASHMAP_SWISS_KERNEL_AUTO;
+
+static bool hashmap_cpu_has_avx2(void) {
+#if defined(HASHMAP_HAVE_AVX2) && defined(_MSC_VER)
+    int regs[4];
+
+    __cpuid(regs, 0);
+    if (regs[0] < 7) {
+        return false;
+    }
+    /* CPU supports AVX and OS saves YMM registers */
+    __cpuid(regs, 1);
+    if ((0 == (regs[2] & (1 << 27))) || (0 == (regs[2] & (1 << 28)))) {
+        return false;
+    }
+    if (6 != (_xgetbv(0) & 6)) {
+        return false;
+    }
+    __cpuidex(regs, 7, 0);
+    return 0 != (regs[1] & (1 << 5));
+#elif defined(HASHMAP_HAVE_AVX2)
+    __builtin_cpu_init();
+    return 0 != __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+HashmapSwissKernel_e hashmap_swiss_kernel(void) {
+    if (HASHMAP_SWISS_KERNEL_AUTO == swiss_kernel) {
+        hashmap_swiss_set_kernel(HASHMAP_SWISS_KERNEL_AUTO);
+    }
+    return swiss_kernel;
+}
 
-    if (NULL == hashmap) {
+int hashmap_swiss_set_kernel(const HashmapSwissKernel_e kernel) {
+    switch (kernel) {
+    case HASHMAP_SWISS_KERNEL_AUTO:
+        if (hashmap_cpu_has_avx2()) {
+            swiss_kernel = HASHMAP_SWISS_KERNEL_AVX2;
+        }
+        else {
+#if defined(HASHMAP_HAVE_SSE2)
+            swiss_kernel = HASHMAP_SWISS_KERNEL_SSE2;
+#else
+            swiss_kernel = HASHMAP_SWISS_KERNEL_GENERIC;
+#endif
+        }
+        return 0;
+    case HASHMAP_SWISS_KERNEL_GENERIC:
+        swiss_kernel = kernel;
+        return 0;
+    case HASHMAP_SWISS_KERNEL_SSE2:
+#if defined(HASHMAP_HAVE_SSE2)
+        swiss_kernel = kernel;
+        return 0;
+#else
+        return -1;
+#endif
+    case HASHMAP_SWISS_KERNEL_AVX2:
+        if (hashmap_cpu_has_avx2()) {
+            swiss_kernel = kernel;
+            return 0;
+        }
         return -1;
     }
-    memset(hashmap, 0, memory_size);
+    return -1;
+}
 
-    hashmap->size = size;
-    hashmap->current_size = 0;
-    hashmap->table_size = table_size;
-    hashmap->readonly = false;
+static inline unsigned int swiss_ctz(const unsigned int mask) {
+#if defined(_MSC_VER)
+    unsigned long idx;
 
-    *new_ctx = hashmap;
+    _BitScanForward(&idx, mask);
+    return (unsigned int) idx;
+#else
+    return (unsigned int) __builtin_ctz(mask);
+#endif
+}
 
-    return 0;
+/* Bit mask of slots of the group whose control byte is equal to h2 */
+static inline unsigned int swiss_match_generic(
+        const unsigned char * const group, const unsigned char h2) {
+    unsigned int mask = 0;
+
+    for (unsigned int i=0; i<SWISS_GROUP_WIDTH; ++i) {
+        if (group[i] == h2) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
 }
 
-int int2int_set(Int2IntHashTable_t * ctx,
-        const unsigned long long key, const size_t value,
-        Int2IntHashTable_t ** new_ctx) {
+#if defined(HASHMAP_HAVE_SSE2)
+static inline unsigned int swiss_match_sse2(
+        const unsigned char * const group, const unsigned char h2) {
+    __m128i ctrl = _mm_loadu_si128((const __m128i *) group);
 
-    Int2IntItem_t *table = (Int2IntItem_t*) (
-            (char*) ctx + sizeof(Int2IntHashTable_t));
-    Int2IntHashTable_t *new_hashmap;
-    Int2IntItem_t item;
-    size_t idx;
+    return (unsigned int) _mm_movemask_epi8(
+            _mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char) h2)));
+}
+#endif
 
-    if (ctx->readonly) {
-        return -1;
+#if defined(HASHMAP_HAVE_AVX2)
+/* Two groups at once, bit mask has 32 bits */
+HASHMAP_TARGET_AVX2
+static inline unsigned int swiss_match_avx2(
+        const unsigned char * const group, const unsigned char h2) {
+    __m256i ctrl = _mm256_loadu_si256((const __m256i *) group);
+
+    return (unsigned int) _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(ctrl, _mm256_set1_epi8((char) h2)));
+}
+#endif
+
+static inline void swiss_set_ctrl(unsigned char * const ctrl,
+        const size_t table_size, const size_t idx, const unsigned char value) {
+    ctrl[idx] = value;
+    if (idx < SWISS_GROUP_WIDTH) {
+        ctrl[table_size + idx] = value;
     }
+}
 
-    // Resize table if necessary
-    if (NULL != new_ctx) {
-        if (ctx->current_size == ctx->size) {
-            if (int2int_new(ctx->size * 2, &new_hashmap)) {
-                return -1;
-            }
+/* Index of the first empty or deleted slot for the hash */
+static size_t swiss_find_free(const unsigned char * const ctrl,
+        const size_t table_size, const unsigned long long hash) {
+    size_t mask = table_size - 1;
+    size_t group = SWISS_H1(hash) & mask & ~((size_t) SWISS_GROUP_WIDTH - 1);
 
-            for (size_t i=0; i<ctx->table_size; ++i) {
-                item = table[i];
-                if (item.status == USED) {
-                    if (int2int_set(new_hashmap, item.key, item.value, NULL)) {
-                        free(new_hashmap);
-                        return -1;
-                    }
-                }
+    for (size_t probed=0; probed<table_size; probed+=SWISS_GROUP_WIDTH) {
+        for (size_t i=0; i<SWISS_GROUP_WIDTH; ++i) {
+            if (ctrl[group + i] & SWISS_EMPTY) {
+                return group + i;
             }
-
-            free(ctx);
-            ctx = new_hashmap;
-            table = (Int2IntItem_t*) ((char*) ctx + sizeof(Int2IntHashTable_t));
         }
-        *new_ctx = ctx;
+        group = (group + SWISS_GROUP_WIDTH) & mask;
     }
+    return table_size;
+}
 
-    idx = u_long_long_hash(key, ctx->table_size);
-    for (size_t i=0; i<ctx->table_size; ++i) {
-        if ((table[idx].status == USED) && (table[idx].key == key)) {
-            table[idx].value = value;
-            return 0;
-        }
-        if ((table[idx].status == EMPTY) || (table[idx].status == DELETED)) {
-            table[idx].status = USED;
-            table[idx].key = key;
-            table[idx].value = value;
-            ctx->current_size += 1;
-            return 0;
-        }
-        idx = (idx + 1) % ctx->table_size;
+static inline unsigned char swiss_free_mark(const unsigned char * const ctrl,
+        const size_t idx) {
+    const unsigned char *group =
+            ctrl + (idx & ~((size_t) SWISS_GROUP_WIDTH - 1));
+
+    if (0 != swiss_match_generic(group, SWISS_EMPTY)) {
+        return SWISS_EMPTY;
     }
-    return -1;
+    return SWISS_DELETED;
 }
 
-int int2int_del(Int2IntHashTable_t * const ctx,
+/*
+ * Compact and SoA layouts - sentinel keys
+ *
+ * Slots have no status, key 0 marks an empty slot. Real key 0 is kept in
+ * an extra slot at index table_size and zero_key_used flag of the header
+ * tells whether it is set. Probe distance of the slot is computed from
+ * the hash of its key. Keys and values are accessed through strides, so
+ * one implementation serves compact and SoA layouts of both int2int and
+ * int2float.
+ */
+
+#define HASHMAP_LAYOUT_IS_STRIDED(layout) \
+        ((HASHMAP_LAYOUT_COMPACT == (layout)) \
+                || (HASHMAP_LAYOUT_SOA == (layout)))
+
+typedef struct {
+    char *keys;
+    char *values;
+    size_t key_stride;
+    size_t value_stride;
+    size_t value_size;
+    size_t table_size;
+    bool *zero_key_used;
+} StridedTable_t;
+
+#define STRIDED_KEY(t, idx) \
+        (*(unsigned long long*) ((t)->keys + (idx) * (t)->key_stride))
+#define STRIDED_VALUE(t, idx) \
+        ((void*) ((t)->values + (idx) * (t)->value_stride))
+
+static inline size_t strided_distance(const StridedTable_t * const t,
+        const size_t idx) {
+    return (idx - u_long_long_hash(STRIDED_KEY(t, idx), t->table_size))
+            & (t->table_size - 1);
+}
+
+/* Return index of the key, or table_size + 1 if key does not exist */
+static size_t strided_find(const StridedTable_t * const t,
         const unsigned long long key) {
 
-    Int2IntItem_t *table = (Int2IntItem_t*) (
-            (char*) ctx + sizeof(Int2IntHashTable_t));
-    size_t idx = u_long_long_hash(key, ctx->table_size);
+    size_t mask = t->table_size - 1;
+    size_t idx = u_long_long_hash(key, t->table_size);
+    unsigned long long slot_key;
 
-    for (size_t i=0; i<ctx->table_size; ++i) {
-        if (table[idx].status == EMPTY) {
+    if (0 == key) {
+        return *(t->zero_key_used) ? t->table_size : t->table_size + 1;
+    }
+    for (size_t distance=0; distance<t->table_size; ++distance) {
+        slot_key = STRIDED_KEY(t, idx);
+        if (0 == slot_key) {
             break;
         }
-        if ((table[idx].status == USED) && (table[idx].key == key)) {
-            table[idx].status = DELETED;
-            ctx->current_size -= 1;
-            return 0;
+        if (slot_key == key) {
+            return idx;
         }
-        idx = (idx + 1) % ctx->table_size;
+        if (strided_distance(t, idx) < distance) {
+            break;
+        }
+        idx = (idx + 1) & mask;
     }
-    return -1;
+    return t->table_size + 1;
 }
 
-int int2int_get(const Int2IntHashTable_t * const ctx,
-        const unsigned long long key, size_t * const value) {
+/* Insert key which is not in the table yet */
+static int strided_insert(const StridedTable_t * const t,
+        unsigned long long key, const void * const value) {
 
-    size_t * p_value;
+    size_t mask = t->table_size - 1;
+    size_t idx = u_long_long_hash(key, t->table_size);
+    size_t distance = 0;
+    size_t slot_distance;
+    unsigned long long tmp_key;
+    unsigned char cur_value[sizeof(unsigned long long)];
+    unsigned char tmp_value[sizeof(unsigned long long)];
 
-    if (int2int_ptr(ctx, key, &p_value) == 0) {
-        *value = *p_value;
+    if (0 == key) {
+        memcpy(STRIDED_VALUE(t, t->table_size), value, t->value_size);
+        *(t->zero_key_used) = true;
         return 0;
     }
+    memcpy(cur_value, value, t->value_size);
+    for (size_t i=0; i<t->table_size; ++i) {
+        if (0 == STRIDED_KEY(t, idx)) {
+            STRIDED_KEY(t, idx) = key;
+            memcpy(STRIDED_VALUE(t, idx), cur_value, t->value_size);
+            return 0;
+        }
+        /* Rich slot gives its place to the poor one */
+        slot_distance = strided_distance(t, idx);
+        if (slot_distance < distance) {
+            tmp_key = STRIDED_KEY(t, idx);
+            memcpy(tmp_value, STRIDED_VALUE(t, idx), t->value_size);
+            STRIDED_KEY(t, idx) = key;
+            memcpy(STRIDED_VALUE(t, idx), cur_value, t->value_size);
+            key = tmp_key;
+            memcpy(cur_value, tmp_value, t->value_size);
+            distance = slot_distance;
+        }
+        idx = (idx + 1) & mask;
+        ++distance;
+    }
     return -1;
 }
 
-int int2int_ptr(const Int2IntHashTable_t * const ctx,
-        const unsigned long long key, size_t ** const value) {
+/* Remove slot, following slots are shifted back */
+static void strided_remove(const StridedTable_t * const t, size_t idx) {
+    size_t mask = t->table_size - 1;
+    size_t next = (idx + 1) & mask;
 
-    Int2IntItem_t *table = (Int2IntItem_t*) (
-            (char*) ctx + sizeof(Int2IntHashTable_t));
-    size_t idx = u_long_long_hash(key, ctx->table_size);
+    if (idx == t->table_size) {
+        *(t->zero_key_used) = false;
+        return;
+    }
+    while ((0 != STRIDED_KEY(t, next)) && (0 != strided_distance(t, next))) {
+        STRIDED_KEY(t, idx) = STRIDED_KEY(t, next);
+        memcpy(STRIDED_VALUE(t, idx), STRIDED_VALUE(t, next), t->value_size);
+        idx = next;
+        next = (next + 1) & mask;
+    }
+    STRIDED_KEY(t, idx) = 0;
+}
 
-    for (size_t i=0; i<ctx->table_size; ++i) {
-        if (table[idx].status == EMPTY) {
-            break;
-        }
-        if ((table[idx].status == USED) && (table[idx].key == key)) {
-            *value = &(table[idx].value);
+/* Return 0 and index of the next used slot from position */
+static int strided_next(const StridedTable_t * const t,
+        size_t * const position, size_t * const idx) {
+    while (*position < t->table_size) {
+        *idx = (*position)++;
+        if (0 != STRIDED_KEY(t, *idx)) {
             return 0;
         }
-        idx = (idx + 1) % ctx->table_size;
+    }
+    if ((*position == t->table_size) && *(t->zero_key_used)) {
+        *idx = (*position)++;
+        return 0;
     }
     return -1;
 }
 
-int int2int_has(const Int2IntHashTable_t * const ctx,
-        const unsigned long long key) {
+/* Growth in place - memory block is reallocated and keys are rehashed
+   within it. Keys of the old table are marked in the pending bitmap and
+   placed one by one. Pending slot is an empty slot for the placed key,
+   key which was pending there is placed next. */
 
-    size_t * value;
+#define PENDING_BITMAP_SIZE(table_size) \
+        (((table_size) + CHAR_BIT - 1) / CHAR_BIT)
+#define PENDING_MASK(idx) (1u << ((idx) % CHAR_BIT))
 
-    return int2int_ptr(ctx, key, &value);
+static inline bool pending_pop(unsigned char * const pending,
+        const size_t pending_size, const size_t idx) {
+    if ((idx < pending_size)
+            && (pending[idx / CHAR_BIT] & PENDING_MASK(idx))) {
+        pending[idx / CHAR_BIT] &= ~PENDING_MASK(idx);
+        return true;
+    }
+    return false;
 }
 
-/*
- * int2float
- */
+static void strided_place(const StridedTable_t * const t,
+        unsigned char * const pending, const size_t pending_size,
+        unsigned long long key, const void * const value) {
 
-int int2float_new(const size_t size, Int2FloatHashTable_t ** new_ctx) {
-    size_t table_size = NEW_TABLE_SIZE(size);
-    size_t memory_size = INT2FLOAT_MEMORY_SIZE(table_size);
-    Int2FloatHashTable_t *hashmap = malloc(memory_size);
+    size_t mask = t->table_size - 1;
+    size_t idx = u_long_long_hash(key, t->table_size);
+    size_t distance = 0;
+    size_t slot_distance;
+    bool slot_pending;
+    unsigned long long tmp_key;
+    unsigned char cur_value[sizeof(unsigned long long)];
+    unsigned char tmp_value[sizeof(unsigned long long)];
 
-    if (NULL == hashmap) {
-        return -1;
+    memcpy(cur_value, value, t->value_size);
+    /* Table is bigger than number of keys, there is always empty slot */
+    for (;;) {
+        if (0 == STRIDED_KEY(t, idx)) {
+            STRIDED_KEY(t, idx) = key;
+            memcpy(STRIDED_VALUE(t, idx), cur_value, t->value_size);
+            return;
+        }
+        slot_pending = pending_pop(pending, pending_size, idx);
+        slot_distance = slot_pending ? 0 : strided_distance(t, idx);
+        if (slot_pending || (slot_distance < distance)) {
+            tmp_key = STRIDED_KEY(t, idx);
+            memcpy(tmp_value, STRIDED_VALUE(t, idx), t->value_size);
+            STRIDED_KEY(t, idx) = key;
+            memcpy(STRIDED_VALUE(t, idx), cur_value, t->value_size);
+            key = tmp_key;
+            memcpy(cur_value, tmp_value, t->value_size);
+            distance = slot_distance;
+        }
+        if (slot_pending) {
+            /* Pending key starts from its home */
+            idx = u_long_long_hash(key, t->table_size);
+            continue;
+        }
+        idx = (idx + 1) & mask;
+        ++distance;
     }
-    memset(hashmap, 0, memory_size);
-
-    hashmap->size = size;
-    hashmap->current_size = 0;
-    hashmap->table_size = table_size;
-    hashmap->readonly = false;
-
-    *new_ctx = hashmap;
-
-    return 0;
 }
 
-int int2float_set(Int2FloatHashTable_t * ctx,
-        const unsigned long long key, const double value,
-        Int2FloatHashTable_t ** new_ctx) {
+/* Move table described by old_t into bigger table t in the same memory
+   block, memory behind old_t must be already allocated. */
+static void strided_grow(const StridedTable_t * const old_t,
+        const StridedTable_t * const t, unsigned char * const pending) {
 
-    Int2FloatItem_t *table = (Int2FloatItem_t*) (
-            (char*) ctx + sizeof(Int2FloatHashTable_t));
-    Int2FloatHashTable_t *new_hashmap;
-    Int2FloatItem_t item;
-    size_t idx;
+    size_t old_table_size = old_t->table_size;
+    unsigned long long key;
+    unsigned char zero_value[sizeof(unsigned long long)];
+    unsigned char value[sizeof(unsigned long long)];
 
-    if (ctx->readonly) {
-        return -1;
+    memcpy(zero_value, STRIDED_VALUE(old_t, old_table_size), t->value_size);
+    if (t->values != old_t->values) {
+        /* SoA - values array follows bigger keys array */
+        memmove(t->values, old_t->values,
+                (old_table_size + 1) * old_t->value_stride);
     }
+    for (size_t idx=old_table_size; idx<=t->table_size; ++idx) {
+        STRIDED_KEY(t, idx) = 0;
+    }
+    memcpy(STRIDED_VALUE(t, t->table_size), zero_value, t->value_size);
 
-    // Resize table if necessary
-    if (NULL != new_ctx) {
-        if (ctx->current_size == ctx->size) {
-            if (int2float_new(ctx->size * 2, &new_hashmap)) {
-                return -1;
-            }
-
-            for (size_t i=0; i<ctx->table_size; ++i) {
-                item = table[i];
-                if (item.status == USED) {
-                    if (int2float_set(new_hashmap, item.key,
-                            item.value, NULL)) {
-                        free(new_hashmap);
-                        return -1;
-                    }
-                }
-            }
-
-            free(ctx);
-            ctx = new_hashmap;
-            table = (Int2FloatItem_t*) (
-                    (char*) ctx + sizeof(Int2FloatHashTable_t));
+    for (size_t idx=0; idx<old_table_size; ++idx) {
+        if (0 != STRIDED_KEY(t, idx)) {
+            pending[idx / CHAR_BIT] |= PENDING_MASK(idx);
+        }
+    }
+    for (size_t idx=0; idx<old_table_size; ++idx) {
+        if (pending_pop(pending, old_table_size, idx)) {
+            key = STRIDED_KEY(t, idx);
+            memcpy(value, STRIDED_VALUE(t, idx), t->value_size);
+            STRIDED_KEY(t, idx) = 0;
+            strided_place(t, pending, old_table_size, key, value);
         }
-        *new_ctx = ctx;
     }
+}
+
+/*
+ * int2int
+ */
+
+/* Tables in legacy format use different hash and probe step, they are
+   kept readable and writable, resize converts them into current format. */
+
+static int int2int_legacy_insert(Int2IntHashTable_t * const ctx,
+        const unsigned long long key, const size_t value) {
+
+    Int2IntItem_t *table = (Int2IntItem_t*) INT2INT_TABLE(ctx);
+    size_t idx = u_long_long_legacy_hash(key, ctx->table_size);
 
-    idx = u_long_long_hash(key, ctx->table_size);
     for (size_t i=0; i<ctx->table_size; ++i) {
         if ((table[idx].status == USED) && (table[idx].key == key)) {
             table[idx].value = value;
@@ -233,63 +688,2957 @@ int int2float_set(Int2FloatHashTable_t * ctx,
     return -1;
 }
 
-int int2float_del(Int2FloatHashTable_t * const ctx,
+static Int2IntItem_t* int2int_legacy_find(const Int2IntHashTable_t * const ctx,
         const unsigned long long key) {
 
-    Int2FloatItem_t *table = (Int2FloatItem_t*) (
-            (char*) ctx + sizeof(Int2FloatHashTable_t));
-    size_t idx = u_long_long_hash(key, ctx->table_size);
+    Int2IntItem_t *table = (Int2IntItem_t*) INT2INT_TABLE(ctx);
+    size_t idx = u_long_long_legacy_hash(key, ctx->table_size);
 
     for (size_t i=0; i<ctx->table_size; ++i) {
         if (table[idx].status == EMPTY) {
             break;
         }
         if ((table[idx].status == USED) && (table[idx].key == key)) {
-            table[idx].status = DELETED;
-            ctx->current_size -= 1;
-            return 0;
+            return &(table[idx]);
         }
         idx = (idx + 1) % ctx->table_size;
     }
-    return -1;
+    return NULL;
 }
 
-int int2float_get(const Int2FloatHashTable_t * const ctx,
-        const unsigned long long key, double * const value) {
+/* Items are placed by Robin Hood insertion, every item stores its distance
+   from the home position. Item with distance lower than the distance of
+   the probe can not be followed by the searched key, so miss stops there
+   without scanning the rest of the cluster. Deletion shifts following
+   items of the cluster back, so the table never contains tombstones. */
 
-    double * p_value;
+static Int2IntItem_t* int2int_find(const Int2IntHashTable_t * const ctx,
+        const unsigned long long key) {
 
-    if (int2float_ptr(ctx, key, &p_value) == 0) {
-        *value = *p_value;
-        return 0;
+    Int2IntItem_t *table = (Int2IntItem_t*) INT2INT_TABLE(ctx);
+    size_t idx = u_long_long_hash(key, ctx->table_size);
+
+    for (unsigned int distance=0; distance<ctx->table_size; ++distance) {
+        if ((table[idx].status == EMPTY)
+                || (table[idx].distance < distance)) {
+            break;
+        }
+        if ((table[idx].status == USED) && (table[idx].key == key)) {
+            return &(table[idx]);
+        }
+        idx = (idx + 1) & (ctx->table_size - 1);
     }
-    return -1;
+    return NULL;
 }
 
-int int2float_ptr(const Int2FloatHashTable_t * const ctx,
-        const unsigned long long key, double ** const value) {
+static int int2int_insert(Int2IntHashTable_t * const ctx,
+        const unsigned long long key, const size_t value) {
 
-    Int2FloatItem_t *table = (Int2FloatItem_t*) (
-            (char*) ctx + sizeof(Int2FloatHashTable_t));
+    Int2IntItem_t *table = (Int2IntItem_t*) INT2INT_TABLE(ctx);
+    Int2IntItem_t item = { .key = key, .value = value, .status = USED };
+    Int2IntItem_t displaced;
     size_t idx = u_long_long_hash(key, ctx->table_size);
 
     for (size_t i=0; i<ctx->table_size; ++i) {
         if (table[idx].status == EMPTY) {
-            break;
-        }
-        if ((table[idx].status == USED) && (table[idx].key == key)) {
-            *value = &(table[idx].value);
+            table[idx] = item;
+            ctx->current_size += 1;
             return 0;
         }
-        idx = (idx + 1) % ctx->table_size;
+        if (table[idx].distance < item.distance) {
+            displaced = table[idx];
+            table[idx] = item;
+            item = displaced;
+        }
+        item.distance += 1;
+        idx = (idx + 1) & (ctx->table_size - 1);
     }
     return -1;
 }
 
-int int2float_has(const Int2FloatHashTable_t * const ctx,
-        const unsigned long long key) {
+static void int2int_remove(Int2IntHashTable_t * const ctx,
+        Int2IntItem_t * const item) {
 
-    double * value;
+    Int2IntItem_t *table = (Int2IntItem_t*) INT2INT_TABLE(ctx);
+    size_t idx = item - table;
+    size_t next = (idx + 1) & (ctx->table_size - 1);
 
-    return int2float_ptr(ctx, key, &value);
+    /* Backward shift deletion - move following items of the cluster one
+       slot closer to their home, until empty slot or item placed in its
+       home is reached. */
+    while ((table[next].status == USED) && (table[next].distance > 0)) {
+        table[idx] = table[next];
+        table[idx].distance -= 1;
+        idx = next;
+        next = (next + 1) & (ctx->table_size - 1);
+    }
+    table[idx].status = EMPTY;
+    table[idx].distance = 0;
+    ctx->current_size -= 1;
+}
+
+/* Place item while the table grows in place, PENDING item is treated as
+   an empty slot and it is placed next. */
+static void int2int_place(Int2IntHashTable_t * const ctx,
+        Int2IntItem_t item) {
+
+    Int2IntItem_t *table = (Int2IntItem_t*) INT2INT_TABLE(ctx);
+    Int2IntItem_t displaced;
+    size_t idx = u_long_long_hash(item.key, ctx->table_size);
+
+    item.status = USED;
+    item.distance = 0;
+    /* Table is bigger than number of items, there is always empty slot */
+    for (;;) {
+        if (table[idx].status == EMPTY) {
+            table[idx] = item;
+            return;
+        }
+        if (table[idx].status == PENDING) {
+            displaced = table[idx];
+            table[idx] = item;
+            item = displaced;
+            item.status = USED;
+            item.distance = 0;
+            idx = u_long_long_hash(item.key, ctx->table_size);
+            continue;
+        }
+        if (table[idx].distance < item.distance) {
+            displaced = table[idx];
+            table[idx] = item;
+            item = displaced;
+        }
+        item.distance += 1;
+        idx = (idx + 1) & (ctx->table_size - 1);
+    }
+}
+
+static void int2int_rehash(Int2IntHashTable_t * const ctx,
+        const size_t old_table_size) {
+
+    Int2IntItem_t *table = (Int2IntItem_t*) INT2INT_TABLE(ctx);
+    Int2IntItem_t item;
+
+    for (size_t idx=0; idx<old_table_size; ++idx) {
+        if (table[idx].status == USED) {
+            table[idx].status = PENDING;
+        }
+    }
+    for (size_t idx=0; idx<old_table_size; ++idx) {
+        if (table[idx].status == PENDING) {
+            item = table[idx];
+            table[idx].status = EMPTY;
+            table[idx].distance = 0;
+            int2int_place(ctx, item);
+        }
+    }
+}
+
+/* Swiss layout */
+
+#define INT2INT_SWISS_CTRL(ctx) \
+        ((unsigned char*) INT2INT_TABLE(ctx))
+#define INT2INT_SWISS_SLOTS(ctx) ((Int2IntSlot_t*) \
+        (INT2INT_SWISS_CTRL(ctx) + (ctx)->table_size + SWISS_GROUP_WIDTH))
+
+static Int2IntSlot_t* int2int_swiss_find_generic(
+        const Int2IntHashTable_t * const ctx, const unsigned long long key) {
+
+    const unsigned char *ctrl = INT2INT_SWISS_CTRL(ctx);
+    Int2IntSlot_t *slots = INT2INT_SWISS_SLOTS(ctx);
+    unsigned long long hash = u_long_long_mix(key);
+    size_t mask = ctx->table_size - 1;
+    size_t group = SWISS_H1(hash) & mask & ~((size_t) SWISS_GROUP_WIDTH - 1);
+    unsigned int match;
+    size_t idx;
+
+    for (size_t probed=0; probed<ctx->table_size;
+            probed+=SWISS_GROUP_WIDTH) {
+        match = swiss_match_generic(ctrl + group, SWISS_H2(hash));
+        while (0 != match) {
+            idx = group + swiss_ctz(match);
+            if (slots[idx].key == key) {
+                return &(slots[idx]);
+            }
+            match &= match - 1;
+        }
+        if (0 != swiss_match_generic(ctrl + group, SWISS_EMPTY)) {
+            break;
+        }
+        group = (group + SWISS_GROUP_WIDTH) & mask;
+    }
+    return NULL;
+}
+
+#if defined(HASHMAP_HAVE_SSE2)
+static Int2IntSlot_t* int2int_swiss_find_sse2(
+        const Int2IntHashTable_t * const ctx, const unsigned long long key) {
+
+    const unsigned char *ctrl = INT2INT_SWISS_CTRL(ctx);
+    Int2IntSlot_t *slots = INT2INT_SWISS_SLOTS(ctx);
+    unsigned long long hash = u_long_long_mix(key);
+    size_t mask = ctx->table_size - 1;
+    size_t group = SWISS_H1(hash) & mask & ~((size_t) SWISS_GROUP_WIDTH - 1);
+    unsigned int match;
+    size_t idx;
+
+    for (size_t probed=0; probed<ctx->table_size;
+            probed+=SWISS_GROUP_WIDTH) {
+        match = swiss_match_sse2(ctrl + group, SWISS_H2(hash));
+        while (0 != match) {
+            idx = group + swiss_ctz(match);
+            if (slots[idx].key == key) {
+                return &(slots[idx]);
+            }
+            match &= match - 1;
+        }
+        if (0 != swiss_match_sse2(ctrl + group, SWISS_EMPTY)) {
+            break;
+        }
+        group = (group + SWISS_GROUP_WIDTH) & mask;
+    }
+    return NULL;
+}
+#endif
+
+#if defined(HASHMAP_HAVE_AVX2)
+/* Two consecutive groups are tested at once, key can not be placed behind
+   a group with an empty slot, so the probe stops when any of them
+   contains one. */
+HASHMAP_TARGET_AVX2
+static Int2IntSlot_t* int2int_swiss_find_avx2(
+        const Int2IntHashTable_t * const ctx, const unsigned long long key) {
+
+    const unsigned char *ctrl = INT2INT_SWISS_CTRL(ctx);
+    Int2IntSlot_t *slots = INT2INT_SWISS_SLOTS(ctx);
+    unsigned long long hash = u_long_long_mix(key);
+    size_t mask = ctx->table_size - 1;
+    size_t group = SWISS_H1(hash) & mask & ~((size_t) SWISS_GROUP_WIDTH - 1);
+    unsigned int match;
+    size_t idx;
+
+    for (size_t probed=0; probed<ctx->table_size;
+            probed+=2*SWISS_GROUP_WIDTH) {
+        match = swiss_match_avx2(ctrl + group, SWISS_H2(hash));
+        while (0 != match) {
+            idx = (group + swiss_ctz(match)) & mask;
+            if (slots[idx].key == key) {
+                return &(slots[idx]);
+            }
+            match &= match - 1;
+        }
+        if (0 != swiss_match_avx2(ctrl + group, SWISS_EMPTY)) {
+            break;
+        }
+        group = (group + 2 * SWISS_GROUP_WIDTH) & mask;
+    }
+    return NULL;
+}
+#endif
+
+static Int2IntSlot_t* int2int_swiss_find(
+        const Int2IntHashTable_t * const ctx, const unsigned long long key) {
+
+    switch (hashmap_swiss_kernel()) {
+#if defined(HASHMAP_HAVE_AVX2)
+    case HASHMAP_SWISS_KERNEL_AVX2:
+        return int2int_swiss_find_avx2(ctx, key);
+#endif
+#if defined(HASHMAP_HAVE_SSE2)
+    case HASHMAP_SWISS_KERNEL_SSE2:
+        return int2int_swiss_find_sse2(ctx, key);
+#endif
+    default:
+        return int2int_swiss_find_generic(ctx, key);
+    }
+}
+
+static int int2int_swiss_insert(Int2IntHashTable_t * const ctx,
+        const unsigned long long key, const size_t value) {
+
+    unsigned char *ctrl = INT2INT_SWISS_CTRL(ctx);
+    Int2IntSlot_t *slots = INT2INT_SWISS_SLOTS(ctx);
+    unsigned long long hash = u_long_long_mix(key);
+    size_t idx = swiss_find_free(ctrl, ctx->table_size, hash);
+
+    if (idx == ctx->table_size) {
+        return -1;
+    }
+    swiss_set_ctrl(ctrl, ctx->table_size, idx, SWISS_H2(hash));
+    slots[idx].key = key;
+    slots[idx].value = value;
+    ctx->current_size += 1;
+
+    return 0;
+}
+
+static void int2int_swiss_remove(Int2IntHashTable_t * const ctx,
+        Int2IntSlot_t * const slot) {
+
+    unsigned char *ctrl = INT2INT_SWISS_CTRL(ctx);
+    size_t idx = slot - INT2INT_SWISS_SLOTS(ctx);
+
+    swiss_set_ctrl(ctrl, ctx->table_size, idx, swiss_free_mark(ctrl, idx));
+    ctx->current_size -= 1;
+}
+
+/* Place slot while the table grows in place, control byte DELETED marks
+   pending slot, it is free for the placed slot and it is placed next. */
+static void int2int_swiss_place(Int2IntHashTable_t * const ctx,
+        Int2IntSlot_t slot) {
+
+    unsigned char *ctrl = INT2INT_SWISS_CTRL(ctx);
+    Int2IntSlot_t *slots = INT2INT_SWISS_SLOTS(ctx);
+    Int2IntSlot_t displaced;
+    unsigned long long hash;
+    size_t idx;
+    bool pending;
+
+    do {
+        hash = u_long_long_mix(slot.key);
+        idx = swiss_find_free(ctrl, ctx->table_size, hash);
+        pending = (SWISS_DELETED == ctrl[idx]);
+        displaced = slots[idx];
+        swiss_set_ctrl(ctrl, ctx->table_size, idx, SWISS_H2(hash));
+        slots[idx] = slot;
+        slot = displaced;
+    } while (pending);
+}
+
+/* Move slots behind bigger control bytes array and rehash them, memory
+   for the table_size must be already allocated. */
+static void int2int_swiss_grow(Int2IntHashTable_t * const ctx,
+        const size_t table_size) {
+
+    unsigned char *ctrl = INT2INT_SWISS_CTRL(ctx);
+    size_t old_table_size = ctx->table_size;
+    Int2IntSlot_t *slots;
+    Int2IntSlot_t slot;
+
+    memmove(ctrl + table_size + SWISS_GROUP_WIDTH,
+            INT2INT_SWISS_SLOTS(ctx), old_table_size * sizeof(Int2IntSlot_t));
+    ctx->table_size = table_size;
+    slots = INT2INT_SWISS_SLOTS(ctx);
+
+    /* Used slots become pending, deleted ones empty */
+    for (size_t idx=0; idx<old_table_size; ++idx) {
+        ctrl[idx] = (ctrl[idx] & SWISS_EMPTY) ? SWISS_EMPTY : SWISS_DELETED;
+    }
+    memset(ctrl + old_table_size, SWISS_EMPTY,
+            table_size + SWISS_GROUP_WIDTH - old_table_size);
+
+    for (size_t idx=0; idx<old_table_size; ++idx) {
+        if (SWISS_DELETED == ctrl[idx]) {
+            slot = slots[idx];
+            swiss_set_ctrl(ctrl, table_size, idx, SWISS_EMPTY);
+            int2int_swiss_place(ctx, slot);
+        }
+    }
+}
+
+/* Incremental resize - new table keeps pointer to the previous one and
+   every set/del migrates HASHMAP_MIGRATE_STEP buckets of it. Migrated and
+   deleted items of the previous table are only marked as DELETED, their
+   distances are kept, so lookup in the previous table still stops early
+   and positions of not yet migrated items do not move. Each key is stored
+   in exactly one of the tables, current_size counts items of both. */
+
+static inline Int2IntHashTable_t* int2int_previous(
+        const Int2IntHashTable_t * const ctx) {
+    return (ctx->flags & HASHMAP_FLAG_MIGRATING) ? ctx->previous : NULL;
+}
+
+static void int2int_migrate(Int2IntHashTable_t * const ctx,
+        const size_t steps) {
+
+    Int2IntHashTable_t *previous = int2int_previous(ctx);
+    Int2IntItem_t *table;
+    size_t end;
+
+    if (NULL == previous) {
+        return;
+    }
+    table = (Int2IntItem_t*) INT2INT_TABLE(previous);
+    end = ctx->migrate_position + steps;
+    if ((end > previous->table_size) || (end < ctx->migrate_position)) {
+        end = previous->table_size;
+    }
+
+    for (size_t idx=ctx->migrate_position; idx<end; ++idx) {
+        if (USED == table[idx].status) {
+            /* New table is at least twice bigger, there is always space */
+            int2int_insert(ctx, table[idx].key, table[idx].value);
+            ctx->current_size -= 1;
+            table[idx].status = DELETED;
+        }
+    }
+    ctx->migrate_position = end;
+
+    if (end == previous->table_size) {
+        free(previous);
+        ctx->previous = NULL;
+        ctx->migrate_position = 0;
+        ctx->flags &= ~HASHMAP_FLAG_MIGRATING;
+    }
+}
+
+/* Compact and SoA layouts */
+
+static void int2int_strided(const Int2IntHashTable_t * const ctx,
+        StridedTable_t * const t) {
+    char *table = INT2INT_TABLE(ctx);
+
+    if (HASHMAP_LAYOUT_SOA == ctx->layout) {
+        t->keys = (char*) INT2INT_SOA_KEYS(ctx);
+        t->values = (char*) INT2INT_SOA_VALUES(ctx);
+        t->key_stride = sizeof(unsigned long long);
+        t->value_stride = sizeof(size_t);
+    }
+    else {
+        t->keys = table + offsetof(Int2IntSlot_t, key);
+        t->values = table + offsetof(Int2IntSlot_t, value);
+        t->key_stride = sizeof(Int2IntSlot_t);
+        t->value_stride = sizeof(Int2IntSlot_t);
+    }
+    t->value_size = sizeof(size_t);
+    t->table_size = ctx->table_size;
+    t->zero_key_used = (bool*) &(ctx->zero_key_used);
+}
+
+/* Cuckoo layout */
+
+/* Number of displaced keys before the build gives up and tries bigger
+   table */
+#define CUCKOO_MAX_KICKS 512
+
+static inline void cuckoo_buckets(const unsigned long long key,
+        const size_t table_size, size_t * const first,
+        size_t * const second) {
+    unsigned long long hash = u_long_long_mix(key);
+    size_t mask = table_size / CUCKOO_BUCKET_SIZE - 1;
+
+    *first = (size_t) hash & mask;
+    *second = (size_t) ((hash >> 32) | (hash << 32)) & mask;
+    if (*second == *first) {
+        *second = *first ^ 1;
+    }
+}
+
+static Int2IntSlot_t* int2int_cuckoo_find(
+        const Int2IntHashTable_t * const ctx, const unsigned long long key) {
+
+    Int2IntSlot_t *slots = (Int2IntSlot_t*) INT2INT_TABLE(ctx);
+    Int2IntSlot_t *bucket;
+    size_t buckets[2];
+
+    if (0 == key) {
+        return ctx->zero_key_used ? &(slots[ctx->table_size]) : NULL;
+    }
+    cuckoo_buckets(key, ctx->table_size, &buckets[0], &buckets[1]);
+    for (size_t b=0; b<2; ++b) {
+        bucket = slots + buckets[b] * CUCKOO_BUCKET_SIZE;
+        for (size_t i=0; i<CUCKOO_BUCKET_SIZE; ++i) {
+            if (bucket[i].key == key) {
+                return &(bucket[i]);
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Insert key which is not in the table yet. When both buckets are full,
+   key takes place of a random slot of them and the displaced key is
+   inserted next. Return -1 when it does not end in CUCKOO_MAX_KICKS,
+   displaced key is lost then. */
+static int int2int_cuckoo_insert(Int2IntHashTable_t * const ctx,
+        unsigned long long key, size_t value, unsigned int * const random) {
+
+    Int2IntSlot_t *slots = (Int2IntSlot_t*) INT2INT_TABLE(ctx);
+    Int2IntSlot_t *bucket;
+    Int2IntSlot_t displaced;
+    size_t buckets[2];
+
+    if (0 == key) {
+        slots[ctx->table_size].value = value;
+        ctx->zero_key_used = true;
+        ctx->current_size += 1;
+        return 0;
+    }
+    for (size_t kick=0; kick<CUCKOO_MAX_KICKS; ++kick) {
+        cuckoo_buckets(key, ctx->table_size, &buckets[0], &buckets[1]);
+        for (size_t b=0; b<2; ++b) {
+            bucket = slots + buckets[b] * CUCKOO_BUCKET_SIZE;
+            for (size_t i=0; i<CUCKOO_BUCKET_SIZE; ++i) {
+                if (0 == bucket[i].key) {
+                    bucket[i].key = key;
+                    bucket[i].value = value;
+                    ctx->current_size += 1;
+                    return 0;
+                }
+            }
+        }
+        *random = *random * 1103515245 + 12345;
+        bucket = slots + buckets[(*random >> 16) & 1] * CUCKOO_BUCKET_SIZE
+                + ((*random >> 17) % CUCKOO_BUCKET_SIZE);
+        displaced = *bucket;
+        bucket->key = key;
+        bucket->value = value;
+        key = displaced.key;
+        value = displaced.value;
+    }
+    return -1;
+}
+
+/* Read-modify-write operations of int2int_add etc., key which is not in
+   the table gets the operand, added to or subtracted from 0 by add/sub */
+typedef enum {
+    HASHMAP_OP_SET,
+    HASHMAP_OP_ADD,
+    HASHMAP_OP_SUB,
+    HASHMAP_OP_MIN,
+    HASHMAP_OP_MAX
+} HashmapOp_e;
+
+/* Return -4 when the result of add/sub does not fit into size_t, the
+   value is not changed then */
+static inline int int2int_apply_op(const HashmapOp_e op,
+        const size_t value, const size_t operand, size_t * const result) {
+    switch (op) {
+    case HASHMAP_OP_SET:
+        *result = operand;
+        return 0;
+    case HASHMAP_OP_ADD:
+        *result = value + operand;
+        return (*result < value) ? -4 : 0;
+    case HASHMAP_OP_SUB:
+        *result = value - operand;
+        return (operand > value) ? -4 : 0;
+    case HASHMAP_OP_MIN:
+        *result = (operand < value) ? operand : value;
+        return 0;
+    case HASHMAP_OP_MAX:
+        *result = (operand > value) ? operand : value;
+        return 0;
+    }
+    *result = value;
+    return 0;
+}
+
+static inline int int2int_initial_value(const HashmapOp_e op,
+        const size_t operand, size_t * const result) {
+    if ((HASHMAP_OP_ADD == op) || (HASHMAP_OP_SUB == op)) {
+        return int2int_apply_op(op, 0, operand, result);
+    }
+    *result = operand;
+    return 0;
+}
+
+/* Concurrent layout
+
+   Items are never moved. Writer claims a free item on the probe sequence
+   of the key by CAS of its key word from 0 to the key, claimed item keeps
+   the key until clear, so the probe sequence of a key never changes and
+   lookup stops at the first free item. Claims are counted by claimed of
+   the header, at most size items are claimed. Present keys have USED
+   status. Writer which inserts the key locks the item by PENDING status,
+   stores its process id into distance of the item, stores the value and
+   publishes it by USED status, values of present keys are modified by
+   atomic operations. del swaps USED to DELETED. Item of the key 0 is the
+   extra item at index table_size. */
+
+/* Reserve a claim of a free item, claimed never exceeds size */
+static bool int2int_concurrent_reserve(Int2IntHashTable_t * const ctx) {
+    size_t claimed = HASHMAP_ATOMIC_LOAD(&(ctx->claimed));
+    size_t expected;
+
+    do {
+        if (claimed >= ctx->size) {
+            return false;
+        }
+        expected = claimed;
+        claimed = HASHMAP_ATOMIC_CAS(&(ctx->claimed), expected, expected + 1);
+    } while (claimed != expected);
+    return true;
+}
+
+/* Claim is passed only by writers, the table is not modified otherwise */
+static Int2IntItem_t* int2int_concurrent_find(
+        const Int2IntHashTable_t * const ctx, const unsigned long long key,
+        const bool claim) {
+
+    Int2IntItem_t *table = (Int2IntItem_t*) INT2INT_TABLE(ctx);
+    size_t idx = u_long_long_hash(key, ctx->table_size);
+    Int2IntItem_t *item = NULL;
+    unsigned long long item_key;
+    bool reserved = false;
+
+    if (0 == key) {
+        return &(table[ctx->table_size]);
+    }
+    for (size_t i=0; i<ctx->table_size; ++i) {
+        item_key = HASHMAP_ATOMIC_LOAD(&(table[idx].key));
+        if ((0 == item_key) && claim) {
+            if (!reserved && !(reserved = int2int_concurrent_reserve(
+                    (Int2IntHashTable_t*) ctx))) {
+                return NULL;
+            }
+            /* Failed CAS returns key of other writer, it may be the same */
+            item_key = HASHMAP_ATOMIC_CAS(&(table[idx].key), 0ULL, key);
+            if (0 == item_key) {
+                return &(table[idx]);
+            }
+        }
+        if (item_key == key) {
+            item = &(table[idx]);
+            break;
+        }
+        if (0 == item_key) {
+            break;
+        }
+        idx = (idx + 1) & (ctx->table_size - 1);
+    }
+    if (reserved) {
+        /* Other writer claimed the item of the key */
+        HASHMAP_ATOMIC_DEC(&(((Int2IntHashTable_t*) ctx)->claimed));
+    }
+    return item;
+}
+
+/* Return USED if the key is present, otherwise the item is locked by
+   PENDING status for the caller and its previous status is returned.
+   Writer waits while other writer inserts the same key, PENDING is
+   returned only when the process of the other writer does not exist,
+   it crashed in the insert. Owner 0 is not known yet. */
+static ItemStatus_e int2int_concurrent_acquire(Int2IntItem_t * const item) {
+    ItemStatus_e status;
+    unsigned int owner;
+
+    for (size_t attempt=0; true; ++attempt) {
+        status = (ItemStatus_e) HASHMAP_ATOMIC_LOAD32(&(item->status));
+        if (USED == status) {
+            return status;
+        }
+        if ((PENDING != status) && (status == (ItemStatus_e)
+                HASHMAP_ATOMIC_CAS32(&(item->status), status, PENDING))) {
+            HASHMAP_ATOMIC_XCHG32(&(item->distance), hashmap_process_id());
+            return status;
+        }
+        /* Other writer inserts the same key */
+        if (attempt < HASHMAP_CONCURRENT_SPINS) {
+            HASHMAP_SPIN();
+            continue;
+        }
+        owner = (unsigned int) HASHMAP_ATOMIC_LOAD32(&(item->distance));
+        if ((0 != owner) && !hashmap_process_alive(owner)
+                && (PENDING == HASHMAP_ATOMIC_LOAD32(&(item->status)))
+                && (owner == (unsigned int)
+                        HASHMAP_ATOMIC_LOAD32(&(item->distance)))) {
+            return PENDING;
+        }
+        hashmap_yield();
+    }
+}
+
+/* Unlock the item locked by int2int_concurrent_acquire without insert */
+static void int2int_concurrent_release(Int2IntItem_t * const item,
+        const ItemStatus_e status) {
+    HASHMAP_ATOMIC_XCHG32(&(item->distance), 0);
+    HASHMAP_ATOMIC_XCHG32(&(item->status), status);
+}
+
+/* Insert the key of the item locked by int2int_concurrent_acquire, status
+   is restored when the table is full */
+static int int2int_concurrent_publish(Int2IntHashTable_t * const ctx,
+        Int2IntItem_t * const item, const size_t value,
+        const ItemStatus_e status) {
+
+    size_t current_size = HASHMAP_ATOMIC_LOAD(&(ctx->current_size));
+    size_t expected;
+
+    /* Place of the new key is reserved before the key is published, so
+       current_size never exceeds size */
+    do {
+        if (current_size >= ctx->size) {
+            int2int_concurrent_release(item, status);
+            return -1;
+        }
+        expected = current_size;
+        current_size = HASHMAP_ATOMIC_CAS(&(ctx->current_size),
+                expected, expected + 1);
+    } while (current_size != expected);
+    HASHMAP_ATOMIC_STORE(&(item->value), value);
+    /* Next owner of the item is not known until it stores its id */
+    HASHMAP_ATOMIC_XCHG32(&(item->distance), 0);
+    HASHMAP_ATOMIC_XCHG32(&(item->status), USED);
+    return 0;
+}
+
+static int int2int_concurrent_apply(Int2IntHashTable_t * const ctx,
+        const unsigned long long key, const HashmapOp_e op,
+        const size_t operand, size_t * const value) {
+
+    Int2IntItem_t *item = int2int_concurrent_find(ctx, key, true);
+    ItemStatus_e status;
+    size_t current;
+    size_t previous;
+    size_t result;
+    int res;
+
+    if (NULL == item) {
+        /* No item is free, either the table is full or deleted keys
+           hold their items */
+        return (HASHMAP_ATOMIC_LOAD(&(ctx->current_size)) < ctx->size)
+                ? -2 : -1;
+    }
+    if (PENDING == (status = int2int_concurrent_acquire(item))) {
+        return -3;
+    }
+    if (USED != status) {
+        if ((res = int2int_initial_value(op, operand, &result))) {
+            int2int_concurrent_release(item, status);
+            return res;
+        }
+        if (int2int_concurrent_publish(ctx, item, result, status)) {
+            return -1;
+        }
+    }
+    else if (HASHMAP_OP_SET == op) {
+        HASHMAP_ATOMIC_STORE(&(item->value), operand);
+        result = operand;
+    }
+    else {
+        /* Value is replaced only when the operation changes it, result
+           out of range is checked before the swap */
+        current = HASHMAP_ATOMIC_LOAD(&(item->value));
+        while (true) {
+            if ((res = int2int_apply_op(op, current, operand, &result))) {
+                return res;
+            }
+            if (result == current) {
+                break;
+            }
+            previous = HASHMAP_ATOMIC_CAS(&(item->value), current, result);
+            if (previous == current) {
+                break;
+            }
+            current = previous;
+        }
+    }
+    if (NULL != value) {
+        *value = result;
+    }
+    return 0;
+}
+
+static int int2int_concurrent_del(Int2IntHashTable_t * const ctx,
+        const unsigned long long key) {
+
+    Int2IntItem_t *item = int2int_concurrent_find(ctx, key, false);
+
+    if ((NULL == item) || (USED != HASHMAP_ATOMIC_CAS32(&(item->status),
+            USED, DELETED))) {
+        return -1;
+    }
+    HASHMAP_ATOMIC_DEC(&(ctx->current_size));
+    return 0;
+}
+
+int int2int_new(const size_t size, Int2IntHashTable_t ** new_ctx) {
+    return int2int_new_layout(size, HASHMAP_LAYOUT_ITEMS, new_ctx);
+}
+
+int int2int_new_layout(const size_t size, const HashmapLayout_e layout,
+        Int2IntHashTable_t ** new_ctx) {
+    return int2int_new_ex(size, layout, HASHMAP_DEFAULT_MAX_LOAD,
+            HASHMAP_DEFAULT_GROWTH, new_ctx);
+}
+
+/* Initialize header and empty table in memory block of memory_size bytes */
+static void int2int_format(Int2IntHashTable_t * const hashmap,
+        const size_t memory_size, const size_t size, const size_t table_size,
+        const HashmapLayout_e layout, const double max_load,
+        const double growth) {
+
+    memset(hashmap, 0, memory_size);
+
+    hashmap->size = size;
+    hashmap->current_size = 0;
+    hashmap->table_size = table_size;
+    hashmap->readonly = false;
+    hashmap->version = HASHMAP_VERSION;
+    hashmap->layout = layout;
+    hashmap->max_load = max_load;
+    hashmap->growth = growth;
+    if (HASHMAP_LAYOUT_SWISS == layout) {
+        memset(INT2INT_SWISS_CTRL(hashmap), SWISS_EMPTY,
+                table_size + SWISS_GROUP_WIDTH);
+    }
+}
+
+int int2int_new_ex(const size_t size, const HashmapLayout_e layout,
+        const double max_load, const double growth,
+        Int2IntHashTable_t ** new_ctx) {
+    size_t table_size;
+    size_t memory_size;
+    Int2IntHashTable_t *hashmap;
+
+    if (!((max_load > 0.0) && (max_load <= 1.0)) || !(growth > 1.0)) {
+        return -1;
+    }
+    table_size = int2int_layout_table_size(size, layout, max_load);
+    memory_size = int2int_layout_memory_size(table_size, layout);
+    if ((0 == table_size) || (0 == memory_size)) {
+        return -1;
+    }
+    if (NULL == (hashmap = malloc(memory_size))) {
+        return -1;
+    }
+    int2int_format(hashmap, memory_size, size, table_size, layout,
+            max_load, growth);
+
+    *new_ctx = hashmap;
+
+    return 0;
+}
+
+int int2int_new_in(void * const memory, const size_t memory_size,
+        const size_t size, const HashmapLayout_e layout,
+        const double max_load, Int2IntHashTable_t ** new_ctx) {
+    size_t table_size;
+    size_t required_size;
+    Int2IntHashTable_t *hashmap = memory;
+
+    if (!((max_load > 0.0) && (max_load <= 1.0))
+            || (0 != ((uintptr_t) memory % sizeof(double)))) {
+        return -1;
+    }
+    table_size = int2int_layout_table_size(size, layout, max_load);
+    required_size = int2int_layout_memory_size(table_size, layout);
+    if ((0 == table_size) || (0 == required_size)
+            || (required_size > memory_size)) {
+        return -1;
+    }
+    int2int_format(hashmap, required_size, size, table_size, layout,
+            max_load, HASHMAP_DEFAULT_GROWTH);
+    hashmap->flags = HASHMAP_FLAG_FIXED_SIZE;
+
+    *new_ctx = hashmap;
+
+    return 0;
+}
+
+/* Seqlock - the writer makes sequence odd before it modifies the table and
+   even again behind the modification. Reader repeats the lookup when
+   sequence was odd or changed meanwhile. Memory of the table of fixed size
+   never moves and its table_size never changes, so a lookup which races
+   with the writer reads only the memory of the table and it ends after
+   at most table_size probes. */
+
+int int2int_seqlock(Int2IntHashTable_t * const ctx) {
+    /* Concurrent table has many writers, its items are atomic */
+    if ((HASHMAP_LEGACY_VERSION == ctx->version)
+            || !(ctx->flags & HASHMAP_FLAG_FIXED_SIZE)
+            || (HASHMAP_LAYOUT_CONCURRENT == ctx->layout)) {
+        return -1;
+    }
+    ctx->flags |= HASHMAP_FLAG_SEQLOCK;
+
+    return 0;
+}
+
+/* Return true if the modification must be finished by int2int_write_end,
+   table without seqlock may be reallocated by the modification */
+static inline bool int2int_write_begin(Int2IntHashTable_t * const ctx) {
+    if (!(ctx->flags & HASHMAP_FLAG_SEQLOCK)) {
+        return false;
+    }
+    HASHMAP_SEQ_STORE(&ctx->sequence, ctx->sequence + 1);
+    HASHMAP_RELEASE();
+    return true;
+}
+
+static inline void int2int_write_end(Int2IntHashTable_t * const ctx,
+        const bool locked) {
+    if (locked) {
+        HASHMAP_RELEASE();
+        HASHMAP_SEQ_STORE(&ctx->sequence, ctx->sequence + 1);
+    }
+}
+
+static inline unsigned long long int2int_read_begin(
+        const Int2IntHashTable_t * const ctx) {
+    unsigned long long sequence = HASHMAP_SEQ_LOAD(&ctx->sequence);
+
+    HASHMAP_ACQUIRE();
+    return sequence;
+}
+
+/* Return true if data read since int2int_read_begin may be torn */
+static inline bool int2int_read_retry(const Int2IntHashTable_t * const ctx,
+        const unsigned long long sequence) {
+    HASHMAP_ACQUIRE();
+    return (0 != (sequence & 1))
+            || (sequence != HASHMAP_SEQ_LOAD(&ctx->sequence));
+}
+
+size_t int2int_layout_table_size(const size_t size,
+        const HashmapLayout_e layout, const double max_load) {
+    switch (layout) {
+    case HASHMAP_LAYOUT_ITEMS:
+    case HASHMAP_LAYOUT_COMPACT:
+    case HASHMAP_LAYOUT_SOA:
+    case HASHMAP_LAYOUT_CONCURRENT:
+        return hashmap_load_table_size(size, max_load);
+    case HASHMAP_LAYOUT_SWISS:
+        return SWISS_TABLE_SIZE(hashmap_load_table_size(size, max_load));
+    case HASHMAP_LAYOUT_CUCKOO:
+        /* Buckets are filled densely, max_load is not used */
+        return CUCKOO_TABLE_SIZE(
+                hashmap_load_table_size(size, CUCKOO_MAX_LOAD));
+    }
+    return 0;
+}
+
+size_t int2int_layout_memory_size(const size_t table_size,
+        const HashmapLayout_e layout) {
+    switch (layout) {
+    case HASHMAP_LAYOUT_ITEMS:
+        return INT2INT_MEMORY_SIZE(table_size);
+    case HASHMAP_LAYOUT_SWISS:
+        return INT2INT_SWISS_MEMORY_SIZE(table_size);
+    case HASHMAP_LAYOUT_COMPACT:
+    case HASHMAP_LAYOUT_CUCKOO:
+        return INT2INT_COMPACT_MEMORY_SIZE(table_size);
+    case HASHMAP_LAYOUT_SOA:
+        return INT2INT_SOA_MEMORY_SIZE(table_size);
+    case HASHMAP_LAYOUT_CONCURRENT:
+        return INT2INT_CONCURRENT_MEMORY_SIZE(table_size);
+    }
+    return 0;
+}
+
+/* Extend memory block of the table for size items by realloc and rehash
+   items within it, so the old and the new table never exist at the same
+   time. Large blocks are mmap-ed by the allocator and extended by mremap
+   without copying. Legacy blocks have different header, they are not
+   grown in place. */
+static int int2int_grow(Int2IntHashTable_t * const ctx, const size_t size,
+        Int2IntHashTable_t ** new_ctx) {
+
+    size_t old_table_size = ctx->table_size;
+    size_t old_memory_size = int2int_buffer_size(ctx);
+    size_t table_size = int2int_layout_table_size(size, ctx->layout,
+            int2int_max_load(ctx));
+    size_t memory_size = int2int_layout_memory_size(table_size, ctx->layout);
+    unsigned char *pending = NULL;
+    Int2IntHashTable_t *hashmap;
+    StridedTable_t old_strided;
+    StridedTable_t strided;
+
+    if ((table_size < old_table_size) || (memory_size < old_memory_size)) {
+        return -1;
+    }
+    if (table_size == old_table_size) {
+        /* Load of the table is still under max_load */
+        ctx->size = size;
+        *new_ctx = ctx;
+        return 0;
+    }
+    if (HASHMAP_LAYOUT_IS_STRIDED(ctx->layout)) {
+        pending = calloc(PENDING_BITMAP_SIZE(old_table_size), 1);
+        if (NULL == pending) {
+            return -1;
+        }
+    }
+    if (NULL == (hashmap = realloc(ctx, memory_size))) {
+        free(pending);
+        return -1;
+    }
+    memset((char*) hashmap + old_memory_size, 0,
+            memory_size - old_memory_size);
+
+    if (HASHMAP_LAYOUT_SWISS == hashmap->layout) {
+        int2int_swiss_grow(hashmap, table_size);
+    }
+    else if (HASHMAP_LAYOUT_IS_STRIDED(hashmap->layout)) {
+        int2int_strided(hashmap, &old_strided);
+        hashmap->table_size = table_size;
+        int2int_strided(hashmap, &strided);
+        strided_grow(&old_strided, &strided, pending);
+        free(pending);
+    }
+    else {
+        hashmap->table_size = table_size;
+        int2int_rehash(hashmap, old_table_size);
+    }
+    hashmap->size = size;
+
+    *new_ctx = hashmap;
+
+    return 0;
+}
+
+static int int2int_set_item(Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t value,
+        Int2IntHashTable_t ** new_ctx) {
+
+    Int2IntHashTable_t *new_hashmap;
+    Int2IntHashTable_t *previous;
+    Int2IntItem_t *found;
+    Int2IntSlot_t *slot;
+    StridedTable_t strided;
+    size_t idx;
+    size_t position = 0;
+    unsigned long long item_key;
+    size_t *item_value;
+    size_t size;
+    bool incremental;
+
+    if (ctx->readonly || (HASHMAP_LAYOUT_CUCKOO == ctx->layout)) {
+        return -1;
+    }
+    if (HASHMAP_LAYOUT_CONCURRENT == ctx->layout) {
+        /* Table is never resized */
+        if (NULL != new_ctx) {
+            *new_ctx = ctx;
+        }
+        return int2int_concurrent_apply(ctx, key, HASHMAP_OP_SET, value,
+                NULL);
+    }
+
+    // Resize table if necessary
+    if (NULL != new_ctx) {
+        if ((ctx->current_size == ctx->size)
+                && (ctx->flags & HASHMAP_FLAG_FIXED_SIZE)) {
+            /* Full table in memory of the caller can only update keys */
+            if (0 != int2int_has(ctx, key)) {
+                return -1;
+            }
+        }
+        else if (ctx->current_size == ctx->size) {
+            int2int_finish_resize(ctx);
+            incremental = (ctx->flags & HASHMAP_FLAG_INCREMENTAL_RESIZE)
+                    && (HASHMAP_LAYOUT_ITEMS == ctx->layout);
+
+            size = (size_t) (ctx->size * int2int_growth(ctx));
+            if (size <= ctx->size) {
+                size = ctx->size + 1;
+            }
+
+            if ((HASHMAP_LEGACY_VERSION != ctx->version) && !incremental) {
+                /* Block is extended, items are rehashed within it */
+                if (int2int_grow(ctx, size, &new_hashmap)) {
+                    return -1;
+                }
+            }
+            else {
+                if (int2int_new_ex(size, ctx->layout, int2int_max_load(ctx),
+                        int2int_growth(ctx), &new_hashmap)) {
+                    return -1;
+                }
+                new_hashmap->flags =
+                        ctx->flags & HASHMAP_FLAG_INCREMENTAL_RESIZE;
+
+                if (HASHMAP_LEGACY_VERSION != ctx->version) {
+                    /* Items are migrated by following calls */
+                    new_hashmap->flags |= HASHMAP_FLAG_MIGRATING;
+                    new_hashmap->previous = ctx;
+                    new_hashmap->current_size = ctx->current_size;
+                }
+                else {
+                    /* Legacy table is converted into current format */
+                    while (0 == int2int_next(ctx, &position,
+                            &item_key, &item_value)) {
+                        if (int2int_set(new_hashmap, item_key, *item_value,
+                                NULL)) {
+                            free(new_hashmap);
+                            return -1;
+                        }
+                    }
+                    free(ctx);
+                }
+            }
+            ctx = new_hashmap;
+        }
+        *new_ctx = ctx;
+    }
+
+    if (HASHMAP_LAYOUT_SWISS == ctx->layout) {
+        if (NULL != (slot = int2int_swiss_find(ctx, key))) {
+            slot->value = value;
+            return 0;
+        }
+        return int2int_swiss_insert(ctx, key, value);
+    }
+    if (HASHMAP_LAYOUT_IS_STRIDED(ctx->layout)) {
+        int2int_strided(ctx, &strided);
+        if ((idx = strided_find(&strided, key)) <= ctx->table_size) {
+            *(size_t*) STRIDED_VALUE(&strided, idx) = value;
+            return 0;
+        }
+        if (strided_insert(&strided, key, &value)) {
+            return -1;
+        }
+        ctx->current_size += 1;
+        return 0;
+    }
+    if (HASHMAP_LEGACY_VERSION == ctx->version) {
+        return int2int_legacy_insert(ctx, key, value);
+    }
+
+    int2int_migrate(ctx, HASHMAP_MIGRATE_STEP);
+    if (NULL != (found = int2int_find(ctx, key))) {
+        found->value = value;
+        return 0;
+    }
+    if ((NULL != (previous = int2int_previous(ctx)))
+            && (NULL != (found = int2int_find(previous, key)))) {
+        found->value = value;
+        return 0;
+    }
+    return int2int_insert(ctx, key, value);
+}
+
+int int2int_set(Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t value,
+        Int2IntHashTable_t ** new_ctx) {
+
+    bool locked = int2int_write_begin(ctx);
+    int res = int2int_set_item(ctx, key, value, new_ctx);
+
+    int2int_write_end(ctx, locked);
+
+    return res;
+}
+
+static int int2int_del_item(Int2IntHashTable_t * const ctx,
+        const unsigned long long key) {
+
+    Int2IntHashTable_t *previous;
+    Int2IntItem_t *item;
+    Int2IntSlot_t *slot;
+    StridedTable_t strided;
+    size_t idx;
+
+    if (HASHMAP_LAYOUT_CUCKOO == ctx->layout) {
+        /* Frozen table is read-only */
+        return -1;
+    }
+    if (HASHMAP_LAYOUT_CONCURRENT == ctx->layout) {
+        return int2int_concurrent_del(ctx, key);
+    }
+    if (HASHMAP_LAYOUT_SWISS == ctx->layout) {
+        if (NULL == (slot = int2int_swiss_find(ctx, key))) {
+            return -1;
+        }
+        int2int_swiss_remove(ctx, slot);
+        return 0;
+    }
+    if (HASHMAP_LAYOUT_IS_STRIDED(ctx->layout)) {
+        int2int_strided(ctx, &strided);
+        if ((idx = strided_find(&strided, key)) > ctx->table_size) {
+            return -1;
+        }
+        strided_remove(&strided, idx);
+        ctx->current_size -= 1;
+        return 0;
+    }
+    if (HASHMAP_LEGACY_VERSION == ctx->version) {
+        if (NULL == (item = int2int_legacy_find(ctx, key))) {
+            return -1;
+        }
+        item->status = DELETED;
+        ctx->current_size -= 1;
+        return 0;
+    }
+
+    int2int_migrate(ctx, HASHMAP_MIGRATE_STEP);
+    if (NULL != (item = int2int_find(ctx, key))) {
+        int2int_remove(ctx, item);
+        return 0;
+    }
+    if ((NULL != (previous = int2int_previous(ctx)))
+            && (NULL != (item = int2int_find(previous, key)))) {
+        /* Items of the previous table must not move */
+        item->status = DELETED;
+        ctx->current_size -= 1;
+        return 0;
+    }
+
+    return -1;
+}
+
+int int2int_del(Int2IntHashTable_t * const ctx,
+        const unsigned long long key) {
+
+    bool locked = int2int_write_begin(ctx);
+    int res = int2int_del_item(ctx, key);
+
+    int2int_write_end(ctx, locked);
+
+    return res;
+}
+
+int int2int_get(const Int2IntHashTable_t * const ctx,
+        const unsigned long long key, size_t * const value) {
+
+    size_t * p_value;
+
+    if (int2int_ptr(ctx, key, &p_value) == 0) {
+        *value = *p_value;
+        return 0;
+    }
+    return -1;
+}
+
+int int2int_ptr(const Int2IntHashTable_t * const ctx,
+        const unsigned long long key, size_t ** const value) {
+
+    Int2IntHashTable_t *previous;
+    Int2IntItem_t *item;
+    Int2IntSlot_t *slot;
+    StridedTable_t strided;
+    size_t idx;
+
+    if (HASHMAP_LAYOUT_SWISS == ctx->layout) {
+        if (NULL == (slot = int2int_swiss_find(ctx, key))) {
+            return -1;
+        }
+        *value = &(slot->value);
+        return 0;
+    }
+    if (HASHMAP_LAYOUT_CUCKOO == ctx->layout) {
+        if (NULL == (slot = int2int_cuckoo_find(ctx, key))) {
+            return -1;
+        }
+        *value = &(slot->value);
+        return 0;
+    }
+    if (HASHMAP_LAYOUT_CONCURRENT == ctx->layout) {
+        item = int2int_concurrent_find(ctx, key, false);
+        if ((NULL == item)
+                || (USED != HASHMAP_ATOMIC_LOAD32(&(item->status)))) {
+            return -1;
+        }
+        *value = &(item->value);
+        return 0;
+    }
+    if (HASHMAP_LAYOUT_IS_STRIDED(ctx->layout)) {
+        int2int_strided(ctx, &strided);
+        if ((idx = strided_find(&strided, key)) > ctx->table_size) {
+            return -1;
+        }
+        *value = STRIDED_VALUE(&strided, idx);
+        return 0;
+    }
+    if (HASHMAP_LEGACY_VERSION == ctx->version) {
+        item = int2int_legacy_find(ctx, key);
+    }
+    else {
+        item = int2int_find(ctx, key);
+        if ((NULL == item) && (NULL != (previous = int2int_previous(ctx)))) {
+            item = int2int_find(previous, key);
+        }
+    }
+    if (NULL == item) {
+        return -1;
+    }
+    *value = &(item->value);
+
+    return 0;
+}
+
+int int2int_has(const Int2IntHashTable_t * const ctx,
+        const unsigned long long key) {
+
+    size_t * value;
+
+    return int2int_ptr(ctx, key, &value);
+}
+
+int int2int_get_consistent(const Int2IntHashTable_t * const ctx,
+        const unsigned long long key, size_t * const value) {
+
+    unsigned long long sequence;
+    size_t found_value;
+    int res;
+
+    if (!(ctx->flags & HASHMAP_FLAG_SEQLOCK)) {
+        return int2int_get(ctx, key, value);
+    }
+    for (size_t attempt=0; attempt<HASHMAP_SEQLOCK_MAX_RETRIES; ++attempt) {
+        sequence = int2int_read_begin(ctx);
+        if (0 == (sequence & 1)) {
+            res = int2int_get(ctx, key, &found_value);
+            if (!int2int_read_retry(ctx, sequence)) {
+                if (0 == res) {
+                    *value = found_value;
+                }
+                return res;
+            }
+        }
+        HASHMAP_SPIN();
+    }
+    return -2;
+}
+
+/* Addresses of the memory where lookup of the key starts, get_many
+   prefetches them. Prefetch itself must stay in the caller, otherwise the
+   compiler treats this function as pure and drops its calls. */
+static inline void int2int_lookup_start(const Int2IntHashTable_t * const ctx,
+        const unsigned long long key,
+        const void ** const first, const void ** const second) {
+
+    const char *table = INT2INT_TABLE(ctx);
+    size_t idx;
+    size_t other;
+
+    switch (ctx->layout) {
+    case HASHMAP_LAYOUT_SWISS:
+        idx = u_long_long_hash(key, ctx->table_size)
+                & ~((size_t) SWISS_GROUP_WIDTH - 1);
+        *first = INT2INT_SWISS_CTRL(ctx) + idx;
+        *second = INT2INT_SWISS_SLOTS(ctx) + idx;
+        break;
+    case HASHMAP_LAYOUT_COMPACT:
+        idx = u_long_long_hash(key, ctx->table_size);
+        *first = *second = table + idx * sizeof(Int2IntSlot_t);
+        break;
+    case HASHMAP_LAYOUT_SOA:
+        idx = u_long_long_hash(key, ctx->table_size);
+        *first = INT2INT_SOA_KEYS(ctx) + idx;
+        *second = INT2INT_SOA_VALUES(ctx) + idx;
+        break;
+    case HASHMAP_LAYOUT_CUCKOO:
+        cuckoo_buckets(key, ctx->table_size, &idx, &other);
+        *first = table + idx * CUCKOO_BUCKET_SIZE * sizeof(Int2IntSlot_t);
+        *second = table + other * CUCKOO_BUCKET_SIZE * sizeof(Int2IntSlot_t);
+        break;
+    default:
+        idx = (HASHMAP_LEGACY_VERSION == ctx->version)
+                ? u_long_long_legacy_hash(key, ctx->table_size)
+                : u_long_long_hash(key, ctx->table_size);
+        *first = *second = table + idx * sizeof(Int2IntItem_t);
+        break;
+    }
+}
+
+size_t int2int_get_many(const Int2IntHashTable_t * const ctx,
+        const unsigned long long * const keys, const size_t n,
+        size_t * const values, bool * const found) {
+
+    size_t * value;
+    size_t count = 0;
+    const void *first;
+    const void *second;
+
+    for (size_t i=0; (i<HASHMAP_PREFETCH_DISTANCE) && (i<n); ++i) {
+        int2int_lookup_start(ctx, keys[i], &first, &second);
+        HASHMAP_PREFETCH(first);
+        HASHMAP_PREFETCH(second);
+    }
+    for (size_t i=0; i<n; ++i) {
+        if (i + HASHMAP_PREFETCH_DISTANCE < n) {
+            int2int_lookup_start(ctx, keys[i + HASHMAP_PREFETCH_DISTANCE],
+                    &first, &second);
+            HASHMAP_PREFETCH(first);
+            HASHMAP_PREFETCH(second);
+        }
+        if (0 == int2int_ptr(ctx, keys[i], &value)) {
+            values[i] = *value;
+            count += 1;
+            if (NULL != found) {
+                found[i] = true;
+            }
+        }
+        else if (NULL != found) {
+            found[i] = false;
+        }
+    }
+    return count;
+}
+
+size_t int2int_get_many_consistent(const Int2IntHashTable_t * const ctx,
+        const unsigned long long * const keys, const size_t n,
+        size_t * const values, bool * const found) {
+
+    unsigned long long sequence;
+    size_t chunk_values[HASHMAP_SEQLOCK_CHUNK];
+    bool chunk_found[HASHMAP_SEQLOCK_CHUNK];
+    size_t chunk_count = 0;
+    size_t count = 0;
+    size_t m;
+    size_t attempt;
+
+    if (!(ctx->flags & HASHMAP_FLAG_SEQLOCK)) {
+        return int2int_get_many(ctx, keys, n, values, found);
+    }
+    /* Chunk is looked up into local arrays, so torn attempt never
+       overwrites values of missing keys */
+    for (size_t i=0; i<n; i+=HASHMAP_SEQLOCK_CHUNK) {
+        m = (n - i < HASHMAP_SEQLOCK_CHUNK) ? n - i : HASHMAP_SEQLOCK_CHUNK;
+        for (attempt=0; attempt<HASHMAP_SEQLOCK_MAX_RETRIES; ++attempt) {
+            sequence = int2int_read_begin(ctx);
+            if (0 == (sequence & 1)) {
+                chunk_count = int2int_get_many(ctx, keys + i, m,
+                        chunk_values, chunk_found);
+                if (!int2int_read_retry(ctx, sequence)) {
+                    break;
+                }
+            }
+            HASHMAP_SPIN();
+        }
+        if (HASHMAP_SEQLOCK_MAX_RETRIES == attempt) {
+            return SIZE_MAX;
+        }
+        for (size_t j=0; j<m; ++j) {
+            if (chunk_found[j]) {
+                values[i + j] = chunk_values[j];
+            }
+            if (NULL != found) {
+                found[i + j] = chunk_found[j];
+            }
+        }
+        count += chunk_count;
+    }
+    return count;
+}
+
+int int2int_next(const Int2IntHashTable_t * const ctx,
+        size_t * const position,
+        unsigned long long * const key, size_t ** const value) {
+
+    Int2IntHashTable_t *previous;
+    Int2IntItem_t *table = (Int2IntItem_t*) INT2INT_TABLE(ctx);
+    const unsigned char *ctrl = INT2INT_SWISS_CTRL(ctx);
+    Int2IntSlot_t *slots = INT2INT_SWISS_SLOTS(ctx);
+    StridedTable_t strided;
+    size_t idx;
+
+    if (HASHMAP_LAYOUT_IS_STRIDED(ctx->layout)
+            || (HASHMAP_LAYOUT_CUCKOO == ctx->layout)) {
+        int2int_strided(ctx, &strided);
+        if (strided_next(&strided, position, &idx)) {
+            return -1;
+        }
+        *key = (idx == ctx->table_size) ? 0 : STRIDED_KEY(&strided, idx);
+        *value = STRIDED_VALUE(&strided, idx);
+        return 0;
+    }
+    if (HASHMAP_LAYOUT_SWISS == ctx->layout) {
+        while (*position < ctx->table_size) {
+            size_t idx = (*position)++;
+            if (0 == (ctrl[idx] & SWISS_EMPTY)) {
+                *key = slots[idx].key;
+                *value = &(slots[idx].value);
+                return 0;
+            }
+        }
+        return -1;
+    }
+    if (HASHMAP_LAYOUT_CONCURRENT == ctx->layout) {
+        /* Extra item of the key 0 is the last one */
+        while (*position <= ctx->table_size) {
+            size_t idx = (*position)++;
+            if (USED == HASHMAP_ATOMIC_LOAD32(&(table[idx].status))) {
+                *key = (idx == ctx->table_size) ? 0 : table[idx].key;
+                *value = &(table[idx].value);
+                return 0;
+            }
+        }
+        return -1;
+    }
+
+    while (*position < ctx->table_size) {
+        size_t idx = (*position)++;
+        if (table[idx].status == USED) {
+            *key = table[idx].key;
+            *value = &(table[idx].value);
+            return 0;
+        }
+    }
+    /* Items which were not migrated yet follow */
+    if (NULL != (previous = int2int_previous(ctx))) {
+        table = (Int2IntItem_t*) INT2INT_TABLE(previous);
+        while (*position < ctx->table_size + previous->table_size) {
+            size_t idx = (*position)++ - ctx->table_size;
+            if (table[idx].status == USED) {
+                *key = table[idx].key;
+                *value = &(table[idx].value);
+                return 0;
+            }
+        }
+    }
+    return -1;
+}
+
+size_t int2int_export(const Int2IntHashTable_t * const ctx,
+        unsigned long long * const keys, size_t * const values) {
+
+    size_t position = 0;
+    size_t count = 0;
+    unsigned long long key;
+    size_t *value;
+
+    while (0 == int2int_next(ctx, &position, &key, &value)) {
+        if (NULL != keys) {
+            keys[count] = key;
+        }
+        if (NULL != values) {
+            values[count] = *value;
+        }
+        count += 1;
+    }
+    return count;
+}
+
+void int2int_clear(Int2IntHashTable_t * const ctx) {
+    bool locked = int2int_write_begin(ctx);
+
+    if (NULL != int2int_previous(ctx)) {
+        free(ctx->previous);
+        ctx->previous = NULL;
+        ctx->migrate_position = 0;
+        ctx->flags &= ~HASHMAP_FLAG_MIGRATING;
+    }
+    if (HASHMAP_LAYOUT_SWISS == ctx->layout) {
+        memset(INT2INT_SWISS_CTRL(ctx), SWISS_EMPTY,
+                ctx->table_size + SWISS_GROUP_WIDTH);
+    }
+    else {
+        memset(INT2INT_TABLE(ctx), 0,
+                int2int_buffer_size(ctx) - INT2INT_HEADER_SIZE(ctx));
+    }
+    ctx->current_size = 0;
+    ctx->zero_key_used = false;
+    if (HASHMAP_LAYOUT_CONCURRENT == ctx->layout) {
+        ctx->claimed = 0;
+    }
+
+    int2int_write_end(ctx, locked);
+}
+
+size_t int2int_buffer_size(const Int2IntHashTable_t * const ctx) {
+    if (HASHMAP_LEGACY_VERSION == ctx->version) {
+        return HASHMAP_LEGACY_HEADER_SIZE
+                + ctx->table_size * sizeof(Int2IntItem_t);
+    }
+    return int2int_layout_memory_size(ctx->table_size, ctx->layout);
+}
+
+double int2int_max_load(const Int2IntHashTable_t * const ctx) {
+    if (HASHMAP_LEGACY_VERSION == ctx->version) {
+        return HASHMAP_DEFAULT_MAX_LOAD;
+    }
+    return ctx->max_load;
+}
+
+double int2int_growth(const Int2IntHashTable_t * const ctx) {
+    if (HASHMAP_LEGACY_VERSION == ctx->version) {
+        return HASHMAP_DEFAULT_GROWTH;
+    }
+    return ctx->growth;
+}
+
+double int2int_shrink_load(const Int2IntHashTable_t * const ctx) {
+    if (HASHMAP_LEGACY_VERSION == ctx->version) {
+        return 0.0;
+    }
+    return ctx->shrink_load;
+}
+
+/* Insert items into new table for size items and free the old one, the
+   table is converted into current format */
+static int int2int_rebuild(Int2IntHashTable_t * const ctx, const size_t size,
+        Int2IntHashTable_t ** new_ctx) {
+
+    Int2IntHashTable_t *hashmap;
+    size_t position = 0;
+    unsigned long long item_key;
+    size_t *item_value;
+
+    int2int_finish_resize(ctx);
+    if (int2int_new_ex(size, ctx->layout, int2int_max_load(ctx),
+            int2int_growth(ctx), &hashmap)) {
+        return -1;
+    }
+    hashmap->flags = ctx->flags & HASHMAP_FLAG_INCREMENTAL_RESIZE;
+    hashmap->shrink_load = int2int_shrink_load(ctx);
+
+    while (0 == int2int_next(ctx, &position, &item_key, &item_value)) {
+        if (int2int_set(hashmap, item_key, *item_value, NULL)) {
+            free(hashmap);
+            return -1;
+        }
+    }
+    free(ctx);
+
+    *new_ctx = hashmap;
+
+    return 0;
+}
+
+int int2int_freeze(Int2IntHashTable_t * const ctx,
+        Int2IntHashTable_t ** new_ctx) {
+
+    Int2IntHashTable_t *hashmap = NULL;
+    size_t table_size;
+    size_t memory_size;
+    size_t position;
+    unsigned long long item_key;
+    size_t *item_value;
+    unsigned int random;
+
+    if (HASHMAP_LAYOUT_CUCKOO == ctx->layout) {
+        *new_ctx = ctx;
+        return 0;
+    }
+    if (INT2INT_IS_FIXED_SIZE(ctx)) {
+        /* Memory of the caller can't be replaced by a new block */
+        return -1;
+    }
+    int2int_finish_resize(ctx);
+
+    /* Cuckoo insert can fail, build is repeated with bigger table then */
+    table_size = int2int_layout_table_size(ctx->current_size,
+            HASHMAP_LAYOUT_CUCKOO, CUCKOO_MAX_LOAD);
+    while (NULL == hashmap) {
+        memory_size = int2int_layout_memory_size(table_size,
+                HASHMAP_LAYOUT_CUCKOO);
+        if ((0 == table_size) || (table_size > (SIZE_MAX / 4))
+                || (NULL == (hashmap = malloc(memory_size)))) {
+            return -1;
+        }
+        memset(hashmap, 0, memory_size);
+        hashmap->size = ctx->current_size;
+        hashmap->table_size = table_size;
+        hashmap->version = HASHMAP_VERSION;
+        hashmap->layout = HASHMAP_LAYOUT_CUCKOO;
+        hashmap->max_load = int2int_max_load(ctx);
+        hashmap->growth = int2int_growth(ctx);
+
+        position = 0;
+        random = 1;
+        while (0 == int2int_next(ctx, &position, &item_key, &item_value)) {
+            if (int2int_cuckoo_insert(hashmap, item_key, *item_value,
+                    &random)) {
+                free(hashmap);
+                hashmap = NULL;
+                table_size *= 2;
+                break;
+            }
+        }
+    }
+    hashmap->readonly = true;
+    free(ctx);
+
+    *new_ctx = hashmap;
+
+    return 0;
+}
+
+int int2int_compact(Int2IntHashTable_t * const ctx,
+        Int2IntHashTable_t ** new_ctx) {
+    if (ctx->readonly || INT2INT_IS_FIXED_SIZE(ctx)) {
+        return -1;
+    }
+    return int2int_rebuild(ctx, (ctx->current_size > INT2INT_INITIAL_SIZE)
+            ? ctx->current_size : INT2INT_INITIAL_SIZE, new_ctx);
+}
+
+int int2int_shrink(Int2IntHashTable_t * const ctx,
+        Int2IntHashTable_t ** new_ctx) {
+
+    double shrink_load = int2int_shrink_load(ctx);
+    size_t size;
+
+    *new_ctx = ctx;
+    if (ctx->readonly || INT2INT_IS_FIXED_SIZE(ctx)
+            || !(shrink_load > 0.0)
+            || (ctx->current_size >= ctx->size * shrink_load)) {
+        return 0;
+    }
+    /* Leave space for growth, so the table is not resized back soon */
+    size = (size_t) (ctx->current_size * int2int_growth(ctx));
+    if (size < INT2INT_INITIAL_SIZE) {
+        size = INT2INT_INITIAL_SIZE;
+    }
+    if (int2int_layout_table_size(size, ctx->layout, int2int_max_load(ctx))
+            >= ctx->table_size) {
+        return 0;
+    }
+    return int2int_rebuild(ctx, size, new_ctx);
+}
+
+/* Make room for size items by one resize */
+static int int2int_reserve(Int2IntHashTable_t * const ctx, const size_t size,
+        Int2IntHashTable_t ** new_ctx) {
+
+    if (size <= ctx->size) {
+        *new_ctx = ctx;
+        return 0;
+    }
+    int2int_finish_resize(ctx);
+    if (HASHMAP_LEGACY_VERSION != ctx->version) {
+        return int2int_grow(ctx, size, new_ctx);
+    }
+    /* Legacy table is converted into current format */
+    return int2int_rebuild(ctx, size, new_ctx);
+}
+
+int int2int_set_many(Int2IntHashTable_t * ctx,
+        const unsigned long long * const keys, const size_t * const values,
+        const size_t n, Int2IntHashTable_t ** new_ctx,
+        size_t * const inserted) {
+
+    size_t current_size = ctx->current_size;
+    const void *first;
+    const void *second;
+    bool fixed_size;
+    bool locked;
+    int res = 0;
+
+    *new_ctx = ctx;
+    if (NULL != inserted) {
+        *inserted = 0;
+    }
+    if (ctx->readonly || (HASHMAP_LAYOUT_CUCKOO == ctx->layout)
+            || (n > SIZE_MAX - current_size)) {
+        return -1;
+    }
+    /* Table is sized for the final count at once, so no key triggers
+       a resize. Overwritten keys make the estimate larger than needed.
+       Table of fixed size checks its capacity per key instead. */
+    fixed_size = INT2INT_IS_FIXED_SIZE(ctx);
+    if (!fixed_size && int2int_reserve(ctx, current_size + n, &ctx)) {
+        return -1;
+    }
+    *new_ctx = ctx;
+
+    /* All keys are set by one modification of the seqlock */
+    locked = int2int_write_begin(ctx);
+    for (size_t i=0; (i<HASHMAP_PREFETCH_DISTANCE) && (i<n); ++i) {
+        int2int_lookup_start(ctx, keys[i], &first, &second);
+        HASHMAP_PREFETCH(first);
+        HASHMAP_PREFETCH(second);
+    }
+    for (size_t i=0; i<n; ++i) {
+        if (i + HASHMAP_PREFETCH_DISTANCE < n) {
+            int2int_lookup_start(ctx, keys[i + HASHMAP_PREFETCH_DISTANCE],
+                    &first, &second);
+            HASHMAP_PREFETCH(first);
+            HASHMAP_PREFETCH(second);
+        }
+        if ((res = int2int_set_item(ctx, keys[i],
+                (NULL != values) ? values[i] : i,
+                fixed_size ? &ctx : NULL))) {
+            break;
+        }
+    }
+    int2int_write_end(ctx, locked);
+    if (NULL != inserted) {
+        *inserted = ctx->current_size - current_size;
+    }
+
+    return res;
+}
+
+/* Existing key is modified in place after one lookup, only a new key is
+   inserted by int2int_set_item */
+static int int2int_apply_item(Int2IntHashTable_t * ctx,
+        const unsigned long long key, const HashmapOp_e op,
+        const size_t operand, size_t * const value,
+        Int2IntHashTable_t ** new_ctx) {
+
+    size_t *item_value;
+    size_t result;
+    int res;
+
+    *new_ctx = ctx;
+    if (ctx->readonly || (HASHMAP_LAYOUT_CUCKOO == ctx->layout)) {
+        return -1;
+    }
+    if (HASHMAP_LAYOUT_CONCURRENT == ctx->layout) {
+        return int2int_concurrent_apply(ctx, key, op, operand, value);
+    }
+    if (0 == int2int_ptr(ctx, key, &item_value)) {
+        if ((res = int2int_apply_op(op, *item_value, operand, &result))) {
+            return res;
+        }
+        *item_value = result;
+    }
+    else if ((res = int2int_initial_value(op, operand, &result))) {
+        return res;
+    }
+    else if (int2int_set_item(ctx, key, result, new_ctx)) {
+        return -1;
+    }
+    if (NULL != value) {
+        *value = result;
+    }
+    return 0;
+}
+
+static int int2int_apply(Int2IntHashTable_t * ctx,
+        const unsigned long long key, const HashmapOp_e op,
+        const size_t operand, size_t * const value,
+        Int2IntHashTable_t ** new_ctx) {
+
+    bool locked = int2int_write_begin(ctx);
+    int res = int2int_apply_item(ctx, key, op, operand, value, new_ctx);
+
+    int2int_write_end(ctx, locked);
+
+    return res;
+}
+
+int int2int_add(Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t delta,
+        size_t * const value, Int2IntHashTable_t ** new_ctx) {
+    return int2int_apply(ctx, key, HASHMAP_OP_ADD, delta, value, new_ctx);
+}
+
+int int2int_sub(Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t delta,
+        size_t * const value, Int2IntHashTable_t ** new_ctx) {
+    return int2int_apply(ctx, key, HASHMAP_OP_SUB, delta, value, new_ctx);
+}
+
+int int2int_min(Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t operand,
+        size_t * const value, Int2IntHashTable_t ** new_ctx) {
+    return int2int_apply(ctx, key, HASHMAP_OP_MIN, operand, value, new_ctx);
+}
+
+int int2int_max(Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t operand,
+        size_t * const value, Int2IntHashTable_t ** new_ctx) {
+    return int2int_apply(ctx, key, HASHMAP_OP_MAX, operand, value, new_ctx);
+}
+
+/* Deltas are either size_t or signed ptrdiff_t, negative delta is
+   subtracted */
+static int int2int_add_many_deltas(Int2IntHashTable_t * ctx,
+        const unsigned long long * const keys, const size_t * const deltas,
+        const ptrdiff_t * const signed_deltas, const size_t n,
+        Int2IntHashTable_t ** new_ctx) {
+
+    const void *first;
+    const void *second;
+    bool locked;
+    int res = 0;
+
+    *new_ctx = ctx;
+    if (ctx->readonly || (HASHMAP_LAYOUT_CUCKOO == ctx->layout)) {
+        return -1;
+    }
+    /* Keys repeat when events are counted, so the table is not reserved
+       for n new keys like by int2int_set_many, it grows per new key */
+    locked = int2int_write_begin(ctx);
+    for (size_t i=0; (i<HASHMAP_PREFETCH_DISTANCE) && (i<n); ++i) {
+        int2int_lookup_start(ctx, keys[i], &first, &second);
+        HASHMAP_PREFETCH(first);
+        HASHMAP_PREFETCH(second);
+    }
+    for (size_t i=0; i<n; ++i) {
+        if (i + HASHMAP_PREFETCH_DISTANCE < n) {
+            int2int_lookup_start(ctx, keys[i + HASHMAP_PREFETCH_DISTANCE],
+                    &first, &second);
+            HASHMAP_PREFETCH(first);
+            HASHMAP_PREFETCH(second);
+        }
+        if (NULL != deltas) {
+            res = int2int_apply_item(ctx, keys[i], HASHMAP_OP_ADD,
+                    deltas[i], NULL, &ctx);
+        }
+        else if (signed_deltas[i] < 0) {
+            res = int2int_apply_item(ctx, keys[i], HASHMAP_OP_SUB,
+                    (size_t) 0 - (size_t) signed_deltas[i], NULL, &ctx);
+        }
+        else {
+            res = int2int_apply_item(ctx, keys[i], HASHMAP_OP_ADD,
+                    (size_t) signed_deltas[i], NULL, &ctx);
+        }
+        if (res) {
+            break;
+        }
+    }
+    int2int_write_end(ctx, locked);
+    *new_ctx = ctx;
+
+    return res;
+}
+
+int int2int_add_many(Int2IntHashTable_t * ctx,
+        const unsigned long long * const keys, const size_t * const deltas,
+        const size_t n, Int2IntHashTable_t ** new_ctx) {
+    return int2int_add_many_deltas(ctx, keys, deltas, NULL, n, new_ctx);
+}
+
+int int2int_add_many_signed(Int2IntHashTable_t * ctx,
+        const unsigned long long * const keys,
+        const ptrdiff_t * const deltas, const size_t n,
+        Int2IntHashTable_t ** new_ctx) {
+    return int2int_add_many_deltas(ctx, keys, NULL, deltas, n, new_ctx);
+}
+
+void int2int_finish_resize(Int2IntHashTable_t * const ctx) {
+    Int2IntHashTable_t *previous = int2int_previous(ctx);
+
+    if (NULL != previous) {
+        int2int_migrate(ctx, previous->table_size);
+    }
+}
+
+/*
+ * int2float
+ */
+
+/* Tables in legacy format use different hash and probe step, they are
+   kept readable and writable, resize converts them into current format. */
+
+static int int2float_legacy_insert(Int2FloatHashTable_t * const ctx,
+        const unsigned long long key, const double value) {
+
+    Int2FloatItem_t *table = (Int2FloatItem_t*) (
+            (char*) ctx + sizeof(Int2FloatHashTable_t));
+    size_t idx = u_long_long_legacy_hash(key, ctx->table_size);
+
+    for (size_t i=0; i<ctx->table_size; ++i) {
+        if ((table[idx].status == USED) && (table[idx].key == key)) {
+            table[idx].value = value;
+            return 0;
+        }
+        if ((table[idx].status == EMPTY) || (table[idx].status == DELETED)) {
+            table[idx].status = USED;
+            table[idx].key = key;
+            table[idx].value = value;
+            ctx->current_size += 1;
+            return 0;
+        }
+        idx = (idx + 1) % ctx->table_size;
+    }
+    return -1;
+}
+
+static Int2FloatItem_t* int2float_legacy_find(
+        const Int2FloatHashTable_t * const ctx,
+        const unsigned long long key) {
+
+    Int2FloatItem_t *table = (Int2FloatItem_t*) (
+            (char*) ctx + sizeof(Int2FloatHashTable_t));
+    size_t idx = u_long_long_legacy_hash(key, ctx->table_size);
+
+    for (size_t i=0; i<ctx->table_size; ++i) {
+        if (table[idx].status == EMPTY) {
+            break;
+        }
+        if ((table[idx].status == USED) && (table[idx].key == key)) {
+            return &(table[idx]);
+        }
+        idx = (idx + 1) % ctx->table_size;
+    }
+    return NULL;
+}
+
+/* Items are placed by Robin Hood insertion, every item stores its distance
+   from the home position. Item with distance lower than the distance of
+   the probe can not be followed by the searched key, so miss stops there
+   without scanning the rest of the cluster. Deletion shifts following
+   items of the cluster back, so the table never contains tombstones. */
+
+static Int2FloatItem_t* int2float_find(const Int2FloatHashTable_t * const ctx,
+        const unsigned long long key) {
+
+    Int2FloatItem_t *table = (Int2FloatItem_t*) (
+            (char*) ctx + sizeof(Int2FloatHashTable_t));
+    size_t idx = u_long_long_hash(key, ctx->table_size);
+
+    for (unsigned int distance=0; distance<ctx->table_size; ++distance) {
+        if ((table[idx].status == EMPTY)
+                || (table[idx].distance < distance)) {
+            break;
+        }
+        if ((table[idx].status == USED) && (table[idx].key == key)) {
+            return &(table[idx]);
+        }
+        idx = (idx + 1) & (ctx->table_size - 1);
+    }
+    return NULL;
+}
+
+static int int2float_insert(Int2FloatHashTable_t * const ctx,
+        const unsigned long long key, const double value) {
+
+    Int2FloatItem_t *table = (Int2FloatItem_t*) (
+            (char*) ctx + sizeof(Int2FloatHashTable_t));
+    Int2FloatItem_t item = { .key = key, .value = value, .status = USED };
+    Int2FloatItem_t displaced;
+    size_t idx = u_long_long_hash(key, ctx->table_size);
+
+    for (size_t i=0; i<ctx->table_size; ++i) {
+        if (table[idx].status == EMPTY) {
+            table[idx] = item;
+            ctx->current_size += 1;
+            return 0;
+        }
+        if (table[idx].distance < item.distance) {
+            displaced = table[idx];
+            table[idx] = item;
+            item = displaced;
+        }
+        item.distance += 1;
+        idx = (idx + 1) & (ctx->table_size - 1);
+    }
+    return -1;
+}
+
+static void int2float_remove(Int2FloatHashTable_t * const ctx,
+        Int2FloatItem_t * const item) {
+
+    Int2FloatItem_t *table = (Int2FloatItem_t*) (
+            (char*) ctx + sizeof(Int2FloatHashTable_t));
+    size_t idx = item - table;
+    size_t next = (idx + 1) & (ctx->table_size - 1);
+
+    /* Backward shift deletion - move following items of the cluster one
+       slot closer to their home, until empty slot or item placed in its
+       home is reached. */
+    while ((table[next].status == USED) && (table[next].distance > 0)) {
+        table[idx] = table[next];
+        table[idx].distance -= 1;
+        idx = next;
+        next = (next + 1) & (ctx->table_size - 1);
+    }
+    table[idx].status = EMPTY;
+    table[idx].distance = 0;
+    ctx->current_size -= 1;
+}
+
+/* Place item while the table grows in place, PENDING item is treated as
+   an empty slot and it is placed next. */
+static void int2float_place(Int2FloatHashTable_t * const ctx,
+        Int2FloatItem_t item) {
+
+    Int2FloatItem_t *table = (Int2FloatItem_t*) (
+            (char*) ctx + sizeof(Int2FloatHashTable_t));
+    Int2FloatItem_t displaced;
+    size_t idx = u_long_long_hash(item.key, ctx->table_size);
+
+    item.status = USED;
+    item.distance = 0;
+    /* Table is bigger than number of items, there is always empty slot */
+    for (;;) {
+        if (table[idx].status == EMPTY) {
+            table[idx] = item;
+            return;
+        }
+        if (table[idx].status == PENDING) {
+            displaced = table[idx];
+            table[idx] = item;
+            item = displaced;
+            item.status = USED;
+            item.distance = 0;
+            idx = u_long_long_hash(item.key, ctx->table_size);
+            continue;
+        }
+        if (table[idx].distance < item.distance) {
+            displaced = table[idx];
+            table[idx] = item;
+            item = displaced;
+        }
+        item.distance += 1;
+        idx = (idx + 1) & (ctx->table_size - 1);
+    }
+}
+
+static void int2float_rehash(Int2FloatHashTable_t * const ctx,
+        const size_t old_table_size) {
+
+    Int2FloatItem_t *table = (Int2FloatItem_t*) (
+            (char*) ctx + sizeof(Int2FloatHashTable_t));
+    Int2FloatItem_t item;
+
+    for (size_t idx=0; idx<old_table_size; ++idx) {
+        if (table[idx].status == USED) {
+            table[idx].status = PENDING;
+        }
+    }
+    for (size_t idx=0; idx<old_table_size; ++idx) {
+        if (table[idx].status == PENDING) {
+            item = table[idx];
+            table[idx].status = EMPTY;
+            table[idx].distance = 0;
+            int2float_place(ctx, item);
+        }
+    }
+}
+
+/* Compact and SoA layouts */
+
+static void int2float_strided(const Int2FloatHashTable_t * const ctx,
+        StridedTable_t * const t) {
+    char *table = (char*) ctx + sizeof(Int2FloatHashTable_t);
+
+    if (HASHMAP_LAYOUT_SOA == ctx->layout) {
+        t->keys = (char*) INT2FLOAT_SOA_KEYS(ctx);
+        t->values = (char*) INT2FLOAT_SOA_VALUES(ctx);
+        t->key_stride = sizeof(unsigned long long);
+        t->value_stride = sizeof(double);
+    }
+    else {
+        t->keys = table + offsetof(Int2FloatSlot_t, key);
+        t->values = table + offsetof(Int2FloatSlot_t, value);
+        t->key_stride = sizeof(Int2FloatSlot_t);
+        t->value_stride = sizeof(Int2FloatSlot_t);
+    }
+    t->value_size = sizeof(double);
+    t->table_size = ctx->table_size;
+    t->zero_key_used = (bool*) &(ctx->zero_key_used);
+}
+
+int int2float_new(const size_t size, Int2FloatHashTable_t ** new_ctx) {
+    return int2float_new_layout(size, HASHMAP_LAYOUT_ITEMS, new_ctx);
+}
+
+/* Initialize header and empty table in memory block of memory_size bytes */
+static void int2float_format(Int2FloatHashTable_t * const hashmap,
+        const size_t memory_size, const size_t size, const size_t table_size,
+        const HashmapLayout_e layout) {
+
+    memset(hashmap, 0, memory_size);
+
+    hashmap->size = size;
+    hashmap->current_size = 0;
+    hashmap->table_size = table_size;
+    hashmap->readonly = false;
+    hashmap->version = HASHMAP_VERSION;
+    hashmap->layout = layout;
+}
+
+int int2float_new_layout(const size_t size, const HashmapLayout_e layout,
+        Int2FloatHashTable_t ** new_ctx) {
+    size_t table_size;
+    size_t memory_size;
+    Int2FloatHashTable_t *hashmap;
+
+    table_size = int2float_layout_table_size(size, layout);
+    memory_size = int2float_layout_memory_size(table_size, layout);
+    if ((0 == table_size) || (0 == memory_size)) {
+        return -1;
+    }
+    if (NULL == (hashmap = malloc(memory_size))) {
+        return -1;
+    }
+    int2float_format(hashmap, memory_size, size, table_size, layout);
+
+    *new_ctx = hashmap;
+
+    return 0;
+}
+
+int int2float_new_in(void * const memory, const size_t memory_size,
+        const size_t size, const HashmapLayout_e layout,
+        Int2FloatHashTable_t ** new_ctx) {
+    size_t table_size;
+    size_t required_size;
+    Int2FloatHashTable_t *hashmap = memory;
+
+    if (0 != ((uintptr_t) memory % sizeof(double))) {
+        return -1;
+    }
+    table_size = int2float_layout_table_size(size, layout);
+    required_size = int2float_layout_memory_size(table_size, layout);
+    if ((0 == table_size) || (0 == required_size)
+            || (required_size > memory_size)) {
+        return -1;
+    }
+    int2float_format(hashmap, required_size, size, table_size, layout);
+    hashmap->flags = HASHMAP_FLAG_FIXED_SIZE;
+
+    *new_ctx = hashmap;
+
+    return 0;
+}
+
+size_t int2float_layout_table_size(const size_t size,
+        const HashmapLayout_e layout) {
+    switch (layout) {
+    case HASHMAP_LAYOUT_ITEMS:
+    case HASHMAP_LAYOUT_COMPACT:
+    case HASHMAP_LAYOUT_SOA:
+        return NEW_TABLE_SIZE(size);
+    default:
+        return 0;
+    }
+}
+
+size_t int2float_layout_memory_size(const size_t table_size,
+        const HashmapLayout_e layout) {
+    switch (layout) {
+    case HASHMAP_LAYOUT_ITEMS:
+        return INT2FLOAT_MEMORY_SIZE(table_size);
+    case HASHMAP_LAYOUT_COMPACT:
+        return INT2FLOAT_COMPACT_MEMORY_SIZE(table_size);
+    case HASHMAP_LAYOUT_SOA:
+        return INT2FLOAT_SOA_MEMORY_SIZE(table_size);
+    default:
+        return 0;
+    }
+}
+
+/* Extend memory block of the table for size items by realloc and rehash
+   items within it, see int2int_grow. */
+static int int2float_grow(Int2FloatHashTable_t * const ctx,
+        const size_t size, Int2FloatHashTable_t ** new_ctx) {
+
+    size_t old_table_size = ctx->table_size;
+    size_t old_memory_size = int2float_buffer_size(ctx);
+    size_t table_size = int2float_layout_table_size(size, ctx->layout);
+    size_t memory_size =
+            int2float_layout_memory_size(table_size, ctx->layout);
+    unsigned char *pending = NULL;
+    Int2FloatHashTable_t *hashmap;
+    StridedTable_t old_strided;
+    StridedTable_t strided;
+
+    if ((table_size < old_table_size) || (memory_size < old_memory_size)) {
+        return -1;
+    }
+    if (HASHMAP_LAYOUT_IS_STRIDED(ctx->layout)) {
+        pending = calloc(PENDING_BITMAP_SIZE(old_table_size), 1);
+        if (NULL == pending) {
+            return -1;
+        }
+    }
+    if (NULL == (hashmap = realloc(ctx, memory_size))) {
+        free(pending);
+        return -1;
+    }
+    memset((char*) hashmap + old_memory_size, 0,
+            memory_size - old_memory_size);
+
+    if (HASHMAP_LAYOUT_IS_STRIDED(hashmap->layout)) {
+        int2float_strided(hashmap, &old_strided);
+        hashmap->table_size = table_size;
+        int2float_strided(hashmap, &strided);
+        strided_grow(&old_strided, &strided, pending);
+        free(pending);
+    }
+    else {
+        hashmap->table_size = table_size;
+        int2float_rehash(hashmap, old_table_size);
+    }
+    hashmap->size = size;
+
+    *new_ctx = hashmap;
+
+    return 0;
+}
+
+int int2float_set(Int2FloatHashTable_t * ctx,
+        const unsigned long long key, const double value,
+        Int2FloatHashTable_t ** new_ctx) {
+
+    Int2FloatHashTable_t *new_hashmap;
+    Int2FloatItem_t *found;
+    StridedTable_t strided;
+    size_t idx;
+    size_t position = 0;
+    unsigned long long item_key;
+    double *item_value;
+
+    if (ctx->readonly) {
+        return -1;
+    }
+
+    // Resize table if necessary
+    if (NULL != new_ctx) {
+        if ((ctx->current_size == ctx->size)
+                && (ctx->flags & HASHMAP_FLAG_FIXED_SIZE)) {
+            /* Full table in memory of the caller can only update keys */
+            if (0 != int2float_has(ctx, key)) {
+                return -1;
+            }
+        }
+        else if (ctx->current_size == ctx->size) {
+            if (HASHMAP_LEGACY_VERSION != ctx->version) {
+                /* Block is extended, items are rehashed within it */
+                if (int2float_grow(ctx, ctx->size * 2, &new_hashmap)) {
+                    return -1;
+                }
+            }
+            else {
+                /* Legacy table is converted into current format */
+                if (int2float_new_layout(ctx->size * 2, ctx->layout,
+                        &new_hashmap)) {
+                    return -1;
+                }
+
+                while (0 == int2float_next(ctx, &position,
+                        &item_key, &item_value)) {
+                    if (int2float_set(new_hashmap, item_key, *item_value,
+                            NULL)) {
+                        free(new_hashmap);
+                        return -1;
+                    }
+                }
+
+                free(ctx);
+            }
+            ctx = new_hashmap;
+        }
+        *new_ctx = ctx;
+    }
+
+    if (HASHMAP_LAYOUT_IS_STRIDED(ctx->layout)) {
+        int2float_strided(ctx, &strided);
+        if ((idx = strided_find(&strided, key)) <= ctx->table_size) {
+            *(double*) STRIDED_VALUE(&strided, idx) = value;
+            return 0;
+        }
+        if (strided_insert(&strided, key, &value)) {
+            return -1;
+        }
+        ctx->current_size += 1;
+        return 0;
+    }
+    if (HASHMAP_LEGACY_VERSION == ctx->version) {
+        return int2float_legacy_insert(ctx, key, value);
+    }
+
+    if (NULL != (found = int2float_find(ctx, key))) {
+        found->value = value;
+        return 0;
+    }
+    return int2float_insert(ctx, key, value);
+}
+
+int int2float_del(Int2FloatHashTable_t * const ctx,
+        const unsigned long long key) {
+
+    Int2FloatItem_t *item;
+    StridedTable_t strided;
+    size_t idx;
+
+    if (HASHMAP_LAYOUT_IS_STRIDED(ctx->layout)) {
+        int2float_strided(ctx, &strided);
+        if ((idx = strided_find(&strided, key)) > ctx->table_size) {
+            return -1;
+        }
+        strided_remove(&strided, idx);
+        ctx->current_size -= 1;
+        return 0;
+    }
+    if (HASHMAP_LEGACY_VERSION == ctx->version) {
+        if (NULL == (item = int2float_legacy_find(ctx, key))) {
+            return -1;
+        }
+        item->status = DELETED;
+        ctx->current_size -= 1;
+        return 0;
+    }
+
+    if (NULL == (item = int2float_find(ctx, key))) {
+        return -1;
+    }
+    int2float_remove(ctx, item);
+
+    return 0;
+}
+
+int int2float_get(const Int2FloatHashTable_t * const ctx,
+        const unsigned long long key, double * const value) {
+
+    double * p_value;
+
+    if (int2float_ptr(ctx, key, &p_value) == 0) {
+        *value = *p_value;
+        return 0;
+    }
+    return -1;
+}
+
+int int2float_ptr(const Int2FloatHashTable_t * const ctx,
+        const unsigned long long key, double ** const value) {
+
+    Int2FloatItem_t *item;
+    StridedTable_t strided;
+    size_t idx;
+
+    if (HASHMAP_LAYOUT_IS_STRIDED(ctx->layout)) {
+        int2float_strided(ctx, &strided);
+        if ((idx = strided_find(&strided, key)) > ctx->table_size) {
+            return -1;
+        }
+        *value = STRIDED_VALUE(&strided, idx);
+        return 0;
+    }
+    if (HASHMAP_LEGACY_VERSION == ctx->version) {
+        item = int2float_legacy_find(ctx, key);
+    }
+    else {
+        item = int2float_find(ctx, key);
+    }
+    if (NULL == item) {
+        return -1;
+    }
+    *value = &(item->value);
+
+    return 0;
+}
+
+int int2float_has(const Int2FloatHashTable_t * const ctx,
+        const unsigned long long key) {
+
+    double * value;
+
+    return int2float_ptr(ctx, key, &value);
+}
+
+/* Addresses of the memory where lookup of the key starts, see
+   int2int_lookup_start */
+static inline void int2float_lookup_start(
+        const Int2FloatHashTable_t * const ctx, const unsigned long long key,
+        const void ** const first, const void ** const second) {
+
+    const char *table = (char*) ctx + sizeof(Int2FloatHashTable_t);
+    size_t idx;
+
+    switch (ctx->layout) {
+    case HASHMAP_LAYOUT_COMPACT:
+        idx = u_long_long_hash(key, ctx->table_size);
+        *first = *second = table + idx * sizeof(Int2FloatSlot_t);
+        break;
+    case HASHMAP_LAYOUT_SOA:
+        idx = u_long_long_hash(key, ctx->table_size);
+        *first = INT2FLOAT_SOA_KEYS(ctx) + idx;
+        *second = INT2FLOAT_SOA_VALUES(ctx) + idx;
+        break;
+    default:
+        idx = (HASHMAP_LEGACY_VERSION == ctx->version)
+                ? u_long_long_legacy_hash(key, ctx->table_size)
+                : u_long_long_hash(key, ctx->table_size);
+        *first = *second = table + idx * sizeof(Int2FloatItem_t);
+        break;
+    }
+}
+
+size_t int2float_get_many(const Int2FloatHashTable_t * const ctx,
+        const unsigned long long * const keys, const size_t n,
+        double * const values, bool * const found) {
+
+    double * value;
+    size_t count = 0;
+    const void *first;
+    const void *second;
+
+    for (size_t i=0; (i<HASHMAP_PREFETCH_DISTANCE) && (i<n); ++i) {
+        int2float_lookup_start(ctx, keys[i], &first, &second);
+        HASHMAP_PREFETCH(first);
+        HASHMAP_PREFETCH(second);
+    }
+    for (size_t i=0; i<n; ++i) {
+        if (i + HASHMAP_PREFETCH_DISTANCE < n) {
+            int2float_lookup_start(ctx, keys[i + HASHMAP_PREFETCH_DISTANCE],
+                    &first, &second);
+            HASHMAP_PREFETCH(first);
+            HASHMAP_PREFETCH(second);
+        }
+        if (0 == int2float_ptr(ctx, keys[i], &value)) {
+            values[i] = *value;
+            count += 1;
+            if (NULL != found) {
+                found[i] = true;
+            }
+        }
+        else if (NULL != found) {
+            found[i] = false;
+        }
+    }
+    return count;
+}
+
+int int2float_next(const Int2FloatHashTable_t * const ctx,
+        size_t * const position,
+        unsigned long long * const key, double ** const value) {
+
+    Int2FloatItem_t *table = (Int2FloatItem_t*) (
+            (char*) ctx + sizeof(Int2FloatHashTable_t));
+    StridedTable_t strided;
+    size_t idx;
+
+    if (HASHMAP_LAYOUT_IS_STRIDED(ctx->layout)) {
+        int2float_strided(ctx, &strided);
+        if (strided_next(&strided, position, &idx)) {
+            return -1;
+        }
+        *key = (idx == ctx->table_size) ? 0 : STRIDED_KEY(&strided, idx);
+        *value = STRIDED_VALUE(&strided, idx);
+        return 0;
+    }
+
+    while (*position < ctx->table_size) {
+        size_t idx = (*position)++;
+        if (table[idx].status == USED) {
+            *key = table[idx].key;
+            *value = &(table[idx].value);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+size_t int2float_export(const Int2FloatHashTable_t * const ctx,
+        unsigned long long * const keys, double * const values) {
+
+    size_t position = 0;
+    size_t count = 0;
+    unsigned long long key;
+    double *value;
+
+    while (0 == int2float_next(ctx, &position, &key, &value)) {
+        if (NULL != keys) {
+            keys[count] = key;
+        }
+        if (NULL != values) {
+            values[count] = *value;
+        }
+        count += 1;
+    }
+    return count;
+}
+
+void int2float_clear(Int2FloatHashTable_t * const ctx) {
+    memset((char*) ctx + sizeof(Int2FloatHashTable_t), 0,
+            int2float_buffer_size(ctx) - sizeof(Int2FloatHashTable_t));
+    ctx->current_size = 0;
+    ctx->zero_key_used = false;
+}
+
+size_t int2float_buffer_size(const Int2FloatHashTable_t * const ctx) {
+    return int2float_layout_memory_size(ctx->table_size, ctx->layout);
+}
+
+static int int2float_rebuild(Int2FloatHashTable_t * const ctx,
+        const size_t size, Int2FloatHashTable_t ** new_ctx) {
+
+    Int2FloatHashTable_t *hashmap;
+    size_t position = 0;
+    unsigned long long item_key;
+    double *item_value;
+
+    if (int2float_new_layout(size, ctx->layout, &hashmap)) {
+        return -1;
+    }
+
+    while (0 == int2float_next(ctx, &position, &item_key, &item_value)) {
+        if (int2float_set(hashmap, item_key, *item_value, NULL)) {
+            free(hashmap);
+            return -1;
+        }
+    }
+    free(ctx);
+
+    *new_ctx = hashmap;
+
+    return 0;
+}
+
+int int2float_compact(Int2FloatHashTable_t * const ctx,
+        Int2FloatHashTable_t ** new_ctx) {
+    if (ctx->readonly || (ctx->flags & HASHMAP_FLAG_FIXED_SIZE)) {
+        return -1;
+    }
+    return int2float_rebuild(ctx, (ctx->current_size > INT2FLOAT_INITIAL_SIZE)
+            ? ctx->current_size : INT2FLOAT_INITIAL_SIZE, new_ctx);
+}
+
+int int2float_shrink(Int2FloatHashTable_t * const ctx,
+        const double shrink_load, Int2FloatHashTable_t ** new_ctx) {
+
+    size_t size;
+
+    *new_ctx = ctx;
+    if (ctx->readonly || (ctx->flags & HASHMAP_FLAG_FIXED_SIZE)
+            || !(shrink_load > 0.0)
+            || (ctx->current_size >= ctx->size * shrink_load)) {
+        return 0;
+    }
+    /* Leave space for growth, full int2float table doubles its size */
+    size = ctx->current_size * 2;
+    if (size < INT2FLOAT_INITIAL_SIZE) {
+        size = INT2FLOAT_INITIAL_SIZE;
+    }
+    if (int2float_layout_table_size(size, ctx->layout) >= ctx->table_size) {
+        return 0;
+    }
+    return int2float_rebuild(ctx, size, new_ctx);
+}
+
+/* Make room for size items by one resize */
+static int int2float_reserve(Int2FloatHashTable_t * const ctx,
+        const size_t size, Int2FloatHashTable_t ** new_ctx) {
+
+    if (size <= ctx->size) {
+        *new_ctx = ctx;
+        return 0;
+    }
+    if (HASHMAP_LEGACY_VERSION != ctx->version) {
+        return int2float_grow(ctx, size, new_ctx);
+    }
+    /* Legacy table is converted into current format */
+    return int2float_rebuild(ctx, size, new_ctx);
+}
+
+int int2float_set_many(Int2FloatHashTable_t * ctx,
+        const unsigned long long * const keys, const double * const values,
+        const size_t n, Int2FloatHashTable_t ** new_ctx,
+        size_t * const inserted) {
+
+    size_t current_size = ctx->current_size;
+    const void *first;
+    const void *second;
+    bool fixed_size;
+    int res = 0;
+
+    *new_ctx = ctx;
+    if (NULL != inserted) {
+        *inserted = 0;
+    }
+    if (ctx->readonly || (n > SIZE_MAX - current_size)) {
+        return -1;
+    }
+    /* Table is sized for the final count at once, so no key triggers
+       a resize. Overwritten keys make the estimate larger than needed.
+       Table of fixed size checks its capacity per key instead. */
+    fixed_size = ctx->flags & HASHMAP_FLAG_FIXED_SIZE;
+    if (!fixed_size && int2float_reserve(ctx, current_size + n, &ctx)) {
+        return -1;
+    }
+    *new_ctx = ctx;
+
+    for (size_t i=0; (i<HASHMAP_PREFETCH_DISTANCE) && (i<n); ++i) {
+        int2float_lookup_start(ctx, keys[i], &first, &second);
+        HASHMAP_PREFETCH(first);
+        HASHMAP_PREFETCH(second);
+    }
+    for (size_t i=0; i<n; ++i) {
+        if (i + HASHMAP_PREFETCH_DISTANCE < n) {
+            int2float_lookup_start(ctx, keys[i + HASHMAP_PREFETCH_DISTANCE],
+                    &first, &second);
+            HASHMAP_PREFETCH(first);
+            HASHMAP_PREFETCH(second);
+        }
+        if (int2float_set(ctx, keys[i], values[i],
+                fixed_size ? &ctx : NULL)) {
+            res = -1;
+            break;
+        }
+    }
+    if (NULL != inserted) {
+        *inserted = ctx->current_size - current_size;
+    }
+
+    return res;
+}
+
+static inline double int2float_apply_op(const HashmapOp_e op,
+        const double value, const double operand) {
+    switch (op) {
+    case HASHMAP_OP_SET:
+        return operand;
+    case HASHMAP_OP_ADD:
+        return value + operand;
+    case HASHMAP_OP_SUB:
+        return value - operand;
+    case HASHMAP_OP_MIN:
+        return (operand < value) ? operand : value;
+    case HASHMAP_OP_MAX:
+        return (operand > value) ? operand : value;
+    }
+    return value;
+}
+
+/* Existing key is modified in place after one lookup, only a new key is
+   inserted by int2float_set */
+static int int2float_apply(Int2FloatHashTable_t * ctx,
+        const unsigned long long key, const HashmapOp_e op,
+        const double operand, double * const value,
+        Int2FloatHashTable_t ** new_ctx) {
+
+    double *item_value;
+
+    *new_ctx = ctx;
+    if (ctx->readonly) {
+        return -1;
+    }
+    if (0 == int2float_ptr(ctx, key, &item_value)) {
+        *item_value = int2float_apply_op(op, *item_value, operand);
+        if (NULL != value) {
+            *value = *item_value;
+        }
+        return 0;
+    }
+    if (int2float_set(ctx, key, operand, new_ctx)) {
+        return -1;
+    }
+    if (NULL != value) {
+        *value = operand;
+    }
+    return 0;
+}
+
+int int2float_add(Int2FloatHashTable_t * ctx,
+        const unsigned long long key, const double delta,
+        double * const value, Int2FloatHashTable_t ** new_ctx) {
+    return int2float_apply(ctx, key, HASHMAP_OP_ADD, delta, value, new_ctx);
+}
+
+int int2float_min(Int2FloatHashTable_t * ctx,
+        const unsigned long long key, const double operand,
+        double * const value, Int2FloatHashTable_t ** new_ctx) {
+    return int2float_apply(ctx, key, HASHMAP_OP_MIN, operand, value,
+            new_ctx);
+}
+
+int int2float_max(Int2FloatHashTable_t * ctx,
+        const unsigned long long key, const double operand,
+        double * const value, Int2FloatHashTable_t ** new_ctx) {
+    return int2float_apply(ctx, key, HASHMAP_OP_MAX, operand, value,
+            new_ctx);
+}
+
+int int2float_add_many(Int2FloatHashTable_t * ctx,
+        const unsigned long long * const keys, const double * const deltas,
+        const size_t n, Int2FloatHashTable_t ** new_ctx) {
+
+    const void *first;
+    const void *second;
+
+    *new_ctx = ctx;
+    if (ctx->readonly) {
+        return -1;
+    }
+    for (size_t i=0; (i<HASHMAP_PREFETCH_DISTANCE) && (i<n); ++i) {
+        int2float_lookup_start(ctx, keys[i], &first, &second);
+        HASHMAP_PREFETCH(first);
+        HASHMAP_PREFETCH(second);
+    }
+    for (size_t i=0; i<n; ++i) {
+        if (i + HASHMAP_PREFETCH_DISTANCE < n) {
+            int2float_lookup_start(ctx, keys[i + HASHMAP_PREFETCH_DISTANCE],
+                    &first, &second);
+            HASHMAP_PREFETCH(first);
+            HASHMAP_PREFETCH(second);
+        }
+        if (int2float_apply(ctx, keys[i], HASHMAP_OP_ADD, deltas[i], NULL,
+                &ctx)) {
+            *new_ctx = ctx;
+            return -1;
+        }
+    }
+    *new_ctx = ctx;
+
+    return 0;
+}
+
+unsigned long long hashmap_checksum(const void * const data,
+        const size_t size) {
+    return hashmap_checksum_update(HASHMAP_CHECKSUM_INIT, data, size);
+}
+
+unsigned long long hashmap_checksum_update(unsigned long long checksum,
+        const void * const data, const size_t size) {
+    const unsigned char *bytes = (const unsigned char*) data;
+    uint64_t hash = checksum;
+    uint64_t word;
+    size_t i = 0;
+
+    for (; i + sizeof(word) <= size; i += sizeof(word)) {
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ULL;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+
+    /* 0 is reserved for unknown checksum */
+    return (0 == hash) ? 1 : hash;
+}
+
+static void hashmap_file_header(HashmapFileHeader_t * const header,
+        const HashmapFileType_e type, const void * const table,
+        const size_t table_bytes) {
+    memset(header, 0, sizeof(HashmapFileHeader_t));
+    memcpy(header->magic, HASHMAP_FILE_MAGIC, sizeof(header->magic));
+    header->version = HASHMAP_FILE_VERSION;
+    header->type = (unsigned short) type;
+    header->table_offset = sizeof(HashmapFileHeader_t);
+    header->table_bytes = table_bytes;
+    header->checksum = hashmap_checksum(table, table_bytes);
+}
+
+void int2int_file_header(const Int2IntHashTable_t * const ctx,
+        HashmapFileHeader_t * const header) {
+    hashmap_file_header(header, HASHMAP_FILE_INT2INT, ctx,
+            int2int_buffer_size(ctx));
+    header->layout = (HASHMAP_LEGACY_VERSION == ctx->version)
+            ? HASHMAP_LAYOUT_ITEMS : ctx->layout;
+    header->size = ctx->size;
+    header->current_size = ctx->current_size;
+    header->table_size = ctx->table_size;
+}
+
+void int2float_file_header(const Int2FloatHashTable_t * const ctx,
+        HashmapFileHeader_t * const header) {
+    hashmap_file_header(header, HASHMAP_FILE_INT2FLOAT, ctx,
+            int2float_buffer_size(ctx));
+    header->layout = ctx->layout;
+    header->size = ctx->size;
+    header->current_size = ctx->current_size;
+    header->table_size = ctx->table_size;
+}
+
+int hashmap_file_check(const HashmapFileHeader_t * const header,
+        const size_t file_size, const HashmapFileType_e type) {
+    if ((file_size < sizeof(HashmapFileHeader_t))
+            || (0 != memcmp(header->magic, HASHMAP_FILE_MAGIC,
+                    sizeof(header->magic)))
+            || (HASHMAP_FILE_VERSION != header->version)
+            || (type != header->type)
+            || (header->flags & ~HASHMAP_FILE_FLAG_PAIRS)) {
+        return -1;
+    }
+    /* Table must be aligned as a memory block from malloc */
+    if ((header->table_offset < sizeof(HashmapFileHeader_t))
+            || (0 != (header->table_offset % sizeof(double)))
+            || (header->table_offset > file_size)
+            || (header->table_bytes > file_size - header->table_offset)) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Publisher
+ */
+
+size_t hashmap_publisher_memory_size(const unsigned int slot_count,
+        const size_t slot_size) {
+    size_t slot_bytes;
+
+    if (slot_size > SIZE_MAX - 2 * HASHMAP_PUBLISHER_ALIGN) {
+        return 0;
+    }
+    slot_bytes = HASHMAP_PUBLISHER_ALIGN
+            + ((slot_size + HASHMAP_PUBLISHER_ALIGN - 1)
+                    & ~((size_t) HASHMAP_PUBLISHER_ALIGN - 1));
+    if (slot_count > (SIZE_MAX - HASHMAP_PUBLISHER_ALIGN) / slot_bytes) {
+        return 0;
+    }
+    return HASHMAP_PUBLISHER_ALIGN + slot_count * slot_bytes;
+}
+
+int hashmap_publisher_new_in(void * const memory, const size_t memory_size,
+        const unsigned int slot_count, const size_t slot_size,
+        HashmapPublisher_t ** new_ctx) {
+    HashmapPublisher_t *publisher = memory;
+    size_t required_size;
+
+    if ((slot_count < 2)
+            || (0 != ((uintptr_t) memory % HASHMAP_PUBLISHER_ALIGN))) {
+        return -1;
+    }
+    required_size = hashmap_publisher_memory_size(slot_count, slot_size);
+    if ((0 == required_size) || (required_size > memory_size)) {
+        return -1;
+    }
+
+    /* Tables of slots are written only by publish */
+    memset(publisher, 0, HASHMAP_PUBLISHER_ALIGN);
+    memcpy(publisher->magic, HASHMAP_PUBLISHER_MAGIC,
+            sizeof(publisher->magic));
+    publisher->version = HASHMAP_PUBLISHER_VERSION;
+    publisher->slot_count = slot_count;
+    publisher->slot_size = (required_size - HASHMAP_PUBLISHER_ALIGN)
+            / slot_count - HASHMAP_PUBLISHER_ALIGN;
+    for (unsigned int i=0; i<slot_count; ++i) {
+        memset(HASHMAP_PUBLISHER_SLOT(publisher, i), 0,
+                HASHMAP_PUBLISHER_ALIGN);
+    }
+
+    *new_ctx = publisher;
+
+    return 0;
+}
+
+int hashmap_publisher_check(const void * const memory,
+        const size_t memory_size) {
+    const HashmapPublisher_t *publisher = memory;
+    size_t required_size;
+
+    if ((0 != ((uintptr_t) memory % HASHMAP_PUBLISHER_ALIGN))
+            || (memory_size < HASHMAP_PUBLISHER_ALIGN)
+            || (0 != memcmp(publisher->magic, HASHMAP_PUBLISHER_MAGIC,
+                    sizeof(publisher->magic)))
+            || (HASHMAP_PUBLISHER_VERSION != publisher->version)
+            || (publisher->slot_count < 2)
+            || (publisher->slot_size > SIZE_MAX)
+            || (0 != (publisher->slot_size % HASHMAP_PUBLISHER_ALIGN))) {
+        return -1;
+    }
+    required_size = hashmap_publisher_memory_size(publisher->slot_count,
+            (size_t) publisher->slot_size);
+    if ((0 == required_size) || (required_size > memory_size)) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Reader counts itself in the slot before it checks that the generation
+   did not change, writer checks the readers of the slot after the previous
+   generation was published. So either the writer sees the reader, or the
+   reader sees a newer generation and tries again. */
+
+int hashmap_publisher_publish(HashmapPublisher_t * const ctx,
+        const void * const table, const size_t size,
+        const HashmapFileType_e type) {
+    unsigned long long generation = ctx->generation;
+    HashmapPublisherSlot_t *slot = HASHMAP_PUBLISHER_SLOT(ctx,
+            (generation + 1) % ctx->slot_count);
+
+    if (size > ctx->slot_size) {
+        return -1;
+    }
+    if (0 != HASHMAP_ATOMIC_LOAD(&slot->readers)) {
+        return -2;
+    }
+    memcpy(HASHMAP_PUBLISHER_TABLE(slot), table, size);
+    slot->size = size;
+    slot->type = (unsigned short) type;
+    HASHMAP_ATOMIC_STORE(&ctx->generation, generation + 1);
+
+    return 0;
+}
+
+HashmapPublisherSlot_t* hashmap_publisher_acquire(
+        HashmapPublisher_t * const ctx) {
+    unsigned long long generation;
+    HashmapPublisherSlot_t *slot;
+
+    while (0 != (generation = HASHMAP_ATOMIC_LOAD(&ctx->generation))) {
+        slot = HASHMAP_PUBLISHER_SLOT(ctx, generation % ctx->slot_count);
+        HASHMAP_ATOMIC_INC(&slot->readers);
+        if (generation == HASHMAP_ATOMIC_LOAD(&ctx->generation)) {
+            return slot;
+        }
+        /* Writer published meanwhile, the slot may be overwritten */
+        HASHMAP_ATOMIC_DEC(&slot->readers);
+    }
+    return NULL;
+}
+
+void hashmap_publisher_release(HashmapPublisherSlot_t * const slot) {
+    HASHMAP_ATOMIC_DEC(&slot->readers);
 }
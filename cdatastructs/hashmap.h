@@ -5,13 +5,123 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+/* PENDING marks items which wait for the rehash while the table grows
+   in place, it never remains in the table after the resize. */
 typedef enum {
     EMPTY,
     USED,
-    DELETED
+    DELETED,
+    PENDING
 } ItemStatus_e;
 
-#define NEW_TABLE_SIZE(ncount) ((size_t) ((ncount) * 1.2) + 1)
+/*
+ * Version of the memory block format, it is stored in the header of each
+ * table. Tables created before the version was introduced have version 0
+ * (padding of the header was always zeroed), they use (97 * key) modulo
+ * table size as a hash and can still be attached and used.
+ */
+#define HASHMAP_LEGACY_VERSION 0
+#define HASHMAP_VERSION 1
+
+/* Size of the header in the legacy format (three size_t fields and
+   readonly flag padded to the alignment of size_t) */
+#define HASHMAP_LEGACY_HEADER_SIZE (4 * sizeof(size_t))
+
+/* Default maximum load factor (size / table_size) and growth factor of
+   the size when the table is full */
+#define HASHMAP_DEFAULT_MAX_LOAD (1.0 / 1.2)
+#define HASHMAP_DEFAULT_GROWTH 2.0
+
+/* Number of keys which are hashed and prefetched ahead by get_many */
+#define HASHMAP_PREFETCH_DISTANCE 16
+
+/* Table size is always a power of two, so index is obtained by a mask */
+#define NEW_TABLE_SIZE(ncount) hashmap_table_size(ncount)
+
+size_t hashmap_table_size(const size_t size);
+
+/* Smallest table size for size items which keeps load under max_load */
+size_t hashmap_load_table_size(const size_t size, const double max_load);
+
+/*
+ * Layout of the table which follows the header in the memory block.
+ *
+ * HASHMAP_LAYOUT_ITEMS - array of items with key, value, status and probe
+ *     distance, items are placed by Robin Hood insertion.
+ * HASHMAP_LAYOUT_SWISS - array of control bytes (7 bits of the hash or
+ *     empty/deleted mark per slot) followed by array of key/value slots.
+ *     Control bytes are tested group by group with SIMD instructions.
+ * HASHMAP_LAYOUT_COMPACT - array of key/value slots without status, key 0
+ *     marks an empty slot. Real key 0 is stored in an extra slot behind
+ *     the table, zero_key_used flag in the header tells whether it is set.
+ *     Slots are placed by Robin Hood insertion, probe distance is computed
+ *     from the hash of the key.
+ * HASHMAP_LAYOUT_SOA - same as compact, but keys and values are stored in
+ *     two separate arrays (table_size + 1 keys followed by table_size + 1
+ *     values), so probing reads only keys. Values are a plain C array.
+ * HASHMAP_LAYOUT_CUCKOO - read-only table built by freeze. Slots are the
+ *     same as in the compact layout, they are split into buckets of
+ *     CUCKOO_BUCKET_SIZE slots and each key is stored in one of its two
+ *     buckets, so lookup reads at most two buckets.
+ * HASHMAP_LAYOUT_CONCURRENT - array of items like the items layout plus
+ *     an extra item of the key 0 behind the table. Many writers in threads
+ *     or processes may set and delete keys at the same time without a
+ *     lock: key is claimed by an atomic compare-and-swap of the free (0)
+ *     key word of the item and it stays in the item until clear, del
+ *     only swaps the status. Table is never resized, it accepts at most
+ *     size distinct keys until clear, so probe sequences stay as short
+ *     as max_load allows. Writer which inserts a key holds its item by
+ *     PENDING status and its process id. Other writers of that key yield
+ *     the CPU until it finishes, they give up only when its process does
+ *     not exist, it crashed in the insert. Writers must see the same
+ *     process ids, i.e. run in the same PID namespace.
+ */
+typedef enum {
+    HASHMAP_LAYOUT_ITEMS,
+    HASHMAP_LAYOUT_SWISS,
+    HASHMAP_LAYOUT_COMPACT,
+    HASHMAP_LAYOUT_SOA,
+    HASHMAP_LAYOUT_CUCKOO,
+    HASHMAP_LAYOUT_CONCURRENT
+} HashmapLayout_e;
+
+/*
+ * Cuckoo layout - buckets
+ */
+
+#define CUCKOO_BUCKET_SIZE 4
+#define CUCKOO_MAX_LOAD 0.9
+
+/* Table size of the cuckoo layout, at least two buckets */
+#define CUCKOO_TABLE_SIZE(table_size) \
+        ((table_size) < 2 * CUCKOO_BUCKET_SIZE \
+                ? 2 * CUCKOO_BUCKET_SIZE : (table_size))
+
+/*
+ * Swiss layout - control bytes
+ */
+
+#define SWISS_GROUP_WIDTH 16
+#define SWISS_EMPTY 0x80
+#define SWISS_DELETED 0xFE
+
+/* Table size of the swiss layout, at least one group */
+#define SWISS_TABLE_SIZE(table_size) \
+        ((table_size) < SWISS_GROUP_WIDTH ? SWISS_GROUP_WIDTH : (table_size))
+#define NEW_SWISS_TABLE_SIZE(ncount) SWISS_TABLE_SIZE(NEW_TABLE_SIZE(ncount))
+
+/* Kernels for testing groups of control bytes, HASHMAP_SWISS_KERNEL_AUTO
+   selects the best kernel supported by the CPU on the first use. */
+typedef enum {
+    HASHMAP_SWISS_KERNEL_AUTO,
+    HASHMAP_SWISS_KERNEL_GENERIC,
+    HASHMAP_SWISS_KERNEL_SSE2,
+    HASHMAP_SWISS_KERNEL_AVX2
+} HashmapSwissKernel_e;
+
+HashmapSwissKernel_e hashmap_swiss_kernel(void);
+
+int hashmap_swiss_set_kernel(const HashmapSwissKernel_e kernel);
 
 /*
  * int2int
@@ -21,26 +131,184 @@ typedef struct {
     unsigned long long key;
     size_t value;
     ItemStatus_e status;
+    unsigned int distance;
 } Int2IntItem_t;
 
-typedef struct {
+/*
+ * Header of the int2int memory block. Legacy (version 0) header ends
+ * behind the readonly flag (HASHMAP_LEGACY_HEADER_SIZE bytes), fields
+ * in its padding are zero. Fields behind the padding are present only
+ * in the current version, they are valid only when flags say so.
+ */
+typedef struct Int2IntHashTable_s {
     size_t size;
     size_t current_size;
     size_t table_size;
     bool readonly;
+    unsigned char version;
+    unsigned char layout;
+    bool zero_key_used;
+    unsigned char flags;
+    /* Table which is being migrated into this one (incremental resize)
+       and position of the next bucket to migrate */
+    struct Int2IntHashTable_s *previous;
+    size_t migrate_position;
+    /* Load factor and growth factor of the table, legacy tables use
+       defaults */
+    double max_load;
+    double growth;
+    /* Table is rebuilt smaller when load drops under shrink_load of the
+       capacity, 0 disables it */
+    double shrink_load;
+    /* Sequence counter of the seqlock, odd while the writer modifies the
+       table (HASHMAP_FLAG_SEQLOCK) */
+    unsigned long long sequence;
+    /* Items of HASHMAP_LAYOUT_CONCURRENT claimed by keys, deleted keys
+       keep their items until clear */
+    size_t claimed;
 } Int2IntHashTable_t;
 
+/* Resize allocates new table and migrates items step by step during
+   following set/del calls, only for HASHMAP_LAYOUT_ITEMS. */
+#define HASHMAP_FLAG_INCREMENTAL_RESIZE 0x01
+/* previous table is being migrated */
+#define HASHMAP_FLAG_MIGRATING 0x02
+/* Memory block is owned by the caller (see int2int_new_in), the table is
+   never reallocated or freed, so it can't hold more than size items. */
+#define HASHMAP_FLAG_FIXED_SIZE 0x04
+/* Writer bumps sequence around each modification, so readers in other
+   processes can look up keys without a lock (see int2int_get_consistent).
+   Only for tables of fixed size, their memory never moves. */
+#define HASHMAP_FLAG_SEQLOCK 0x08
+
+/* Table can't be reallocated, concurrent table has fixed size even in
+   memory allocated by int2int */
+#define INT2INT_IS_FIXED_SIZE(ctx) (((ctx)->flags & HASHMAP_FLAG_FIXED_SIZE) \
+        || (HASHMAP_LAYOUT_CONCURRENT == (ctx)->layout))
+
+/* Consistent lookup gives up when the table was modified during this many
+   attempts (e.g. the writer died in the middle of a modification) */
+#define HASHMAP_SEQLOCK_MAX_RETRIES (1 << 20)
+/* get_many_consistent reads keys in chunks of this size, each chunk is
+   retried separately */
+#define HASHMAP_SEQLOCK_CHUNK 64
+
+/* Number of buckets of the previous table migrated by one set/del */
+#define HASHMAP_MIGRATE_STEP 16
+
+#define INT2INT_HEADER_SIZE(ctx) ((HASHMAP_LEGACY_VERSION == (ctx)->version) \
+        ? HASHMAP_LEGACY_HEADER_SIZE : sizeof(Int2IntHashTable_t))
+
+/* Beginning of the table behind the header */
+#define INT2INT_TABLE(ctx) ((char*) (ctx) + INT2INT_HEADER_SIZE(ctx))
+
+typedef struct {
+    unsigned long long key;
+    size_t value;
+} Int2IntSlot_t;
+
 #define INT2INT_INITIAL_SIZE 8
 
 #define INT2INT_MEMORY_SIZE(ncount) (sizeof(Int2IntHashTable_t) \
         + ((ncount) * sizeof(Int2IntItem_t)))
 
+#define INT2INT_SWISS_MEMORY_SIZE(ncount) (sizeof(Int2IntHashTable_t) \
+        + (ncount) + SWISS_GROUP_WIDTH + ((ncount) * sizeof(Int2IntSlot_t)))
+
+#define INT2INT_COMPACT_MEMORY_SIZE(ncount) (sizeof(Int2IntHashTable_t) \
+        + (((ncount) + 1) * sizeof(Int2IntSlot_t)))
+
+#define INT2INT_CONCURRENT_MEMORY_SIZE(ncount) \
+        (INT2INT_MEMORY_SIZE((ncount) + 1))
+
+#define INT2INT_SOA_MEMORY_SIZE(ncount) (sizeof(Int2IntHashTable_t) \
+        + (((ncount) + 1) * (sizeof(unsigned long long) + sizeof(size_t))))
+
+/* Keys and values arrays of the SoA layout, slot with index table_size
+   holds value of the key 0 */
+#define INT2INT_SOA_KEYS(ctx) ((unsigned long long*) INT2INT_TABLE(ctx))
+#define INT2INT_SOA_VALUES(ctx) \
+        ((size_t*) (INT2INT_SOA_KEYS(ctx) + (ctx)->table_size + 1))
+
 int int2int_new(const size_t size, Int2IntHashTable_t ** new_ctx);
 
+int int2int_new_layout(const size_t size, const HashmapLayout_e layout,
+        Int2IntHashTable_t ** new_ctx);
+
+/* New table with max_load in (0, 1] and growth greater than 1 */
+int int2int_new_ex(const size_t size, const HashmapLayout_e layout,
+        const double max_load, const double growth,
+        Int2IntHashTable_t ** new_ctx);
+
+/* New empty table for size items formatted in memory of memory_size bytes
+   owned by the caller (e.g. shared memory). The table has
+   HASHMAP_FLAG_FIXED_SIZE, set of a new key fails when it is full.
+   Return -1 if the memory is too small or not aligned for the header. */
+int int2int_new_in(void * const memory, const size_t memory_size,
+        const size_t size, const HashmapLayout_e layout,
+        const double max_load, Int2IntHashTable_t ** new_ctx);
+
+/* Table size for size items and size of the whole memory block in the
+   layout, 0 if int2int does not support the layout */
+size_t int2int_layout_table_size(const size_t size,
+        const HashmapLayout_e layout, const double max_load);
+
+size_t int2int_layout_memory_size(const size_t table_size,
+        const HashmapLayout_e layout);
+
+/* Set and del of the table in HASHMAP_LAYOUT_CONCURRENT are atomic, they
+   may be called by many threads or processes at once. Set of the
+   concurrent table returns -2 when all items are claimed by keys, though
+   some of them were deleted, and -3 when other writer crashed in the
+   insert of the key. */
 int int2int_set(Int2IntHashTable_t * ctx,
         const unsigned long long key, const size_t value,
         Int2IntHashTable_t ** new_ctx);
 
+/* Set n keys to values, the table is resized at most once. If values is
+   NULL, key is set to its position in keys. Number of new keys is stored
+   into inserted (if not NULL), remaining keys overwrote existing ones.
+   Error of the key which failed is returned as by int2int_set. */
+int int2int_set_many(Int2IntHashTable_t * ctx,
+        const unsigned long long * const keys, const size_t * const values,
+        const size_t n, Int2IntHashTable_t ** new_ctx,
+        size_t * const inserted);
+
+/* Add/subtract delta to/from the value of the key, or keep the
+   smaller/bigger of the value and operand. Key which is not in the table
+   is set to delta (-delta) or operand. New value is stored into value
+   (if not NULL). Existing key is found by one lookup, it is modified
+   atomically in the concurrent layout, errors are the same as of
+   int2int_set. Add/sub returns -4 and keeps the value when the result
+   would not fit into size_t. */
+int int2int_add(Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t delta,
+        size_t * const value, Int2IntHashTable_t ** new_ctx);
+
+int int2int_sub(Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t delta,
+        size_t * const value, Int2IntHashTable_t ** new_ctx);
+
+int int2int_min(Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t operand,
+        size_t * const value, Int2IntHashTable_t ** new_ctx);
+
+int int2int_max(Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t operand,
+        size_t * const value, Int2IntHashTable_t ** new_ctx);
+
+/* int2int_add of n keys and deltas, keys may repeat. Error of the key
+   which failed is returned as by int2int_set. */
+int int2int_add_many(Int2IntHashTable_t * ctx,
+        const unsigned long long * const keys, const size_t * const deltas,
+        const size_t n, Int2IntHashTable_t ** new_ctx);
+
+/* int2int_add_many with signed deltas, negative delta is subtracted */
+int int2int_add_many_signed(Int2IntHashTable_t * ctx,
+        const unsigned long long * const keys,
+        const ptrdiff_t * const deltas, const size_t n,
+        Int2IntHashTable_t ** new_ctx);
+
 int int2int_del(Int2IntHashTable_t * const ctx,
         const unsigned long long key);
 
@@ -53,6 +321,74 @@ int int2int_ptr(const Int2IntHashTable_t * const ctx,
 int int2int_has(const Int2IntHashTable_t * const ctx,
         const unsigned long long key);
 
+/* Enable the seqlock of the table of fixed size, return -1 for other
+   tables and for the concurrent layout. Only one writer may modify the
+   table. */
+int int2int_seqlock(Int2IntHashTable_t * const ctx);
+
+/* Lookup which may run concurrently with the writer of the table with
+   HASHMAP_FLAG_SEQLOCK, it is retried when the writer modified the table
+   during the lookup. Return 0 if the key was found, -1 if not and -2 if
+   the table was being modified for HASHMAP_SEQLOCK_MAX_RETRIES attempts.
+   Table without seqlock is looked up as by int2int_get. */
+int int2int_get_consistent(const Int2IntHashTable_t * const ctx,
+        const unsigned long long key, size_t * const value);
+
+/* Look up n keys, value of the found key is stored into values, found (if
+   not NULL) tells which keys were found. Return number of found keys.
+   Memory of keys ahead is prefetched, so lookups overlap their cache
+   misses. */
+size_t int2int_get_many(const Int2IntHashTable_t * const ctx,
+        const unsigned long long * const keys, const size_t n,
+        size_t * const values, bool * const found);
+
+/* Same as int2int_get_many, but concurrently with the writer of the table
+   with HASHMAP_FLAG_SEQLOCK like int2int_get_consistent. Each chunk of
+   HASHMAP_SEQLOCK_CHUNK keys is a consistent snapshot. Return SIZE_MAX if
+   the table was being modified for all attempts of a chunk, values and
+   found are then filled only partially. */
+size_t int2int_get_many_consistent(const Int2IntHashTable_t * const ctx,
+        const unsigned long long * const keys, const size_t n,
+        size_t * const values, bool * const found);
+
+int int2int_next(const Int2IntHashTable_t * const ctx,
+        size_t * const position,
+        unsigned long long * const key, size_t ** const value);
+
+/* Copy keys and values of all items into arrays of current_size items,
+   keys or values may be NULL. Return number of copied items. */
+size_t int2int_export(const Int2IntHashTable_t * const ctx,
+        unsigned long long * const keys, size_t * const values);
+
+/* Clear is not atomic, no other writer may use the concurrent table */
+void int2int_clear(Int2IntHashTable_t * const ctx);
+
+size_t int2int_buffer_size(const Int2IntHashTable_t * const ctx);
+
+double int2int_max_load(const Int2IntHashTable_t * const ctx);
+
+double int2int_growth(const Int2IntHashTable_t * const ctx);
+
+double int2int_shrink_load(const Int2IntHashTable_t * const ctx);
+
+/* Rebuild the table into read-only cuckoo layout, table which is already
+   frozen is kept */
+int int2int_freeze(Int2IntHashTable_t * const ctx,
+        Int2IntHashTable_t ** new_ctx);
+
+/* Rebuild the table into new memory block right-sized for its items */
+int int2int_compact(Int2IntHashTable_t * const ctx,
+        Int2IntHashTable_t ** new_ctx);
+
+/* Compact the table when its load dropped under shrink_load, new_ctx is
+   set also when table is not changed */
+int int2int_shrink(Int2IntHashTable_t * const ctx,
+        Int2IntHashTable_t ** new_ctx);
+
+/* Migrate rest of the previous table, so memory block is self-contained
+   again (e.g. before it is copied or shared) */
+void int2int_finish_resize(Int2IntHashTable_t * const ctx);
+
 /*
  * int2float
  */
@@ -61,6 +397,7 @@ typedef struct {
     unsigned long long key;
     double value;
     ItemStatus_e status;
+    unsigned int distance;
 } Int2FloatItem_t;
 
 typedef struct {
@@ -68,19 +405,74 @@ typedef struct {
     size_t current_size;
     size_t table_size;
     bool readonly;
+    unsigned char version;
+    unsigned char layout;
+    bool zero_key_used;
+    unsigned char flags;
 } Int2FloatHashTable_t;
 
+typedef struct {
+    unsigned long long key;
+    double value;
+} Int2FloatSlot_t;
+
 #define INT2FLOAT_INITIAL_SIZE 8
 
 #define INT2FLOAT_MEMORY_SIZE(ncount) (sizeof(Int2FloatHashTable_t) \
         + ((ncount) * sizeof(Int2FloatItem_t)))
 
+#define INT2FLOAT_COMPACT_MEMORY_SIZE(ncount) (sizeof(Int2FloatHashTable_t) \
+        + (((ncount) + 1) * sizeof(Int2FloatSlot_t)))
+
+#define INT2FLOAT_SOA_MEMORY_SIZE(ncount) (sizeof(Int2FloatHashTable_t) \
+        + (((ncount) + 1) * (sizeof(unsigned long long) + sizeof(double))))
+
+#define INT2FLOAT_SOA_KEYS(ctx) ((unsigned long long*) \
+        ((char*) (ctx) + sizeof(Int2FloatHashTable_t)))
+#define INT2FLOAT_SOA_VALUES(ctx) \
+        ((double*) (INT2FLOAT_SOA_KEYS(ctx) + (ctx)->table_size + 1))
+
 int int2float_new(const size_t size, Int2FloatHashTable_t ** new_ctx);
 
+int int2float_new_layout(const size_t size, const HashmapLayout_e layout,
+        Int2FloatHashTable_t ** new_ctx);
+
+int int2float_new_in(void * const memory, const size_t memory_size,
+        const size_t size, const HashmapLayout_e layout,
+        Int2FloatHashTable_t ** new_ctx);
+
+size_t int2float_layout_table_size(const size_t size,
+        const HashmapLayout_e layout);
+
+size_t int2float_layout_memory_size(const size_t table_size,
+        const HashmapLayout_e layout);
+
 int int2float_set(Int2FloatHashTable_t * ctx,
         const unsigned long long key, const double value,
         Int2FloatHashTable_t ** new_ctx);
 
+int int2float_set_many(Int2FloatHashTable_t * ctx,
+        const unsigned long long * const keys, const double * const values,
+        const size_t n, Int2FloatHashTable_t ** new_ctx,
+        size_t * const inserted);
+
+/* See int2int_add, int2float has no concurrent layout */
+int int2float_add(Int2FloatHashTable_t * ctx,
+        const unsigned long long key, const double delta,
+        double * const value, Int2FloatHashTable_t ** new_ctx);
+
+int int2float_min(Int2FloatHashTable_t * ctx,
+        const unsigned long long key, const double operand,
+        double * const value, Int2FloatHashTable_t ** new_ctx);
+
+int int2float_max(Int2FloatHashTable_t * ctx,
+        const unsigned long long key, const double operand,
+        double * const value, Int2FloatHashTable_t ** new_ctx);
+
+int int2float_add_many(Int2FloatHashTable_t * ctx,
+        const unsigned long long * const keys, const double * const deltas,
+        const size_t n, Int2FloatHashTable_t ** new_ctx);
+
 int int2float_del(Int2FloatHashTable_t * const ctx,
         const unsigned long long key);
 
@@ -93,4 +485,164 @@ int int2float_ptr(const Int2FloatHashTable_t * const ctx,
 int int2float_has(const Int2FloatHashTable_t * const ctx,
         const unsigned long long key);
 
+size_t int2float_get_many(const Int2FloatHashTable_t * const ctx,
+        const unsigned long long * const keys, const size_t n,
+        double * const values, bool * const found);
+
+int int2float_next(const Int2FloatHashTable_t * const ctx,
+        size_t * const position,
+        unsigned long long * const key, double ** const value);
+
+size_t int2float_export(const Int2FloatHashTable_t * const ctx,
+        unsigned long long * const keys, double * const values);
+
+void int2float_clear(Int2FloatHashTable_t * const ctx);
+
+size_t int2float_buffer_size(const Int2FloatHashTable_t * const ctx);
+
+int int2float_compact(Int2FloatHashTable_t * const ctx,
+        Int2FloatHashTable_t ** new_ctx);
+
+/* Compact the table when its load dropped under shrink_load, header of
+   int2float has no place for it, so the caller keeps it. new_ctx is set
+   also when table is not changed. */
+int int2float_shrink(Int2FloatHashTable_t * const ctx,
+        const double shrink_load, Int2FloatHashTable_t ** new_ctx);
+
+/*
+ * Persistent file of the table: header followed by the memory block of the
+ * table at table_offset, so the file can be mapped into the memory and the
+ * table used in place. Numbers are stored in the native byte order, file
+ * from a machine with different byte order fails on the version. checksum
+ * is computed by hashmap_checksum over table_bytes of the memory block,
+ * 0 means it is unknown (the table was modified in place).
+ *
+ * Stream with HASHMAP_FILE_FLAG_PAIRS holds header of the table followed
+ * by current_size key/value slots (Int2IntSlot_t or Int2FloatSlot_t) of
+ * used items instead of the memory block, so its size does not depend on
+ * table_size. Such table is rebuilt by inserts, it can't be mapped.
+ */
+#define HASHMAP_FILE_MAGIC "CDSHMAP\n"
+#define HASHMAP_FILE_VERSION 1
+
+#define HASHMAP_FILE_FLAG_PAIRS 0x01
+
+typedef enum {
+    HASHMAP_FILE_INT2INT = 1,
+    HASHMAP_FILE_INT2FLOAT = 2
+} HashmapFileType_e;
+
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned short type;
+    unsigned char layout;
+    unsigned char flags;
+    unsigned long long size;
+    unsigned long long current_size;
+    unsigned long long table_size;
+    unsigned long long table_offset;
+    unsigned long long table_bytes;
+    unsigned long long checksum;
+} HashmapFileHeader_t;
+
+/* 64-bit FNV-1a of data processed by 8 bytes, never returns 0. Data can
+   be hashed in parts by hashmap_checksum_update starting with
+   HASHMAP_CHECKSUM_INIT, size of all parts but the last must be divisible
+   by 8. */
+#define HASHMAP_CHECKSUM_INIT 0xcbf29ce484222325ULL
+
+unsigned long long hashmap_checksum(const void * const data,
+        const size_t size);
+
+unsigned long long hashmap_checksum_update(unsigned long long checksum,
+        const void * const data, const size_t size);
+
+/* Fill header of the file for the table, the table must not be migrating.
+   Checksum is computed over the whole memory block. */
+void int2int_file_header(const Int2IntHashTable_t * const ctx,
+        HashmapFileHeader_t * const header);
+
+void int2float_file_header(const Int2FloatHashTable_t * const ctx,
+        HashmapFileHeader_t * const header);
+
+/* Return 0 if header has valid magic, version and type and the table lies
+   within the file of file_size bytes, the table itself is not checked */
+int hashmap_file_check(const HashmapFileHeader_t * const header,
+        const size_t file_size, const HashmapFileType_e type);
+
+/*
+ * Publisher - control block in memory shared by processes, it is followed
+ * by slot_count slots of slot_size bytes. Each slot holds a copy of a
+ * read-only memory block of the table. Writer copies the next version of
+ * the table into the slot of the next generation and publishes it by
+ * increment of generation, so readers switch to it at once. Reader counts
+ * itself in the slot of the current generation while it uses the table,
+ * writer never overwrites slot which is still used. Generation 0 means
+ * that nothing was published yet, slot of generation g is
+ * g % slot_count.
+ *
+ * Slot header and the table of the slot are aligned to
+ * HASHMAP_PUBLISHER_ALIGN bytes, so counters of readers of different
+ * slots do not share a cache line.
+ */
+#define HASHMAP_PUBLISHER_MAGIC "CDSHPUB\n"
+#define HASHMAP_PUBLISHER_VERSION 1
+#define HASHMAP_PUBLISHER_ALIGN 64
+
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int slot_count;
+    unsigned long long slot_size;
+    unsigned long long generation;
+} HashmapPublisher_t;
+
+typedef struct {
+    unsigned long long readers;
+    /* Size of the memory block of the table and its HashmapFileType_e */
+    unsigned long long size;
+    unsigned short type;
+} HashmapPublisherSlot_t;
+
+/* Header of the slot, its table follows behind HASHMAP_PUBLISHER_ALIGN
+   bytes */
+#define HASHMAP_PUBLISHER_SLOT(ctx, idx) ((HashmapPublisherSlot_t*) \
+        ((char*) (ctx) + HASHMAP_PUBLISHER_ALIGN \
+                + (idx) * (HASHMAP_PUBLISHER_ALIGN + (ctx)->slot_size)))
+#define HASHMAP_PUBLISHER_TABLE(slot) \
+        ((void*) ((char*) (slot) + HASHMAP_PUBLISHER_ALIGN))
+
+/* Size of the memory of the publisher with slot_count slots for tables of
+   at most slot_size bytes, 0 if it would not fit into size_t */
+size_t hashmap_publisher_memory_size(const unsigned int slot_count,
+        const size_t slot_size);
+
+/* New publisher formatted in memory of memory_size bytes owned by the
+   caller, slot_count must be at least 2. Return -1 if the memory is too
+   small or not aligned to HASHMAP_PUBLISHER_ALIGN. */
+int hashmap_publisher_new_in(void * const memory, const size_t memory_size,
+        const unsigned int slot_count, const size_t slot_size,
+        HashmapPublisher_t ** new_ctx);
+
+/* Return 0 if memory of memory_size bytes holds valid publisher */
+int hashmap_publisher_check(const void * const memory,
+        const size_t memory_size);
+
+/* Copy memory block of the table of size bytes into the slot of the next
+   generation and publish it. Return -1 if the table exceeds slot_size and
+   -2 if the slot is still used by readers, nothing is changed then. Only
+   one writer may publish. */
+int hashmap_publisher_publish(HashmapPublisher_t * const ctx,
+        const void * const table, const size_t size,
+        const HashmapFileType_e type);
+
+/* Slot of the current generation which is held by the caller until
+   hashmap_publisher_release, NULL if nothing was published yet. Reader
+   never waits for the writer. */
+HashmapPublisherSlot_t* hashmap_publisher_acquire(
+        HashmapPublisher_t * const ctx);
+
+void hashmap_publisher_release(HashmapPublisherSlot_t * const slot);
+
 #endif /* HASHMAP_H_ */
@@ -1,12 +1,46 @@
 
+from libc.stddef cimport ptrdiff_t
 from libcpp cimport bool
 
 cdef extern from "hashmap.h":
 
+    cdef int HASHMAP_LEGACY_VERSION
+    cdef int HASHMAP_VERSION
+    cdef size_t HASHMAP_LEGACY_HEADER_SIZE
+
+    cdef int HASHMAP_FLAG_INCREMENTAL_RESIZE
+    cdef int HASHMAP_FLAG_MIGRATING
+    cdef int HASHMAP_FLAG_FIXED_SIZE
+    cdef int HASHMAP_FLAG_SEQLOCK
+
+    cdef int HASHMAP_SEQLOCK_MAX_RETRIES
+    cdef size_t HASHMAP_SEQLOCK_CHUNK
+
+    cdef double HASHMAP_DEFAULT_MAX_LOAD
+    cdef double HASHMAP_DEFAULT_GROWTH
+
+    cdef size_t HASHMAP_PREFETCH_DISTANCE
+
+    cdef size_t hashmap_table_size(const size_t size)
+
+    cdef size_t hashmap_load_table_size(
+        const size_t size, const double max_load)
+
+    ctypedef enum HashmapLayout_e:
+        HASHMAP_LAYOUT_ITEMS
+        HASHMAP_LAYOUT_SWISS
+        HASHMAP_LAYOUT_COMPACT
+        HASHMAP_LAYOUT_SOA
+        HASHMAP_LAYOUT_CUCKOO
+        HASHMAP_LAYOUT_CONCURRENT
+
+    cdef size_t CUCKOO_BUCKET_SIZE
+
     ctypedef enum ItemStatus_e:
         EMPTY
         USED
         DELETED
+        PENDING
 
     # int2int
 
@@ -14,22 +48,95 @@ cdef extern from "hashmap.h":
         unsigned long long key
         size_t value
         ItemStatus_e status
+        unsigned int distance
 
     ctypedef struct Int2IntHashTable_t:
         size_t size
         size_t current_size
         size_t table_size
         bool readonly
+        unsigned char version
+        unsigned char layout
+        bool zero_key_used
+        unsigned char flags
+        Int2IntHashTable_t * previous
+        size_t migrate_position
+        double max_load
+        double growth
+        double shrink_load
+        unsigned long long sequence
+        size_t claimed
+
+    ctypedef struct Int2IntSlot_t:
+        unsigned long long key
+        size_t value
 
     cdef int int2int_new(
         const size_t size,
         Int2IntHashTable_t ** new_ctx)
 
+    cdef int int2int_new_layout(
+        const size_t size, const HashmapLayout_e layout,
+        Int2IntHashTable_t ** new_ctx)
+
+    cdef int int2int_new_ex(
+        const size_t size, const HashmapLayout_e layout,
+        const double max_load, const double growth,
+        Int2IntHashTable_t ** new_ctx)
+
+    cdef int int2int_new_in(
+        void * const memory, const size_t memory_size,
+        const size_t size, const HashmapLayout_e layout,
+        const double max_load, Int2IntHashTable_t ** new_ctx)
+
+    cdef size_t int2int_layout_table_size(
+        const size_t size, const HashmapLayout_e layout,
+        const double max_load)
+
+    cdef size_t int2int_layout_memory_size(
+        const size_t table_size, const HashmapLayout_e layout)
+
     cdef int int2int_set(
         Int2IntHashTable_t * ctx,
         const unsigned long long key, const size_t value,
         Int2IntHashTable_t ** new_ctx)
 
+    cdef int int2int_set_many(
+        Int2IntHashTable_t * ctx,
+        const unsigned long long * const keys, const size_t * const values,
+        const size_t n, Int2IntHashTable_t ** new_ctx, size_t * const inserted)
+
+    cdef int int2int_add(
+        Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t delta,
+        size_t * const value, Int2IntHashTable_t ** new_ctx)
+
+    cdef int int2int_sub(
+        Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t delta,
+        size_t * const value, Int2IntHashTable_t ** new_ctx)
+
+    cdef int int2int_min(
+        Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t operand,
+        size_t * const value, Int2IntHashTable_t ** new_ctx)
+
+    cdef int int2int_max(
+        Int2IntHashTable_t * ctx,
+        const unsigned long long key, const size_t operand,
+        size_t * const value, Int2IntHashTable_t ** new_ctx)
+
+    cdef int int2int_add_many(
+        Int2IntHashTable_t * ctx,
+        const unsigned long long * const keys, const size_t * const deltas,
+        const size_t n, Int2IntHashTable_t ** new_ctx)
+
+    cdef int int2int_add_many_signed(
+        Int2IntHashTable_t * ctx,
+        const unsigned long long * const keys,
+        const ptrdiff_t * const deltas, const size_t n,
+        Int2IntHashTable_t ** new_ctx)
+
     cdef int int2int_del(
         Int2IntHashTable_t * const ctx,
         const unsigned long long key)
@@ -45,28 +152,122 @@ cdef extern from "hashmap.h":
     cdef int int2int_has(
         const Int2IntHashTable_t * const ctx, const unsigned long long key)
 
+    cdef int int2int_seqlock(Int2IntHashTable_t * const ctx)
+
+    cdef int int2int_get_consistent(
+        const Int2IntHashTable_t * const ctx,
+        const unsigned long long key, size_t * const value)
+
+    cdef size_t int2int_get_many(
+        const Int2IntHashTable_t * const ctx,
+        const unsigned long long * const keys, const size_t n,
+        size_t * const values, bool * const found)
+
+    cdef size_t int2int_get_many_consistent(
+        const Int2IntHashTable_t * const ctx,
+        const unsigned long long * const keys, const size_t n,
+        size_t * const values, bool * const found)
+
+    cdef int int2int_next(
+        const Int2IntHashTable_t * const ctx, size_t * const position,
+        unsigned long long * const key, size_t ** const value)
+
+    cdef size_t int2int_export(
+        const Int2IntHashTable_t * const ctx,
+        unsigned long long * const keys, size_t * const values)
+
+    cdef void int2int_clear(Int2IntHashTable_t * const ctx)
+
+    cdef size_t int2int_buffer_size(const Int2IntHashTable_t * const ctx)
+
+    cdef double int2int_max_load(const Int2IntHashTable_t * const ctx)
+
+    cdef double int2int_growth(const Int2IntHashTable_t * const ctx)
+
+    cdef double int2int_shrink_load(const Int2IntHashTable_t * const ctx)
+
+    cdef int int2int_freeze(
+        Int2IntHashTable_t * const ctx, Int2IntHashTable_t ** new_ctx)
+
+    cdef int int2int_compact(
+        Int2IntHashTable_t * const ctx, Int2IntHashTable_t ** new_ctx)
+
+    cdef int int2int_shrink(
+        Int2IntHashTable_t * const ctx, Int2IntHashTable_t ** new_ctx)
+
+    cdef void int2int_finish_resize(Int2IntHashTable_t * const ctx)
+
     # int2float
 
     ctypedef struct Int2FloatItem_t:
         unsigned long long key
         double value
         ItemStatus_e status
+        unsigned int distance
 
     ctypedef struct Int2FloatHashTable_t:
         size_t size
         size_t current_size
         size_t table_size
         bool readonly
+        unsigned char version
+        unsigned char layout
+        bool zero_key_used
+        unsigned char flags
+
+    ctypedef struct Int2FloatSlot_t:
+        unsigned long long key
+        double value
 
     cdef int int2float_new(
         const size_t size,
         Int2FloatHashTable_t ** new_ctx)
 
+    cdef int int2float_new_layout(
+        const size_t size, const HashmapLayout_e layout,
+        Int2FloatHashTable_t ** new_ctx)
+
+    cdef int int2float_new_in(
+        void * const memory, const size_t memory_size,
+        const size_t size, const HashmapLayout_e layout,
+        Int2FloatHashTable_t ** new_ctx)
+
+    cdef size_t int2float_layout_table_size(
+        const size_t size, const HashmapLayout_e layout)
+
+    cdef size_t int2float_layout_memory_size(
+        const size_t table_size, const HashmapLayout_e layout)
+
     cdef int int2float_set(
         Int2FloatHashTable_t * ctx,
         const unsigned long long key, const double value,
         Int2FloatHashTable_t ** new_ctx)
 
+    cdef int int2float_set_many(
+        Int2FloatHashTable_t * ctx,
+        const unsigned long long * const keys, const double * const values,
+        const size_t n, Int2FloatHashTable_t ** new_ctx, size_t * const inserted)
+
+    cdef int int2float_add(
+        Int2FloatHashTable_t * ctx,
+        const unsigned long long key, const double delta,
+        double * const value, Int2FloatHashTable_t ** new_ctx)
+
+    cdef int int2float_min(
+        Int2FloatHashTable_t * ctx,
+        const unsigned long long key, const double operand,
+        double * const value, Int2FloatHashTable_t ** new_ctx)
+
+    cdef int int2float_max(
+        Int2FloatHashTable_t * ctx,
+        const unsigned long long key, const double operand,
+        double * const value, Int2FloatHashTable_t ** new_ctx)
+
+    cdef int int2float_add_many(
+        Int2FloatHashTable_t * ctx,
+        const unsigned long long * const keys, const double * const deltas,
+        const size_t n, Int2FloatHashTable_t ** new_ctx)
+
     cdef int int2float_del(
         Int2FloatHashTable_t * const ctx,
         const unsigned long long key)
@@ -82,3 +283,111 @@ cdef extern from "hashmap.h":
     cdef int int2float_has(
         const Int2FloatHashTable_t * const ctx,
         const unsigned long long key)
+
+    cdef size_t int2float_get_many(
+        const Int2FloatHashTable_t * const ctx,
+        const unsigned long long * const keys, const size_t n,
+        double * const values, bool * const found)
+
+    cdef int int2float_next(
+        const Int2FloatHashTable_t * const ctx, size_t * const position,
+        unsigned long long * const key, double ** const value)
+
+    cdef size_t int2float_export(
+        const Int2FloatHashTable_t * const ctx,
+        unsigned long long * const keys, double * const values)
+
+    cdef void int2float_clear(Int2FloatHashTable_t * const ctx)
+
+    cdef size_t int2float_buffer_size(const Int2FloatHashTable_t * const ctx)
+
+    cdef int int2float_compact(
+        Int2FloatHashTable_t * const ctx, Int2FloatHashTable_t ** new_ctx)
+
+    cdef int int2float_shrink(
+        Int2FloatHashTable_t * const ctx, const double shrink_load,
+        Int2FloatHashTable_t ** new_ctx)
+
+    cdef char* HASHMAP_FILE_MAGIC
+    cdef int HASHMAP_FILE_VERSION
+    cdef int HASHMAP_FILE_FLAG_PAIRS
+    cdef unsigned long long HASHMAP_CHECKSUM_INIT
+
+    ctypedef enum HashmapFileType_e:
+        HASHMAP_FILE_INT2INT
+        HASHMAP_FILE_INT2FLOAT
+
+    ctypedef struct HashmapFileHeader_t:
+        char magic[8]
+        unsigned int version
+        unsigned short type
+        unsigned char layout
+        unsigned char flags
+        unsigned long long size
+        unsigned long long current_size
+        unsigned long long table_size
+        unsigned long long table_offset
+        unsigned long long table_bytes
+        unsigned long long checksum
+
+    cdef unsigned long long hashmap_checksum(
+        const void * const data, const size_t size)
+
+    cdef unsigned long long hashmap_checksum_update(
+        unsigned long long checksum, const void * const data,
+        const size_t size)
+
+    cdef void int2int_file_header(
+        const Int2IntHashTable_t * const ctx,
+        HashmapFileHeader_t * const header)
+
+    cdef void int2float_file_header(
+        const Int2FloatHashTable_t * const ctx,
+        HashmapFileHeader_t * const header)
+
+    cdef int hashmap_file_check(
+        const HashmapFileHeader_t * const header, const size_t file_size,
+        const HashmapFileType_e type)
+
+    # publisher
+
+    cdef char* HASHMAP_PUBLISHER_MAGIC
+    cdef int HASHMAP_PUBLISHER_VERSION
+    cdef size_t HASHMAP_PUBLISHER_ALIGN
+
+    ctypedef struct HashmapPublisher_t:
+        char magic[8]
+        unsigned int version
+        unsigned int slot_count
+        unsigned long long slot_size
+        unsigned long long generation
+
+    ctypedef struct HashmapPublisherSlot_t:
+        unsigned long long readers
+        unsigned long long size
+        unsigned short type
+
+    cdef HashmapPublisherSlot_t * HASHMAP_PUBLISHER_SLOT(
+        HashmapPublisher_t * ctx, size_t idx)
+
+    cdef void * HASHMAP_PUBLISHER_TABLE(HashmapPublisherSlot_t * slot)
+
+    cdef size_t hashmap_publisher_memory_size(
+        const unsigned int slot_count, const size_t slot_size)
+
+    cdef int hashmap_publisher_new_in(
+        void * const memory, const size_t memory_size,
+        const unsigned int slot_count, const size_t slot_size,
+        HashmapPublisher_t ** new_ctx)
+
+    cdef int hashmap_publisher_check(
+        const void * const memory, const size_t memory_size)
+
+    cdef int hashmap_publisher_publish(
+        HashmapPublisher_t * const ctx, const void * const table,
+        const size_t size, const HashmapFileType_e type)
+
+    cdef HashmapPublisherSlot_t * hashmap_publisher_acquire(
+        HashmapPublisher_t * const ctx)
+
+    cdef void hashmap_publisher_release(HashmapPublisherSlot_t * const slot)
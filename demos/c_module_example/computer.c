@@ -3,6 +3,9 @@
 
 #include "hashmap.h"
 
+/* Number of ids which are looked up at once */
+#define CHUNK_SIZE 256
+
 static PyObject* sum(PyObject *self, PyObject *args) {
     Py_buffer ids;
     size_t ids_size;
@@ -17,6 +20,9 @@ static PyObject* sum(PyObject *self, PyObject *args) {
     double *p_res;
     unsigned long long current_id;
     size_t current_position;
+    size_t positions[CHUNK_SIZE];
+    bool found[CHUNK_SIZE];
+    size_t chunk_size;
 
     if (!PyArg_ParseTuple(args, "y*Ky*y*w*",
             &ids, &id2pos_addr, &a, &b, &res)) {
@@ -31,13 +37,24 @@ static PyObject* sum(PyObject *self, PyObject *args) {
     p_b = (double *) b.buf;
     p_res = (double *) res.buf;
 
-    /* Calculate - there are only pure C types, no Python overhead */
-    for (size_t i=0; i<ids_size; ++i) {
-        current_id = p_ids[i];
-        if (int2int_get(id2pos, current_id, &current_position) != 0) {
-            goto error;
+    /* Calculate - there are only pure C types, no Python overhead. Ids
+       are looked up in chunks, so hashmap overlaps their cache misses. */
+    for (size_t i=0; i<ids_size; i+=CHUNK_SIZE) {
+        chunk_size = (ids_size - i < CHUNK_SIZE) ? ids_size - i : CHUNK_SIZE;
+        if (int2int_get_many(id2pos, p_ids + i, chunk_size,
+                positions, found) != chunk_size) {
+            for (size_t j=0; j<chunk_size; ++j) {
+                if (!found[j]) {
+                    current_id = p_ids[i + j];
+                    goto error;
+                }
+            }
+        }
+        for (size_t j=0; j<chunk_size; ++j) {
+            current_position = positions[j];
+            p_res[current_position] =
+                    p_a[current_position] + p_b[current_position];
         }
-        p_res[current_position] = p_a[current_position] + p_b[current_position];
     }
 
     /* Release buffers */
@@ -1,4 +1,5 @@
 
+import ctypes
 import logging
 import multiprocessing
 import os
@@ -6,6 +7,8 @@ import signal
 
 import sysv_ipc
 
+from cdatastructs.hashmap import Int2Int
+
 from shmdemo.common import configure_logging
 from shmdemo.serviceprocess import indexer
 from shmdemo.workerprocess import worker
@@ -14,6 +17,8 @@ SHM_KEY = None
 
 SHM_SIZE = 1024 * 1024 * 16
 
+CAPACITY = 1024
+
 
 def main():
     configure_logging()
@@ -22,19 +27,21 @@ def main():
     logger.info("Start main process")
 
     pid = os.getpid()
-    shmlock = multiprocessing.Lock()
     shm = sysv_ipc.SharedMemory(
         SHM_KEY, flags=sysv_ipc.IPC_CREX, mode=0o600, size=SHM_SIZE)
     try:
-        shmlock.acquire()
+        # Empty table is ready before processes start. Indexer is the only
+        # writer, workers read the table without any lock.
+        memory = (ctypes.c_char * shm.size).from_address(shm.address)
+        Int2Int.create_in(memory, CAPACITY, seqlock=True)
 
         for unused in range(4):
             worker_process = multiprocessing.Process(
-                target=worker, args=(pid, shm.key, shmlock), daemon=True)
+                target=worker, args=(pid, shm.key), daemon=True)
             worker_process.start()
 
         indexer_process = multiprocessing.Process(
-            target=indexer, args=(pid, shm.key, shmlock), daemon=True)
+            target=indexer, args=(pid, shm.key), daemon=True)
         indexer_process.start()
     finally:
         shm.detach()
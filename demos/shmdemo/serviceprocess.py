@@ -1,5 +1,5 @@
 
-import ctypes
+import array
 import logging
 import os
 import random
@@ -14,35 +14,30 @@ from cdatastructs.hashmap import Int2Int
 from shmdemo.common import configure_logging, StopProcess
 
 
-def indexer(parentpid, shmkey, shmlock):
+def indexer(parentpid, shmkey):
     configure_logging()
     logger = logging.getLogger('indexer')
 
     logger.info("Indexer has been started with pid %d", os.getpid())
 
-    shm_filled = False
     shm = sysv_ipc.SharedMemory(shmkey, flags=0, mode=0o600, size=0)
     try:
         signal.signal(signal.SIGINT, signal.SIG_IGN)
+        data = Int2Int.from_ptr(shm.address)
         while 1:
             try:
-                data = Int2Int()
+                new_data = {}
                 for i in range(random.randint(0, 16)):
                     entity_id = random.randint(100, 999)
-                    data[entity_id] = i
-                data.make_readonly()
-
-                if shm_filled:
-                    shmlock.acquire()
-                try:
-                    if shm.size < data.buffer_size:
-                        raise RuntimeError("SHM is too small")
-                    ctypes.memmove(
-                        shm.address, data.buffer_ptr, data.buffer_size)
-                    shm_filled = True
-                finally:
-                    if shm_filled:
-                        shmlock.release()
+                    new_data[entity_id] = i
+
+                # Workers see each deletion and then all new values at once
+                for entity_id in list(data):
+                    if entity_id not in new_data:
+                        del data[entity_id]
+                data.update_from_buffers(
+                    array.array('Q', new_data.keys()),
+                    array.array('Q', new_data.values()))
 
                 logger.info("Created %d keys: %s", len(data), list(data))
             except Exception:
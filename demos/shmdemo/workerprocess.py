@@ -1,4 +1,5 @@
 
+import array
 import logging
 import os
 import random
@@ -13,7 +14,7 @@ from cdatastructs.hashmap import Int2Int
 from shmdemo.common import configure_logging, StopProcess
 
 
-def worker(parentpid, shmkey, shmlock):
+def worker(parentpid, shmkey):
     configure_logging()
     logger = logging.getLogger('worker')
 
@@ -22,17 +23,18 @@ def worker(parentpid, shmkey, shmlock):
     shm = sysv_ipc.SharedMemory(shmkey, flags=0, mode=0o600, size=0)
     try:
         signal.signal(signal.SIGINT, signal.SIG_IGN)
+        data = Int2Int.from_ptr(shm.address)
+        entity_ids = array.array('Q', range(100, 1000))
+        found = array.array('b', bytes(len(entity_ids)))
         while 1:
             try:
-                if shmlock.acquire(block=True, timeout=1):
-                    try:
-                        data = Int2Int.from_ptr(shm.address)
-                        logger.info(
-                            "Processing %d keys: %s", len(data), list(data))
-                    finally:
-                        shmlock.release()
-                else:
-                    raise logger.warning("SHM is not available")
+                # Lookup is repeated when indexer changed the table meanwhile
+                values = data.get_many(entity_ids, found=found)
+                items = [
+                    (entity_id, value)
+                    for entity_id, value, entity_found
+                    in zip(entity_ids, values, found) if entity_found]
+                logger.info("Processing %d keys: %s", len(items), items)
             except Exception:
                 logger.exception("Processing data error")
 
@@ -1,13 +1,92 @@
 
+import array
 import collections.abc
 import ctypes
+import io
+import mmap
+import multiprocessing
 import operator
+import os
 import pickle
+import random
 import re
+import struct
+import threading
 
 import pytest
 
-from cdatastructs.hashmap import Int2Int, Int2Float
+from cdatastructs import hashmap
+from cdatastructs.hashmap import Int2Int, Int2IntSwiss, Int2Float, Publisher
+
+
+class _Int2IntHashTable_t(ctypes.Structure):
+
+    _fields_ = [
+        ('size', ctypes.c_size_t),
+        ('current_size', ctypes.c_size_t),
+        ('table_size', ctypes.c_size_t),
+        ('readonly', ctypes.c_bool),
+        ('version', ctypes.c_ubyte),
+        ('layout', ctypes.c_ubyte),
+        ('zero_key_used', ctypes.c_bool),
+        ('flags', ctypes.c_ubyte),
+        ('previous', ctypes.c_void_p),
+        ('migrate_position', ctypes.c_size_t),
+        ('max_load', ctypes.c_double),
+        ('growth', ctypes.c_double),
+        ('shrink_load', ctypes.c_double),
+        ('sequence', ctypes.c_ulonglong),
+        ('claimed', ctypes.c_size_t),
+    ]
+
+
+INT2INT_HEADER_SIZE = ctypes.sizeof(_Int2IntHashTable_t)
+
+
+_hashmap_lib = ctypes.CDLL(hashmap.__file__)
+
+
+def _get_many(function, buffer_ptr, keys, value_type):
+    n = len(keys)
+    values = (value_type * n)()
+    found = (ctypes.c_bool * n)()
+    function.restype = ctypes.c_size_t
+    count = function(
+        ctypes.c_void_p(buffer_ptr),
+        (ctypes.c_ulonglong * n)(*keys), ctypes.c_size_t(n), values, found)
+    return count, list(values), list(found)
+
+
+def _set_many(prefix, layout, initial, keys, values, value_type):
+    lib = _hashmap_lib
+    ctx = ctypes.c_void_p()
+    layout = ['items', 'swiss', 'compact', 'soa'].index(layout)
+    assert getattr(lib, prefix + '_new_layout')(
+        ctypes.c_size_t(8), layout, ctypes.byref(ctx)) == 0
+    for key, value in initial.items():
+        assert getattr(lib, prefix + '_set')(
+            ctx, ctypes.c_ulonglong(key), value_type(value),
+            ctypes.byref(ctx)) == 0
+    n = len(keys)
+    inserted = ctypes.c_size_t()
+    res = getattr(lib, prefix + '_set_many')(
+        ctx, (ctypes.c_ulonglong * n)(*keys), (value_type * n)(*values),
+        ctypes.c_size_t(n), ctypes.byref(ctx), ctypes.byref(inserted))
+    cls = Int2Int if prefix == 'int2int' else Int2Float
+    items = dict(cls.from_ptr(ctx.value).items())
+    size = ctypes.c_size_t.from_address(ctx.value).value
+    ctypes.CDLL(None).free(ctx)
+    return res, inserted.value, items, size
+
+
+def _fmix64(key):
+    mask = 2 ** 64 - 1
+    key ^= key >> 33
+    key = (key * 0xff51afd7ed558ccd) & mask
+    key ^= key >> 33
+    key = (key * 0xc4ceb9fe1a85ec53) & mask
+    key ^= key >> 33
+    return key
 
 
 # Int2Int ---------------------------------------------------------------------
@@ -52,6 +131,17 @@ def test_int2int_new_when_prealloc_size_kwarg():
             ('current_size', ctypes.c_size_t),
             ('table_size', ctypes.c_size_t),
             ('readonly', ctypes.c_bool),
+            ('version', ctypes.c_ubyte),
+            ('layout', ctypes.c_ubyte),
+            ('zero_key_used', ctypes.c_bool),
+            ('flags', ctypes.c_ubyte),
+            ('previous', ctypes.c_void_p),
+            ('migrate_position', ctypes.c_size_t),
+            ('max_load', ctypes.c_double),
+            ('growth', ctypes.c_double),
+            ('shrink_load', ctypes.c_double),
+            ('sequence', ctypes.c_ulonglong),
+            ('claimed', ctypes.c_size_t),
         ]
 
     t = Int2IntHashTable_t.from_address(int2int_map.buffer_ptr)
@@ -233,6 +323,17 @@ def test_int2int_setitem_more_items(int2int_map):
             ('current_size', ctypes.c_size_t),
             ('table_size', ctypes.c_size_t),
             ('readonly', ctypes.c_bool),
+            ('version', ctypes.c_ubyte),
+            ('layout', ctypes.c_ubyte),
+            ('zero_key_used', ctypes.c_bool),
+            ('flags', ctypes.c_ubyte),
+            ('previous', ctypes.c_void_p),
+            ('migrate_position', ctypes.c_size_t),
+            ('max_load', ctypes.c_double),
+            ('growth', ctypes.c_double),
+            ('shrink_load', ctypes.c_double),
+            ('sequence', ctypes.c_ulonglong),
+            ('claimed', ctypes.c_size_t),
         ]
 
     t = Int2IntHashTable_t.from_address(int2int_map.buffer_ptr)
@@ -262,6 +363,70 @@ def test_int2int_setitem_more_items(int2int_map):
     assert t.current_size == 16
 
 
+def test_int2int_setitem_stores_probe_distance(int2int_map):
+
+    class Int2IntItem_t(ctypes.Structure):
+
+        _fields_ = [
+            ('key', ctypes.c_ulonglong),
+            ('value', ctypes.c_size_t),
+            ('status', ctypes.c_int),
+            ('distance', ctypes.c_uint),
+        ]
+
+    class Int2IntHashTable_t(ctypes.Structure):
+
+        _fields_ = [
+            ('size', ctypes.c_size_t),
+            ('current_size', ctypes.c_size_t),
+            ('table_size', ctypes.c_size_t),
+            ('readonly', ctypes.c_bool),
+            ('version', ctypes.c_ubyte),
+            ('layout', ctypes.c_ubyte),
+            ('zero_key_used', ctypes.c_bool),
+            ('flags', ctypes.c_ubyte),
+            ('previous', ctypes.c_void_p),
+            ('migrate_position', ctypes.c_size_t),
+            ('max_load', ctypes.c_double),
+            ('growth', ctypes.c_double),
+            ('shrink_load', ctypes.c_double),
+            ('sequence', ctypes.c_ulonglong),
+            ('claimed', ctypes.c_size_t),
+        ]
+
+    for i in range(0, 1000, 7):
+        int2int_map[i] = i
+
+    t = Int2IntHashTable_t.from_address(int2int_map.buffer_ptr)
+    table = (Int2IntItem_t * t.table_size).from_address(
+        int2int_map.buffer_ptr + ctypes.sizeof(Int2IntHashTable_t))
+    mask = t.table_size - 1
+
+    for idx, item in enumerate(table):
+        if item.status == 1:
+            home = _fmix64(item.key) & mask
+            assert item.distance == (idx - home) & mask
+
+
+def test_int2int_setitem_delitem_random_keys(int2int_map):
+    rnd = random.Random(0)
+    expected = {}
+
+    for unused in range(20000):
+        key = rnd.randrange(2000)
+        if rnd.random() < 0.4 and key in expected:
+            del int2int_map[key]
+            del expected[key]
+        else:
+            int2int_map[key] = key + 1
+            expected[key] = (key + 1)
+
+    assert len(int2int_map) == len(expected)
+    assert dict(int2int_map.items()) == expected
+    for key in range(2000):
+        assert (key in int2int_map) == (key in expected)
+
+
 def test_int2int_delitem(int2int_map):
     int2int_map[1] = 101
     int2int_map[2] = 102
@@ -291,6 +456,51 @@ def test_int2int_delitem(int2int_map):
     assert len(int2int_map) == 0
 
 
+def test_int2int_delitem_leaves_no_tombstones(int2int_map):
+
+    class Int2IntItem_t(ctypes.Structure):
+
+        _fields_ = [
+            ('key', ctypes.c_ulonglong),
+            ('value', ctypes.c_size_t),
+            ('status', ctypes.c_int),
+            ('distance', ctypes.c_uint),
+        ]
+
+    class Int2IntHashTable_t(ctypes.Structure):
+
+        _fields_ = [
+            ('size', ctypes.c_size_t),
+            ('current_size', ctypes.c_size_t),
+            ('table_size', ctypes.c_size_t),
+            ('readonly', ctypes.c_bool),
+            ('version', ctypes.c_ubyte),
+            ('layout', ctypes.c_ubyte),
+            ('zero_key_used', ctypes.c_bool),
+            ('flags', ctypes.c_ubyte),
+            ('previous', ctypes.c_void_p),
+            ('migrate_position', ctypes.c_size_t),
+            ('max_load', ctypes.c_double),
+            ('growth', ctypes.c_double),
+            ('shrink_load', ctypes.c_double),
+            ('sequence', ctypes.c_ulonglong),
+            ('claimed', ctypes.c_size_t),
+        ]
+
+    for i in range(100):
+        int2int_map[i] = i
+    for i in range(0, 100, 3):
+        del int2int_map[i]
+    int2int_map.popitem()
+
+    t = Int2IntHashTable_t.from_address(int2int_map.buffer_ptr)
+    table = (Int2IntItem_t * t.table_size).from_address(
+        int2int_map.buffer_ptr + ctypes.sizeof(Int2IntHashTable_t))
+
+    assert [item.status for item in table].count(1) == len(int2int_map)
+    assert [item.status for item in table].count(2) == 0
+
+
 def test_int2int_delitem_fail_when_key_does_not_exist(int2int_map):
     int2int_map[2] = 102
     with pytest.raises(KeyError, match='1'):
@@ -314,6 +524,17 @@ def test_int2int_getitem_more_keys_does_not_exist_and_default_kwarg():
             ('current_size', ctypes.c_size_t),
             ('table_size', ctypes.c_size_t),
             ('readonly', ctypes.c_bool),
+            ('version', ctypes.c_ubyte),
+            ('layout', ctypes.c_ubyte),
+            ('zero_key_used', ctypes.c_bool),
+            ('flags', ctypes.c_ubyte),
+            ('previous', ctypes.c_void_p),
+            ('migrate_position', ctypes.c_size_t),
+            ('max_load', ctypes.c_double),
+            ('growth', ctypes.c_double),
+            ('shrink_load', ctypes.c_double),
+            ('sequence', ctypes.c_ulonglong),
+            ('claimed', ctypes.c_size_t),
         ]
 
     int2int_map = Int2Int(default=100)
@@ -443,6 +664,143 @@ def test_int2int_get_fail_when_default_is_too_big(int2int_map):
     assert "Python int too large to convert to C size_t" in str(exc_info)
 
 
+def test_int2int_get_many_array(int2int_map):
+    int2int_map.update({1: 101, 2: 102, 2 ** 64 - 1: 103})
+
+    res = int2int_map.get_many(array.array('Q', [2, 2 ** 64 - 1, 1, 2]))
+
+    assert isinstance(res, array.array)
+    assert list(res) == [102, 103, 101, 102]
+
+
+def test_int2int_get_many_when_keys_is_empty(int2int_map):
+    assert list(int2int_map.get_many(array.array('Q'))) == []
+
+
+def test_int2int_get_many_out_and_found(int2int_map):
+    int2int_map.update({1: 101, 2: 102})
+    out = array.array('Q', [7, 7, 7])
+    found = bytearray(3)
+
+    res = int2int_map.get_many(
+        memoryview(array.array('Q', [2, 3, 1])), out, found=found)
+
+    assert res is out
+    assert list(out) == [102, 7, 101]
+    assert list(found) == [1, 0, 1]
+
+
+def test_int2int_get_many_when_key_does_not_exist_and_default(int2int_map):
+    int2int_map.update({1: 101, 2: 102})
+
+    res = int2int_map.get_many(array.array('Q', [2, 3, 1]), default=5)
+
+    assert list(res) == [102, 5, 101]
+
+
+def test_int2int_get_many_fail_when_key_does_not_exist(int2int_map):
+    int2int_map.update({1: 101, 2: 102})
+    with pytest.raises(KeyError, match='3'):
+        int2int_map.get_many(array.array('Q', [2, 3, 1, 4]))
+
+
+@pytest.mark.parametrize('keys', [array.array('q', [1]), b'12345678', [1]])
+def test_int2int_get_many_fail_when_invalid_keys_type(int2int_map, keys):
+    with pytest.raises(TypeError):
+        int2int_map.get_many(keys)
+
+
+@pytest.mark.parametrize(
+    'out, found, match',
+    [
+        (array.array('Q', [0]), None, "'out' must have the same length"),
+        (array.array('d', [0, 0]), None, "'out' must be a buffer of size_t"),
+        (None, bytearray(1), "'found' must have the same length"),
+        (None, array.array('Q', [0, 0]), "'found' must be a buffer of bool"),
+    ]
+)
+def test_int2int_get_many_fail_when_invalid_result_buffer(
+        int2int_map, out, found, match):
+    with pytest.raises((TypeError, ValueError), match=match):
+        int2int_map.get_many(
+            array.array('Q', [1, 2]), out, found=found, default=0)
+
+
+def test_int2int_get_many_fail_when_out_is_readonly(int2int_map):
+    with pytest.raises(BufferError):
+        int2int_map.get_many(array.array('Q', [1]), bytes(8), default=0)
+
+
+def test_int2int_get_many_fail_when_invalid_default_type(int2int_map):
+    with pytest.raises(TypeError, match="'default' must be positive int"):
+        int2int_map.get_many(array.array('Q', [1]), default='a')
+
+
+def test_int2int_get_many_blocks_changes_from_other_threads():
+    int2int_map = Int2Int((i, i) for i in range(100000))
+    keys = array.array('Q', range(100000))
+    stop = threading.Event()
+
+    def lookup():
+        while not stop.is_set():
+            int2int_map.get_many(keys)
+
+    thread = threading.Thread(target=lookup)
+    thread.start()
+    try:
+        blocked = False
+        for i in range(100000):
+            try:
+                int2int_map[i] = i
+            except BufferError:
+                blocked = True
+                break
+    finally:
+        stop.set()
+        thread.join()
+
+    assert blocked
+    assert list(int2int_map.get_many(keys)) == list(range(100000))
+
+
+@pytest.mark.parametrize('finish', [
+    lambda int2int_map: pickle.dumps(int2int_map, protocol=4),
+    lambda int2int_map: int2int_map.buffer_ptr,
+])
+def test_int2int_get_many_blocks_finish_resize_from_other_threads(finish):
+    int2int_map = Int2Int(
+        ((i, i) for i in range(100000)), prealloc_size=100000,
+        incremental_resize=True)
+    # Previous table is migrated by following changes
+    int2int_map[100000] = 100000
+    keys = array.array('Q', range(100001))
+    started = threading.Event()
+    stop = threading.Event()
+
+    def lookup():
+        started.set()
+        while not stop.is_set():
+            int2int_map.get_many(keys)
+
+    thread = threading.Thread(target=lookup)
+    thread.start()
+    started.wait()
+    try:
+        blocked = False
+        for unused in range(100000):
+            try:
+                finish(int2int_map)
+            except BufferError:
+                blocked = True
+                break
+    finally:
+        stop.set()
+        thread.join()
+
+    assert blocked
+    assert list(int2int_map.get_many(keys)) == list(range(100001))
+
+
 def test_int2int_contains_when_key_exists(int2int_map):
     int2int_map[2541265478] = 100
     assert 2541265478 in int2int_map
@@ -482,6 +840,81 @@ def test_int2int_from_ptr(int2int_map):
     assert int2int_new_map[2] == 102
 
 
+def test_int2int_new_table_size_is_power_of_two():
+    int2int_map = Int2Int(prealloc_size=1000)
+
+    class Int2IntHashTable_t(ctypes.Structure):
+
+        _fields_ = [
+            ('size', ctypes.c_size_t),
+            ('current_size', ctypes.c_size_t),
+            ('table_size', ctypes.c_size_t),
+            ('readonly', ctypes.c_bool),
+            ('version', ctypes.c_ubyte),
+        ]
+
+    t = Int2IntHashTable_t.from_address(int2int_map.buffer_ptr)
+
+    assert t.size == 1000
+    assert t.table_size == 2048
+    assert t.version == 1
+
+
+def _legacy_int2int_table(items):
+
+    class Int2IntItem_t(ctypes.Structure):
+
+        _fields_ = [
+            ('key', ctypes.c_ulonglong),
+            ('value', ctypes.c_size_t),
+            ('status', ctypes.c_int),
+        ]
+
+    class LegacyInt2IntHashTable_t(ctypes.Structure):
+
+        _fields_ = [
+            ('size', ctypes.c_size_t),
+            ('current_size', ctypes.c_size_t),
+            ('table_size', ctypes.c_size_t),
+            ('readonly', ctypes.c_bool),
+            ('table', Int2IntItem_t * 10),
+        ]
+
+    legacy = LegacyInt2IntHashTable_t(size=8, current_size=0, table_size=10)
+    for key, value in items:
+        idx = (97 * key) % 10
+        while legacy.table[idx].status:
+            idx = (idx + 1) % 10
+        legacy.table[idx] = Int2IntItem_t(key, value, 1)
+        legacy.current_size += 1
+
+    return legacy
+
+
+def test_int2int_from_ptr_when_legacy_format():
+    # All keys have the same legacy hash, so they form one probe chain
+    legacy = _legacy_int2int_table([(1, 101), (11, 111), (21, 121)])
+
+    int2int_map = Int2Int.from_ptr(ctypes.addressof(legacy))
+    assert dict(int2int_map.items()) == {1: 101, 11: 111, 21: 121}
+
+    int2int_map[31] = 131
+    del int2int_map[11]
+
+    assert dict(int2int_map.items()) == {1: 101, 21: 121, 31: 131}
+    assert legacy.current_size == 3
+
+
+def test_int2int_from_raw_data_when_legacy_format():
+    legacy = _legacy_int2int_table([(1, 101), (11, 111), (21, 121)])
+
+    int2int_map = Int2Int._from_raw_data(
+        None, 8, 3, 10, False, bytes(legacy.table))
+
+    assert dict(int2int_map.items()) == {1: 101, 11: 111, 21: 121}
+    assert len(int2int_map) == 3
+
+
 def test_int2int_iter_when_empty(int2int_map):
     assert set(int2int_map) == set()
 
@@ -528,6 +961,161 @@ def test_int2int_items(int2int_map):
         (1, 101), (2, 102), (3, 103), (4, 104), (5, 105), (6, 106)}
 
 
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+@pytest.mark.parametrize('frozen', [False, True])
+def test_int2int_items_arrays(layout, frozen):
+    rnd = random.Random(1)
+    expected = {rnd.randrange(2 ** 64): i for i in range(1000)}
+    expected[0] = 1000
+    int2int_map = Int2Int(expected, layout=layout)
+    if frozen:
+        int2int_map.freeze()
+
+    keys, values = int2int_map.items_arrays()
+
+    assert isinstance(keys, array.array)
+    assert isinstance(values, array.array)
+    assert list(keys) == list(int2int_map.keys())
+    assert list(values) == list(int2int_map.values())
+    assert dict(zip(keys, values)) == expected
+    assert list(int2int_map.keys_array()) == list(keys)
+    assert list(int2int_map.values_array()) == list(values)
+
+
+def test_int2int_items_arrays_when_empty(int2int_map):
+    assert int2int_map.keys_array() == array.array('Q')
+    assert int2int_map.items_arrays() == (array.array('Q'), array.array('Q'))
+
+
+def test_int2int_items_arrays_when_migrating():
+    int2int_map = Int2Int(incremental_resize=True)
+    for i in range(1000):
+        int2int_map[i] = i + 1
+
+    keys, values = int2int_map.items_arrays()
+
+    assert sorted(zip(keys, values)) == [(i, i + 1) for i in range(1000)]
+
+
+def test_int2int_items_arrays_out(int2int_map):
+    int2int_map.update({1: 101, 2: 102})
+    keys_out = array.array('Q', [0, 0])
+    values_out = memoryview(bytearray(16)).cast('Q')
+
+    keys, values = int2int_map.items_arrays(keys_out, values_out=values_out)
+
+    assert keys is keys_out
+    assert values is values_out
+    assert dict(zip(keys, values)) == {1: 101, 2: 102}
+    assert int2int_map.values_array(out=values_out) is values_out
+
+
+@pytest.mark.parametrize(
+    'method, kwargs, exc, msg',
+    [
+        ('keys_array', {'out': array.array('Q', [0])}, ValueError,
+         "'out' must have the same length as the mapping"),
+        ('keys_array', {'out': array.array('d', [0, 0])}, TypeError,
+         "'out' must be a buffer of uint64"),
+        ('values_array', {'out': array.array('d', [0, 0])}, TypeError,
+         "'out' must be a buffer of size_t"),
+        ('items_arrays', {'values_out': array.array('Q', [0])}, ValueError,
+         "'values_out' must have the same length as the mapping"),
+    ]
+)
+def test_int2int_items_arrays_fail_when_invalid_out(
+        int2int_map, method, kwargs, exc, msg):
+    int2int_map.update({1: 101, 2: 102})
+    with pytest.raises(exc, match=msg):
+        getattr(int2int_map, method)(**kwargs)
+
+
+@pytest.mark.parametrize('layout', ['items', 'compact', 'cuckoo'])
+def test_int2int_buffer_protocol(layout):
+    expected = {i * 7 + 1: i for i in range(100)}
+    expected[0] = 1000
+    if layout == 'cuckoo':
+        int2int_map = Int2Int(expected)
+        int2int_map.freeze()
+    else:
+        int2int_map = Int2Int(expected, layout=layout)
+
+    with memoryview(int2int_map) as view:
+        assert view.readonly
+        assert view.ndim == 1
+        if layout == 'items':
+            assert view.format == 'T{Q:key:Q:value:I:status:I:distance:}'
+            assert view.itemsize == 24
+            items = {
+                key: value
+                for key, value, status, unused in struct.iter_unpack(
+                    'QQII', view.cast('B'))
+                if status == 1}
+        else:
+            assert view.format == 'T{Q:key:Q:value:}'
+            assert view.itemsize == 16
+            slots = list(struct.iter_unpack('QQ', view.cast('B')))
+            # Key 0 is stored in the extra slot at the end
+            items = {key: value for key, value in slots[:-1] if key}
+            items[0] = slots[-1][1]
+        t = _Int2IntHashTable_t.from_address(int2int_map.buffer_ptr)
+        assert view.nbytes == int2int_map.buffer_size - INT2INT_HEADER_SIZE
+        assert view.shape[0] >= t.table_size
+
+    assert items == expected
+
+
+@pytest.mark.parametrize('layout', ['swiss', 'soa', 'concurrent'])
+def test_int2int_buffer_protocol_fail_when_layout_is_not_supported(layout):
+    with pytest.raises(BufferError, match=f"Layout '{layout}' can't be"):
+        memoryview(Int2Int(layout=layout))
+
+
+def test_int2int_buffer_protocol_fail_when_writable(int2int_map):
+    with pytest.raises(TypeError, match='not writable'):
+        (ctypes.c_char * 1).from_buffer(int2int_map)
+
+
+@pytest.mark.parametrize(
+    'modify',
+    [
+        lambda m: m.__setitem__(100, 1),
+        lambda m: m.__delitem__(1),
+        lambda m: m.pop(1),
+        lambda m: m.popitem(),
+        lambda m: m.clear(),
+        lambda m: m.shrink_to_fit(),
+        lambda m: m.freeze(),
+        lambda m: m.update_from_buffers(array.array('Q', [100])),
+    ]
+)
+def test_int2int_buffer_protocol_pins_table(modify):
+    int2int_map = Int2Int({1: 1, 2: 2})
+
+    view = memoryview(int2int_map)
+    with pytest.raises(BufferError, match='Existing exports'):
+        modify(int2int_map)
+    assert dict(int2int_map) == {1: 1, 2: 2}
+    view.release()
+
+    modify(int2int_map)
+
+
+def test_int2int_buffer_protocol_when_migrating():
+    int2int_map = Int2Int(incremental_resize=True)
+    for i in range(1, 1001):
+        int2int_map[i] = i
+
+    with memoryview(int2int_map) as view:
+        items = {
+            key: value
+            for key, value, status, unused in struct.iter_unpack(
+                'QQII', view.cast('B'))
+            if status == 1}
+
+    assert items == {i: i for i in range(1, 1001)}
+
+
 def test_int2int_pop(int2int_map):
     for i in range(1, 7, 1):
         int2int_map[i] = 100 + i
@@ -641,105 +1229,980 @@ def test_int2int_update_fail_when_invalid_value(int2int_map, other, exc, msg):
         int2int_map.update(other)
 
 
-def test_int2int_setdefault(int2int_map):
-    int2int_map[1] = 101
-    assert int2int_map.setdefault(1) == 101
-    assert len(int2int_map) == 1
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+def test_int2int_update_from_buffers(layout):
+    int2int_map = Int2Int({1: 1, 2: 2}, layout=layout)
+    keys = array.array('Q', [2, 3, 2 ** 64 - 1])
+    values = array.array('Q', [102, 103, 104])
 
+    int2int_map.update_from_buffers(keys, values)
 
-def test_int2int_setdefault_when_default(int2int_map):
-    int2int_map[1] = 101
-    assert int2int_map.setdefault(2, 102) == 102
-    assert len(int2int_map) == 2
+    assert dict(int2int_map) == {1: 1, 2: 102, 3: 103, 2 ** 64 - 1: 104}
 
 
-@pytest.mark.parametrize('default', [None, 'a'])
-def test_int2int_setdefault_when_invalid_default_type(int2int_map, default):
-    with pytest.raises(TypeError, match="'value' must be an integer"):
-        int2int_map.setdefault(1, default)
+def test_int2int_update_from_buffers_when_values_are_positions(int2int_map):
+    int2int_map[1] = 100
 
+    int2int_map.update_from_buffers(memoryview(array.array('Q', [5, 1, 7])))
 
-def test_int2int_setdefault_fail_when_key_does_not_exist(int2int_map):
-    for i in range(1, 7, 1):
-        int2int_map[i] = 100 + i
-    with pytest.raises(KeyError, match="7"):
-        int2int_map.setdefault(7)
+    assert dict(int2int_map) == {1: 1, 5: 0, 7: 2}
 
 
-def test_int2int_equal_when_empty():
-    a = Int2Int()
-    b = Int2Int()
-    assert a == b
+def test_int2int_update_from_buffers_when_keys_are_empty(int2int_map):
+    int2int_map.update_from_buffers(array.array('Q'), array.array('Q'))
+    assert len(int2int_map) == 0
 
 
-def test_int2int_equal_when_same_keys_and_values():
-    a = Int2Int()
-    b = Int2Int()
-    for i in range(1, 7, 1):
-        a[i] = 100 + i
-        b[i] = 100 + i
-    assert a == b
+@pytest.mark.parametrize(
+    'keys, values, exc, msg',
+    [
+        ([1], None, TypeError, 'bytes-like object is required'),
+        (array.array('q', [1]), None, TypeError, "'keys' must be a buffer"),
+        (array.array('Q', [1]), array.array('d', [1]), TypeError,
+         "'values' must be a buffer of size_t"),
+        (array.array('Q', [1]), array.array('Q', [1, 2]), ValueError,
+         "'values' must have the same length"),
+    ]
+)
+def test_int2int_update_from_buffers_fail_when_invalid_buffers(
+        int2int_map, keys, values, exc, msg):
+    with pytest.raises(exc, match=msg):
+        int2int_map.update_from_buffers(keys, values)
+    assert len(int2int_map) == 0
 
 
-def test_int2int_equal_with_dict_when_same_keys_and_values():
-    a = Int2Int()
-    b = {}
-    for i in range(1, 7, 1):
-        a[i] = 100 + i
-        b[i] = 100 + i
-    assert a == b
+def test_int2int_update_from_buffers_fail_when_readonly(int2int_map):
+    int2int_map.make_readonly()
+    with pytest.raises(RuntimeError, match='Instance is read-only'):
+        int2int_map.update_from_buffers(array.array('Q', [1]))
 
 
-def test_int2int_not_equal_when_same_size_same_keys_but_different_values():
-    a = Int2Int()
-    b = Int2Int()
-    for i in range(1, 7, 1):
-        a[i] = 100 + i
-        b[i] = 100 + i
-    b[6] = 200
-    assert a != b
+@pytest.mark.parametrize(
+    'layout', ['items', 'swiss', 'compact', 'soa', 'concurrent'])
+def test_int2int_add(layout):
+    int2int_map = Int2Int({1: 10}, layout=layout, prealloc_size=100)
+
+    assert int2int_map.add(1, 5) == 15
+    assert int2int_map.add(0, 2) == 2
+    assert int2int_map.add(0, 3) == 5
+    assert int2int_map.add(2 ** 64 - 1, 0) == 0
+    assert int2int_map.add(1, -6) == 9
+    assert int2int_map.add(0, -5) == 0
+    assert int2int_map.add(0, 2) == 2
+    assert int2int_map.add(3, 2 ** 64 - 1) == 2 ** 64 - 1
+    assert int2int_map.add(3, -2 ** 63) == 2 ** 63 - 1
+    assert int2int_map.add(4, 0) == 0
+    assert dict(int2int_map) == {
+        0: 2, 1: 9, 3: 2 ** 63 - 1, 4: 0, 2 ** 64 - 1: 0}
 
 
-def test_int2int_not_equal_when_same_size_same_values_but_different_keys():
-    a = Int2Int()
-    b = Int2Int()
-    for i in range(1, 7, 1):
-        a[i] = 100 + i
-        b[i] = 100 + i
-    a[7] = 200
-    b[8] = 300
-    assert a != b
+@pytest.mark.parametrize(
+    'layout', ['items', 'swiss', 'compact', 'soa', 'concurrent'])
+def test_int2int_add_fail_when_out_of_range(layout):
+    int2int_map = Int2Int({0: 3, 1: 2 ** 64 - 2}, layout=layout,
+                          prealloc_size=100)
+
+    with pytest.raises(OverflowError, match='out of range'):
+        int2int_map.add(0, -5)
+    with pytest.raises(OverflowError, match='out of range'):
+        int2int_map.add(1, 2)
+    with pytest.raises(OverflowError, match='out of range'):
+        int2int_map.add(2, -1)
+    with pytest.raises(OverflowError, match='out of range'):
+        int2int_map.add_many(array.array('Q', [0, 1]),
+                             array.array('q', [-3, 3]))
+    with pytest.raises(OverflowError, match='out of range'):
+        int2int_map.add_many(array.array('Q', [0]),
+                             array.array('q', [-1]))
+
+    assert dict(int2int_map) == {0: 0, 1: 2 ** 64 - 2}
+    assert int2int_map.add(2, 1) == 1
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+def test_int2int_add_many(layout):
+    int2int_map = Int2Int({1: 10}, layout=layout)
+    keys = array.array('Q', [key % 1000 for key in range(10000)])
+
+    int2int_map.add_many(keys, array.array('Q', [2] * len(keys)))
+
+    assert len(int2int_map) == 1000
+    assert dict(int2int_map) == {
+        key: 20 + (10 if key == 1 else 0) for key in range(1000)}
+
+    int2int_map.add_many(keys, array.array('q', [-1] * len(keys)))
+
+    assert dict(int2int_map) == {
+        key: 10 + (10 if key == 1 else 0) for key in range(1000)}
+
+
+@pytest.mark.parametrize('method, args, exc, msg', [
+    ('add', ('1', 1), TypeError, "'key' must be an integer"),
+    ('add', (1, 1.0), TypeError, "'delta' must be an integer"),
+    ('add', (1, -2 ** 63 - 1), OverflowError, "'delta' is too small"),
+    ('add', (1, 2 ** 64), OverflowError, 'too large'),
+    ('add_many', (array.array('Q', [1]), array.array('d', [1])), TypeError,
+     "'deltas' must be a buffer of size_t or ssize_t"),
+    ('add_many', (array.array('Q', [1]), array.array('i', [1])), TypeError,
+     "'deltas' must be a buffer of size_t or ssize_t"),
+    ('add_many', (array.array('Q', [1]), array.array('Q', [1, 2])),
+     ValueError, "'deltas' must have the same length"),
+])
+def test_int2int_add_fail_when_invalid_args(
+        int2int_map, method, args, exc, msg):
+    with pytest.raises(exc, match=msg):
+        getattr(int2int_map, method)(*args)
+    assert len(int2int_map) == 0
 
 
-def test_int2int_not_equal_when_different_size():
-    a = Int2Int()
-    b = Int2Int()
-    for i in range(1, 7, 1):
-        a[i] = 100 + i
-        b[i] = 100 + i
-    b[7] = 107
-    assert a != b
+@pytest.mark.parametrize('method, args', [
+    ('add', (1, 1)),
+    ('add_many', (array.array('Q', [1]), array.array('Q', [1]))),
+])
+def test_int2int_add_fail_when_readonly(int2int_map, method, args):
+    int2int_map.make_readonly()
+    with pytest.raises(RuntimeError, match='Instance is read-only'):
+        getattr(int2int_map, method)(*args)
 
 
-@pytest.mark.parametrize(
-    'other', [1, 'a', [1, 2]])
-def test_int2int_eq_fail_when_invalid_other_object(int2int_map, other):
-    with pytest.raises(TypeError) as exc_info:
-        assert int2int_map == other
-    assert "'other' is not either an Int2Int or a dict" in str(exc_info)
+def test_int2int_add_fail_when_full():
+    buffer = bytearray(Int2Int.buffer_size_for(2))
+    int2int_map = Int2Int.create_in(buffer, 2)
+    int2int_map.add_many(
+        array.array('Q', [1, 2, 1]), array.array('Q', [1, 1, 1]))
 
+    with pytest.raises(RuntimeError, match='Instance is full'):
+        int2int_map.add(3, 1)
+    with pytest.raises(RuntimeError, match='Instance is full'):
+        int2int_map.add_many(
+            array.array('Q', [2, 3]), array.array('Q', [1, 1]))
+    assert dict(int2int_map) == {1: 2, 2: 2}
 
-@pytest.mark.parametrize(
-    'op', [operator.lt, operator.le, operator.gt, operator.ge])
-def test_int2int_eq_fail_when_invalid_operator(int2int_map, op):
-    with pytest.raises(TypeError) as exc_info:
-        op(int2int_map, {})
-    assert 'is not supported' in str(exc_info)
 
+@pytest.mark.parametrize('layout', ['items', 'concurrent'])
+def test_int2int_min_max(layout):
+    buffer = bytearray(Int2Int.buffer_size_for(10, layout=layout))
+    int2int_map = Int2Int.create_in(buffer, 10, layout=layout)
+    ctx = ctypes.c_void_p(int2int_map.buffer_ptr)
+    value = ctypes.c_size_t()
 
-@pytest.mark.parametrize(
-    'args, exc, msg',
-    [
+    for function, key, operand, expected in [
+            ('int2int_min', 1, 5, 5), ('int2int_min', 1, 7, 5),
+            ('int2int_min', 1, 3, 3), ('int2int_max', 2, 5, 5),
+            ('int2int_max', 2, 3, 5), ('int2int_max', 2, 9, 9)]:
+        assert getattr(_hashmap_lib, function)(
+            ctx, ctypes.c_ulonglong(key), ctypes.c_size_t(operand),
+            ctypes.byref(value), ctypes.byref(ctx)) == 0
+        assert value.value == expected
+    assert dict(int2int_map) == {1: 3, 2: 9}
+
+
+def test_int2int_from_arrays():
+    keys = array.array('Q', range(10000, 0, -1))
+
+    int2int_map = Int2Int.from_arrays(keys, layout='soa', default=7)
+
+    assert isinstance(int2int_map, Int2Int)
+    assert int2int_map.layout == 'soa'
+    assert dict(int2int_map) == {key: i for i, key in enumerate(keys)}
+    assert int2int_map[20000] == 7
+
+
+def test_int2int_swiss_from_arrays():
+    int2int_map = Int2IntSwiss.from_arrays(
+        array.array('Q', [1, 2]), array.array('Q', [3, 4]))
+
+    assert isinstance(int2int_map, Int2IntSwiss)
+    assert dict(int2int_map) == {1: 3, 2: 4}
+
+
+@pytest.mark.parametrize(
+    'layout', ['items', 'swiss', 'compact', 'soa', 'concurrent'])
+def test_int2int_create_in(layout):
+    size = Int2Int.buffer_size_for(100, layout=layout)
+    with mmap.mmap(-1, size) as memory:
+        int2int_map = Int2Int.create_in(memory, 100, layout=layout)
+        for key in range(100):
+            int2int_map[key] = key * 2
+
+        assert int2int_map.layout == layout
+        assert int2int_map.buffer_size == size
+        assert int2int_map.buffer_ptr == ctypes.addressof(
+            ctypes.c_char.from_buffer(memory))
+        assert dict(int2int_map) == {key: key * 2 for key in range(100)}
+        with pytest.raises(BufferError):
+            memory.close()
+        del int2int_map
+
+
+def test_int2int_create_in_fail_when_full():
+    buffer = bytearray(Int2Int.buffer_size_for(2))
+    int2int_map = Int2Int.create_in(buffer, 2, default=0)
+    int2int_map[1] = 1
+    int2int_map[2] = 2
+
+    with pytest.raises(RuntimeError, match='Instance is full'):
+        int2int_map[3] = 3
+    with pytest.raises(RuntimeError, match='Instance is full'):
+        int2int_map[4]
+    int2int_map[2] = 20
+    del int2int_map[1]
+    int2int_map[5] = 5
+    assert dict(int2int_map) == {2: 20, 5: 5}
+
+
+@pytest.mark.parametrize('method', ['shrink_to_fit', 'freeze'])
+def test_int2int_create_in_fail_when_resized(method):
+    buffer = bytearray(Int2Int.buffer_size_for(2))
+    int2int_map = Int2Int.create_in(buffer, 2)
+    int2int_map[1] = 1
+
+    with pytest.raises(RuntimeError, match='Instance has fixed size'):
+        getattr(int2int_map, method)()
+    assert dict(int2int_map) == {1: 1}
+
+
+@pytest.mark.parametrize('args, kwargs, exc, msg', [
+    ((bytearray(100), 10), {}, ValueError, 'Buffer of 100 bytes is too small'),
+    ((memoryview(bytearray(1024))[1:], 10), {}, ValueError,
+     'Buffer is not aligned'),
+    ((b'\x00' * 1024, 10), {}, BufferError, 'not writable'),
+    ((bytearray(1024), -1), {}, ValueError, "'capacity' must not be negative"),
+    ((bytearray(1024), 10), {'default': -1}, TypeError,
+     "'default' must be positive int"),
+    ((bytearray(1024), 10), {'layout': 'cuckoo'}, ValueError,
+     "Layout 'cuckoo' is created only by freeze"),
+    ((bytearray(1024), 10), {'layout': 'concurrent', 'seqlock': True},
+     ValueError, "Layout 'concurrent' can't be used with seqlock"),
+    ((bytearray(1024), 10), {'max_load': 0.0}, ValueError,
+     "'max_load' must be greater than 0 and at most 1"),
+])
+def test_int2int_create_in_fail_when_invalid_args(args, kwargs, exc, msg):
+    with pytest.raises(exc, match=msg):
+        Int2Int.create_in(*args, **kwargs)
+
+
+@pytest.mark.parametrize(
+    'layout', ['items', 'swiss', 'compact', 'soa', 'concurrent'])
+def test_int2int_from_buffer(layout):
+    buffer = bytearray(Int2Int.buffer_size_for(10, layout=layout))
+    int2int_map = Int2Int.create_in(buffer, 10, layout=layout)
+    int2int_map.update({1: 2, 3: 4})
+
+    other_map = Int2Int.from_buffer(buffer, default=0)
+    other_map[5] = 6
+
+    assert other_map.layout == layout
+    assert other_map[7] == 0
+    assert dict(int2int_map) == {1: 2, 3: 4, 5: 6, 7: 0}
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+def test_int2int_from_buffer_when_readonly(layout):
+    int2int_map = Int2Int(layout=layout)
+    int2int_map.update({1: 2, 3: 4})
+    int2int_map.freeze()
+    data = ctypes.string_at(
+        int2int_map.buffer_ptr, int2int_map.buffer_size)
+
+    other_map = Int2Int.from_buffer(data)
+
+    assert other_map.readonly
+    assert other_map.layout == int2int_map.layout
+    assert dict(other_map) == {1: 2, 3: 4}
+
+
+def test_int2int_from_buffer_fail_when_readonly_buffer_and_writable_table():
+    int2int_map = Int2Int()
+    int2int_map[1] = 2
+    data = ctypes.string_at(int2int_map.buffer_ptr, int2int_map.buffer_size)
+
+    with pytest.raises(ValueError, match='must be read-only'):
+        Int2Int.from_buffer(data)
+
+
+@pytest.mark.parametrize('mutate, msg', [
+    (lambda data: data[:16], 'Buffer is too small'),
+    (lambda data: data[:-8], 'Table exceeds the buffer'),
+    (lambda data: bytearray(len(data)), 'Unsupported format'),
+    (lambda data: data[:16] + struct.pack('=Q', 1000) + data[24:],
+     'Unsupported format'),
+])
+def test_int2int_from_buffer_fail_when_invalid_table(mutate, msg):
+    buffer = bytearray(Int2Int.buffer_size_for(10))
+    Int2Int.create_in(buffer, 10)[1] = 2
+
+    with pytest.raises(ValueError, match=msg):
+        Int2Int.from_buffer(mutate(buffer))
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+def test_int2int_create_in_seqlock(layout):
+    buffer = bytearray(Int2Int.buffer_size_for(10, layout=layout))
+    int2int_map = Int2Int.create_in(buffer, 10, layout=layout, seqlock=True)
+    t = _Int2IntHashTable_t.from_buffer(buffer)
+
+    int2int_map[1] = 2
+    int2int_map.update_from_buffers(
+        array.array('Q', [3, 5]), array.array('Q', [4, 6]))
+    del int2int_map[5]
+
+    assert t.flags & 0x08
+    assert t.sequence == 6
+    int2int_map.clear()
+    assert t.sequence == 8
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+def test_int2int_seqlock_readers(layout):
+    buffer = bytearray(Int2Int.buffer_size_for(100, layout=layout))
+    int2int_map = Int2Int.create_in(
+        buffer, 100, layout=layout, seqlock=True)
+    int2int_map.update({i: i * 2 for i in range(0, 100, 2)})
+    reader = Int2Int.from_buffer(buffer)
+    found = array.array('b', bytes(100))
+
+    values = reader.get_many(array.array('Q', range(100)), found=found)
+
+    assert reader[10] == 20
+    assert reader.get(11, 7) == 7
+    assert 12 in reader
+    assert 13 not in reader
+    assert list(found) == [1, 0] * 50
+    assert list(values)[::2] == list(range(0, 200, 4))
+
+
+def test_int2int_seqlock_fail_when_writer_does_not_finish():
+    buffer = bytearray(Int2Int.buffer_size_for(10))
+    Int2Int.create_in(buffer, 10, seqlock=True)[1] = 2
+    reader = Int2Int.from_buffer(buffer)
+    _Int2IntHashTable_t.from_buffer(buffer).sequence += 1
+
+    with pytest.raises(RuntimeError, match='being modified by the writer'):
+        reader.get(1)
+    with pytest.raises(RuntimeError, match='being modified by the writer'):
+        reader.get_many(array.array('Q', [1]))
+
+
+@pytest.mark.skipif(
+    'fork' not in multiprocessing.get_all_start_methods(),
+    reason="fork is not available")
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+def test_int2int_seqlock_when_writer_in_other_process(layout):
+    keys = array.array('Q', range(1, 1001))
+    memory = mmap.mmap(-1, Int2Int.buffer_size_for(len(keys), layout=layout))
+    Int2Int.create_in(memory, len(keys), layout=layout, seqlock=True)
+    reader = Int2Int.from_buffer(memory)
+    found = array.array('b', bytes(len(keys)))
+
+    def write():
+        # Value of every key is the key multiplied by the generation, all
+        # keys get the next generation by one modification
+        writer = Int2Int.from_buffer(memory)
+        for generation in range(1, 200):
+            writer.update_from_buffers(keys, array.array(
+                'Q', (key * generation for key in keys)))
+            for key in keys[generation % 2::2]:
+                del writer[key]
+
+    process = multiprocessing.get_context('fork').Process(target=write)
+    process.start()
+    try:
+        while process.is_alive():
+            values = reader.get_many(keys, found=found)
+            for i in range(0, len(keys), 64):
+                generations = {
+                    divmod(value, key) for key, value, key_found in zip(
+                        keys[i:i + 64], values[i:i + 64], found[i:i + 64])
+                    if key_found}
+                assert len(generations) <= 1
+                assert all(0 == rest for unused, rest in generations)
+    finally:
+        process.join()
+    assert process.exitcode == 0
+
+
+def test_int2int_concurrent():
+    buffer = bytearray(Int2Int.buffer_size_for(3, layout='concurrent'))
+    int2int_map = Int2Int.create_in(buffer, 3, layout='concurrent')
+    int2int_map.update({0: 1, 2: 3, 4: 5})
+
+    with pytest.raises(RuntimeError, match='Instance is full'):
+        int2int_map[6] = 7
+    with pytest.raises(RuntimeError, match='Instance has fixed size'):
+        int2int_map.shrink_to_fit()
+    del int2int_map[0]
+    del int2int_map[2]
+    with pytest.raises(KeyError):
+        del int2int_map[2]
+    int2int_map[2] = 30
+    int2int_map[6] = 7
+    assert len(int2int_map) == 3
+    assert 0 not in int2int_map
+    assert dict(int2int_map) == {2: 30, 4: 5, 6: 7}
+    int2int_map.clear()
+    int2int_map.update({8: 9, 10: 11})
+    assert dict(Int2Int.from_buffer(buffer)) == {8: 9, 10: 11}
+
+
+def test_int2int_concurrent_never_grows():
+    int2int_map = Int2Int(layout='concurrent', prealloc_size=2)
+    int2int_map.update({1: 2, 3: 4})
+
+    with pytest.raises(RuntimeError, match='Instance is full'):
+        int2int_map[5] = 6
+    with pytest.raises(RuntimeError, match='Instance is full'):
+        int2int_map.update_from_buffers(array.array('Q', [5, 7]))
+    other_map = pickle.loads(pickle.dumps(int2int_map))
+    assert other_map.layout == 'concurrent'
+    assert dict(other_map) == {1: 2, 3: 4}
+
+
+def test_int2int_concurrent_freeze_fail():
+    int2int_map = Int2Int({1: 2, 3: 4}, layout='concurrent')
+    with pytest.raises(RuntimeError, match='Instance has fixed size'):
+        int2int_map.freeze()
+
+    ctx = ctypes.c_void_p(int2int_map.buffer_ptr)
+    assert _hashmap_lib.int2int_freeze(ctx, ctypes.byref(ctx)) == -1
+    assert int2int_map.layout == 'concurrent'
+    assert dict(int2int_map) == {1: 2, 3: 4}
+
+
+def test_int2int_concurrent_when_writers_in_other_processes():
+    workers = 4
+    count = 20000
+    shared = array.array('Q', range(count))
+    memory = mmap.mmap(-1, Int2Int.buffer_size_for(
+        2 * count, layout='concurrent'))
+    int2int_map = Int2Int.create_in(memory, 2 * count, layout='concurrent')
+
+    def write(worker):
+        # All writers set the same shared keys, own keys are set and
+        # deleted in turns
+        writer = Int2Int.from_buffer(memory)
+        own = array.array('Q', range(count + worker, 2 * count, workers))
+        for turn in range(10):
+            writer.update_from_buffers(shared, shared)
+            writer.update_from_buffers(own, own)
+            for key in own[turn % 2::2]:
+                del writer[key]
+
+    context = multiprocessing.get_context('fork')
+    processes = [
+        context.Process(target=write, args=(worker,))
+        for worker in range(workers)]
+    for process in processes:
+        process.start()
+    for process in processes:
+        process.join()
+
+    assert all(process.exitcode == 0 for process in processes)
+    expected = {key: key for key in shared}
+    for worker in range(workers):
+        own = range(count + worker, 2 * count, workers)
+        expected.update((key, key) for key in own[0::2])
+    assert len(int2int_map) == len(expected)
+    assert dict(int2int_map) == expected
+
+
+def test_int2int_concurrent_churn_when_writers_in_other_processes():
+    workers = 4
+    count = 20000
+    memory = mmap.mmap(-1, Int2Int.buffer_size_for(
+        count, layout='concurrent'))
+    int2int_map = Int2Int.create_in(memory, count, layout='concurrent')
+
+    def churn(worker):
+        # Each distinct key keeps its slot after del until clear()
+        writer = Int2Int.from_buffer(memory)
+        for key in range(1 + worker, count + 1, workers):
+            writer[key] = key
+            del writer[key]
+
+    context = multiprocessing.get_context('fork')
+    processes = [
+        context.Process(target=churn, args=(worker,))
+        for worker in range(workers)]
+    for process in processes:
+        process.start()
+    for process in processes:
+        process.join()
+
+    assert all(process.exitcode == 0 for process in processes)
+    assert len(int2int_map) == 0
+    assert _Int2IntHashTable_t.from_buffer(memory).claimed == count
+    with pytest.raises(RuntimeError, match='deleted keys keep their slots'):
+        int2int_map[count + 1] = 1
+    int2int_map[1] = 2
+    int2int_map[0] = 3
+    assert dict(int2int_map) == {0: 3, 1: 2}
+
+    int2int_map.clear()
+    assert _Int2IntHashTable_t.from_buffer(memory).claimed == 0
+    int2int_map[count + 1] = 1
+    assert dict(int2int_map) == {count + 1: 1}
+
+
+def test_int2int_concurrent_churn():
+    int2int_map = Int2Int(layout='concurrent', prealloc_size=8)
+    for key in range(1, 9):
+        int2int_map[key] = key
+        del int2int_map[key]
+
+    with pytest.raises(RuntimeError, match='deleted keys keep their slots'):
+        int2int_map[9] = 9
+    with pytest.raises(RuntimeError, match='deleted keys keep their slots'):
+        int2int_map.add(9, 1)
+    with pytest.raises(RuntimeError, match='deleted keys keep their slots'):
+        int2int_map.update_from_buffers(array.array('Q', [8, 9]))
+    assert dict(int2int_map) == {8: 0}
+
+    other_map = pickle.loads(pickle.dumps(int2int_map))
+    with pytest.raises(RuntimeError, match='deleted keys keep their slots'):
+        other_map[9] = 9
+    other_map.clear()
+    other_map[9] = 9
+    assert dict(other_map) == {9: 9}
+
+
+def test_int2int_concurrent_waits_for_writer_in_other_process():
+    memory = mmap.mmap(-1, Int2Int.buffer_size_for(8, layout='concurrent'))
+    int2int_map = Int2Int.create_in(memory, 8, layout='concurrent')
+    table_size = _Int2IntHashTable_t.from_buffer(memory).table_size
+    # This process inserts the key 0, its item is PENDING
+    status = INT2INT_HEADER_SIZE + table_size * 24 + 16
+    struct.pack_into('iI', memory, status, 3, os.getpid())
+
+    def write():
+        Int2Int.from_buffer(memory)[0] = 5
+
+    process = multiprocessing.get_context('fork').Process(target=write)
+    process.start()
+    process.join(0.5)
+    assert process.is_alive()
+    struct.pack_into('iI', memory, status, 0, 0)
+    process.join()
+
+    assert process.exitcode == 0
+    assert dict(int2int_map) == {0: 5}
+
+
+def test_int2int_concurrent_fail_when_writer_crashed():
+    buffer = bytearray(Int2Int.buffer_size_for(8, layout='concurrent'))
+    int2int_map = Int2Int.create_in(buffer, 8, layout='concurrent')
+    table_size = _Int2IntHashTable_t.from_buffer(buffer).table_size
+    process = multiprocessing.get_context('fork').Process(target=os.getpid)
+    process.start()
+    process.join()
+    # Writer crashed in the insert of the key 0, its item stays PENDING
+    status = INT2INT_HEADER_SIZE + table_size * 24 + 16
+    struct.pack_into('iI', buffer, status, 3, process.pid)
+
+    with pytest.raises(RuntimeError, match='locked by a writer'):
+        int2int_map[0] = 1
+    with pytest.raises(RuntimeError, match='locked by a writer'):
+        int2int_map.add(0, 1)
+    assert 0 not in int2int_map
+    int2int_map[1] = 2
+    assert dict(int2int_map) == {1: 2}
+
+
+def test_int2int_concurrent_add_when_writers_in_other_processes():
+    workers = 4
+    turns = 20
+    keys = array.array('Q', (key % 5000 for key in range(20000)))
+    memory = mmap.mmap(-1, Int2Int.buffer_size_for(
+        5000, layout='concurrent'))
+    int2int_map = Int2Int.create_in(memory, 5000, layout='concurrent')
+
+    def count(worker):
+        # Writers insert the same keys at once, increments must not be lost
+        writer = Int2Int.from_buffer(memory)
+        deltas = array.array('Q', [worker + 1] * len(keys))
+        for turn in range(turns):
+            writer.add_many(keys, deltas)
+
+    context = multiprocessing.get_context('fork')
+    processes = [
+        context.Process(target=count, args=(worker,))
+        for worker in range(workers)]
+    for process in processes:
+        process.start()
+    for process in processes:
+        process.join()
+
+    assert all(process.exitcode == 0 for process in processes)
+    total = 4 * turns * sum(range(1, workers + 1))
+    assert len(int2int_map) == 5000
+    assert dict(int2int_map) == {key: total for key in range(5000)}
+
+
+def test_int2int_concurrent_when_more_writers_than_cpus():
+    workers = 2 * os.cpu_count() + 2
+    turns = 5
+    memory = mmap.mmap(-1, Int2Int.buffer_size_for(
+        turns * 1000, layout='concurrent'))
+    int2int_map = Int2Int.create_in(memory, turns * 1000, layout='concurrent')
+
+    def count(worker):
+        # Preempted writers hold PENDING items which others wait for
+        writer = Int2Int.from_buffer(memory)
+        for turn in range(turns):
+            keys = array.array('Q', range(turn * 1000, (turn + 1) * 1000))
+            writer.add_many(keys, array.array('Q', [1] * len(keys)))
+
+    context = multiprocessing.get_context('fork')
+    processes = [
+        context.Process(target=count, args=(worker,))
+        for worker in range(workers)]
+    for process in processes:
+        process.start()
+    for process in processes:
+        process.join()
+
+    assert all(process.exitcode == 0 for process in processes)
+    assert dict(int2int_map) == {
+        key: workers for key in range(turns * 1000)}
+
+
+def test_int2int_create_in_pickle_dumps_loads():
+    buffer = bytearray(Int2Int.buffer_size_for(2))
+    int2int_map = Int2Int.create_in(buffer, 2)
+    int2int_map[1] = 2
+
+    other_map = pickle.loads(pickle.dumps(int2int_map))
+    other_map.update({3: 4, 5: 6})
+
+    assert dict(other_map) == {1: 2, 3: 4, 5: 6}
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+def test_int2int_save_open(tmp_path, layout):
+    int2int_map = Int2Int(layout=layout)
+    for key in range(1000):
+        int2int_map[key] = key * 3
+    int2int_map.save(tmp_path / 'map')
+
+    other_map = Int2Int.open(tmp_path / 'map', verify=True)
+
+    assert other_map.readonly
+    assert other_map.layout == layout
+    assert dict(other_map) == dict(int2int_map)
+    assert not int2int_map.readonly
+    with pytest.raises(RuntimeError, match='Instance is read-only'):
+        other_map[1] = 2
+
+
+def test_int2int_save_open_when_frozen(tmp_path):
+    int2int_map = Int2Int()
+    int2int_map.update({1: 2, 3: 4})
+    int2int_map.freeze()
+    int2int_map.save(str(tmp_path / 'map'))
+
+    other_map = Int2Int.open(str(tmp_path / 'map'), verify=True)
+
+    assert other_map.layout == 'cuckoo'
+    assert dict(other_map) == {1: 2, 3: 4}
+
+
+def test_int2int_save_when_migrating(tmp_path):
+    int2int_map = Int2Int(incremental_resize=True)
+    for key in range(1000):
+        int2int_map[key] = key + 1
+    int2int_map.save(tmp_path / 'map')
+
+    other_map = Int2Int.open(tmp_path / 'map')
+
+    assert dict(other_map) == {key: key + 1 for key in range(1000)}
+
+
+def test_int2int_save_replaces_file(tmp_path):
+    Int2Int({1: 2}).save(tmp_path / 'map')
+    int2int_map = Int2Int.open(tmp_path / 'map')
+
+    Int2Int({3: 4}).save(tmp_path / 'map')
+
+    assert dict(int2int_map) == {1: 2}
+    assert dict(Int2Int.open(tmp_path / 'map')) == {3: 4}
+    assert [path.name for path in tmp_path.iterdir()] == ['map']
+
+
+def test_int2int_open_in_place(tmp_path):
+    Int2Int({1: 2}, prealloc_size=2).save(tmp_path / 'map')
+
+    int2int_map = Int2Int.open(tmp_path / 'map', 'r+', default=0)
+    int2int_map[3] = 4
+    with pytest.raises(RuntimeError, match='Instance is full'):
+        int2int_map[5] = 6
+    del int2int_map
+
+    assert dict(Int2Int.open(tmp_path / 'map')) == {1: 2, 3: 4}
+    with pytest.raises(ValueError, match='Checksum of the file is unknown'):
+        Int2Int.open(tmp_path / 'map', verify=True)
+
+
+@pytest.mark.parametrize('mutate, verify, msg', [
+    (lambda data: b'', False, 'cannot mmap an empty file'),
+    (lambda data: data[:32], False, 'Unsupported format of the file'),
+    (lambda data: b'X' + data[1:], False, 'Unsupported format of the file'),
+    (lambda data: data[:-8], False, 'Unsupported format of the file'),
+    (lambda data: data[:-8] + b'\x01' * 8, False, None),
+    (lambda data: data[:-8] + b'\x01' * 8, True,
+     'Checksum of the file is wrong'),
+    (lambda data: data[:64] + bytes(len(data) - 64), False,
+     'Unsupported format of the table'),
+])
+def test_int2int_open_fail_when_invalid_file(tmp_path, mutate, verify, msg):
+    Int2Int({1: 2}).save(tmp_path / 'map')
+    data = (tmp_path / 'map').read_bytes()
+    (tmp_path / 'map').write_bytes(mutate(data))
+
+    if msg is None:
+        assert dict(Int2Int.open(tmp_path / 'map', verify=verify))
+    else:
+        with pytest.raises(ValueError, match=msg):
+            Int2Int.open(tmp_path / 'map', verify=verify)
+
+
+def test_int2int_open_fail_when_invalid_args(tmp_path):
+    Int2Int({1: 2}).save(tmp_path / 'map')
+
+    with pytest.raises(ValueError, match="'mode' must be 'r' or 'r\\+'"):
+        Int2Int.open(tmp_path / 'map', 'w')
+    with pytest.raises(TypeError, match="'default' must be positive int"):
+        Int2Int.open(tmp_path / 'map', default=-1)
+    with pytest.raises(FileNotFoundError):
+        Int2Int.open(tmp_path / 'other')
+
+
+class _ChunkedFile(io.RawIOBase):
+    """Raw file which records sizes of write() and readinto() calls."""
+
+    def __init__(self, data=b'', max_size=None):
+        self.data = bytearray(data)
+        self.position = 0
+        self.max_size = max_size
+        self.calls = []
+
+    def readable(self):
+        return True
+
+    def writable(self):
+        return True
+
+    def write(self, b):
+        self.calls.append(len(b))
+        size = min(len(b), self.max_size or len(b))
+        self.data += bytes(b[:size])
+        return size
+
+    def readinto(self, b):
+        self.calls.append(len(b))
+        size = min(len(b), self.max_size or len(b),
+                   len(self.data) - self.position)
+        b[:size] = self.data[self.position:self.position + size]
+        self.position += size
+        return size
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+@pytest.mark.parametrize('pairs', [False, True])
+def test_int2int_dump_load(layout, pairs):
+    int2int_map = Int2Int(
+        layout=layout, prealloc_size=1000, shrink_load=0.25, default=0)
+    for key in range(100):
+        int2int_map[key * 7] = key
+    stream = io.BytesIO()
+
+    int2int_map.dump(stream, pairs=pairs)
+    stream.seek(0)
+    new = Int2Int.load(stream, default=1)
+
+    assert len(stream.getvalue()) == 64 + (
+        ctypes.sizeof(_Int2IntHashTable_t) + 100 * 16 if pairs
+        else int2int_map.buffer_size)
+    assert new.layout == layout
+    assert new.shrink_load == 0.25
+    assert dict(new) == dict(int2int_map)
+    assert new[1] == 1
+
+
+def test_int2int_dump_load_when_frozen():
+    int2int_map = Int2Int({1: 2, 3: 4})
+    int2int_map.freeze()
+    stream = io.BytesIO()
+
+    int2int_map.dump(stream, pairs=True)
+    stream.seek(0)
+    new = Int2Int.load(stream)
+
+    assert new.readonly
+    assert new.layout == 'cuckoo'
+    assert dict(new) == {1: 2, 3: 4}
+
+
+def test_int2int_dump_load_by_chunks():
+    int2int_map = Int2Int.from_arrays(array.array('Q', range(100000)))
+    stream = _ChunkedFile(max_size=1000)
+
+    int2int_map.dump(stream)
+    stream.position = 0
+    stream.calls.clear()
+    new = Int2Int.load(stream)
+
+    assert new == int2int_map
+    assert max(stream.calls) == 1 << 20
+
+
+def test_int2int_dump_is_same_as_save(tmp_path):
+    int2int_map = Int2Int({1: 2, 3: 4})
+    stream = io.BytesIO()
+    int2int_map.dump(stream)
+    int2int_map.save(tmp_path / 'map')
+
+    assert stream.getvalue() == (tmp_path / 'map').read_bytes()
+    with open(tmp_path / 'map', 'rb') as f:
+        assert dict(Int2Int.load(f)) == {1: 2, 3: 4}
+
+
+def test_int2int_open_fail_when_pairs(tmp_path):
+    with open(tmp_path / 'map', 'wb') as f:
+        Int2Int({1: 2}).dump(f, pairs=True)
+
+    with pytest.raises(ValueError, match='it must be read by load'):
+        Int2Int.open(tmp_path / 'map')
+
+
+def test_int2int_dump_fail_when_changed_by_file():
+    int2int_map = Int2Int({1: 2})
+
+    class File(io.BytesIO):
+        def write(self, b):
+            int2int_map[3] = 4
+
+    with pytest.raises(BufferError, match='Existing exports of data'):
+        int2int_map.dump(File())
+    int2int_map[3] = 4
+
+
+@pytest.mark.parametrize('pairs', [False, True])
+@pytest.mark.parametrize('mutate, msg', [
+    (lambda data: data[:-1], 'Unexpected end of the stream'),
+    (lambda data: data[:40], 'Unexpected end of the stream'),
+    (lambda data: data[:-2] + bytes([data[-2] ^ 1]) + data[-1:],
+     'Checksum of the stream is wrong'),
+    (lambda data: b'X' + data[1:], 'Unsupported format of the stream'),
+    (lambda data: data[:12] + b'\x02' + data[13:],
+     'Unsupported format of the stream'),
+])
+def test_int2int_load_fail_when_invalid_stream(pairs, mutate, msg):
+    stream = io.BytesIO()
+    Int2Int({1: 2, 3: 4}).dump(stream, pairs=pairs)
+
+    with pytest.raises(ValueError, match=msg):
+        Int2Int.load(io.BytesIO(mutate(stream.getvalue())))
+
+
+def test_int2int_setdefault(int2int_map):
+    int2int_map[1] = 101
+    assert int2int_map.setdefault(1) == 101
+    assert len(int2int_map) == 1
+
+
+def test_int2int_setdefault_when_default(int2int_map):
+    int2int_map[1] = 101
+    assert int2int_map.setdefault(2, 102) == 102
+    assert len(int2int_map) == 2
+
+
+@pytest.mark.parametrize('default', [None, 'a'])
+def test_int2int_setdefault_when_invalid_default_type(int2int_map, default):
+    with pytest.raises(TypeError, match="'value' must be an integer"):
+        int2int_map.setdefault(1, default)
+
+
+def test_int2int_setdefault_fail_when_key_does_not_exist(int2int_map):
+    for i in range(1, 7, 1):
+        int2int_map[i] = 100 + i
+    with pytest.raises(KeyError, match="7"):
+        int2int_map.setdefault(7)
+
+
+def test_int2int_equal_when_empty():
+    a = Int2Int()
+    b = Int2Int()
+    assert a == b
+
+
+def test_int2int_equal_when_same_keys_and_values():
+    a = Int2Int()
+    b = Int2Int()
+    for i in range(1, 7, 1):
+        a[i] = 100 + i
+        b[i] = 100 + i
+    assert a == b
+
+
+def test_int2int_equal_with_dict_when_same_keys_and_values():
+    a = Int2Int()
+    b = {}
+    for i in range(1, 7, 1):
+        a[i] = 100 + i
+        b[i] = 100 + i
+    assert a == b
+
+
+def test_int2int_not_equal_when_same_size_same_keys_but_different_values():
+    a = Int2Int()
+    b = Int2Int()
+    for i in range(1, 7, 1):
+        a[i] = 100 + i
+        b[i] = 100 + i
+    b[6] = 200
+    assert a != b
+
+
+def test_int2int_not_equal_when_same_size_same_values_but_different_keys():
+    a = Int2Int()
+    b = Int2Int()
+    for i in range(1, 7, 1):
+        a[i] = 100 + i
+        b[i] = 100 + i
+    a[7] = 200
+    b[8] = 300
+    assert a != b
+
+
+def test_int2int_not_equal_when_different_size():
+    a = Int2Int()
+    b = Int2Int()
+    for i in range(1, 7, 1):
+        a[i] = 100 + i
+        b[i] = 100 + i
+    b[7] = 107
+    assert a != b
+
+
+@pytest.mark.parametrize(
+    'other', [1, 'a', [1, 2]])
+def test_int2int_eq_fail_when_invalid_other_object(int2int_map, other):
+    with pytest.raises(TypeError) as exc_info:
+        assert int2int_map == other
+    assert "'other' is not either an Int2Int or a dict" in str(exc_info)
+
+
+@pytest.mark.parametrize(
+    'op', [operator.lt, operator.le, operator.gt, operator.ge])
+def test_int2int_eq_fail_when_invalid_operator(int2int_map, op):
+    with pytest.raises(TypeError) as exc_info:
+        op(int2int_map, {})
+    assert 'is not supported' in str(exc_info)
+
+
+@pytest.mark.parametrize(
+    'args, exc, msg',
+    [
         [(-1, 8, 0, 10, False, b'\0'*24*10), TypeError, "'default' must be"],
         [('1', 8, 0, 10, False, b'\0'*24*10), TypeError, "'default' must be"],
         [(None, 8, 9, 10, False, b'\0'*24*10), ValueError, "Inconsistent"],
@@ -784,6 +2247,81 @@ def test_int2int_pickle_dumps_loads_when_default():
     assert set(new.values()) == {101, 102, 103, 104, 105, 0}
 
 
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+def test_int2int_pickle_protocol_5_out_of_band(layout):
+    int2int_map = Int2Int({1: 2, 3: 4}, layout=layout, default=0)
+    buffers = []
+
+    data = pickle.dumps(
+        int2int_map, protocol=5, buffer_callback=buffers.append)
+
+    assert len(buffers) == 1
+    assert buffers[0].raw().nbytes == int2int_map.buffer_size
+    with pytest.raises(BufferError, match='Existing exports of data'):
+        int2int_map[5] = 6
+    new = pickle.loads(data, buffers=buffers)
+    del buffers
+    int2int_map[5] = 6
+    new[7] = 8
+    assert new.layout == layout
+    assert dict(new) == {1: 2, 3: 4, 7: 8}
+    assert dict(int2int_map) == {1: 2, 3: 4, 5: 6}
+
+
+def test_int2int_pickle_protocol_5_when_migrating():
+    int2int_map = Int2Int(incremental_resize=True)
+    for i in range(1000):
+        int2int_map[i] = i + 1
+
+    new = pickle.loads(pickle.dumps(int2int_map, protocol=5))
+
+    assert dict(new) == {i: i + 1 for i in range(1000)}
+
+
+@pytest.mark.parametrize('frozen', [False, True])
+def test_int2int_pickle_protocol_5_readonly_is_not_copied(frozen):
+    int2int_map = Int2Int({1: 2, 3: 4})
+    if frozen:
+        int2int_map.freeze()
+    else:
+        int2int_map.make_readonly()
+    buffers = []
+
+    data = pickle.dumps(
+        int2int_map, protocol=5, buffer_callback=buffers.append)
+    new = pickle.loads(data, buffers=buffers)
+
+    assert new.readonly
+    assert new.buffer_ptr == int2int_map.buffer_ptr
+    assert dict(new) == {1: 2, 3: 4}
+    if not frozen:
+        with pytest.raises(RuntimeError, match='Instance has fixed size'):
+            new.freeze()
+
+
+def test_int2int_pickle_protocol_5_readonly_in_band():
+    int2int_map = Int2Int({1: 2, 3: 4})
+    int2int_map.freeze()
+
+    new = pickle.loads(pickle.dumps(int2int_map, protocol=5))
+
+    assert new.readonly
+    assert new.layout == 'cuckoo'
+    assert dict(new) == {1: 2, 3: 4}
+
+
+def test_int2int_from_raw_data_fail_when_block_is_inconsistent():
+    int2int_map = Int2Int({1: 2})
+    int2int_map.make_readonly()
+    _, args = int2int_map.__reduce_ex__(5)
+    block = bytes(args[5].raw())
+
+    with pytest.raises(ValueError, match='Inconsistent'):
+        Int2Int._from_raw_data(*args[:5], block[:-8], *args[6:])
+    with pytest.raises(ValueError, match='Inconsistent'):
+        Int2Int._from_raw_data(None, 100, *args[2:5], block, *args[6:])
+
+
 def test_int2int_readonly_flag_is_false(int2int_map):
     assert int2int_map.readonly is False
 
@@ -793,6 +2331,593 @@ def test_int2int_readonly_flag_is_true(int2int_map):
     assert int2int_map.readonly is True
 
 
+def test_int2int_incremental_resize_setitem_delitem_random_keys():
+    int2int_map = Int2Int(incremental_resize=True)
+    rnd = random.Random(0)
+    expected = {}
+
+    for i in range(20000):
+        key = rnd.randrange(5000)
+        if rnd.random() < 0.3 and key in expected:
+            del int2int_map[key]
+            del expected[key]
+        else:
+            int2int_map[key] = i
+            expected[key] = i
+        if i % 1000 == 0:
+            assert len(int2int_map) == len(expected)
+            assert dict(int2int_map.items()) == expected
+
+    assert len(int2int_map) == len(expected)
+    assert dict(int2int_map.items()) == expected
+    for key in range(5000):
+        assert int2int_map.get(key) == expected.get(key)
+
+
+def test_int2int_incremental_resize_during_migration():
+    int2int_map = Int2Int(prealloc_size=1024, incremental_resize=True)
+    for i in range(1025):
+        int2int_map[i] = i
+
+    # Previous table is migrated by following set/del calls, items of both
+    # tables are visible meanwhile
+    assert len(int2int_map) == 1025
+    assert all(int2int_map[i] == i for i in range(1025))
+    int2int_map[1000] = 0
+    del int2int_map[999]
+    assert int2int_map[1000] == 0
+    assert 999 not in int2int_map
+    assert sorted(int2int_map) == [i for i in range(1025) if i != 999]
+
+    new = pickle.loads(pickle.dumps(int2int_map))
+    assert new == int2int_map
+    new[5000] = 5000
+    assert len(new) == 1025
+
+    int2int_map.clear()
+    assert len(int2int_map) == 0
+    assert list(int2int_map) == []
+
+
+def test_int2int_incremental_resize_buffer_ptr_finishes_migration():
+    int2int_map = Int2Int(prealloc_size=8, incremental_resize=True)
+    for i in range(9):
+        int2int_map[i] = i
+
+    t = _Int2IntHashTable_t.from_address(int2int_map.buffer_ptr)
+
+    assert t.flags == 1
+    assert t.previous is None
+    assert Int2Int.from_ptr(int2int_map.buffer_ptr) == {i: i for i in range(9)}
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+def test_int2int_grow_in_place_keeps_items(layout):
+    int2int_map = Int2Int(layout=layout)
+    rnd = random.Random(0)
+    expected = {}
+
+    for key in [0] + [rnd.randrange(2 ** 64) for unused in range(5000)]:
+        int2int_map[key] = key % 1000
+        expected[key] = key % 1000
+        # Deleted slots must not survive the resize
+        if rnd.random() < 0.2:
+            del int2int_map[key]
+            del expected[key]
+        if len(expected) % 500 == 0:
+            assert dict(int2int_map.items()) == expected
+
+    assert len(int2int_map) == len(expected)
+    assert dict(int2int_map.items()) == expected
+    for key, value in expected.items():
+        assert int2int_map[key] == value
+
+
+def test_int2int_max_load_and_growth_defaults(int2int_map):
+    assert int2int_map.max_load == pytest.approx(1 / 1.2)
+    assert int2int_map.growth == 2.0
+
+
+def test_int2int_max_load_kwarg():
+    int2int_map = Int2Int(prealloc_size=100, max_load=0.5)
+    t = _Int2IntHashTable_t.from_address(int2int_map.buffer_ptr)
+
+    assert int2int_map.max_load == 0.5
+    assert t.max_load == 0.5
+    assert t.size == 100
+    assert t.table_size == 256
+
+
+def test_int2int_growth_kwarg():
+    int2int_map = Int2Int(prealloc_size=100, growth=1.5)
+    t = _Int2IntHashTable_t.from_address(int2int_map.buffer_ptr)
+
+    for key in range(100):
+        int2int_map[key] = key
+    assert t.size == 100
+    int2int_map[100] = 100
+    t = _Int2IntHashTable_t.from_address(int2int_map.buffer_ptr)
+    assert t.size == 150
+    assert t.growth == 1.5
+
+
+@pytest.mark.parametrize(
+    'kwargs, msg',
+    [
+        ({'max_load': 0.0}, "'max_load' must be greater than 0"),
+        ({'max_load': -0.5}, "'max_load' must be greater than 0"),
+        ({'max_load': 1.5}, "'max_load' must be .* at most 1"),
+        ({'growth': 1.0}, "'growth' must be greater than 1"),
+        ({'growth': 0.5}, "'growth' must be greater than 1"),
+    ]
+)
+def test_int2int_new_fail_when_invalid_max_load_or_growth(kwargs, msg):
+    with pytest.raises(ValueError, match=msg):
+        Int2Int(**kwargs)
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+@pytest.mark.parametrize('max_load, growth', [(1.0, 1.1), (0.5, 3.0)])
+def test_int2int_max_load_and_growth_random_keys(layout, max_load, growth):
+    int2int_map = Int2Int(layout=layout, max_load=max_load, growth=growth)
+    rnd = random.Random(0)
+    expected = {}
+
+    for unused in range(5000):
+        key = rnd.randrange(3000)
+        if rnd.random() < 0.3 and key in expected:
+            del int2int_map[key]
+            del expected[key]
+        else:
+            int2int_map[key] = key + 1
+            expected[key] = key + 1
+
+    t = _Int2IntHashTable_t.from_address(int2int_map.buffer_ptr)
+    assert t.size <= t.table_size * max_load
+    assert dict(int2int_map.items()) == expected
+
+
+def test_int2int_max_load_and_growth_pickle_and_from_ptr():
+    int2int_map = Int2Int({1: 2}, max_load=0.5, growth=1.25)
+
+    new = pickle.loads(pickle.dumps(int2int_map))
+    assert new == int2int_map
+    assert new.max_load == 0.5
+    assert new.growth == 1.25
+    assert new.buffer_size == int2int_map.buffer_size
+
+    shared = Int2Int.from_ptr(int2int_map.buffer_ptr)
+    assert shared.max_load == 0.5
+    assert shared.growth == 1.25
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+def test_int2int_shrink_to_fit(layout):
+    int2int_map = Int2Int(((i, i + 1) for i in range(10000)), layout=layout)
+    buffer_size = int2int_map.buffer_size
+
+    for key in range(100, 10000):
+        del int2int_map[key]
+    assert int2int_map.buffer_size == buffer_size
+    int2int_map.shrink_to_fit()
+
+    t = _Int2IntHashTable_t.from_address(int2int_map.buffer_ptr)
+    assert t.size == 100
+    assert int2int_map.buffer_size < buffer_size / 50
+    assert dict(int2int_map.items()) == {i: i + 1 for i in range(100)}
+    int2int_map[100] = 101
+    assert int2int_map[100] == 101
+
+
+def test_int2int_shrink_to_fit_fail_when_readonly(int2int_map):
+    int2int_map.make_readonly()
+    with pytest.raises(RuntimeError, match="Instance is read-only"):
+        int2int_map.shrink_to_fit()
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+def test_int2int_shrink_load_kwarg(layout):
+    int2int_map = Int2Int(layout=layout, shrink_load=0.25)
+    for key in range(10000):
+        int2int_map[key] = key + 1
+    buffer_size = int2int_map.buffer_size
+
+    for key in range(10, 10000):
+        del int2int_map[key]
+    assert int2int_map.shrink_load == 0.25
+    assert int2int_map.buffer_size < buffer_size / 50
+    assert dict(int2int_map.items()) == {i: i + 1 for i in range(10)}
+
+    assert int2int_map.pop(0) == 1
+    assert int2int_map.popitem() in {(i, i + 1) for i in range(1, 10)}
+    assert len(int2int_map) == 8
+
+    new = pickle.loads(pickle.dumps(int2int_map))
+    assert new.shrink_load == 0.25
+    assert new == int2int_map
+
+
+@pytest.mark.parametrize('shrink_load', [-0.1, 1.0])
+def test_int2int_new_fail_when_invalid_shrink_load(shrink_load):
+    with pytest.raises(ValueError, match="'shrink_load' must be at least 0"):
+        Int2Int(shrink_load=shrink_load)
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+@pytest.mark.parametrize('count', [0, 1, 7, 1000, 50000])
+def test_int2int_freeze(layout, count):
+    rnd = random.Random(count)
+    expected = {rnd.randrange(2 ** 64): i for i in range(count)}
+    expected[0] = 1
+    int2int_map = Int2Int(expected, layout=layout)
+
+    int2int_map.freeze()
+
+    assert int2int_map.layout == 'cuckoo'
+    assert int2int_map.readonly is True
+    assert len(int2int_map) == len(expected)
+    assert dict(int2int_map.items()) == expected
+    for key, value in expected.items():
+        assert int2int_map[key] == value
+    for unused in range(1000):
+        key = rnd.randrange(1, 2 ** 64)
+        assert (key in int2int_map) == (key in expected)
+
+
+def test_int2int_freeze_table_size():
+    int2int_map = Int2Int((i, i) for i in range(900))
+    int2int_map.freeze()
+
+    t = _Int2IntHashTable_t.from_address(int2int_map.buffer_ptr)
+    assert t.size == 900
+    assert t.table_size == 1024
+    assert int2int_map.buffer_size == INT2INT_HEADER_SIZE + 1025 * 16
+
+
+def test_int2int_freeze_twice_keeps_table(int2int_map):
+    int2int_map[1] = 2
+    int2int_map.freeze()
+    buffer_ptr = int2int_map.buffer_ptr
+
+    int2int_map.freeze()
+
+    assert int2int_map.buffer_ptr == buffer_ptr
+    assert dict(int2int_map) == {1: 2}
+
+
+@pytest.mark.parametrize(
+    'modify',
+    [
+        lambda m: m.__setitem__(1, 1),
+        lambda m: m.__delitem__(1),
+        lambda m: m.pop(1),
+        lambda m: m.popitem(),
+        lambda m: m.clear(),
+        lambda m: m.shrink_to_fit(),
+    ]
+)
+def test_int2int_freeze_is_readonly(modify):
+    int2int_map = Int2Int({1: 2, 3: 4})
+    int2int_map.freeze()
+
+    with pytest.raises(RuntimeError, match="Instance is read-only"):
+        modify(int2int_map)
+    assert dict(int2int_map) == {1: 2, 3: 4}
+
+
+def test_int2int_freeze_from_ptr_and_pickle():
+    expected = {i * 7919: i for i in range(1000)}
+    int2int_map = Int2Int(expected)
+    int2int_map.freeze()
+
+    shared = Int2Int.from_ptr(int2int_map.buffer_ptr)
+    assert shared.layout == 'cuckoo'
+    assert dict(shared) == expected
+
+    new = pickle.loads(pickle.dumps(int2int_map))
+    assert new.layout == 'cuckoo'
+    assert new.readonly is True
+    assert dict(new) == expected
+
+
+@pytest.mark.parametrize('frozen', [False, True])
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+@pytest.mark.parametrize('count', [0, 1, 15, 16, 17, 5000])
+def test_int2int_get_many(layout, frozen, count):
+    rnd = random.Random(count)
+    expected = {rnd.randrange(2 ** 64): i for i in range(count)}
+    expected[0] = 7
+    int2int_map = Int2Int(expected, layout=layout)
+    if frozen:
+        int2int_map.freeze()
+    keys = [k for k in expected] + [rnd.randrange(1, 2 ** 64)
+                                    for unused in range(count)]
+    rnd.shuffle(keys)
+
+    count, values, found = _get_many(
+        _hashmap_lib.int2int_get_many, int2int_map.buffer_ptr, keys,
+        ctypes.c_size_t)
+
+    assert count == len(expected)
+    for key, value, is_found in zip(keys, values, found):
+        assert is_found == (key in expected)
+        if is_found:
+            assert value == expected[key]
+
+
+def test_int2int_get_many_when_migrating():
+    int2int_map = Int2Int(incremental_resize=True)
+    for i in range(1000):
+        int2int_map[i] = i + 1
+
+    count, values, found = _get_many(
+        _hashmap_lib.int2int_get_many, int2int_map.buffer_ptr,
+        list(range(2000)), ctypes.c_size_t)
+
+    assert count == 1000
+    assert values[:1000] == list(range(1, 1001))
+    assert found == [True] * 1000 + [False] * 1000
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+@pytest.mark.parametrize('count', [0, 1, 17, 5000])
+def test_int2int_set_many(layout, count):
+    rnd = random.Random(count)
+    initial = {rnd.randrange(2 ** 64): i for i in range(count)}
+    keys = [rnd.randrange(2 ** 64) for unused in range(count)]
+    keys += rnd.sample(list(initial), k=count // 2) + [0]
+    values = list(range(len(keys)))
+    expected = dict(initial)
+    expected.update(zip(keys, values))
+
+    res, inserted, items, unused = _set_many(
+        'int2int', layout, initial, keys, values, ctypes.c_size_t)
+
+    assert res == 0
+    assert inserted == len(expected) - len(initial)
+    assert items == expected
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+def test_int2int_set_many_sizes_table_for_final_count(layout):
+    initial = {key: key for key in range(1, 6)}
+    keys = list(range(1, 10001))
+
+    res, inserted, items, size = _set_many(
+        'int2int', layout, initial, keys, keys, ctypes.c_size_t)
+
+    assert res == 0
+    assert inserted == 9995
+    assert items == {key: key for key in keys}
+    # Table is grown once for current size plus all keys
+    assert size == 10005
+
+
+def test_int2int_set_many_fail_when_readonly():
+    int2int_map = Int2Int({1: 1})
+    int2int_map.make_readonly()
+    ctx = ctypes.c_void_p(int2int_map.buffer_ptr)
+    inserted = ctypes.c_size_t(7)
+
+    res = _hashmap_lib.int2int_set_many(
+        ctx, (ctypes.c_ulonglong * 1)(2), (ctypes.c_size_t * 1)(2),
+        ctypes.c_size_t(1), ctypes.byref(ctx), ctypes.byref(inserted))
+
+    assert res == -1
+    assert inserted.value == 0
+    assert ctx.value == int2int_map.buffer_ptr
+    assert dict(int2int_map) == {1: 1}
+
+
+def test_int2int_new_fail_when_cuckoo_layout():
+    with pytest.raises(ValueError, match="created only by freeze"):
+        Int2Int(layout='cuckoo')
+
+
+def test_int2int_layout_is_items_by_default(int2int_map):
+    assert int2int_map.layout == 'items'
+
+
+def test_int2int_new_fail_when_unknown_layout():
+    with pytest.raises(ValueError, match="Unknown layout 'foo'"):
+        Int2Int(layout='foo')
+
+
+@pytest.mark.parametrize('layout', ['compact', 'soa'])
+@pytest.mark.parametrize('key', [0, 1, (2 ** 64) - 1])
+def test_int2int_sentinel_layout_setitem_getitem_delitem(layout, key):
+    int2int_map = Int2Int(layout=layout)
+
+    int2int_map[key] = 1
+    assert int2int_map[key] == 1
+    int2int_map[key] = 2
+    assert int2int_map[key] == 2
+    assert len(int2int_map) == 1
+    assert list(int2int_map.items()) == [(key, 2)]
+    del int2int_map[key]
+    assert key not in int2int_map
+    assert len(int2int_map) == 0
+
+
+@pytest.mark.parametrize('layout', ['compact', 'soa'])
+def test_int2int_sentinel_layout_setitem_delitem_random_keys(layout):
+    int2int_map = Int2Int(layout=layout)
+    rnd = random.Random(0)
+    expected = {}
+
+    for unused in range(20000):
+        key = rnd.randrange(2000)
+        if rnd.random() < 0.4 and key in expected:
+            del int2int_map[key]
+            del expected[key]
+        else:
+            int2int_map[key] = key + 1
+            expected[key] = int(key + 1)
+
+    assert int2int_map.layout == layout
+    assert len(int2int_map) == len(expected)
+    assert dict(int2int_map.items()) == expected
+    for key in range(2000):
+        assert (int2int_map.get(key) is not None) == (key in expected)
+
+
+@pytest.mark.parametrize('layout', ['compact', 'soa'])
+def test_int2int_sentinel_layout_buffer_size(layout):
+    int2int_map = Int2Int(prealloc_size=100, layout=layout)
+    header_size = INT2INT_HEADER_SIZE
+    # 128 keys and values of 8 bytes and extra slot for the key 0
+    assert int2int_map.buffer_size == header_size + 129 * 16
+
+
+@pytest.mark.parametrize('layout', ['compact', 'soa'])
+def test_int2int_sentinel_layout_clear_and_from_ptr(layout):
+    int2int_map = Int2Int({0: 100, 1: 101}, layout=layout)
+
+    int2int_new_map = Int2Int.from_ptr(int2int_map.buffer_ptr)
+    assert int2int_new_map == {0: 100, 1: 101}
+    int2int_new_map.clear()
+    assert len(int2int_map) == 0
+    assert 0 not in int2int_map
+
+
+def test_int2int_soa_keys_and_values_are_arrays():
+    int2int_map = Int2Int({0: 100, 5: 105, 7: 107}, layout='soa')
+    header_size = INT2INT_HEADER_SIZE
+    table_size = ctypes.c_size_t.from_address(
+        int2int_map.buffer_ptr + 2 * ctypes.sizeof(ctypes.c_size_t)).value
+
+    keys = (ctypes.c_ulonglong * (table_size + 1)).from_address(
+        int2int_map.buffer_ptr + header_size)
+    values = (ctypes.c_size_t * (table_size + 1)).from_address(
+        ctypes.addressof(keys) + ctypes.sizeof(keys))
+
+    assert sorted(k for k in keys[:table_size] if k) == [5, 7]
+    for idx, key in enumerate(keys[:table_size]):
+        if key:
+            assert values[idx] == 100 + key
+    assert values[table_size] == 100
+
+
+@pytest.mark.parametrize('layout', ['compact', 'soa'])
+def test_int2int_sentinel_layout_pickle_dumps_loads(layout):
+    int2int_map = Int2Int(layout=layout)
+    for i in range(100):
+        int2int_map[i] = 100 + i
+
+    new = pickle.loads(pickle.dumps(int2int_map))
+
+    assert new.layout == layout
+    assert new == int2int_map
+    assert new[0] == 100
+
+
+# Int2IntSwiss ----------------------------------------------------------------
+
+def _swiss_kernels():
+    kernels = []
+    for kernel in ('generic', 'sse2', 'avx2'):
+        try:
+            hashmap._set_swiss_kernel(kernel)
+        except ValueError:
+            continue
+        kernels.append(kernel)
+    hashmap._set_swiss_kernel('auto')
+    return kernels
+
+
+@pytest.fixture(scope='function', params=_swiss_kernels())
+def int2int_swiss_map(request):
+    hashmap._set_swiss_kernel(request.param)
+    yield Int2IntSwiss()
+    hashmap._set_swiss_kernel('auto')
+
+
+def test_int2int_swiss_new(int2int_swiss_map):
+    assert isinstance(int2int_swiss_map, Int2IntSwiss)
+    assert isinstance(int2int_swiss_map, Int2Int)
+    assert isinstance(int2int_swiss_map, collections.abc.MutableMapping)
+
+
+def test_int2int_swiss_set_kernel_fail_when_unknown_kernel():
+    with pytest.raises(ValueError, match="Unknown kernel 'neon'"):
+        hashmap._set_swiss_kernel('neon')
+
+
+@pytest.mark.parametrize('key', [0, (2 ** 64) - 1])
+def test_int2int_swiss_setitem_getitem(int2int_swiss_map, key):
+    int2int_swiss_map[key] = 1
+    assert int2int_swiss_map[key] == 1
+    int2int_swiss_map[key] = 2
+    assert int2int_swiss_map[key] == 2
+    assert len(int2int_swiss_map) == 1
+
+
+def test_int2int_swiss_setitem_delitem_random_keys(int2int_swiss_map):
+    rnd = random.Random(0)
+    expected = {}
+
+    for unused in range(20000):
+        key = rnd.randrange(2000)
+        if rnd.random() < 0.4 and key in expected:
+            del int2int_swiss_map[key]
+            del expected[key]
+        else:
+            int2int_swiss_map[key] = key + 1
+            expected[key] = (key + 1)
+
+    assert len(int2int_swiss_map) == len(expected)
+    assert dict(int2int_swiss_map.items()) == expected
+    assert int2int_swiss_map == expected
+    for key in range(2000):
+        assert (key in int2int_swiss_map) == (key in expected)
+
+
+def test_int2int_swiss_popitem_clear(int2int_swiss_map):
+    int2int_swiss_map.update({1: 101, 2: 102})
+
+    assert int2int_swiss_map.popitem() in {(1, 101), (2, 102)}
+    assert len(int2int_swiss_map) == 1
+    int2int_swiss_map.clear()
+    assert len(int2int_swiss_map) == 0
+    assert list(int2int_swiss_map) == []
+    int2int_swiss_map[3] = 103
+    assert dict(int2int_swiss_map) == {3: 103}
+
+
+def test_int2int_swiss_equal_to_int2int(int2int_swiss_map):
+    int2int_swiss_map.update({1: 101, 2: 102})
+    assert int2int_swiss_map == Int2Int({1: 101, 2: 102})
+    assert Int2Int({1: 101, 2: 102}) == int2int_swiss_map
+
+
+def test_int2int_swiss_from_ptr(int2int_swiss_map):
+    int2int_swiss_map[1] = 101
+
+    int2int_new_map = Int2IntSwiss.from_ptr(int2int_swiss_map.buffer_ptr)
+    int2int_new_map[2] = 102
+
+    assert int2int_swiss_map == {1: 101, 2: 102}
+
+
+def test_int2int_swiss_buffer_size():
+    int2int_swiss_map = Int2IntSwiss(prealloc_size=100)
+    # header, 128 + 16 control bytes, 128 slots
+    header_size = INT2INT_HEADER_SIZE
+    assert int2int_swiss_map.buffer_size == header_size + 128 + 16 + 128 * 16
+
+
+def test_int2int_swiss_pickle_dumps_loads(int2int_swiss_map):
+    for i in range(100):
+        int2int_swiss_map[i] = 100 + i
+
+    new = pickle.loads(pickle.dumps(int2int_swiss_map))
+
+    assert isinstance(new, Int2IntSwiss)
+    assert new == int2int_swiss_map
+    new[1000] = 1
+    assert new[1000] == 1
+
+
 # Int2Float -------------------------------------------------------------------
 
 @pytest.fixture(scope='function')
@@ -1003,29 +3128,82 @@ def test_int2float_setitem_more_items(int2float_map):
 
     t = Int2FloatHashTable_t.from_address(int2float_map.buffer_ptr)
 
-    assert int2float_map.buffer_size == (
-        ctypes.sizeof(Int2FloatHashTable_t)
-        + (ctypes.sizeof(Int2FloatItem_t) * t.table_size))
-    assert t.size == 8
-    assert t.current_size == 0
+    assert int2float_map.buffer_size == (
+        ctypes.sizeof(Int2FloatHashTable_t)
+        + (ctypes.sizeof(Int2FloatItem_t) * t.table_size))
+    assert t.size == 8
+    assert t.current_size == 0
+
+    for i in range(16):
+        int2float_map[i] = i + 100
+
+    t = Int2FloatHashTable_t.from_address(int2float_map.buffer_ptr)
+
+    assert int2float_map.buffer_size == (
+        ctypes.sizeof(Int2FloatHashTable_t)
+        + (ctypes.sizeof(Int2FloatItem_t) * t.table_size))
+    assert len(int2float_map) == 16
+    assert set(int2float_map.items()) == {
+        (0, 100.0), (1, 101.0), (2, 102.0), (3, 103.0),
+        (4, 104.0), (5, 105.0), (6, 106.0), (7, 107.0),
+        (8, 108.0), (9, 109.0), (10, 110.0), (11, 111.0),
+        (12, 112.0), (13, 113.0), (14, 114.0), (15, 115.0),
+    }
+    assert t.size == 16
+    assert t.current_size == 16
+
+
+def test_int2float_setitem_stores_probe_distance(int2float_map):
+
+    class Int2FloatItem_t(ctypes.Structure):
+
+        _fields_ = [
+            ('key', ctypes.c_ulonglong),
+            ('value', ctypes.c_double),
+            ('status', ctypes.c_int),
+            ('distance', ctypes.c_uint),
+        ]
+
+    class Int2FloatHashTable_t(ctypes.Structure):
+
+        _fields_ = [
+            ('size', ctypes.c_size_t),
+            ('current_size', ctypes.c_size_t),
+            ('table_size', ctypes.c_size_t),
+            ('readonly', ctypes.c_bool),
+        ]
+
+    for i in range(0, 1000, 7):
+        int2float_map[i] = i
+
+    t = Int2FloatHashTable_t.from_address(int2float_map.buffer_ptr)
+    table = (Int2FloatItem_t * t.table_size).from_address(
+        int2float_map.buffer_ptr + ctypes.sizeof(Int2FloatHashTable_t))
+    mask = t.table_size - 1
+
+    for idx, item in enumerate(table):
+        if item.status == 1:
+            home = _fmix64(item.key) & mask
+            assert item.distance == (idx - home) & mask
 
-    for i in range(16):
-        int2float_map[i] = i + 100
 
-    t = Int2FloatHashTable_t.from_address(int2float_map.buffer_ptr)
+def test_int2float_setitem_delitem_random_keys(int2float_map):
+    rnd = random.Random(0)
+    expected = {}
 
-    assert int2float_map.buffer_size == (
-        ctypes.sizeof(Int2FloatHashTable_t)
-        + (ctypes.sizeof(Int2FloatItem_t) * t.table_size))
-    assert len(int2float_map) == 16
-    assert set(int2float_map.items()) == {
-        (0, 100.0), (1, 101.0), (2, 102.0), (3, 103.0),
-        (4, 104.0), (5, 105.0), (6, 106.0), (7, 107.0),
-        (8, 108.0), (9, 109.0), (10, 110.0), (11, 111.0),
-        (12, 112.0), (13, 113.0), (14, 114.0), (15, 115.0),
-    }
-    assert t.size == 16
-    assert t.current_size == 16
+    for unused in range(20000):
+        key = rnd.randrange(2000)
+        if rnd.random() < 0.4 and key in expected:
+            del int2float_map[key]
+            del expected[key]
+        else:
+            int2float_map[key] = key + 1
+            expected[key] = float(key + 1)
+
+    assert len(int2float_map) == len(expected)
+    assert dict(int2float_map.items()) == expected
+    for key in range(2000):
+        assert (key in int2float_map) == (key in expected)
 
 
 def test_int2float_delitem(int2float_map):
@@ -1057,6 +3235,40 @@ def test_int2float_delitem(int2float_map):
     assert len(int2float_map) == 0
 
 
+def test_int2float_delitem_leaves_no_tombstones(int2float_map):
+
+    class Int2FloatItem_t(ctypes.Structure):
+
+        _fields_ = [
+            ('key', ctypes.c_ulonglong),
+            ('value', ctypes.c_double),
+            ('status', ctypes.c_int),
+            ('distance', ctypes.c_uint),
+        ]
+
+    class Int2FloatHashTable_t(ctypes.Structure):
+
+        _fields_ = [
+            ('size', ctypes.c_size_t),
+            ('current_size', ctypes.c_size_t),
+            ('table_size', ctypes.c_size_t),
+            ('readonly', ctypes.c_bool),
+        ]
+
+    for i in range(100):
+        int2float_map[i] = i
+    for i in range(0, 100, 3):
+        del int2float_map[i]
+    int2float_map.popitem()
+
+    t = Int2FloatHashTable_t.from_address(int2float_map.buffer_ptr)
+    table = (Int2FloatItem_t * t.table_size).from_address(
+        int2float_map.buffer_ptr + ctypes.sizeof(Int2FloatHashTable_t))
+
+    assert [item.status for item in table].count(1) == len(int2float_map)
+    assert [item.status for item in table].count(2) == 0
+
+
 def test_int2float_delitem_fail_when_key_does_not_exist(int2float_map):
     int2float_map[2] = 102
     with pytest.raises(KeyError, match='1'):
@@ -1198,6 +3410,56 @@ def test_int2float_get_fail_when_key_is_too_big(int2float_map):
     assert "int too big to convert" in str(exc_info)
 
 
+def test_int2float_get_many_array(int2float_map):
+    int2float_map.update({1: 1.5, 2: 2.5, 2 ** 64 - 1: 3.5})
+
+    res = int2float_map.get_many(array.array('Q', [2, 2 ** 64 - 1, 1, 2]))
+
+    assert isinstance(res, array.array)
+    assert list(res) == [2.5, 3.5, 1.5, 2.5]
+
+
+def test_int2float_get_many_out_and_found(int2float_map):
+    int2float_map.update({1: 1.5, 2: 2.5})
+    out = array.array('d', [7.0, 7.0, 7.0])
+    found = bytearray(3)
+
+    res = int2float_map.get_many(
+        array.array('Q', [2, 3, 1]), out, found=found)
+
+    assert res is out
+    assert list(out) == [2.5, 7.0, 1.5]
+    assert list(found) == [1, 0, 1]
+
+
+@pytest.mark.parametrize('default', [5, 5.0])
+def test_int2float_get_many_when_key_does_not_exist_and_default(
+        int2float_map, default):
+    int2float_map.update({1: 1.5, 2: 2.5})
+
+    res = int2float_map.get_many(
+        array.array('Q', [2, 3, 1]), default=default)
+
+    assert list(res) == [2.5, 5.0, 1.5]
+
+
+def test_int2float_get_many_fail_when_key_does_not_exist(int2float_map):
+    int2float_map[1] = 1.5
+    with pytest.raises(KeyError, match='3'):
+        int2float_map.get_many(array.array('Q', [1, 3]))
+
+
+def test_int2float_get_many_fail_when_invalid_out_type(int2float_map):
+    with pytest.raises(TypeError, match="'out' must be a buffer of double"):
+        int2float_map.get_many(
+            array.array('Q', [1]), array.array('Q', [0]), default=0)
+
+
+def test_int2float_get_many_fail_when_invalid_default_type(int2float_map):
+    with pytest.raises(TypeError, match="'default' must be a float"):
+        int2float_map.get_many(array.array('Q', [1]), default='a')
+
+
 def test_int2float_contains_when_key_exists(int2float_map):
     int2float_map[2541265478] = 100
     assert 2541265478 in int2float_map
@@ -1237,6 +3499,86 @@ def test_int2float_from_ptr(int2float_map):
     assert int2float_new_map[2] == 102.0
 
 
+def test_int2float_new_table_size_is_power_of_two():
+    int2float_map = Int2Float(prealloc_size=1000)
+
+    class Int2FloatHashTable_t(ctypes.Structure):
+
+        _fields_ = [
+            ('size', ctypes.c_size_t),
+            ('current_size', ctypes.c_size_t),
+            ('table_size', ctypes.c_size_t),
+            ('readonly', ctypes.c_bool),
+            ('version', ctypes.c_ubyte),
+        ]
+
+    t = Int2FloatHashTable_t.from_address(int2float_map.buffer_ptr)
+
+    assert t.size == 1000
+    assert t.table_size == 2048
+    assert t.version == 1
+
+
+def _legacy_int2float_table(items):
+
+    class Int2FloatItem_t(ctypes.Structure):
+
+        _fields_ = [
+            ('key', ctypes.c_ulonglong),
+            ('value', ctypes.c_double),
+            ('status', ctypes.c_int),
+        ]
+
+    class LegacyInt2FloatHashTable_t(ctypes.Structure):
+
+        _fields_ = [
+            ('size', ctypes.c_size_t),
+            ('current_size', ctypes.c_size_t),
+            ('table_size', ctypes.c_size_t),
+            ('readonly', ctypes.c_bool),
+            ('table', Int2FloatItem_t * 10),
+        ]
+
+    legacy = LegacyInt2FloatHashTable_t(size=8, current_size=0, table_size=10)
+    for key, value in items:
+        idx = (97 * key) % 10
+        while legacy.table[idx].status:
+            idx = (idx + 1) % 10
+        legacy.table[idx] = Int2FloatItem_t(key, value, 1)
+        legacy.current_size += 1
+
+    return legacy
+
+
+def test_int2float_from_ptr_when_legacy_format():
+    # All keys have the same legacy hash, so they form one probe chain
+    legacy = _legacy_int2float_table(
+        [(1, 101.0), (11, 111.0), (21, 121.0)])
+
+    int2float_map = Int2Float.from_ptr(ctypes.addressof(legacy))
+    assert dict(int2float_map.items()) == {
+        1: 101.0, 11: 111.0, 21: 121.0}
+
+    int2float_map[31] = 131.0
+    del int2float_map[11]
+
+    assert dict(int2float_map.items()) == {
+        1: 101.0, 21: 121.0, 31: 131.0}
+    assert legacy.current_size == 3
+
+
+def test_int2float_from_raw_data_when_legacy_format():
+    legacy = _legacy_int2float_table(
+        [(1, 101.0), (11, 111.0), (21, 121.0)])
+
+    int2float_map = Int2Float._from_raw_data(
+        None, 8, 3, 10, False, bytes(legacy.table))
+
+    assert dict(int2float_map.items()) == {
+        1: 101.0, 11: 111.0, 21: 121.0}
+    assert len(int2float_map) == 3
+
+
 def test_int2float_iter_when_empty(int2float_map):
     assert set(int2float_map) == set()
 
@@ -1285,6 +3627,79 @@ def test_int2float_items(int2float_map):
         (4, 104.0), (5, 105.0), (6, 106.0)}
 
 
+@pytest.mark.parametrize('layout', ['items', 'compact', 'soa'])
+def test_int2float_items_arrays(layout):
+    rnd = random.Random(1)
+    expected = {rnd.randrange(2 ** 64): i / 3 for i in range(1000)}
+    expected[0] = 0.5
+    int2float_map = Int2Float(expected, layout=layout)
+
+    keys, values = int2float_map.items_arrays()
+
+    assert values.typecode == 'd'
+    assert list(keys) == list(int2float_map.keys())
+    assert list(values) == list(int2float_map.values())
+    assert dict(zip(keys, values)) == expected
+    assert list(int2float_map.keys_array()) == list(keys)
+    assert list(int2float_map.values_array()) == list(values)
+
+
+def test_int2float_items_arrays_out(int2float_map):
+    int2float_map.update({1: 1.5, 2: 2.5})
+    values_out = array.array('d', [0.0, 0.0])
+
+    keys, values = int2float_map.items_arrays(values_out=values_out)
+
+    assert values is values_out
+    assert dict(zip(keys, values)) == {1: 1.5, 2: 2.5}
+
+
+def test_int2float_items_arrays_fail_when_invalid_out(int2float_map):
+    int2float_map[1] = 1.5
+    with pytest.raises(TypeError, match="'out' must be a buffer of double"):
+        int2float_map.values_array(array.array('Q', [0]))
+
+
+@pytest.mark.parametrize('layout', ['items', 'compact'])
+def test_int2float_buffer_protocol(layout):
+    expected = {i * 7 + 1: i / 3 for i in range(100)}
+    int2float_map = Int2Float(expected, layout=layout)
+
+    with memoryview(int2float_map) as view:
+        assert view.readonly
+        if layout == 'items':
+            assert view.format == 'T{Q:key:d:value:I:status:I:distance:}'
+            items = {
+                key: value
+                for key, value, status, unused in struct.iter_unpack(
+                    'QdII', view.cast('B'))
+                if status == 1}
+        else:
+            assert view.format == 'T{Q:key:d:value:}'
+            items = {
+                key: value
+                for key, value in struct.iter_unpack('Qd', view.cast('B'))
+                if key}
+
+    assert items == expected
+
+
+def test_int2float_buffer_protocol_pins_table(int2float_map):
+    int2float_map[1] = 1.5
+
+    with memoryview(int2float_map):
+        with pytest.raises(BufferError, match='Existing exports'):
+            int2float_map[2] = 2.5
+
+    int2float_map[2] = 2.5
+    assert dict(int2float_map) == {1: 1.5, 2: 2.5}
+
+
+def test_int2float_buffer_protocol_fail_when_soa_layout():
+    with pytest.raises(BufferError, match="Layout 'soa' can't be"):
+        memoryview(Int2Float(layout='soa'))
+
+
 def test_int2float_pop(int2float_map):
     for i in range(1, 7, 1):
         int2float_map[i] = 100 + i
@@ -1401,6 +3816,169 @@ def test_int2float_update_fail_when_invalid_value(
         int2float_map.update(other)
 
 
+@pytest.mark.parametrize('layout', ['items', 'compact', 'soa'])
+def test_int2float_update_from_buffers(layout):
+    int2float_map = Int2Float({1: 1.0, 2: 2.0}, layout=layout)
+    keys = array.array('Q', [2, 3])
+    values = array.array('d', [2.5, 3.5])
+
+    int2float_map.update_from_buffers(keys, values)
+
+    assert dict(int2float_map) == {1: 1.0, 2: 2.5, 3: 3.5}
+
+
+@pytest.mark.parametrize(
+    'values, exc, msg',
+    [
+        (array.array('Q', [1]), TypeError, "'values' must be a buffer"),
+        (array.array('d', [1, 2]), ValueError, "must have the same length"),
+    ]
+)
+def test_int2float_update_from_buffers_fail_when_invalid_values(
+        int2float_map, values, exc, msg):
+    with pytest.raises(exc, match=msg):
+        int2float_map.update_from_buffers(array.array('Q', [1]), values)
+
+
+@pytest.mark.parametrize('layout', ['items', 'compact', 'soa'])
+def test_int2float_add(layout):
+    int2float_map = Int2Float({1: 1.5}, layout=layout)
+
+    assert int2float_map.add(1, 2) == 3.5
+    assert int2float_map.add(0, -0.5) == -0.5
+    assert int2float_map.add(0, 0.25) == -0.25
+    assert dict(int2float_map) == {0: -0.25, 1: 3.5}
+
+
+@pytest.mark.parametrize('layout', ['items', 'compact', 'soa'])
+def test_int2float_add_many(layout):
+    int2float_map = Int2Float(layout=layout)
+    keys = array.array('Q', [key % 100 for key in range(1000)])
+
+    int2float_map.add_many(keys, array.array('d', [0.5] * len(keys)))
+
+    assert dict(int2float_map) == {key: 5.0 for key in range(100)}
+
+
+@pytest.mark.parametrize('method, args, exc, msg', [
+    ('add', (1, '1'), TypeError, "'delta' must be a float"),
+    ('add_many', (array.array('Q', [1]), array.array('Q', [1])), TypeError,
+     "'deltas' must be a buffer of double"),
+    ('add_many', (array.array('Q', [1]), array.array('d', [1, 2])),
+     ValueError, "'deltas' must have the same length"),
+])
+def test_int2float_add_fail_when_invalid_args(
+        int2float_map, method, args, exc, msg):
+    with pytest.raises(exc, match=msg):
+        getattr(int2float_map, method)(*args)
+    assert len(int2float_map) == 0
+
+
+def test_int2float_min_max():
+    buffer = bytearray(Int2Float.buffer_size_for(10))
+    int2float_map = Int2Float.create_in(buffer, 10)
+    ctx = ctypes.c_void_p(int2float_map.buffer_ptr)
+    value = ctypes.c_double()
+
+    for function, key, operand, expected in [
+            ('int2float_min', 1, 0.5, 0.5), ('int2float_min', 1, 1.5, 0.5),
+            ('int2float_max', 2, -1.0, -1.0), ('int2float_max', 2, 2.5, 2.5)]:
+        assert getattr(_hashmap_lib, function)(
+            ctx, ctypes.c_ulonglong(key), ctypes.c_double(operand),
+            ctypes.byref(value), ctypes.byref(ctx)) == 0
+        assert value.value == expected
+    assert dict(int2float_map) == {1: 0.5, 2: 2.5}
+
+
+def test_int2float_from_arrays():
+    int2float_map = Int2Float.from_arrays(
+        array.array('Q', [1, 2]), array.array('d', [0.5, 1.5]),
+        layout='compact')
+
+    assert int2float_map.layout == 'compact'
+    assert dict(int2float_map) == {1: 0.5, 2: 1.5}
+
+
+@pytest.mark.parametrize('layout', ['items', 'compact', 'soa'])
+def test_int2float_create_in(layout):
+    size = Int2Float.buffer_size_for(3, layout=layout)
+    buffer = bytearray(size)
+    int2float_map = Int2Float.create_in(buffer, 3, default=1, layout=layout)
+    int2float_map.update({1: 0.5, 2: 1.5})
+
+    assert int2float_map.buffer_size == size
+    assert int2float_map[3] == 1.0
+    with pytest.raises(RuntimeError, match='Instance is full'):
+        int2float_map[4] = 2.5
+    with pytest.raises(RuntimeError, match='Instance has fixed size'):
+        int2float_map.shrink_to_fit()
+
+    other_map = Int2Float.from_buffer(buffer)
+
+    assert other_map.layout == layout
+    assert dict(other_map) == {1: 0.5, 2: 1.5, 3: 1.0}
+
+
+@pytest.mark.parametrize('args, kwargs, exc, msg', [
+    ((bytearray(100), 10), {}, ValueError, 'Buffer of 100 bytes is too small'),
+    ((bytearray(1024), 10), {'default': 'a'}, TypeError,
+     "'default' must be a float"),
+    ((bytearray(1024), 10), {'layout': 'swiss'}, ValueError,
+     "Layout 'swiss' is not supported"),
+])
+def test_int2float_create_in_fail_when_invalid_args(args, kwargs, exc, msg):
+    with pytest.raises(exc, match=msg):
+        Int2Float.create_in(*args, **kwargs)
+
+
+def test_int2float_from_buffer_fail_when_invalid_table():
+    with pytest.raises(ValueError, match='Unsupported format'):
+        Int2Float.from_buffer(bytearray(1024))
+
+
+@pytest.mark.parametrize('layout', ['items', 'compact', 'soa'])
+def test_int2float_save_open(tmp_path, layout):
+    int2float_map = Int2Float({1: 0.5, 2: 1.5}, layout=layout)
+    int2float_map.save(tmp_path / 'map')
+
+    other_map = Int2Float.open(tmp_path / 'map', verify=True)
+
+    assert other_map.readonly
+    assert other_map.layout == layout
+    assert dict(other_map) == {1: 0.5, 2: 1.5}
+
+
+def test_int2float_open_fail_when_int2int_file(tmp_path):
+    Int2Int({1: 2}).save(tmp_path / 'map')
+
+    with pytest.raises(ValueError, match='Unsupported format of the file'):
+        Int2Float.open(tmp_path / 'map')
+
+
+@pytest.mark.parametrize('layout', ['items', 'compact', 'soa'])
+@pytest.mark.parametrize('pairs', [False, True])
+def test_int2float_dump_load(layout, pairs):
+    int2float_map = Int2Float({1: 0.5, 2: 1.5}, layout=layout)
+    stream = io.BytesIO()
+
+    int2float_map.dump(stream, pairs=pairs)
+    stream.seek(0)
+    new = Int2Float.load(stream, default=1)
+
+    assert new.layout == layout
+    assert dict(new) == {1: 0.5, 2: 1.5}
+    assert new[3] == 1.0
+    assert isinstance(new[3], float)
+
+
+def test_int2float_load_fail_when_int2int_stream():
+    stream = io.BytesIO()
+    Int2Int({1: 2}).dump(stream)
+
+    with pytest.raises(ValueError, match='Unsupported format of the stream'):
+        Int2Float.load(io.BytesIO(stream.getvalue()))
+
+
 def test_int2float_setdefault(int2float_map):
     int2float_map[1] = 101
     assert int2float_map.setdefault(1) == 101.0
@@ -1507,6 +4085,8 @@ def test_int2float_eq_fail_when_invalid_operator(int2float_map, op):
         [(None, 11, 0, 10, False, b'\0'*24*10), ValueError, "Inconsistent"],
         [(None, 8, 0, 10, False, b'\0'*24*9), ValueError, "Inconsistent"],
         [(None, 8, 0, 10, False, b'\0'*24*11), ValueError, "Inconsistent"],
+        [(None, 8, 0, 10, False, b'\0'*24*10, 1, 0, False, False, 1.0),
+         ValueError, "Unsupported format"],
     ])
 def test_int2float_from_raw_data_fail_when_inconsistent_args(args, exc, msg):
     with pytest.raises(exc, match=msg):
@@ -1545,6 +4125,35 @@ def test_int2float_pickle_dumps_loads_when_default():
     assert set(new.values()) == {101.0, 102.0, 103.0, 104.0, 105.0, 0}
 
 
+def test_int2float_pickle_protocol_5_out_of_band():
+    int2float_map = Int2Float({1: 0.5, 2: 1.5}, layout='compact')
+    buffers = []
+
+    data = pickle.dumps(
+        int2float_map, protocol=5, buffer_callback=buffers.append)
+    new = pickle.loads(data, buffers=buffers)
+    new[3] = 2.5
+
+    assert len(buffers) == 1
+    assert new.layout == 'compact'
+    assert dict(new) == {1: 0.5, 2: 1.5, 3: 2.5}
+    assert dict(int2float_map) == {1: 0.5, 2: 1.5}
+
+
+def test_int2float_pickle_protocol_5_readonly_is_not_copied():
+    int2float_map = Int2Float({1: 0.5, 2: 1.5})
+    int2float_map.make_readonly()
+    buffers = []
+
+    data = pickle.dumps(
+        int2float_map, protocol=5, buffer_callback=buffers.append)
+    new = pickle.loads(data, buffers=buffers)
+
+    assert new.readonly
+    assert new.buffer_ptr == int2float_map.buffer_ptr
+    assert dict(new) == {1: 0.5, 2: 1.5}
+
+
 def test_int2float_readonly_flag_is_false(int2float_map):
     assert int2float_map.readonly is False
 
@@ -1552,3 +4161,372 @@ def test_int2float_readonly_flag_is_false(int2float_map):
 def test_int2float_readonly_flag_is_true(int2float_map):
     int2float_map.make_readonly()
     assert int2float_map.readonly is True
+
+
+@pytest.mark.parametrize('layout', ['items', 'compact', 'soa'])
+def test_int2float_grow_in_place_keeps_items(layout):
+    int2float_map = Int2Float(layout=layout)
+    rnd = random.Random(0)
+    expected = {}
+
+    for key in [0] + [rnd.randrange(2 ** 64) for unused in range(5000)]:
+        int2float_map[key] = key / 3
+        expected[key] = key / 3
+        # Deleted slots must not survive the resize
+        if rnd.random() < 0.2:
+            del int2float_map[key]
+            del expected[key]
+        if len(expected) % 500 == 0:
+            assert dict(int2float_map.items()) == expected
+
+    assert len(int2float_map) == len(expected)
+    assert dict(int2float_map.items()) == expected
+    for key, value in expected.items():
+        assert int2float_map[key] == value
+
+
+@pytest.mark.parametrize('layout', ['items', 'compact', 'soa'])
+def test_int2float_shrink_to_fit(layout):
+    int2float_map = Int2Float(
+        ((i, i / 2) for i in range(10000)), layout=layout)
+    buffer_size = int2float_map.buffer_size
+
+    for key in range(100, 10000):
+        del int2float_map[key]
+    assert int2float_map.buffer_size == buffer_size
+    int2float_map.shrink_to_fit()
+
+    assert int2float_map.buffer_size < buffer_size / 50
+    assert dict(int2float_map.items()) == {i: i / 2 for i in range(100)}
+    int2float_map[100] = 0.5
+    assert int2float_map[100] == 0.5
+
+
+def test_int2float_shrink_to_fit_fail_when_readonly(int2float_map):
+    int2float_map.make_readonly()
+    with pytest.raises(RuntimeError, match="Instance is read-only"):
+        int2float_map.shrink_to_fit()
+
+
+@pytest.mark.parametrize('layout', ['items', 'compact', 'soa'])
+def test_int2float_shrink_load_kwarg(layout):
+    int2float_map = Int2Float(layout=layout, shrink_load=0.25)
+    for key in range(10000):
+        int2float_map[key] = key / 2
+    buffer_size = int2float_map.buffer_size
+
+    for key in range(10, 10000):
+        del int2float_map[key]
+    assert int2float_map.shrink_load == 0.25
+    assert int2float_map.buffer_size < buffer_size / 50
+    assert dict(int2float_map.items()) == {i: i / 2 for i in range(10)}
+
+    assert int2float_map.pop(0) == 0.0
+    assert int2float_map.popitem() in {(i, i / 2) for i in range(1, 10)}
+    assert len(int2float_map) == 8
+
+    for protocol in range(2, pickle.HIGHEST_PROTOCOL + 1):
+        new = pickle.loads(pickle.dumps(int2float_map, protocol=protocol))
+        assert new.shrink_load == 0.25
+        assert new == int2float_map
+
+
+@pytest.mark.parametrize('shrink_load', [-0.1, 1.0])
+def test_int2float_new_fail_when_invalid_shrink_load(shrink_load):
+    with pytest.raises(ValueError, match="'shrink_load' must be at least 0"):
+        Int2Float(shrink_load=shrink_load)
+
+
+def test_int2float_layout_is_items_by_default(int2float_map):
+    assert int2float_map.layout == 'items'
+
+
+def test_int2float_new_fail_when_unknown_layout():
+    with pytest.raises(ValueError, match="Unknown layout 'foo'"):
+        Int2Float(layout='foo')
+
+
+@pytest.mark.parametrize('layout', ['compact', 'soa'])
+@pytest.mark.parametrize('key', [0, 1, (2 ** 64) - 1])
+def test_int2float_sentinel_layout_setitem_getitem_delitem(layout, key):
+    int2float_map = Int2Float(layout=layout)
+
+    int2float_map[key] = 1
+    assert int2float_map[key] == 1
+    int2float_map[key] = 2
+    assert int2float_map[key] == 2
+    assert len(int2float_map) == 1
+    assert list(int2float_map.items()) == [(key, 2)]
+    del int2float_map[key]
+    assert key not in int2float_map
+    assert len(int2float_map) == 0
+
+
+@pytest.mark.parametrize('layout', ['compact', 'soa'])
+def test_int2float_sentinel_layout_setitem_delitem_random_keys(layout):
+    int2float_map = Int2Float(layout=layout)
+    rnd = random.Random(0)
+    expected = {}
+
+    for unused in range(20000):
+        key = rnd.randrange(2000)
+        if rnd.random() < 0.4 and key in expected:
+            del int2float_map[key]
+            del expected[key]
+        else:
+            int2float_map[key] = key + 1
+            expected[key] = float(key + 1)
+
+    assert int2float_map.layout == layout
+    assert len(int2float_map) == len(expected)
+    assert dict(int2float_map.items()) == expected
+    for key in range(2000):
+        assert (int2float_map.get(key) is not None) == (key in expected)
+
+
+@pytest.mark.parametrize('layout', ['compact', 'soa'])
+def test_int2float_sentinel_layout_buffer_size(layout):
+    int2float_map = Int2Float(prealloc_size=100, layout=layout)
+    header_size = 4 * ctypes.sizeof(ctypes.c_size_t)
+    # 128 keys and values of 8 bytes and extra slot for the key 0
+    assert int2float_map.buffer_size == header_size + 129 * 16
+
+
+@pytest.mark.parametrize('layout', ['compact', 'soa'])
+def test_int2float_sentinel_layout_clear_and_from_ptr(layout):
+    int2float_map = Int2Float({0: 100, 1: 101}, layout=layout)
+
+    int2float_new_map = Int2Float.from_ptr(int2float_map.buffer_ptr)
+    assert int2float_new_map == {0: 100, 1: 101}
+    int2float_new_map.clear()
+    assert len(int2float_map) == 0
+    assert 0 not in int2float_map
+
+
+def test_int2float_soa_keys_and_values_are_arrays():
+    int2float_map = Int2Float({0: 100, 5: 105, 7: 107}, layout='soa')
+    header_size = 4 * ctypes.sizeof(ctypes.c_size_t)
+    table_size = ctypes.c_size_t.from_address(
+        int2float_map.buffer_ptr + 2 * ctypes.sizeof(ctypes.c_size_t)).value
+
+    keys = (ctypes.c_ulonglong * (table_size + 1)).from_address(
+        int2float_map.buffer_ptr + header_size)
+    values = (ctypes.c_double * (table_size + 1)).from_address(
+        ctypes.addressof(keys) + ctypes.sizeof(keys))
+
+    assert sorted(k for k in keys[:table_size] if k) == [5, 7]
+    for idx, key in enumerate(keys[:table_size]):
+        if key:
+            assert values[idx] == 100 + key
+    assert values[table_size] == 100
+
+
+@pytest.mark.parametrize('layout', ['compact', 'soa'])
+def test_int2float_sentinel_layout_pickle_dumps_loads(layout):
+    int2float_map = Int2Float(layout=layout)
+    for i in range(100):
+        int2float_map[i] = 100 + i
+
+    new = pickle.loads(pickle.dumps(int2float_map))
+
+    assert new.layout == layout
+    assert new == int2float_map
+    assert new[0] == 100
+
+
+def test_int2float_new_fail_when_layout_is_not_supported():
+    with pytest.raises(ValueError, match="Layout 'swiss' is not supported"):
+        Int2Float(layout='swiss')
+
+
+@pytest.mark.parametrize('layout', ['items', 'compact', 'soa'])
+@pytest.mark.parametrize('count', [0, 1, 17, 5000])
+def test_int2float_get_many(layout, count):
+    rnd = random.Random(count)
+    expected = {rnd.randrange(2 ** 64): i / 3 for i in range(count)}
+    expected[0] = 0.5
+    int2float_map = Int2Float(expected, layout=layout)
+    keys = [k for k in expected] + [rnd.randrange(1, 2 ** 64)
+                                    for unused in range(count)]
+    rnd.shuffle(keys)
+
+    count, values, found = _get_many(
+        _hashmap_lib.int2float_get_many, int2float_map.buffer_ptr, keys,
+        ctypes.c_double)
+
+    assert count == len(expected)
+    for key, value, is_found in zip(keys, values, found):
+        assert is_found == (key in expected)
+        if is_found:
+            assert value == expected[key]
+
+
+@pytest.mark.parametrize('layout', ['items', 'compact', 'soa'])
+@pytest.mark.parametrize('count', [0, 1, 17, 5000])
+def test_int2float_set_many(layout, count):
+    rnd = random.Random(count)
+    initial = {rnd.randrange(2 ** 64): i / 3 for i in range(count)}
+    keys = [rnd.randrange(2 ** 64) for unused in range(count)]
+    keys += rnd.sample(list(initial), k=count // 2) + [0]
+    values = [i / 7 for i in range(len(keys))]
+    expected = dict(initial)
+    expected.update(zip(keys, values))
+
+    res, inserted, items, unused = _set_many(
+        'int2float', layout, initial, keys, values, ctypes.c_double)
+
+    assert res == 0
+    assert inserted == len(expected) - len(initial)
+    assert items == expected
+
+
+def _aligned_buffer(data):
+    buffer = bytearray(len(data) + 64)
+    offset = -ctypes.addressof(ctypes.c_char.from_buffer(buffer)) % 64
+    view = memoryview(buffer)[offset:offset + len(data)]
+    view[:] = data
+    return view
+
+
+def _readonly(cls, items, **kwargs):
+    table = cls(**kwargs)
+    table.update(items)
+    table.make_readonly()
+    return table
+
+
+@pytest.mark.parametrize('cls, items', [
+    (Int2Int, {1: 2, 3: 4}),
+    (Int2Float, {1: 2.5, 3: 4.5}),
+])
+def test_publisher_publish_acquire(cls, items):
+    memory = mmap.mmap(-1, Publisher.buffer_size_for(4096, slots=3))
+    publisher = Publisher.create_in(memory, 4096, slots=3)
+    reader = Publisher.from_buffer(memory)
+
+    generation = publisher.publish(_readonly(cls, items))
+    table = reader.acquire()
+
+    assert generation == reader.generation == 1
+    assert (reader.slots, reader.slot_size) == (3, 4096)
+    assert type(table) is cls
+    assert table.readonly
+    assert dict(table) == items
+
+
+def test_publisher_acquire_when_nothing_published():
+    memory = _aligned_buffer(bytes(Publisher.buffer_size_for(4096)))
+    publisher = Publisher.create_in(memory, 4096)
+
+    assert publisher.generation == 0
+    assert publisher.acquire() is None
+
+
+@pytest.mark.parametrize('layout', ['items', 'swiss', 'compact', 'soa'])
+def test_publisher_acquire_when_published_again(layout):
+    memory = mmap.mmap(-1, Publisher.buffer_size_for(4096))
+    publisher = Publisher.create_in(memory, 4096)
+    publisher.publish(_readonly(Int2Int, {1: 1}, layout=layout))
+    old_table = publisher.acquire()
+
+    publisher.publish(_readonly(Int2Int, {2: 2}, layout=layout))
+    table = publisher.acquire()
+
+    assert table.layout == layout
+    assert dict(old_table) == {1: 1}
+    assert dict(table) == {2: 2}
+
+
+def test_publisher_publish_fail_when_slot_is_used():
+    memory = mmap.mmap(-1, Publisher.buffer_size_for(4096))
+    publisher = Publisher.create_in(memory, 4096)
+    publisher.publish(_readonly(Int2Int, {1: 1}))
+    table = publisher.acquire()
+    publisher.publish(_readonly(Int2Int, {2: 2}))
+
+    with pytest.raises(RuntimeError, match='still used by readers'):
+        publisher.publish(_readonly(Int2Int, {3: 3}))
+    assert publisher.generation == 2
+    assert dict(table) == {1: 1}
+
+    del table
+    assert publisher.publish(_readonly(Int2Int, {3: 3})) == 3
+    assert dict(publisher.acquire()) == {3: 3}
+
+
+@pytest.mark.parametrize('table, exc, msg', [
+    (Int2Int({1: 2}), ValueError, 'must be read-only'),
+    (_readonly(Int2Int, {}, prealloc_size=1000), ValueError, 'exceeds slot'),
+    ({1: 2}, TypeError, 'must be an Int2Int or an Int2Float'),
+])
+def test_publisher_publish_fail_when_invalid_table(table, exc, msg):
+    memory = mmap.mmap(-1, Publisher.buffer_size_for(4096))
+    publisher = Publisher.create_in(memory, 4096)
+
+    with pytest.raises(exc, match=msg):
+        publisher.publish(table)
+    assert publisher.generation == 0
+
+
+@pytest.mark.parametrize('args, kwargs, exc, msg', [
+    ((-1,), {}, ValueError, "'slot_size' must not be negative"),
+    ((4096,), {'slots': 1}, ValueError, "'slots' must be at least 2"),
+    ((2 ** 63 - 1,), {}, ValueError, "'slot_size' is too big"),
+])
+def test_publisher_buffer_size_for_fail_when_invalid_args(
+        args, kwargs, exc, msg):
+    with pytest.raises(exc, match=msg):
+        Publisher.buffer_size_for(*args, **kwargs)
+
+
+@pytest.mark.parametrize('mutate, exc, msg', [
+    (lambda data: _aligned_buffer(bytes(len(data))), ValueError,
+     'Unsupported format'),
+    (lambda data: _aligned_buffer(data[:-64]), ValueError,
+     'Unsupported format'),
+    (bytes, BufferError, 'not writable'),
+])
+def test_publisher_from_buffer_fail_when_invalid_buffer(mutate, exc, msg):
+    memory = mmap.mmap(-1, Publisher.buffer_size_for(4096))
+    Publisher.create_in(memory, 4096)
+
+    with pytest.raises(exc, match=msg):
+        Publisher.from_buffer(mutate(memory))
+
+
+@pytest.mark.skipif(
+    'fork' not in multiprocessing.get_all_start_methods(),
+    reason="fork is not available")
+def test_publisher_when_writer_in_other_process():
+    keys = range(1, 101)
+    memory = mmap.mmap(-1, Publisher.buffer_size_for(8192, slots=3))
+    Publisher.create_in(memory, 8192, slots=3)
+    reader = Publisher.from_buffer(memory)
+
+    def write():
+        # All values of the table are its generation, publish is retried
+        # while the slot is used
+        writer = Publisher.from_buffer(memory)
+        generation = 1
+        while generation < 500:
+            table = _readonly(Int2Int, dict.fromkeys(keys, generation))
+            try:
+                generation = writer.publish(table) + 1
+            except RuntimeError:
+                pass
+
+    process = multiprocessing.get_context('fork').Process(target=write)
+    process.start()
+    try:
+        generations = set()
+        while process.is_alive():
+            table = reader.acquire()
+            if table is not None:
+                values = set(table.values())
+                assert len(values) == 1
+                generations.update(values)
+    finally:
+        process.join()
+    assert process.exitcode == 0
+    assert reader.generation == 499
+    assert set(reader.acquire().values()) == {499}